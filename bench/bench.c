@@ -0,0 +1,285 @@
+//
+// Created by Dylan Lukes on 8/23/23.
+//
+// The benchmark harness. For each benchmark: set up, warm up, work out how many iterations
+// make a sample long enough to time reliably, then time a number of samples. Results are
+// reported per iteration (min, percentiles, max, mean), as a table and optionally as JSON.
+//
+// Usage: neopad_bench [--filter SUBSTRING] [--warmup N] [--samples N] [--sample-ms MS] [--json FILE|-]
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <neopad/renderer.h>
+
+#include "neopad/internal/shims/bx/timer.h"
+
+#include "bench.h"
+
+#ifndef NEOPAD_BENCH_BUILD_TYPE
+#define NEOPAD_BENCH_BUILD_TYPE "unknown"
+#endif
+
+volatile uint64_t neopad_bench_sink;
+
+static const neopad_bench_t *const SUITES[] = {
+        neopad_bench_stroke,
+        neopad_bench_transform,
+        neopad_bench_containers,
+        neopad_bench_frame,
+};
+
+typedef struct {
+    const char *filter;
+    int warmup;
+    int samples;
+    double sample_ms;
+    const char *json_path;
+} options_t;
+
+typedef struct {
+    const neopad_bench_t *bench;
+    uint64_t batch;
+    double min, p50, p90, p99, max, mean, stddev;
+} result_t;
+
+#pragma mark - Shared State
+
+static neopad_renderer_t shared_renderer = NULL;
+
+neopad_renderer_t neopad_bench_renderer(void) {
+    if (!shared_renderer) {
+        shared_renderer = neopad_renderer_create();
+        neopad_renderer_init_t init = {
+                .name = "neopad_bench",
+                .width = 1920,
+                .height = 1080,
+                .content_scale = 1.0f,
+                .headless = true,
+                .background = {.color = 0x222222FF, .grid_enabled = true, .grid_major = 100, .grid_minor = 25},
+        };
+        if (!neopad_renderer_init(shared_renderer, init)) {
+            fprintf(stderr, "Failed to initialize a headless renderer.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        // Set up the matrices.
+        neopad_renderer_begin_frame(shared_renderer);
+        neopad_renderer_end_frame(shared_renderer);
+    }
+    return shared_renderer;
+}
+
+uint32_t neopad_bench_random(uint32_t *state) {
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+#pragma mark - Measurement
+
+static double ticks_to_ns(int64_t ticks) {
+    return (double) ticks * 1.0e9 / (double) bx_get_hp_frequency();
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/// Percentile of sorted samples, interpolating between the nearest two.
+static double percentile(const double *sorted, int count, double p) {
+    double rank = p * (double) (count - 1);
+    int lo = (int) rank;
+    int hi = lo + 1 < count ? lo + 1 : lo;
+    double t = rank - (double) lo;
+    return sorted[lo] * (1.0 - t) + sorted[hi] * t;
+}
+
+static result_t measure(const neopad_bench_t *bench, const options_t *options) {
+    result_t result = {.bench = bench};
+    void *context = bench->setup ? bench->setup() : NULL;
+
+    for (int i = 0; i < options->warmup; i++) {
+        bench->run(context);
+    }
+
+    // Enough iterations per sample that each takes about sample_ms.
+    int64_t start = bx_get_hp_counter();
+    bench->run(context);
+    double once = ticks_to_ns(bx_get_hp_counter() - start);
+    double target = options->sample_ms * 1.0e6;
+    result.batch = once >= target ? 1 : (uint64_t) ceil(target / (once > 1.0 ? once : 1.0));
+
+    double *samples = malloc((size_t) options->samples * sizeof(double));
+    for (int s = 0; s < options->samples; s++) {
+        start = bx_get_hp_counter();
+        for (uint64_t i = 0; i < result.batch; i++) {
+            bench->run(context);
+        }
+        samples[s] = ticks_to_ns(bx_get_hp_counter() - start) / (double) result.batch;
+    }
+
+    if (bench->teardown) {
+        bench->teardown(context);
+    }
+
+    qsort(samples, (size_t) options->samples, sizeof(double), compare_doubles);
+    double sum = 0.0;
+    for (int s = 0; s < options->samples; s++) {
+        sum += samples[s];
+    }
+    result.mean = sum / (double) options->samples;
+
+    double variance = 0.0;
+    for (int s = 0; s < options->samples; s++) {
+        variance += (samples[s] - result.mean) * (samples[s] - result.mean);
+    }
+    result.stddev = sqrt(variance / (double) options->samples);
+
+    result.min = samples[0];
+    result.p50 = percentile(samples, options->samples, 0.50);
+    result.p90 = percentile(samples, options->samples, 0.90);
+    result.p99 = percentile(samples, options->samples, 0.99);
+    result.max = samples[options->samples - 1];
+
+    free(samples);
+    return result;
+}
+
+#pragma mark - Output
+
+static void print_header(FILE *file) {
+    fprintf(file, "%-36s %12s %12s %12s %12s %14s\n", "benchmark", "min (ns)", "p50 (ns)", "p90 (ns)", "p99 (ns)", "items/s");
+}
+
+static double items_per_second(const result_t *r) {
+    return r->p50 > 0.0 ? (double) r->bench->items * 1.0e9 / r->p50 : 0.0;
+}
+
+static void print_result(FILE *file, const result_t *r) {
+    fprintf(file, "%-36s %12.1f %12.1f %12.1f %12.1f %14.4g\n",
+            r->bench->name, r->min, r->p50, r->p90, r->p99, items_per_second(r));
+}
+
+static bool write_json(const char *path, const options_t *options, const result_t *results, size_t count) {
+    FILE *file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Could not open %s for writing.\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"build\": \"%s\",\n  \"warmup\": %d,\n  \"samples\": %d,\n  \"benchmarks\": [\n",
+            NEOPAD_BENCH_BUILD_TYPE, options->warmup, options->samples);
+    for (size_t i = 0; i < count; i++) {
+        const result_t *r = &results[i];
+        fprintf(file,
+                "    {\"name\": \"%s\", \"iterations\": %llu, \"items\": %llu, \"items_per_second\": %.6g,\n"
+                "     \"ns\": {\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, "
+                "\"mean\": %.3f, \"stddev\": %.3f}}%s\n",
+                r->bench->name,
+                (unsigned long long) (r->batch * (uint64_t) options->samples),
+                (unsigned long long) r->bench->items,
+                items_per_second(r),
+                r->min, r->p50, r->p90, r->p99, r->max, r->mean, r->stddev,
+                i + 1 < count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    bool ok = !ferror(file);
+    if (file != stdout) {
+        ok = fclose(file) == 0 && ok;
+    }
+    return ok;
+}
+
+#pragma mark - Main
+
+static void usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--filter SUBSTRING] [--warmup N] [--samples N] [--sample-ms MS] [--json FILE|-]\n",
+            program);
+}
+
+int main(int argc, char **argv) {
+    options_t options = {
+            .filter = NULL,
+            .warmup = 10,
+            .samples = 50,
+            .sample_ms = 2.0,
+            .json_path = NULL,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        if (strcmp(arg, "--filter") == 0) {
+            options.filter = value;
+        } else if (strcmp(arg, "--warmup") == 0) {
+            options.warmup = atoi(value);
+        } else if (strcmp(arg, "--samples") == 0) {
+            options.samples = atoi(value);
+        } else if (strcmp(arg, "--sample-ms") == 0) {
+            options.sample_ms = atof(value);
+        } else if (strcmp(arg, "--json") == 0) {
+            options.json_path = value;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        i++;
+    }
+
+    if (options.samples < 1 || options.warmup < 0 || options.sample_ms <= 0.0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // The table goes to stderr if the JSON is going to stdout.
+    FILE *table = options.json_path && strcmp(options.json_path, "-") == 0 ? stderr : stdout;
+
+    size_t capacity = 0;
+    for (size_t s = 0; s < sizeof(SUITES) / sizeof(SUITES[0]); s++) {
+        for (const neopad_bench_t *b = SUITES[s]; b->name; b++) {
+            capacity++;
+        }
+    }
+
+    result_t *results = malloc(capacity * sizeof(result_t));
+    size_t count = 0;
+
+    print_header(table);
+    for (size_t s = 0; s < sizeof(SUITES) / sizeof(SUITES[0]); s++) {
+        for (const neopad_bench_t *b = SUITES[s]; b->name; b++) {
+            if (options.filter && !strstr(b->name, options.filter)) {
+                continue;
+            }
+            results[count] = measure(b, &options);
+            print_result(table, &results[count]);
+            fflush(table);
+            count++;
+        }
+    }
+
+    bool ok = !options.json_path || write_json(options.json_path, &options, results, count);
+
+    free(results);
+    if (shared_renderer) {
+        neopad_renderer_shutdown(shared_renderer);
+        neopad_renderer_destroy(shared_renderer);
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
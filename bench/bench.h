@@ -0,0 +1,50 @@
+//
+// Created by Dylan Lukes on 8/23/23.
+//
+
+#ifndef NEOPAD_BENCH_H
+#define NEOPAD_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct neopad_renderer_s *neopad_renderer_t;
+
+/// A benchmark. Each iteration calls `run` once; `setup` and `teardown` are not timed.
+typedef struct neopad_bench_s {
+    /// Name, as "group/case".
+    const char *name;
+
+    /// Items processed per iteration (points, lookups, frames...), for throughput.
+    uint64_t items;
+
+    /// Make the context passed to run (may be NULL).
+    void *(*setup)(void);
+
+    /// The code being measured.
+    void (*run)(void *context);
+
+    /// Free the context.
+    void (*teardown)(void *context);
+} neopad_bench_t;
+
+/// Marks the end of a list of benchmarks.
+#define NEOPAD_BENCH_END() {NULL, 0, NULL, NULL, NULL}
+
+/** Benchmark lists: one per file. */
+extern const neopad_bench_t neopad_bench_stroke[];
+extern const neopad_bench_t neopad_bench_transform[];
+extern const neopad_bench_t neopad_bench_containers[];
+extern const neopad_bench_t neopad_bench_frame[];
+
+/// Results go here, so the compiler cannot optimize the work away.
+extern volatile uint64_t neopad_bench_sink;
+
+/// A headless renderer, shared by all benchmarks (bgfx only allows one at a time).
+/// @note Created on first use, and destroyed when the run ends.
+neopad_renderer_t neopad_bench_renderer(void);
+
+/// Deterministic pseudo-random numbers, so every run measures the same work.
+uint32_t neopad_bench_random(uint32_t *state);
+
+#endif //NEOPAD_BENCH_H
@@ -0,0 +1,245 @@
+//
+// Created by Dylan Lukes on 8/23/23.
+//
+// The CTL containers, on the operations the renderer and scene lean on.
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <ctl/allocator.h>
+
+// vec_uint32_t
+#define POD
+#define T uint32_t
+#include <ctl/vector.h>
+
+// uset_uint32_t
+#define POD
+#define T uint32_t
+#include <ctl/unordered_set.h>
+
+// ufset_uint32_t
+#define POD
+#define T uint32_t
+#include <ctl/unordered_flat_set.h>
+
+// set_uint32_t
+#define POD
+#define T uint32_t
+#include <ctl/set.h>
+
+#include "bench.h"
+
+#define KEY_COUNT 10000
+
+typedef struct {
+    uint32_t keys[KEY_COUNT];
+
+    /// Filled once, for lookups.
+    uset_uint32_t uset;
+    ufset_uint32_t ufset;
+    set_uint32_t set;
+
+    /// Reset every run, as a frame's scratch would be.
+    ctl_arena arena;
+    ctl_pool set_pool;
+} containers_context_t;
+
+static void *setup(void) {
+    containers_context_t *context = malloc(sizeof(containers_context_t));
+
+    uint32_t state = 0x2545F491;
+    for (int i = 0; i < KEY_COUNT; i++) {
+        context->keys[i] = neopad_bench_random(&state);
+    }
+
+    ctl_arena_init(&context->arena, 0);
+    ctl_pool_init(&context->set_pool, sizeof(set_uint32_t_node));
+
+    context->uset = uset_uint32_t_init(NULL, NULL);
+    context->ufset = ufset_uint32_t_init(NULL, NULL);
+    context->set = set_uint32_t_init(NULL);
+    for (int i = 0; i < KEY_COUNT; i++) {
+        uset_uint32_t_insert(&context->uset, context->keys[i]);
+        ufset_uint32_t_insert(&context->ufset, context->keys[i]);
+        set_uint32_t_insert(&context->set, context->keys[i]);
+    }
+    return context;
+}
+
+static void teardown(void *context) {
+    containers_context_t *c = context;
+    uset_uint32_t_free(&c->uset);
+    ufset_uint32_t_free(&c->ufset);
+    set_uint32_t_free(&c->set);
+    ctl_arena_free(&c->arena);
+    ctl_pool_free(&c->set_pool);
+    free(c);
+}
+
+static void run_vec_push_back(void *context) {
+    containers_context_t *c = context;
+    vec_uint32_t vec = vec_uint32_t_init();
+    for (int i = 0; i < KEY_COUNT; i++) {
+        vec_uint32_t_push_back(&vec, c->keys[i]);
+    }
+    neopad_bench_sink += vec.size;
+    vec_uint32_t_free(&vec);
+}
+
+static void run_vec_push_back_arena(void *context) {
+    containers_context_t *c = context;
+    ctl_arena_reset(&c->arena);
+    vec_uint32_t vec = vec_uint32_t_init();
+    vec_uint32_t_set_allocator(&vec, ctl_arena_allocator(&c->arena));
+    for (int i = 0; i < KEY_COUNT; i++) {
+        vec_uint32_t_push_back(&vec, c->keys[i]);
+    }
+    neopad_bench_sink += vec.size;
+}
+
+static void run_vec_iterate(void *context) {
+    containers_context_t *c = context;
+    vec_uint32_t vec = vec_uint32_t_init();
+    vec_uint32_t_reserve(&vec, KEY_COUNT);
+    for (int i = 0; i < KEY_COUNT; i++) {
+        vec_uint32_t_push_back(&vec, c->keys[i]);
+    }
+    uint64_t sum = 0;
+    vec_foreach(uint32_t, &vec, key) {
+        sum += *key;
+    }
+    neopad_bench_sink += sum;
+    vec_uint32_t_free(&vec);
+}
+
+static vec_uint32_t copy_keys(containers_context_t *c) {
+    vec_uint32_t vec = vec_uint32_t_init();
+    vec_uint32_t_reserve(&vec, KEY_COUNT);
+    for (int i = 0; i < KEY_COUNT; i++) {
+        vec_uint32_t_push_back(&vec, c->keys[i]);
+    }
+    return vec;
+}
+
+/// Descending, so the sort can't take the radix path the default compare gets.
+static int compare_descending(uint32_t *a, uint32_t *b) {
+    return *a > *b;
+}
+
+static void run_vec_sort(void *context) {
+    vec_uint32_t vec = copy_keys(context);
+    vec_uint32_t_sort(&vec);
+    neopad_bench_sink += vec.vector[0];
+    vec_uint32_t_free(&vec);
+}
+
+static void run_vec_sort_compare(void *context) {
+    vec_uint32_t vec = copy_keys(context);
+    vec.compare = compare_descending;
+    vec_uint32_t_sort(&vec);
+    neopad_bench_sink += vec.vector[0];
+    vec_uint32_t_free(&vec);
+}
+
+static void run_uset_insert(void *context) {
+    containers_context_t *c = context;
+    uset_uint32_t uset = uset_uint32_t_init(NULL, NULL);
+    for (int i = 0; i < KEY_COUNT; i++) {
+        uset_uint32_t_insert(&uset, c->keys[i]);
+    }
+    neopad_bench_sink += uset.size;
+    uset_uint32_t_free(&uset);
+}
+
+static void run_uset_contains(void *context) {
+    containers_context_t *c = context;
+    uint64_t found = 0;
+    for (int i = 0; i < KEY_COUNT; i++) {
+        // Half hits, half (almost certainly) misses.
+        found += uset_uint32_t_contains(&c->uset, i % 2 ? c->keys[i] : ~c->keys[i]);
+    }
+    neopad_bench_sink += found;
+}
+
+static void run_ufset_insert(void *context) {
+    containers_context_t *c = context;
+    ufset_uint32_t ufset = ufset_uint32_t_init(NULL, NULL);
+    for (int i = 0; i < KEY_COUNT; i++) {
+        ufset_uint32_t_insert(&ufset, c->keys[i]);
+    }
+    neopad_bench_sink += ufset.size;
+    ufset_uint32_t_free(&ufset);
+}
+
+static void run_ufset_contains(void *context) {
+    containers_context_t *c = context;
+    uint64_t found = 0;
+    for (int i = 0; i < KEY_COUNT; i++) {
+        found += ufset_uint32_t_contains(&c->ufset, i % 2 ? c->keys[i] : ~c->keys[i]);
+    }
+    neopad_bench_sink += found;
+}
+
+/// Dense ids (as the scene hands out), inserted and looked up: an identity hash, unmixed, would
+/// pile them into neighbouring slots.
+static void run_ufset_ids(void *context) {
+    ufset_uint32_t ufset = ufset_uint32_t_init(NULL, NULL);
+    ufset_uint32_t_reserve(&ufset, KEY_COUNT);
+    for (uint32_t id = 0; id < KEY_COUNT; id++) {
+        ufset_uint32_t_insert(&ufset, id);
+    }
+    uint64_t found = 0;
+    for (uint32_t id = 0; id < KEY_COUNT; id++) {
+        found += ufset_uint32_t_contains(&ufset, id % 2 ? id : id + KEY_COUNT);
+    }
+    neopad_bench_sink += found;
+    ufset_uint32_t_free(&ufset);
+}
+
+static void run_set_insert(void *context) {
+    containers_context_t *c = context;
+    set_uint32_t set = set_uint32_t_init(NULL);
+    for (int i = 0; i < KEY_COUNT; i++) {
+        set_uint32_t_insert(&set, c->keys[i]);
+    }
+    neopad_bench_sink += set.size;
+    set_uint32_t_free(&set);
+}
+
+static void run_set_insert_pool(void *context) {
+    containers_context_t *c = context;
+    ctl_pool_reset(&c->set_pool);
+    set_uint32_t set = set_uint32_t_init(NULL);
+    set_uint32_t_set_allocator(&set, ctl_pool_allocator(&c->set_pool));
+    for (int i = 0; i < KEY_COUNT; i++) {
+        set_uint32_t_insert(&set, c->keys[i]);
+    }
+    neopad_bench_sink += set.size;
+}
+
+static void run_set_find(void *context) {
+    containers_context_t *c = context;
+    uint64_t found = 0;
+    for (int i = 0; i < KEY_COUNT; i++) {
+        found += set_uint32_t_count(&c->set, i % 2 ? c->keys[i] : ~c->keys[i]);
+    }
+    neopad_bench_sink += found;
+}
+
+const neopad_bench_t neopad_bench_containers[] = {
+        {"ctl/vec_push_back", KEY_COUNT, setup, run_vec_push_back, teardown},
+        {"ctl/vec_push_back_arena", KEY_COUNT, setup, run_vec_push_back_arena, teardown},
+        {"ctl/vec_iterate", KEY_COUNT, setup, run_vec_iterate, teardown},
+        {"ctl/vec_sort", KEY_COUNT, setup, run_vec_sort, teardown},
+        {"ctl/vec_sort_compare", KEY_COUNT, setup, run_vec_sort_compare, teardown},
+        {"ctl/uset_insert", KEY_COUNT, setup, run_uset_insert, teardown},
+        {"ctl/uset_contains", KEY_COUNT, setup, run_uset_contains, teardown},
+        {"ctl/ufset_insert", KEY_COUNT, setup, run_ufset_insert, teardown},
+        {"ctl/ufset_contains", KEY_COUNT, setup, run_ufset_contains, teardown},
+        {"ctl/ufset_ids", KEY_COUNT, setup, run_ufset_ids, teardown},
+        {"ctl/set_insert", KEY_COUNT, setup, run_set_insert, teardown},
+        {"ctl/set_insert_pool", KEY_COUNT, setup, run_set_insert_pool, teardown},
+        {"ctl/set_find", KEY_COUNT, setup, run_set_find, teardown},
+        NEOPAD_BENCH_END(),
+};
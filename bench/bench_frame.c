@@ -0,0 +1,113 @@
+//
+// Created by Dylan Lukes on 8/23/23.
+//
+// Whole frames, rendered headless: everything up to (and including) submission to bgfx.
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <neopad/renderer.h>
+#include <neopad/scene.h>
+
+#include "bench.h"
+
+#define GRID_SIZE 200
+#define GRID_SPACING 100.0f
+#define STROKE_COUNT 200
+#define STROKE_POINTS 256
+
+typedef struct {
+    neopad_renderer_t renderer;
+    neopad_scene_t scene;
+} frame_context_t;
+
+/// A grid of shapes, like the demo's.
+static void populate_scene(neopad_scene_t scene) {
+    for (int i = 0; i < GRID_SIZE; i++) {
+        for (int j = 0; j < GRID_SIZE; j++) {
+            float x = GRID_SPACING * (float) (i - GRID_SIZE / 2);
+            float y = GRID_SPACING * (float) (j - GRID_SIZE / 2);
+
+            neopad_scene_object_t object = {.color = 0x80FF00FF, .width = 4.0f};
+            switch ((i + j) % 3) {
+                case 0:
+                    object.kind = NEOPAD_SCENE_OBJECT_RECT;
+                    object.rect = (rect_t) {.min = {x - 20, y - 20}, .max = {x + 20, y + 20}};
+                    break;
+                case 1:
+                    object.kind = NEOPAD_SCENE_OBJECT_ELLIPSE;
+                    object.ellipse = (ellipse_t) {.center = {x, y}, .radii = {30, 20}};
+                    break;
+                default:
+                    object.kind = NEOPAD_SCENE_OBJECT_LINE;
+                    object.line = (line_t) {.start = {x - 30, y - 30}, .end = {x + 30, y + 30}};
+                    break;
+            }
+            neopad_scene_add(scene, object);
+        }
+    }
+}
+
+static void render_frame(neopad_renderer_t renderer, neopad_scene_t scene) {
+    neopad_renderer_begin_frame(renderer);
+    neopad_renderer_draw_background(renderer);
+    if (scene) {
+        neopad_renderer_draw_scene(renderer, scene);
+    }
+    neopad_renderer_end_frame(renderer);
+}
+
+static void *setup_empty(void) {
+    frame_context_t *context = malloc(sizeof(frame_context_t));
+    context->renderer = neopad_bench_renderer();
+    context->scene = NULL;
+    return context;
+}
+
+static void *setup_scene(void) {
+    frame_context_t *context = setup_empty();
+    context->scene = neopad_scene_create();
+    populate_scene(context->scene);
+    return context;
+}
+
+static void *setup_strokes(void) {
+    frame_context_t *context = setup_empty();
+
+    // Finished strokes, all in view. (Strokes can't be removed, so this is done only once.)
+    static bool populated = false;
+    if (!populated) {
+        for (int s = 0; s < STROKE_COUNT; s++) {
+            double y = -500.0 + 5.0 * s;
+            neopad_renderer_begin_points_d(context->renderer, (neopad_dvec2_t) {-900.0, y});
+            for (int i = 1; i < STROKE_POINTS; i++) {
+                double x = -900.0 + 7.0 * i;
+                neopad_renderer_pen_add_point_d(context->renderer, (neopad_dvec2_t) {x, y + 20.0 * sin(x / 30.0)});
+            }
+            neopad_renderer_end_points(context->renderer);
+        }
+        populated = true;
+    }
+    return context;
+}
+
+static void teardown(void *context) {
+    frame_context_t *c = context;
+    if (c->scene) {
+        neopad_scene_destroy(c->scene);
+    }
+    free(c);
+}
+
+static void run_frame(void *context) {
+    frame_context_t *c = context;
+    render_frame(c->renderer, c->scene);
+}
+
+// Ordered so that the strokes added last don't weigh on the other frames.
+const neopad_bench_t neopad_bench_frame[] = {
+        {"frame/empty", 1, setup_empty, run_frame, teardown},
+        {"frame/scene_40k", 1, setup_scene, run_frame, teardown},
+        {"frame/strokes_200", 1, setup_strokes, run_frame, teardown},
+        NEOPAD_BENCH_END(),
+};
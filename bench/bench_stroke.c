@@ -0,0 +1,97 @@
+//
+// Created by Dylan Lukes on 8/23/23.
+//
+// Stroke tessellation, in one go and incrementally, for a long wavy stroke.
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "neopad/internal/renderer/stroke.h"
+
+#include "bench.h"
+
+#define POINT_COUNT 1024
+
+typedef struct {
+    neopad_stroke_style_t style;
+    neopad_vec2_t points[POINT_COUNT];
+    neopad_renderer_vertex_t *vertices;
+    uint32_t *indices;
+} stroke_context_t;
+
+static stroke_context_t *make_context(neopad_stroke_join_t join, neopad_stroke_cap_t cap) {
+    stroke_context_t *context = malloc(sizeof(stroke_context_t));
+    context->style = (neopad_stroke_style_t) {
+            .width = 4.0f,
+            .color = 0xFFFFFFFF,
+            .join = join,
+            .cap = cap,
+            .miter_limit = 4.0f,
+    };
+
+    // A wave, as if drawn by hand: a couple of pixels between points.
+    for (int i = 0; i < POINT_COUNT; i++) {
+        float t = (float) i;
+        context->points[i] = (neopad_vec2_t) {.x = 2.0f * t, .y = 40.0f * sinf(t / 20.0f)};
+    }
+
+    neopad_stroke_size_t size = neopad_stroke_measure(POINT_COUNT, &context->style);
+    context->vertices = malloc(size.vertex_count * sizeof(neopad_renderer_vertex_t));
+    context->indices = malloc(size.index_count * sizeof(uint32_t));
+    return context;
+}
+
+static void *setup_miter(void) {
+    return make_context(NEOPAD_STROKE_JOIN_MITER, NEOPAD_STROKE_CAP_BUTT);
+}
+
+static void *setup_round(void) {
+    return make_context(NEOPAD_STROKE_JOIN_ROUND, NEOPAD_STROKE_CAP_ROUND);
+}
+
+static void teardown(void *context) {
+    stroke_context_t *c = context;
+    free(c->vertices);
+    free(c->indices);
+    free(c);
+}
+
+static void run_tessellate(void *context) {
+    stroke_context_t *c = context;
+    neopad_stroke_size_t size = neopad_stroke_tessellate(
+            c->points, POINT_COUNT, &c->style, 0, c->vertices, c->indices);
+    neopad_bench_sink += size.index_count;
+}
+
+static void run_stream(void *context) {
+    stroke_context_t *c = context;
+    neopad_stroke_stream_t stream;
+    neopad_stroke_stream_begin(&stream, &c->style, 0);
+    stream.vertices = c->vertices;
+    stream.indices = c->indices;
+
+    for (int i = 0; i < POINT_COUNT; i++) {
+        neopad_stroke_stream_push(&stream, (vec2) {c->points[i].x, c->points[i].y});
+    }
+    neopad_stroke_size_t end = neopad_stroke_stream_finish(
+            &stream,
+            &c->vertices[stream.size.vertex_count],
+            &c->indices[stream.size.index_count]);
+    neopad_bench_sink += stream.size.index_count + end.index_count;
+}
+
+static void run_simplify(void *context) {
+    stroke_context_t *c = context;
+    uint32_t scratch[2 * POINT_COUNT];
+    neopad_vec2_t out[POINT_COUNT];
+    neopad_bench_sink += neopad_stroke_simplify(c->points, POINT_COUNT, 0.5f, scratch, out);
+}
+
+const neopad_bench_t neopad_bench_stroke[] = {
+        {"stroke/tessellate_miter", POINT_COUNT, setup_miter, run_tessellate, teardown},
+        {"stroke/tessellate_round", POINT_COUNT, setup_round, run_tessellate, teardown},
+        {"stroke/stream_miter", POINT_COUNT, setup_miter, run_stream, teardown},
+        {"stroke/stream_round", POINT_COUNT, setup_round, run_stream, teardown},
+        {"stroke/simplify", POINT_COUNT, setup_miter, run_simplify, teardown},
+        NEOPAD_BENCH_END(),
+};
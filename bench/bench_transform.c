@@ -0,0 +1,86 @@
+//
+// Created by Dylan Lukes on 8/23/23.
+//
+// Coordinate transforms, as done for every input event (and more, for hit testing).
+
+#include <stdlib.h>
+
+#include <neopad/renderer.h>
+
+#include "bench.h"
+
+#define POINT_COUNT 1024
+
+typedef struct {
+    neopad_renderer_t renderer;
+    neopad_vec4_t viewport;
+    neopad_vec2_t points[POINT_COUNT];
+} transform_context_t;
+
+static void *setup(void) {
+    transform_context_t *context = malloc(sizeof(transform_context_t));
+    context->renderer = neopad_bench_renderer();
+    context->viewport = (neopad_vec4_t) {.left = 0.0f, .top = 0.0f, .right = 1920.0f, .bottom = 1080.0f};
+
+    uint32_t state = 0x9E3779B9;
+    for (int i = 0; i < POINT_COUNT; i++) {
+        context->points[i] = (neopad_vec2_t) {
+                .x = (float) (neopad_bench_random(&state) % 1920),
+                .y = (float) (neopad_bench_random(&state) % 1080),
+        };
+    }
+    return context;
+}
+
+static void teardown(void *context) {
+    free(context);
+}
+
+static void run_window_to_world(void *context) {
+    transform_context_t *c = context;
+    float sum = 0.0f;
+    for (int i = 0; i < POINT_COUNT; i++) {
+        neopad_vec2_t q;
+        neopad_renderer_window_to_world(c->renderer, c->viewport, c->points[i], &q);
+        sum += q.x + q.y;
+    }
+    neopad_bench_sink += (uint64_t) (int64_t) sum;
+}
+
+static void run_window_to_world_d(void *context) {
+    transform_context_t *c = context;
+    double sum = 0.0;
+    for (int i = 0; i < POINT_COUNT; i++) {
+        neopad_dvec2_t q;
+        neopad_renderer_window_to_world_d(c->renderer, c->viewport, c->points[i], &q);
+        sum += q.x + q.y;
+    }
+    neopad_bench_sink += (uint64_t) (int64_t) sum;
+}
+
+static void run_window_to_world_n(void *context) {
+    transform_context_t *c = context;
+    neopad_dvec2_t q[POINT_COUNT];
+    neopad_renderer_window_to_world_n(c->renderer, c->viewport, c->points, q, POINT_COUNT);
+
+    double sum = 0.0;
+    for (int i = 0; i < POINT_COUNT; i++) {
+        sum += q[i].x + q[i].y;
+    }
+    neopad_bench_sink += (uint64_t) (int64_t) sum;
+}
+
+static void run_view_rect(void *context) {
+    transform_context_t *c = context;
+    rect_t view;
+    neopad_renderer_get_view_rect(c->renderer, &view);
+    neopad_bench_sink += (uint64_t) (int64_t) view.max[0];
+}
+
+const neopad_bench_t neopad_bench_transform[] = {
+        {"transform/window_to_world", POINT_COUNT, setup, run_window_to_world, teardown},
+        {"transform/window_to_world_d", POINT_COUNT, setup, run_window_to_world_d, teardown},
+        {"transform/window_to_world_n", POINT_COUNT, setup, run_window_to_world_n, teardown},
+        {"transform/view_rect", 1, setup, run_view_rect, teardown},
+        NEOPAD_BENCH_END(),
+};
@@ -1,3 +1,4 @@
+# Any further arguments are extra directories to search for includes (e.g. generated headers).
 function(add_shaders_directory SHADERS_DIR TARGET_OUT_VAR)
     get_filename_component(SHADERS_DIR "${SHADERS_DIR}" ABSOLUTE)
     get_filename_component(NAMESPACE "${CMAKE_CURRENT_SOURCE_DIR}" NAME_WE)
@@ -36,7 +37,7 @@ function(add_shaders_directory SHADERS_DIR TARGET_OUT_VAR)
             VARYING_DEF "${VARYING_DEF_LOCATION}"
             OUTPUT_DIR "${SHADERS_OUT_DIR}"
             OUT_FILES_VAR VERTEX_OUTPUT_FILES
-            INCLUDE_DIRS "${SHADERS_DIR}" "${BGFX_DIR}/src"
+            INCLUDE_DIRS "${SHADERS_DIR}" "${BGFX_DIR}/src" ${ARGN}
     )
 
     bgfx_compile_shader_to_header(
@@ -45,7 +46,7 @@ function(add_shaders_directory SHADERS_DIR TARGET_OUT_VAR)
             VARYING_DEF "${VARYING_DEF_LOCATION}"
             OUTPUT_DIR "${SHADERS_OUT_DIR}"
             OUT_FILES_VAR FRAGMENT_OUTPUT_FILES
-            INCLUDE_DIRS "${SHADERS_DIR}" "${BGFX_DIR}/src"
+            INCLUDE_DIRS "${SHADERS_DIR}" "${BGFX_DIR}/src" ${ARGN}
     )
 
     set(OUTPUT_FILES)
@@ -0,0 +1,37 @@
+# Generate the shader side of the uniform declarations (see src/include/neopad/internal/renderer/uniforms.def.h):
+# a header declaring each block as an array of vec4s, and each field as a swizzle of it.
+function(generate_uniforms_header DECLARATIONS OUTPUT_FILE)
+    get_filename_component(DECLARATIONS "${DECLARATIONS}" ABSOLUTE)
+
+    # Declarations are read at configure time, so configure again when they change.
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS "${DECLARATIONS}")
+
+    set(SWIZZLES "xyzw")
+    set(HEADER "// Generated from ${DECLARATIONS}. Do not edit.\n")
+
+    set(BLOCK_PATTERN "BLOCK\\(([A-Z_0-9]+), *([a-z_0-9]+), *([0-9]+)\\)")
+    set(FIELD_PATTERN "FIELD\\(([A-Z_0-9]+), *[A-Z_0-9]+, *([a-z_0-9]+), *([0-9]+), *([0-9]+)\\)")
+
+    file(READ "${DECLARATIONS}" CONTENT)
+    string(REGEX MATCHALL "${BLOCK_PATTERN}|${FIELD_PATTERN}" ENTRIES "${CONTENT}")
+    foreach(ENTRY IN LISTS ENTRIES)
+        if(ENTRY MATCHES "${BLOCK_PATTERN}")
+            set("BLOCK_NAME_${CMAKE_MATCH_1}" "${CMAKE_MATCH_2}")
+            string(APPEND HEADER "\nuniform vec4 u_${CMAKE_MATCH_2}[${CMAKE_MATCH_3}];\n")
+        elseif(ENTRY MATCHES "${FIELD_PATTERN}")
+            set(BLOCK "${BLOCK_NAME_${CMAKE_MATCH_1}}")
+            if(NOT BLOCK)
+                message(FATAL_ERROR "Uniform ${CMAKE_MATCH_2} declared before its block ${CMAKE_MATCH_1}")
+            endif()
+            math(EXPR VEC4 "${CMAKE_MATCH_3} / 4")
+            math(EXPR COMPONENT "${CMAKE_MATCH_3} % 4")
+            string(SUBSTRING "${SWIZZLES}" ${COMPONENT} ${CMAKE_MATCH_4} SWIZZLE)
+            string(APPEND HEADER "#define u_${CMAKE_MATCH_2} u_${BLOCK}[${VEC4}].${SWIZZLE}\n")
+        endif()
+    endforeach()
+
+    # Only touch the header when it changes (configure_file copies only then), so shaders are not
+    # recompiled for nothing.
+    file(WRITE "${OUTPUT_FILE}.tmp" "${HEADER}")
+    configure_file("${OUTPUT_FILE}.tmp" "${OUTPUT_FILE}" COPYONLY)
+endfunction()
@@ -6,6 +6,7 @@
 #include "util.h"
 
 #include <neopad/renderer.h>
+#include <neopad/scene.h>
 
 GLFWwindow *setup_glfw(int width, int height, demo_state_t *state) {
     glfwSetErrorCallback(error_callback);
@@ -53,6 +54,37 @@ void teardown_glfw(GLFWwindow *window) {
     glfwTerminate();
 }
 
+/// Fill the scene with a large grid of shapes, far more than fit on screen at once.
+void populate_scene(neopad_scene_t scene) {
+    const int N = 200;
+    const float SPACING = 100.0f;
+
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            float x = SPACING * (float) (i - N / 2);
+            float y = SPACING * (float) (j - N / 2);
+            uint32_t color = 0x80000000 | (uint32_t) (i * 255 / N) << 16 | (uint32_t) (j * 255 / N);
+
+            neopad_scene_object_t object = {.color = color, .width = 4.0f};
+            switch ((i + j) % 3) {
+                case 0:
+                    object.kind = NEOPAD_SCENE_OBJECT_RECT;
+                    object.rect = (rect_t) {.min = {x - 20, y - 20}, .max = {x + 20, y + 20}};
+                    break;
+                case 1:
+                    object.kind = NEOPAD_SCENE_OBJECT_ELLIPSE;
+                    object.ellipse = (ellipse_t) {.center = {x, y}, .radii = {30, 20}};
+                    break;
+                default:
+                    object.kind = NEOPAD_SCENE_OBJECT_LINE;
+                    object.line = (line_t) {.start = {x - 30, y - 30}, .end = {x + 30, y + 30}};
+                    break;
+            }
+            neopad_scene_add(scene, object);
+        }
+    }
+}
+
 void setup_neopad(GLFWwindow *window) {
     demo_state_t *state = (demo_state_t *) glfwGetWindowUserPointer(window);
 
@@ -61,6 +93,8 @@ void setup_neopad(GLFWwindow *window) {
             .height = state->size.height,
             .content_scale = state->content_scale,
             .debug = true,
+            .threaded = true,
+            .tile_cache = true,
             .native_window_handle = demo_get_native_window_handle(window),
             .native_display_type = demo_get_native_display_type(window),
             .background = {
@@ -72,13 +106,21 @@ void setup_neopad(GLFWwindow *window) {
     };
 
     state->renderer = neopad_renderer_create();
-    neopad_renderer_await_frame(state->renderer, 0); // marks this as the render thread
-    neopad_renderer_init(state->renderer, init);  // marks this as the API thread
+    if (!neopad_renderer_init(state->renderer, init)) {  // this becomes the render thread
+        eprintf("Error: unable to initialize the renderer");
+        neopad_renderer_destroy(state->renderer);
+        exit(EXIT_FAILURE);
+    }
+
+    state->scene = neopad_scene_create();
+    populate_scene(state->scene);
 }
 
 void teardown_neopad(GLFWwindow *window) {
     demo_state_t *state = (demo_state_t *) glfwGetWindowUserPointer(window);
 
+    neopad_scene_destroy(state->scene);
+
     neopad_renderer_shutdown(state->renderer);
     neopad_renderer_destroy(state->renderer);
 }
@@ -119,12 +161,20 @@ void exit_fullscreen(GLFWwindow *window) {
 }
 
 void run(GLFWwindow *window) {
+    demo_state_t *state = (demo_state_t *) glfwGetWindowUserPointer(window);
     setup_neopad(window);
 
     while (!glfwWindowShouldClose(window)) {
         update(window);
-        draw(window);
-        glfwPollEvents();
+        if (neopad_renderer_needs_frame(state->renderer)) {
+            draw(window);
+            neopad_renderer_await_frame(state->renderer, 1);
+            glfwPollEvents();
+        } else {
+            // Nothing has changed: finish rendering any frame still in flight, then sleep until something does.
+            neopad_renderer_await_frame(state->renderer, 0);
+            glfwWaitEventsTimeout(1.0 / 60.0);
+        }
     }
 
     teardown_neopad(window);
@@ -157,14 +207,24 @@ void update(GLFWwindow *window) {
     }
 
     if (state->is_dirty.camera) {
-        neopad_renderer_set_camera(state->renderer, state->camera);
+        neopad_renderer_set_camera_d(state->renderer, state->camera);
         state->is_dirty.camera = false;
     }
 
     if (state->is_dirty.zoom) {
-        neopad_renderer_zoom(state->renderer, state->zoom.level);
+        if (state->zoom.has_anchor) {
+            neopad_renderer_zoom_at(state->renderer, state->zoom.level, state->zoom.anchor);
+            state->zoom.has_anchor = false;
+        } else {
+            neopad_renderer_zoom(state->renderer, state->zoom.level);
+        }
         state->is_dirty.zoom = false;
     }
+
+    if (state->is_dirty.flight) {
+        neopad_renderer_fly_to(state->renderer, state->camera, state->zoom.level, 0.0f);
+        state->is_dirty.flight = false;
+    }
 }
 
 void draw(GLFWwindow *window) {
@@ -175,10 +235,11 @@ void draw(GLFWwindow *window) {
     neopad_renderer_begin_frame(renderer);
     neopad_renderer_draw_background(renderer);
     neopad_renderer_draw_test_rect(renderer, -100, 100, 100, -100);
+    neopad_renderer_draw_scene(renderer, state->scene);
     neopad_renderer_end_frame(renderer);
 
     // Save the resulting camera position.
-    neopad_renderer_get_camera(renderer, &state->camera);
+    neopad_renderer_get_camera_d(renderer, &state->camera);
 }
 
 const int W = 1200;
@@ -189,8 +250,8 @@ int main() {
     memset(&state, 0, sizeof(demo_state_t));
 
     // Initialize the camera.
-    state.camera.x = 0.0f;
-    state.camera.y = 0.0f;
+    state.camera.x = 0.0;
+    state.camera.y = 0.0;
 
     state.zoom.level = 1.0f;
     state.zoom.min_level = 0.1f;
@@ -9,6 +9,7 @@
 #include <neopad/types.h>
 
 typedef struct neopad_renderer_s *neopad_renderer_t;
+typedef struct neopad_scene_s *neopad_scene_t;
 
 /** GLFW callbacks: demo_input.c */
 void error_callback(int error, const char *description);
@@ -27,6 +28,9 @@ void draw(GLFWwindow *window);
 typedef struct {
     neopad_renderer_t renderer;
 
+    /// Objects to show (culled to the view by the renderer).
+    neopad_scene_t scene;
+
     // Window size and content scale.
     neopad_ivec2_t size;
     float content_scale;
@@ -42,12 +46,13 @@ typedef struct {
             bool fullscreen;
             bool camera: 1;
             bool zoom: 1;
+            bool flight: 1;
         };
         uint8_t any;
     } is_dirty;
 
     /// Last known camera position.
-    neopad_vec2_t camera;
+    neopad_dvec2_t camera;
 
     /// Last known cursor details.
     struct {
@@ -71,9 +76,14 @@ typedef struct {
         /// Window coordinates of the drag end.
         neopad_vec2_t to;
         /// Initial camera position to offset from.
-        neopad_vec2_t from_camera;
+        neopad_dvec2_t from_camera;
     } drag;
 
+    struct {
+        /// Is the user drawing with the pen?
+        bool is_down;
+    } pen;
+
     struct {
         /// Is the user zooming?
         bool is_zooming;
@@ -81,6 +91,10 @@ typedef struct {
         /// Current zoom level.
         float level;
 
+        /// Point to zoom about, in world coordinates (such as under the cursor), if any.
+        bool has_anchor;
+        neopad_dvec2_t anchor;
+
         // Maximum and minimum (config).
         float max_level;
         float min_level;
@@ -19,12 +19,11 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
                 glfwSetWindowShouldClose(window, GLFW_TRUE);
                 break;
             case GLFW_KEY_SPACE:
+                // Fly back home.
                 state->camera.x = 0;
                 state->camera.y = 0;
-                state->is_dirty.camera = true;
-
                 state->zoom.level = 1;
-                state->is_dirty.zoom = true;
+                state->is_dirty.flight = true;
                 break;
             case GLFW_KEY_1:
             case GLFW_KEY_2:
@@ -61,10 +60,8 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
                 }
 
                 state->camera.x = state->camera.y = 0;
-                state->is_dirty.camera = true;
-
                 state->zoom.level = zoom;
-                state->is_dirty.zoom = true;
+                state->is_dirty.flight = true;
 
                 break;
             }
@@ -98,10 +95,27 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
             neopad_renderer_window_to_screen(state->renderer, viewport, cursor_pos, &state->drag.from);
 
             // Save the starting camera position.
-            neopad_renderer_get_camera(state->renderer, &state->drag.from_camera);
+            neopad_renderer_get_camera_d(state->renderer, &state->drag.from_camera);
         } else if (action == GLFW_RELEASE) {
             state->cursor.is_down = false;
         }
+    } else if (button == GLFW_MOUSE_BUTTON_RIGHT) {
+        if (action == GLFW_PRESS) {
+            state->pen.is_down = true;
+
+            neopad_vec4_t viewport;
+            get_viewport(window, &viewport);
+
+            neopad_vec2_t cursor_pos;
+            get_cursor_pos(window, &cursor_pos);
+
+            neopad_dvec2_t world_pos;
+            neopad_renderer_window_to_world_d(state->renderer, viewport, cursor_pos, &world_pos);
+            neopad_renderer_begin_points_d(state->renderer, world_pos);
+        } else if (action == GLFW_RELEASE) {
+            state->pen.is_down = false;
+            neopad_renderer_end_points(state->renderer);
+        }
     }
 }
 
@@ -120,9 +134,22 @@ void cursor_position_callback(GLFWwindow *window, double x, double y) {
 
         vec2 drag_delta; // in screen coords
         glm_vec2_sub(state->drag.to.vec, state->drag.from.vec, drag_delta);
-        glm_vec2_add(state->drag.from_camera.vec, drag_delta, state->camera.vec);
+        state->camera.x = state->drag.from_camera.x + drag_delta[0];
+        state->camera.y = state->drag.from_camera.y + drag_delta[1];
         state->is_dirty.camera = true;
     }
+
+    if (state->pen.is_down) {
+        neopad_vec4_t viewport;
+        get_viewport(window, &viewport);
+
+        neopad_vec2_t cursor_pos;
+        get_cursor_pos(window, &cursor_pos);
+
+        neopad_dvec2_t world_pos;
+        neopad_renderer_window_to_world_d(state->renderer, viewport, cursor_pos, &world_pos);
+        neopad_renderer_pen_add_point_d(state->renderer, world_pos);
+    }
 }
 
 void scroll_callback(GLFWwindow *window, double x_offset, double y_offset) {
@@ -139,6 +166,16 @@ void scroll_callback(GLFWwindow *window, double x_offset, double y_offset) {
     // Clamp the zoom level within the min/max.
     zoom = glm_clamp(zoom, state->zoom.min_level, state->zoom.max_level);
 
+    // Zoom about whatever is under the cursor.
+    neopad_vec4_t viewport;
+    get_viewport(window, &viewport);
+
+    neopad_vec2_t cursor_pos;
+    get_cursor_pos(window, &cursor_pos);
+
+    neopad_renderer_window_to_world_d(state->renderer, viewport, cursor_pos, &state->zoom.anchor);
+    state->zoom.has_anchor = true;
+
     state->zoom.level = zoom;
     state->is_dirty.zoom = true;
 }
@@ -0,0 +1,113 @@
+//
+// Created by Dylan Lukes on 8/22/23.
+//
+
+#ifndef NEOPAD_PROFILE_H
+#define NEOPAD_PROFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <neopad/renderer.h>
+
+#pragma mark - Types
+
+/// Number of recent frames kept by the profiler.
+#define NEOPAD_PROFILE_FRAMES 128
+
+/// Most modules reported on per frame.
+#define NEOPAD_PROFILE_MAX_MODULES 16
+
+/// Phases of a frame that modules take part in.
+typedef enum neopad_profile_phase_e {
+    NEOPAD_PROFILE_PHASE_BEGIN_FRAME,
+    NEOPAD_PROFILE_PHASE_RENDER,
+    NEOPAD_PROFILE_PHASE_END_FRAME,
+    NEOPAD_PROFILE_PHASE_COUNT,
+} neopad_profile_phase_t;
+
+/// Work done (and avoided) during a frame.
+typedef struct neopad_profile_counters_s {
+    /// Draw calls submitted.
+    uint32_t draw_calls;
+
+    /// Vertices and indices drawn.
+    uint32_t vertices;
+    uint32_t indices;
+
+    /// Bytes of transient (per-frame) vertex and index data.
+    uint64_t transient_bytes;
+
+    /// Objects (or chunks of them) drawn, and those culled.
+    uint32_t visible;
+    uint32_t culled;
+} neopad_profile_counters_t;
+
+/// A module's part in a frame.
+typedef struct neopad_profile_module_s {
+    const char *name;
+
+    /// When each phase started, in milliseconds since the renderer was initialized.
+    double start_ms[NEOPAD_PROFILE_PHASE_COUNT];
+
+    /// Time spent in each phase, in milliseconds. Zero if the module skipped the phase.
+    double duration_ms[NEOPAD_PROFILE_PHASE_COUNT];
+
+    neopad_profile_counters_t counters;
+} neopad_profile_module_t;
+
+/// A profiled frame.
+typedef struct neopad_profile_frame_s {
+    /// Frame number, counting from the first frame profiled.
+    uint64_t index;
+
+    /// When the frame began, in milliseconds since the renderer was initialized.
+    double start_ms;
+
+    /// CPU time from the beginning of the frame to its submission, in milliseconds.
+    double cpu_ms;
+
+    /// Time spent submitting the frame (in bgfx_frame), in milliseconds.
+    double submit_ms;
+
+    /// GPU time of the frame, as reported by bgfx, in milliseconds (when available).
+    double gpu_ms;
+
+    uint32_t module_count;
+    neopad_profile_module_t modules[NEOPAD_PROFILE_MAX_MODULES];
+
+    /// Sum of all modules' counters.
+    neopad_profile_counters_t totals;
+} neopad_profile_frame_t;
+
+/// Formats the profile can be written out in.
+typedef enum neopad_profile_format_e {
+    /// A JSON array of frames, as in neopad_profile_frame_t.
+    NEOPAD_PROFILE_FORMAT_JSON,
+    /// Chrome's Trace Event Format (for chrome://tracing, or Perfetto).
+    NEOPAD_PROFILE_FORMAT_CHROME_TRACE,
+} neopad_profile_format_t;
+
+#pragma mark - Profiling
+
+/// Turn profiling on or off.
+/// @note Off by default. Turning it on starts over with no frames recorded.
+/// @note Threaded renderers record frames on their API thread (from the next frame played back).
+void neopad_renderer_set_profiling(neopad_renderer_t this, bool enabled);
+
+/// The number of frames recorded (up to NEOPAD_PROFILE_FRAMES).
+size_t neopad_renderer_get_profile_frame_count(neopad_renderer_const_t this);
+
+/// Get a recorded frame.
+/// @param age How many frames ago: 0 is the most recently ended frame.
+/// @return The frame, or NULL if there is no such frame recorded.
+/// @note For threaded renderers, a copy (as the API thread records frames), valid until the next call.
+const neopad_profile_frame_t *neopad_renderer_get_profile_frame(neopad_renderer_const_t this, size_t age);
+
+/// Write out all recorded frames, oldest first.
+/// @return Whether the profile was written successfully.
+bool neopad_renderer_dump_profile(neopad_renderer_const_t this, FILE *file, neopad_profile_format_t format);
+
+#endif //NEOPAD_PROFILE_H
@@ -6,9 +6,11 @@
 #define NEOPAD_RENDERER_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <neopad/types.h>
+#include <neopad/object.h>
 
 #pragma mark - Types
 
@@ -21,6 +23,47 @@ typedef struct neopad_renderer_s *neopad_renderer_t;
 /// @todo Make this actually const. Currently blocked by cglm's lack of const qualifiers.
 typedef /*const*/ struct neopad_renderer_s *neopad_renderer_const_t;
 
+/// A scene (see neopad/scene.h).
+typedef struct neopad_scene_s *neopad_scene_t;
+
+/// How consecutive segments of a stroke are joined.
+typedef enum neopad_stroke_join_e {
+    /// Sharp corners, falling back to bevel past the miter limit.
+    NEOPAD_STROKE_JOIN_MITER,
+    /// Corners cut off flat.
+    NEOPAD_STROKE_JOIN_BEVEL,
+    /// Rounded corners.
+    NEOPAD_STROKE_JOIN_ROUND,
+} neopad_stroke_join_t;
+
+/// How the ends of a stroke are capped.
+typedef enum neopad_stroke_cap_e {
+    /// Flat, ending exactly at the end point.
+    NEOPAD_STROKE_CAP_BUTT,
+    /// Flat, extended past the end point by half the width.
+    NEOPAD_STROKE_CAP_SQUARE,
+    /// Half-disc centered on the end point.
+    NEOPAD_STROKE_CAP_ROUND,
+} neopad_stroke_cap_t;
+
+/// Appearance of a stroke.
+typedef struct neopad_stroke_style_s {
+    /// Width of the stroke, in pad-world units.
+    float width;
+
+    /// Color of the stroke (0xAABBGGRR, see neopad_color_t).
+    uint32_t color;
+
+    /// Join between segments.
+    neopad_stroke_join_t join;
+
+    /// Cap at both ends.
+    neopad_stroke_cap_t cap;
+
+    /// Maximum ratio of miter length to half the width before a miter join becomes a bevel.
+    float miter_limit;
+} neopad_stroke_style_t;
+
 /// Initialization parameters for a renderer.
 typedef struct neopad_renderer_init_s {
     /// The name of the renderer.
@@ -38,6 +81,46 @@ typedef struct neopad_renderer_init_s {
     /// Enable debug mode.
     bool debug;
 
+    /// Run without a window (or a GPU), on bgfx's Noop backend. Frames go through the whole pipeline,
+    /// modules and CPU-side geometry included, but nothing is displayed.
+    /// @note For benchmarks and tests on build machines. The native handles are ignored.
+    bool headless;
+
+    /// Run the renderer's API thread (tessellation and bgfx submission) separately from the application.
+    /// @note Calls made on the application thread are recorded, and played back on the API thread,
+    ///       so they do not wait on the frame being submitted. The application thread renders: call
+    ///       neopad_renderer_await_frame there, once per frame.
+    /// @note Coordinate conversions and getters see the view as of the last frame played back.
+    /// @note A scene passed to neopad_renderer_draw_scene is free to change as soon as it returns.
+    bool threaded;
+
+    /// Rasterize finished strokes into tiles (offscreen, at a few zoom levels), and composite those,
+    /// rather than drawing the strokes themselves every frame.
+    /// @note Cheaper for drawings with many strokes, at the cost of some memory (up to 32 MiB), and
+    ///       of some sharpness between zoom levels.
+    bool tile_cache;
+
+    /// Redraw only the part of the back buffer that changed, when nothing but strokes (or areas
+    /// invalidated with neopad_renderer_invalidate_rect) did, by scissoring the back buffer's views.
+    /// @note Only correct where the back buffer keeps its contents from one frame to the next
+    ///       (not, in general, with a swap chain).
+    bool partial_redraw;
+
+    /// Worker threads that per-frame work (such as building the scene's instances) is spread across,
+    /// besides the thread drawing. 0 for one per core, less one.
+    /// @note Renderers sharing bgfx share these, as started by the first.
+    uint32_t worker_threads;
+
+    /// Another (initialized) renderer to share bgfx with: its programs and vertex layouts, and the
+    /// strokes finished in either. This renderer draws into its own window, by native_window_handle
+    /// (or, headless, into a framebuffer of its own), with a canvas, camera and zoom of its own.
+    /// @note Neither renderer can be threaded.
+    /// @note The renderer shared with submits every window's frame: render this renderer's frames
+    ///       (one renderer's frame at a time) before its own. Shut down first, it hands the strokes
+    ///       and submitting to a renderer still sharing (whose frames then go last), and bgfx stays
+    ///       up, with its window, until the last of them shuts down.
+    neopad_renderer_t share;
+
     /// The native window handle.
     void *native_window_handle;
 
@@ -62,7 +145,11 @@ neopad_renderer_t neopad_renderer_create();
 void neopad_renderer_destroy(neopad_renderer_t this);
 
 /// Initialize the renderer. Call this on the thread that will be calling neopad_ functions.
-void neopad_renderer_init(neopad_renderer_t this, neopad_renderer_init_t init);
+/// @note Headless renderers always render on their API thread (this one, unless threaded); there is
+///       no need to call await_frame.
+/// @note Threaded renderers mark this thread as the render thread themselves.
+/// @return Whether the renderer was initialized. If not, destroy it (without shutting it down).
+bool neopad_renderer_init(neopad_renderer_t this, neopad_renderer_init_t init);
 
 /// Shutdown the renderer. Call this on the thread that called neopad_renderer_init().
 void neopad_renderer_shutdown(neopad_renderer_t this);
@@ -88,6 +175,26 @@ void neopad_renderer_begin_frame(neopad_renderer_t this);
 /// @note This MUST be called on the API thread.
 void neopad_renderer_end_frame(neopad_renderer_t this);
 
+/// Whether a frame is needed: whether anything has changed since the last frame ended. That is,
+/// the size, scale, camera or zoom (including while they move toward their targets), strokes, the
+/// last scene drawn, or areas invalidated; threaded, frames still in flight count too.
+/// @note Skip frames (begin_frame through end_frame) while this is false: they would be the same.
+/// @note The last scene drawn is checked for changes, so it must outlive the calls made after it
+///       is drawn, until a frame is drawn without it.
+bool neopad_renderer_needs_frame(neopad_renderer_const_t this);
+
+/// Get the area of the world that has changed since the last frame ended.
+/// @param dst The output rect, in world coordinates: the view if everything has changed, or empty
+///            if nothing has.
+void neopad_renderer_get_dirty_rect(neopad_renderer_const_t this, rect_t *dst);
+
+/// Have the next frame redraw everything.
+void neopad_renderer_invalidate(neopad_renderer_t this);
+
+/// Have the next frame redraw an area, for changes the renderer does not see for itself.
+/// @param area The area, in world coordinates.
+void neopad_renderer_invalidate_rect(neopad_renderer_t this, rect_t area);
+
 #pragma mark - Coordinate Transformations
 
 /// Convert a point from window coordinates to world coordinates.
@@ -96,6 +203,22 @@ void neopad_renderer_end_frame(neopad_renderer_t this);
 /// @param q The output point in world coordinates.
 void neopad_renderer_window_to_world(neopad_renderer_const_t this, neopad_vec4_t viewport, neopad_vec2_t p, neopad_vec2_t *q);
 
+/// Convert a point from window coordinates to world coordinates, in double precision.
+/// @param viewport The viewport of the window (left, top, right, bottom).
+/// @param p The input point in window coordinates.
+/// @param q The output point in world coordinates.
+void neopad_renderer_window_to_world_d(neopad_renderer_const_t this, neopad_vec4_t viewport, neopad_vec2_t p, neopad_dvec2_t *q);
+
+/// Convert many points from window coordinates to world coordinates, in double precision.
+/// @note Cheaper per point than neopad_renderer_window_to_world_d: use it for batches of input
+///       (e.g. a packet of stylus samples).
+/// @param viewport The viewport of the window (left, top, right, bottom).
+/// @param p The input points in window coordinates.
+/// @param q The output points in world coordinates.
+/// @param count The number of points.
+void neopad_renderer_window_to_world_n(neopad_renderer_const_t this, neopad_vec4_t viewport,
+                                       const neopad_vec2_t *p, neopad_dvec2_t *q, size_t count);
+
 /// Convert a point from screen coordinates to world coordinates.
 /// @note This differs from the window-to-world transformation in that it takes the camera position into account.
 ///       This is important for the camera controls, where we want to avoid a feedback loop.
@@ -104,6 +227,10 @@ void neopad_renderer_window_to_world(neopad_renderer_const_t this, neopad_vec4_t
 /// @param q The output point in screen coordinates.
 void neopad_renderer_window_to_screen(neopad_renderer_const_t this, neopad_vec4_t viewport, neopad_vec2_t p, neopad_vec2_t *q);
 
+/// Get the area of the world that is visible, as of the last frame ended.
+/// @param dst The output rect, in world coordinates.
+void neopad_renderer_get_view_rect(neopad_renderer_const_t this, rect_t *dst);
+
 
 #pragma mark - Manipulation
 
@@ -125,6 +252,18 @@ void neopad_renderer_zoom(neopad_renderer_t this, float zoom);
 /// @return The current zoom.
 float neopad_renderer_arrest_zoom(neopad_renderer_t this);
 
+/// Set the zoom of the renderer, about a point that stays where it is on screen meanwhile
+/// (such as the cursor, zooming with the scroll wheel).
+/// @note The anchor is in world coordinates.
+/// @note Takes effect on the next frame rendered.
+void neopad_renderer_zoom_at(neopad_renderer_t this, float zoom, neopad_dvec2_t anchor);
+
+/// Fly to a camera and zoom, zooming out on the way as much as it takes to keep both ends in
+/// sight (as for following a portal). Setting the camera or zoom otherwise cuts the flight short.
+/// @note The camera is in world coordinates, as for neopad_renderer_set_camera_d.
+/// @param duration In seconds, or 0 for one in proportion to the distance (zooming included).
+void neopad_renderer_fly_to(neopad_renderer_t this, neopad_dvec2_t camera, float zoom, float duration);
+
 /// Reposition the viewport of the renderer.
 /// @note In world coordinates.
 /// @note Takes effect from the start of the next begun frame.
@@ -135,14 +274,35 @@ void neopad_renderer_get_camera(neopad_renderer_const_t this, neopad_vec2_t *dst
 /// @note Takes effect from the start of the next begun frame.
 void neopad_renderer_set_camera(neopad_renderer_t this, neopad_vec2_t src);
 
+/// Get the camera of the renderer, in double precision.
+/// @note In world coordinates.
+void neopad_renderer_get_camera_d(neopad_renderer_const_t this, neopad_dvec2_t *dst);
+
+/// Reposition the viewport of the renderer, in double precision.
+/// @note In world coordinates.
+/// @note Takes effect from the start of the next begun frame.
+void neopad_renderer_set_camera_d(neopad_renderer_t this, neopad_dvec2_t src);
+
 #pragma mark - Drawing
 
 void neopad_renderer_draw_background(neopad_renderer_t this);
 void neopad_renderer_draw_cursor(neopad_renderer_t this, vec2 p);
 void neopad_renderer_draw_test_rect(neopad_renderer_t this, float l, float t, float r, float b);
 
+/// Draw the visible objects of a scene this frame.
+/// @note Objects are culled against the view when the frame ends, so only those in view are drawn.
+/// @note Like the background, this must be called every frame the scene should be drawn.
+/// @param this The renderer.
+/// @param scene The scene. It must outlive the frame.
+void neopad_renderer_draw_scene(neopad_renderer_t this, neopad_scene_t scene);
+
 #pragma mark - Line Drawing
 
+/// Set the style used for strokes begun from now on.
+/// @param this The renderer.
+/// @param style The stroke style.
+void neopad_renderer_set_stroke_style(neopad_renderer_t this, neopad_stroke_style_t style);
+
 /// Begin a series of points.
 /// @param this The renderer.
 /// @param p The first point.
@@ -153,7 +313,18 @@ void neopad_renderer_begin_points(neopad_renderer_t this, vec2 p);
 /// @param p The point to add.
 void neopad_renderer_pen_add_point(neopad_renderer_t this, vec2 p);
 
+/// Begin a series of points, in double precision.
+/// @param this The renderer.
+/// @param p The first point.
+void neopad_renderer_begin_points_d(neopad_renderer_t this, neopad_dvec2_t p);
+
+/// Add a point to the current series, in double precision.
+/// @param this The renderer.
+/// @param p The point to add.
+void neopad_renderer_pen_add_point_d(neopad_renderer_t this, neopad_dvec2_t p);
+
 /// End a series of points.
+/// @note The finished stroke is kept by the renderer, and drawn every frame from then on.
 /// @param this The renderer.
 void neopad_renderer_end_points(neopad_renderer_t this);
 
@@ -0,0 +1,93 @@
+//
+// Created by Dylan Lukes on 8/21/23.
+//
+
+#ifndef NEOPAD_SCENE_H
+#define NEOPAD_SCENE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <neopad/object.h>
+
+#pragma mark - Types
+
+/// A scene: a collection of objects, indexed by where they are.
+/// @note This is an opaque type.
+typedef struct neopad_scene_s *neopad_scene_t;
+
+/// Identifies an object within a scene.
+typedef uint32_t neopad_scene_id_t;
+
+/// No object.
+#define NEOPAD_SCENE_ID_NONE UINT32_MAX
+
+/// Kinds of scene object.
+typedef enum neopad_scene_object_kind_e {
+    NEOPAD_SCENE_OBJECT_LINE,
+    NEOPAD_SCENE_OBJECT_RECT,
+    NEOPAD_SCENE_OBJECT_ELLIPSE,
+} neopad_scene_object_kind_t;
+
+/// An object in a scene.
+typedef struct neopad_scene_object_s {
+    neopad_scene_object_kind_t kind;
+
+    /// Geometry, in pad-world coordinates.
+    union {
+        line_t line;
+        rect_t rect;
+        ellipse_t ellipse;
+    };
+
+    /// Color (0xAABBGGRR, see neopad_color_t).
+    uint32_t color;
+
+    /// Width of a line, in pad-world units. Lines have round caps (reaching half this past each end).
+    /// @note Rects and ellipses are filled, and ignore this.
+    float width;
+} neopad_scene_object_t;
+
+#pragma mark - Lifecycle
+
+/// Create an empty scene.
+neopad_scene_t neopad_scene_create();
+
+/// Destroy a scene, and all objects in it.
+void neopad_scene_destroy(neopad_scene_t this);
+
+#pragma mark - Objects
+
+/// Add an object to the scene.
+/// @return The id of the new object.
+neopad_scene_id_t neopad_scene_add(neopad_scene_t this, neopad_scene_object_t object);
+
+/// Replace an object in the scene (e.g. to move it).
+void neopad_scene_set(neopad_scene_t this, neopad_scene_id_t id, neopad_scene_object_t object);
+
+/// Remove an object from the scene.
+/// @note Its id may be reused by objects added later.
+void neopad_scene_remove(neopad_scene_t this, neopad_scene_id_t id);
+
+/// Look up an object in the scene.
+/// @return The object, or NULL if there is no such object.
+/// @note The pointer is invalidated by adding or removing objects.
+const neopad_scene_object_t *neopad_scene_get(neopad_scene_t this, neopad_scene_id_t id);
+
+/// The number of objects in the scene.
+size_t neopad_scene_count(neopad_scene_t this);
+
+/// Bounds of an object, in pad-world coordinates.
+void neopad_scene_object_bounds(const neopad_scene_object_t *object, rect_t *dst);
+
+#pragma mark - Queries
+
+/// Find the objects which intersect an area (by their bounds).
+/// @param area The area, in pad-world coordinates.
+/// @param ids Output ids, in the order their objects were added (each drawn over those before it).
+///            May be NULL if capacity is 0.
+/// @param capacity The number of ids that fit in `ids`. Any further ids are not written.
+/// @return The number of objects found, which may be more than capacity.
+size_t neopad_scene_query(neopad_scene_t this, rect_t area, neopad_scene_id_t *ids, size_t capacity);
+
+#endif //NEOPAD_SCENE_H
@@ -98,6 +98,13 @@ NEOPAD_VEC_TYPE_DECL(float, vec, 4);
 //    __scalar height;                               \
 //};)                                                \
 
+/// A double-precision 2D vector.
+/// @note Used for pad-world positions, which must hold up however far out (or deep in) they are.
+typedef struct {
+    double x;
+    double y;
+} neopad_dvec2_t;
+
 typedef union {
     uint32_t abgr;
     struct {
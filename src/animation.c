@@ -0,0 +1,200 @@
+//
+// Created by Dylan Lukes on 8/28/23.
+//
+
+#include <math.h>
+#include <memory.h>
+
+#include "neopad/internal/animation.h"
+
+/// How much flights zoom out rather than pan: √2, as van Wijk and Nuij recommend.
+#define FLIGHT_RHO 1.4142135623730951
+
+/// Seconds of flight per unit of path length, and the bounds on a flight's duration, by default.
+#define FLIGHT_SECONDS_PER_LENGTH 0.5
+#define FLIGHT_MIN_SECONDS 0.25
+#define FLIGHT_MAX_SECONDS 2.5
+
+#pragma mark - Channels
+
+void neopad_animator_init(neopad_animator_t *this) {
+    memset(this, 0, sizeof(neopad_animator_t));
+}
+
+neopad_animation_id_t neopad_animator_add(neopad_animator_t *this,
+                                          neopad_animation_kind_t kind,
+                                          double value,
+                                          double rate,
+                                          double precision) {
+    if (this->used == UINT64_MAX) {
+        return NEOPAD_ANIMATION_NONE;
+    }
+
+    neopad_animation_id_t id = 0;
+    while (this->used & (UINT64_C(1) << id)) {
+        id++;
+    }
+
+    this->value[id] = value;
+    this->velocity[id] = 0.0;
+    this->target[id] = value;
+    this->rate[id] = rate;
+    this->precision[id] = precision;
+    this->kind[id] = kind;
+    this->used |= UINT64_C(1) << id;
+    return id;
+}
+
+void neopad_animator_remove(neopad_animator_t *this, neopad_animation_id_t id) {
+    this->used &= ~(UINT64_C(1) << id);
+    this->moving &= ~(UINT64_C(1) << id);
+}
+
+void neopad_animator_set_target(neopad_animator_t *this, neopad_animation_id_t id, double target) {
+    this->target[id] = target;
+    if (this->value[id] != target || this->velocity[id] != 0.0) {
+        this->moving |= UINT64_C(1) << id;
+    }
+}
+
+void neopad_animator_set_value(neopad_animator_t *this, neopad_animation_id_t id, double value) {
+    this->value[id] = value;
+    this->target[id] = value;
+    this->velocity[id] = 0.0;
+    this->moving &= ~(UINT64_C(1) << id);
+}
+
+void neopad_animator_set_precision(neopad_animator_t *this, neopad_animation_id_t id, double precision) {
+    this->precision[id] = precision;
+}
+
+void neopad_animator_update(neopad_animator_t *this, double dt) {
+    for (uint64_t moving = this->moving; moving != 0; moving &= moving - 1) {
+        int id = __builtin_ctzll(moving);
+
+        double x = this->value[id] - this->target[id];
+        double v = this->velocity[id];
+        double w = this->rate[id];
+        double decay = exp(-w * dt);
+
+        // Exact solutions, so any step (however long) lands where the motion would be.
+        switch (this->kind[id]) {
+            case NEOPAD_ANIMATION_SPRING: {
+                double c = v + w * x;
+                x = (x + c * dt) * decay;
+                v = (v - w * c * dt) * decay;
+                break;
+            }
+            case NEOPAD_ANIMATION_DECAY:
+                x *= decay;
+                v = 0.0;
+                break;
+        }
+
+        // At rest once near enough, and slow enough not to get any further.
+        if (fabs(x) < this->precision[id] && fabs(v) < this->precision[id] * w) {
+            this->value[id] = this->target[id];
+            this->velocity[id] = 0.0;
+            this->moving &= ~(UINT64_C(1) << id);
+        } else {
+            this->value[id] = this->target[id] + x;
+            this->velocity[id] = v;
+        }
+    }
+}
+
+#pragma mark - Flights
+
+static double distance(neopad_dvec2_t a, neopad_dvec2_t b) {
+    return hypot(b.x - a.x, b.y - a.y);
+}
+
+/// Whether a flight only zooms (its ends are, near enough, in the same place).
+static bool is_zoom_only(const neopad_flight_t *this) {
+    return distance(this->from, this->to) < 1e-9 * fmax(this->from_width, this->to_width);
+}
+
+/// The view at a distance `s` along a flight's path.
+static void flight_at(const neopad_flight_t *this, double s, neopad_dvec2_t *center, double *width) {
+    double w0 = this->from_width;
+    double u1 = distance(this->from, this->to);
+    double u;
+
+    if (is_zoom_only(this)) {
+        double k = this->to_width < w0 ? -1.0 : 1.0;
+        *width = w0 * exp(k * FLIGHT_RHO * s);
+        u = this->length > 0.0 ? u1 * s / this->length : u1;
+    } else {
+        double rho2 = FLIGHT_RHO * FLIGHT_RHO;
+        double r = FLIGHT_RHO * s + this->r0;
+        // cosh(r0) tanh(r) - sinh(r0), without the cancellation when the pan is small next to the widths.
+        u = w0 / rho2 * sinh(r - this->r0) / cosh(r);
+        *width = w0 * cosh(this->r0) / cosh(r);
+    }
+
+    double t = u1 > 0.0 ? u / u1 : 1.0;
+    center->x = this->from.x + (this->to.x - this->from.x) * t;
+    center->y = this->from.y + (this->to.y - this->from.y) * t;
+}
+
+void neopad_flight_begin(neopad_flight_t *this,
+                         neopad_dvec2_t from, double from_width,
+                         neopad_dvec2_t to, double to_width,
+                         double duration) {
+    *this = (neopad_flight_t) {
+            .is_active = true,
+            .from = from,
+            .to = to,
+            .from_width = from_width,
+            .to_width = to_width,
+    };
+
+    double w0 = from_width;
+    double w1 = to_width;
+    if (is_zoom_only(this)) {
+        this->length = fabs(log(w1 / w0)) / FLIGHT_RHO;
+    } else {
+        double u1 = distance(from, to);
+        double rho2 = FLIGHT_RHO * FLIGHT_RHO;
+        double rho4 = rho2 * rho2;
+        double b0 = (w1 * w1 - w0 * w0 + rho4 * u1 * u1) / (2.0 * w0 * rho2 * u1);
+        double b1 = (w1 * w1 - w0 * w0 - rho4 * u1 * u1) / (2.0 * w1 * rho2 * u1);
+        // log(-b + sqrt(b^2 + 1)), which cancels (to -inf) for large b: a small pan next to the widths.
+        this->r0 = -asinh(b0);
+        double r1 = -asinh(b1);
+        this->length = (r1 - this->r0) / FLIGHT_RHO;
+    }
+
+    this->duration = duration > 0.0
+                     ? duration
+                     : fmin(fmax(this->length * FLIGHT_SECONDS_PER_LENGTH, FLIGHT_MIN_SECONDS), FLIGHT_MAX_SECONDS);
+}
+
+bool neopad_flight_update(neopad_flight_t *this, double dt, neopad_dvec2_t *center, double *width) {
+    this->elapsed += dt;
+    if (this->elapsed >= this->duration || this->length <= 0.0) {
+        this->is_active = false;
+        *center = this->to;
+        *width = this->to_width;
+        return false;
+    }
+
+    // Eased in and out, along the path.
+    double t = this->elapsed / this->duration;
+    flight_at(this, this->length * t * t * (3.0 - 2.0 * t), center, width);
+    return true;
+}
+
+void neopad_flight_peak(const neopad_flight_t *this, neopad_dvec2_t *center, double *width) {
+    // The path is widest where cosh(rho s + r0) is least: at s = -r0 / rho, if that is on it.
+    double s = -this->r0 / FLIGHT_RHO;
+    if (!is_zoom_only(this) && s > 0.0 && s < this->length) {
+        flight_at(this, s, center, width);
+    } else if (this->from_width > this->to_width) {
+        *center = this->from;
+        *width = this->from_width;
+    } else {
+        *center = this->to;
+        *width = this->to_width;
+    }
+}
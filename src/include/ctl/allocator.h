@@ -0,0 +1,314 @@
+/* Allocators for containers: a bump arena, and a pool of fixed-size blocks.
+   SPDX-License-Identifier: MIT
+
+   Containers take their memory from the heap unless given a ctl_allocator
+   (see <ctl/ctl.h>) with their set_allocator, while they are still empty:
+
+     ctl_arena arena;
+     ctl_arena_init(&arena, 0);
+
+     vec_uint32_t scratch = vec_uint32_t_init();
+     vec_uint32_t_set_allocator(&scratch, ctl_arena_allocator(&arena));
+     ...
+     ctl_arena_reset(&arena); // scratch's memory is gone: re-init it to use it again
+
+   ctl_arena hands out memory by bumping an offset through large chunks.
+   Freeing does nothing (beyond giving back the last allocation), and reset
+   takes everything back at once, keeping the chunks for next time: for
+   scratch that all dies together, such as per-frame work. Growing the last
+   allocation happens in place, so a single vector grows without copying.
+
+   ctl_pool hands out blocks of one size, from a free list, refilled from an
+   arena. It suits node-based containers (list, set, map, uset, umap), whose
+   nodes are all the same size (sizeof(set_int_node) and so on): they stop
+   fragmenting the heap, and freeing a node makes room for the next. Larger
+   allocations (such as uset's buckets) go to its fallback allocator.
+
+   Both keep a ctl_allocator inside themselves, so must not be moved (or
+   copied) once initialized. Neither is thread-safe.
+
+   Tunable policies:
+
+   - CTL_ARENA_CHUNK_SIZE: default bytes per arena chunk. Defaults to 64KiB.
+   - CTL_POOL_CHUNK_BLOCKS: blocks per chunk of a pool. Defaults to 256.
+*/
+
+#ifndef __CTL_ALLOCATOR_H__
+#define __CTL_ALLOCATOR_H__
+
+#include <ctl/ctl.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef CTL_ARENA_CHUNK_SIZE
+#define CTL_ARENA_CHUNK_SIZE (64 * 1024)
+#endif
+
+#ifndef CTL_POOL_CHUNK_BLOCKS
+#define CTL_POOL_CHUNK_BLOCKS 256
+#endif
+
+// Everything handed out is aligned for any type.
+#define CTL_ALLOCATOR_ALIGN _Alignof(max_align_t)
+#define CTL_ALLOCATOR_ROUND(size) (((size) + CTL_ALLOCATOR_ALIGN - 1) & ~(size_t)(CTL_ALLOCATOR_ALIGN - 1))
+
+/* Arena */
+
+typedef struct ctl_arena_chunk
+{
+    struct ctl_arena_chunk *next;
+    size_t size; // usable bytes, after the header
+} ctl_arena_chunk;
+
+#define CTL_ARENA_HEADER CTL_ALLOCATOR_ROUND(sizeof(ctl_arena_chunk))
+
+typedef struct ctl_arena
+{
+    // Chunks in the order they are used; those after current are free (since the last reset).
+    ctl_arena_chunk *first;
+    ctl_arena_chunk *current;
+    size_t used;       // bytes of current handed out
+    size_t chunk_size; // for new chunks (unless an allocation needs more)
+    void *last;        // the last allocation, which can still grow, or be given back
+    size_t allocated;  // bytes handed out since the last reset
+    ctl_allocator allocator;
+} ctl_arena;
+
+static inline char *ctl_arena_chunk_data(ctl_arena_chunk *chunk)
+{
+    return (char *)chunk + CTL_ARENA_HEADER;
+}
+
+// makes current a chunk with room for size bytes: the next one if it fits, else a new one.
+static inline bool ctl_arena_next_chunk(ctl_arena *self, size_t size)
+{
+    ctl_arena_chunk *next = self->current ? self->current->next : self->first;
+    if (!next || next->size < size)
+    {
+        size_t chunk_size = size > self->chunk_size ? size : self->chunk_size;
+        ctl_arena_chunk *chunk = (ctl_arena_chunk *)malloc(CTL_ARENA_HEADER + chunk_size);
+        if (!chunk)
+            return false;
+        chunk->size = chunk_size;
+        chunk->next = next;
+        if (self->current)
+            self->current->next = chunk;
+        else
+            self->first = chunk;
+        next = chunk;
+    }
+    self->current = next;
+    self->used = 0;
+    return true;
+}
+
+static inline void *ctl_arena_alloc(ctl_arena *self, size_t size)
+{
+    size = CTL_ALLOCATOR_ROUND(size ? size : 1);
+    if (!self->current || self->current->size - self->used < size)
+        if (!ctl_arena_next_chunk(self, size))
+            return NULL;
+    void *ptr = ctl_arena_chunk_data(self->current) + self->used;
+    self->used += size;
+    self->allocated += size;
+    self->last = ptr;
+    return ptr;
+}
+
+// grows (or shrinks) the last allocation in place if it can, else copies.
+static inline void *ctl_arena_realloc(ctl_arena *self, void *ptr, size_t old_size, size_t size)
+{
+    if (ptr && ptr == self->last)
+    {
+        size_t offset = (size_t)((char *)ptr - ctl_arena_chunk_data(self->current));
+        size_t rounded = CTL_ALLOCATOR_ROUND(size ? size : 1);
+        if (offset + rounded <= self->current->size)
+        {
+            self->allocated += rounded;
+            self->allocated -= self->used - offset;
+            self->used = offset + rounded;
+            return ptr;
+        }
+    }
+    else if (ptr && size <= old_size)
+        return ptr;
+    void *moved = ctl_arena_alloc(self, size);
+    if (moved && ptr)
+        memcpy(moved, ptr, old_size < size ? old_size : size);
+    return moved;
+}
+
+// gives back the last allocation; any other stays until the next reset.
+static inline void ctl_arena_release(ctl_arena *self, void *ptr)
+{
+    if (ptr && ptr == self->last)
+    {
+        size_t offset = (size_t)((char *)ptr - ctl_arena_chunk_data(self->current));
+        self->allocated -= self->used - offset;
+        self->used = offset;
+        self->last = NULL;
+    }
+}
+
+// takes back everything at once, keeping the chunks.
+static inline void ctl_arena_reset(ctl_arena *self)
+{
+    self->current = self->first;
+    self->used = 0;
+    self->last = NULL;
+    self->allocated = 0;
+}
+
+static inline void *ctl_arena_allocator_alloc(void *context, size_t size)
+{
+    return ctl_arena_alloc((ctl_arena *)context, size);
+}
+
+static inline void *ctl_arena_allocator_realloc(void *context, void *ptr, size_t old_size, size_t size)
+{
+    return ctl_arena_realloc((ctl_arena *)context, ptr, old_size, size);
+}
+
+static inline void ctl_arena_allocator_free(void *context, void *ptr, size_t size)
+{
+    (void)size;
+    ctl_arena_release((ctl_arena *)context, ptr);
+}
+
+// chunk_size: bytes per chunk, or 0 for CTL_ARENA_CHUNK_SIZE. Nothing is allocated until used.
+static inline void ctl_arena_init(ctl_arena *self, size_t chunk_size)
+{
+    static ctl_arena zero;
+    *self = zero;
+    self->chunk_size = CTL_ALLOCATOR_ROUND(chunk_size ? chunk_size : CTL_ARENA_CHUNK_SIZE);
+    self->allocator.alloc = ctl_arena_allocator_alloc;
+    self->allocator.realloc = ctl_arena_allocator_realloc;
+    self->allocator.free = ctl_arena_allocator_free;
+    self->allocator.context = self;
+}
+
+static inline ctl_allocator *ctl_arena_allocator(ctl_arena *self)
+{
+    return &self->allocator;
+}
+
+// frees the chunks (and everything in them).
+static inline void ctl_arena_free(ctl_arena *self)
+{
+    for (ctl_arena_chunk *chunk = self->first, *next; chunk; chunk = next)
+    {
+        next = chunk->next;
+        free(chunk);
+    }
+    ctl_arena_init(self, self->chunk_size);
+}
+
+/* Pool */
+
+typedef struct ctl_pool_block
+{
+    struct ctl_pool_block *next;
+} ctl_pool_block;
+
+typedef struct ctl_pool
+{
+    size_t block_size;
+    ctl_pool_block *free_list;
+    ctl_arena arena;
+    // for anything larger than a block: NULL for the heap.
+    ctl_allocator *fallback;
+    ctl_allocator allocator;
+} ctl_pool;
+
+static inline void *ctl_pool_alloc(ctl_pool *self, size_t size)
+{
+    if (size > self->block_size)
+        return ctl_alloc(self->fallback, size);
+    ctl_pool_block *block = self->free_list;
+    if (block)
+    {
+        self->free_list = block->next;
+        return block;
+    }
+    return ctl_arena_alloc(&self->arena, self->block_size);
+}
+
+static inline void ctl_pool_release(ctl_pool *self, void *ptr, size_t size)
+{
+    if (size > self->block_size)
+    {
+        ctl_free(self->fallback, ptr, size);
+        return;
+    }
+    if (!ptr)
+        return;
+    ctl_pool_block *block = (ctl_pool_block *)ptr;
+    block->next = self->free_list;
+    self->free_list = block;
+}
+
+static inline void *ctl_pool_realloc(ctl_pool *self, void *ptr, size_t old_size, size_t size)
+{
+    if (old_size > self->block_size && size > self->block_size)
+        return ctl_realloc(self->fallback, ptr, old_size, size);
+    if (ptr && old_size <= self->block_size && size <= self->block_size)
+        return ptr;
+    void *moved = ctl_pool_alloc(self, size);
+    if (moved && ptr)
+    {
+        memcpy(moved, ptr, old_size < size ? old_size : size);
+        ctl_pool_release(self, ptr, old_size);
+    }
+    return moved;
+}
+
+// takes back every block at once (but not the fallback's allocations).
+static inline void ctl_pool_reset(ctl_pool *self)
+{
+    self->free_list = NULL;
+    ctl_arena_reset(&self->arena);
+}
+
+static inline void *ctl_pool_allocator_alloc(void *context, size_t size)
+{
+    return ctl_pool_alloc((ctl_pool *)context, size);
+}
+
+static inline void *ctl_pool_allocator_realloc(void *context, void *ptr, size_t old_size, size_t size)
+{
+    return ctl_pool_realloc((ctl_pool *)context, ptr, old_size, size);
+}
+
+static inline void ctl_pool_allocator_free(void *context, void *ptr, size_t size)
+{
+    ctl_pool_release((ctl_pool *)context, ptr, size);
+}
+
+// block_size: the size of what it is for, such as sizeof(set_int_node).
+static inline void ctl_pool_init(ctl_pool *self, size_t block_size)
+{
+    static ctl_pool zero;
+    *self = zero;
+    if (block_size < sizeof(ctl_pool_block))
+        block_size = sizeof(ctl_pool_block);
+    self->block_size = CTL_ALLOCATOR_ROUND(block_size);
+    ctl_arena_init(&self->arena, self->block_size * CTL_POOL_CHUNK_BLOCKS);
+    self->allocator.alloc = ctl_pool_allocator_alloc;
+    self->allocator.realloc = ctl_pool_allocator_realloc;
+    self->allocator.free = ctl_pool_allocator_free;
+    self->allocator.context = self;
+}
+
+static inline ctl_allocator *ctl_pool_allocator(ctl_pool *self)
+{
+    return &self->allocator;
+}
+
+// frees every block (but not the fallback's allocations).
+static inline void ctl_pool_free(ctl_pool *self)
+{
+    self->free_list = NULL;
+    ctl_arena_free(&self->arena);
+}
+
+#endif // __CTL_ALLOCATOR_H__
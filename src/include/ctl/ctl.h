@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define CAT(a, b) a##b
 #define PASTE(a, b) CAT(a, b)
@@ -52,6 +53,57 @@
 #define LIKELY(x) x
 #define UNLIKELY(x) x
 #endif
+
+/* Allocators. Containers take their memory from self->allocator (see
+   vec_T_set_allocator and friends), or the heap if it is NULL.
+   <ctl/allocator.h> has a bump arena and a fixed-size pool. */
+
+typedef struct ctl_allocator
+{
+    void *(*alloc)(void *context, size_t size);
+    // optional: without it, realloc is alloc, copy and free.
+    void *(*realloc)(void *context, void *ptr, size_t old_size, size_t size);
+    void (*free)(void *context, void *ptr, size_t size);
+    void *context;
+} ctl_allocator;
+
+static inline void *ctl_alloc(ctl_allocator *allocator, size_t size)
+{
+    return allocator ? allocator->alloc(allocator->context, size) : malloc(size);
+}
+
+static inline void *ctl_calloc(ctl_allocator *allocator, size_t count, size_t size)
+{
+    if (!allocator)
+        return calloc(count, size);
+    void *ptr = allocator->alloc(allocator->context, count * size);
+    if (ptr)
+        memset(ptr, 0, count * size);
+    return ptr;
+}
+
+static inline void *ctl_realloc(ctl_allocator *allocator, void *ptr, size_t old_size, size_t size)
+{
+    if (!allocator)
+        return realloc(ptr, size);
+    if (allocator->realloc)
+        return allocator->realloc(allocator->context, ptr, old_size, size);
+    void *moved = allocator->alloc(allocator->context, size);
+    if (moved && ptr)
+    {
+        memcpy(moved, ptr, old_size < size ? old_size : size);
+        allocator->free(allocator->context, ptr, old_size);
+    }
+    return moved;
+}
+
+static inline void ctl_free(ctl_allocator *allocator, void *ptr, size_t size)
+{
+    if (!allocator)
+        free(ptr);
+    else if (ptr)
+        allocator->free(allocator->context, ptr, size);
+}
 #endif
 
 #ifndef MAX
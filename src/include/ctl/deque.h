@@ -38,6 +38,7 @@ typedef struct A
     T (*copy)(T *);
     int (*compare)(T *, T *); // 2-way operator<
     int (*equal)(T *, T *);
+    ctl_allocator *allocator; // optional, else the heap
 } A;
 
 #include <ctl/bits/iterator_vtable.h>
@@ -68,10 +69,10 @@ static inline T *JOIN(A, at)(A *self, size_t index)
     {
         ASSERT(index <= self->size || !"invalid deque index");
         self->capacity = 1;
-        self->pages = (B **)calloc(1, sizeof(B *));
+        self->pages = (B **)ctl_calloc(self->allocator, 1, sizeof(B *));
         if (!self->pages)
             return NULL;
-        self->pages[0] = (B *)calloc(1, sizeof(B));
+        self->pages[0] = (B *)ctl_calloc(self->allocator, 1, sizeof(B));
         if (!self->pages[0])
             return NULL;
         return &self->pages[0]->value[0];
@@ -217,6 +218,7 @@ static inline A JOIN(A, init_from)(A *copy)
     self.copy = copy->copy;
     self.compare = copy->compare;
     self.equal = copy->equal;
+    self.allocator = copy->allocator;
     return self;
 }
 
@@ -247,9 +249,9 @@ static inline I JOIN(B, iter)(A *self, size_t index)
     return iter;
 }
 
-static inline B *JOIN(B, init)(size_t cut)
+static inline B *JOIN(B, init)(ctl_allocator *allocator, size_t cut)
 {
-    B *self = (B *)malloc(sizeof(B));
+    B *self = (B *)ctl_alloc(allocator, sizeof(B));
     self->a = self->b = cut;
     return self;
 }
@@ -271,8 +273,8 @@ static inline void JOIN(A, set)(A *self, size_t index, T value)
 
 static inline void JOIN(A, alloc)(A *self, size_t capacity, size_t shift_from)
 {
+    self->pages = (B **)ctl_realloc(self->allocator, self->pages, self->capacity * sizeof(B *), capacity * sizeof(B *));
     self->capacity = capacity;
-    self->pages = (B **)realloc(self->pages, capacity * sizeof(B *));
     size_t shift = (self->capacity - shift_from) / 2;
     size_t i = self->mark_b;
     while (i != 0)
@@ -298,6 +300,13 @@ static inline A JOIN(A, init)(void)
     return self;
 }
 
+// only while empty, and holding no memory: before the first push, say.
+static inline void JOIN(A, set_allocator)(A *self, ctl_allocator *allocator)
+{
+    ASSERT(!self->pages || !"set_allocator after allocating");
+    self->allocator = allocator;
+}
+
 static inline void JOIN(A, push_front)(A *self, T value)
 {
     if (JOIN(A, empty)(self))
@@ -305,7 +314,7 @@ static inline void JOIN(A, push_front)(A *self, T value)
         self->mark_a = 0;
         self->mark_b = 1;
         JOIN(A, alloc)(self, 1, 0);
-        *JOIN(A, last)(self) = JOIN(B, init)(DEQ_BUCKET_SIZE);
+        *JOIN(A, last)(self) = JOIN(B, init)(self->allocator, DEQ_BUCKET_SIZE);
     }
     else
     {
@@ -315,7 +324,7 @@ static inline void JOIN(A, push_front)(A *self, T value)
             if (self->mark_a == 0)
                 JOIN(A, alloc)(self, 2 * self->capacity, self->mark_a);
             self->mark_a--;
-            *JOIN(A, first)(self) = JOIN(B, init)(DEQ_BUCKET_SIZE);
+            *JOIN(A, first)(self) = JOIN(B, init)(self->allocator, DEQ_BUCKET_SIZE);
         }
     }
     B *page = *JOIN(A, first)(self);
@@ -338,7 +347,7 @@ static inline void JOIN(A, pop_front)(A *self)
     self->size--;
     if (page->a == page->b)
     {
-        free(page);
+        ctl_free(self->allocator, page, sizeof(B));
         self->mark_a++;
     }
 }
@@ -350,7 +359,7 @@ static inline void JOIN(A, push_back)(A *self, T value)
         self->mark_a = 0;
         self->mark_b = 1;
         JOIN(A, alloc)(self, 1, 0);
-        *JOIN(A, last)(self) = JOIN(B, init)(0);
+        *JOIN(A, last)(self) = JOIN(B, init)(self->allocator, 0);
     }
     else
     {
@@ -360,7 +369,7 @@ static inline void JOIN(A, push_back)(A *self, T value)
             if (self->mark_b == self->capacity)
                 JOIN(A, alloc)(self, 2 * self->capacity, self->mark_b);
             self->mark_b++;
-            *JOIN(A, last)(self) = JOIN(B, init)(0);
+            *JOIN(A, last)(self) = JOIN(B, init)(self->allocator, 0);
         }
     }
     B *page = *JOIN(A, last)(self);
@@ -383,7 +392,7 @@ static inline void JOIN(A, pop_back)(A *self)
 #endif
     if (page->b == page->a)
     {
-        free(page);
+        ctl_free(self->allocator, page, sizeof(B));
         self->mark_b--;
     }
 }
@@ -476,13 +485,16 @@ static inline void JOIN(A, clear)(A *self)
 static inline void JOIN(A, free)(A *self)
 {
     JOIN(A, clear)(self);
-    free(self->pages);
+    ctl_allocator *allocator = self->allocator;
+    ctl_free(allocator, self->pages, self->capacity * sizeof(B *));
     *self = JOIN(A, init)();
+    self->allocator = allocator;
 }
 
 static inline A JOIN(A, copy)(A *self)
 {
     A other = JOIN(A, init)();
+    other.allocator = self->allocator;
     while (other.size < self->size)
     {
         T *value = JOIN(A, at)(self, other.size);
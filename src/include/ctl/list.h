@@ -30,6 +30,7 @@ typedef struct A
     T (*copy)(T *);
     int (*compare)(T *, T *); // 2-way operator<
     int (*equal)(T *, T *);
+    ctl_allocator *allocator; // optional, else the heap
 } A;
 
 #include <ctl/bits/iterator_vtable.h>
@@ -242,12 +243,20 @@ static inline A JOIN(A, init_from)(A *copy)
 #endif
     self.compare = copy->compare;
     self.equal = copy->equal;
+    self.allocator = copy->allocator;
     return self;
 }
 
-static inline B *JOIN(B, init)(T value)
+// only while empty.
+static inline void JOIN(A, set_allocator)(A *self, ctl_allocator *allocator)
 {
-    B *self = (B *)malloc(sizeof(B));
+    ASSERT(!self->size || !"set_allocator on a non-empty list");
+    self->allocator = allocator;
+}
+
+static inline B *JOIN(B, init)(ctl_allocator *allocator, T value)
+{
+    B *self = (B *)ctl_alloc(allocator, sizeof(B));
     self->prev = self->next = NULL;
     self->value = value;
     return self;
@@ -281,12 +290,13 @@ static inline void JOIN(A, connect_before)(A *self, B *position, B *node)
 
 static inline void JOIN(A, push_front)(A *self, T value)
 {
-    B *node = JOIN(B, init)(value);
+    B *node = JOIN(B, init)(self->allocator, value);
     JOIN(A, connect_before)(self, self->head, node);
 }
 
 static inline void JOIN(A, transfer_before)(A *self, A *other, B *position, B *node)
 {
+    ASSERT(self->allocator == other->allocator || !"transfer between allocators");
     if (LIKELY(other->size))
         JOIN(A, disconnect)(other, node);
     JOIN(A, connect_before)(self, position, node);
@@ -298,7 +308,7 @@ static inline void JOIN(A, erase_node)(A *self, B *node)
         JOIN(A, disconnect)(self, node);
     if (self->free)
         self->free(&node->value);
-    free(node);
+    ctl_free(self->allocator, node, sizeof(B));
 }
 
 static inline void JOIN(A, erase)(I *it)
@@ -319,7 +329,7 @@ static inline void JOIN(A, pop_front)(A *self)
 
 static inline I *JOIN(A, insert)(I *pos, T value)
 {
-    B *node = JOIN(B, init)(value);
+    B *node = JOIN(B, init)(pos->container->allocator, value);
     JOIN(A, connect_before)(pos->container, pos->node, node);
     pos->node = node;
     pos->ref = &node->value;
@@ -336,10 +346,12 @@ static inline void JOIN(A, free)(A *self)
 {
     JOIN(A, compare_fn) *compare = &self->compare;
     JOIN(A, compare_fn) *equal = &self->equal;
+    ctl_allocator *allocator = self->allocator;
     JOIN(A, clear)(self);
     *self = JOIN(A, init)();
     self->compare = *compare;
     self->equal = *equal;
+    self->allocator = allocator;
 }
 
 static inline void JOIN(A, connect_after)(A *self, B *position, B *node)
@@ -370,7 +382,7 @@ static inline void JOIN(A, connect_after)(A *self, B *position, B *node)
 
 static inline void JOIN(A, push_back)(A *self, T value)
 {
-    B *node = JOIN(B, init)(value);
+    B *node = JOIN(B, init)(self->allocator, value);
     JOIN(A, connect_after)(self, self->tail, node);
 }
 
@@ -447,7 +459,7 @@ static inline size_t JOIN(A, remove)(A *self, T value)
 static inline I *JOIN(A, emplace)(I *pos, T *value)
 {
     A *self = pos->container;
-    B *node = JOIN(B, init)(self->copy(value));
+    B *node = JOIN(B, init)(self->allocator, self->copy(value));
     JOIN(A, connect_before)(self, pos->node, node);
     JOIN(I, next)(pos);
     return pos;
@@ -455,7 +467,7 @@ static inline I *JOIN(A, emplace)(I *pos, T *value)
 
 static inline B *JOIN(A, emplace_front)(A *self, T *value)
 {
-    B *node = JOIN(B, init)(self->copy(value));
+    B *node = JOIN(B, init)(self->allocator, self->copy(value));
     JOIN(A, connect_before)(self, self->head, node);
     // FIXME return iter
     return self->head;
@@ -463,7 +475,7 @@ static inline B *JOIN(A, emplace_front)(A *self, T *value)
 
 static inline B *JOIN(A, emplace_back)(A *self, T *value)
 {
-    B *node = JOIN(B, init)(self->copy(value));
+    B *node = JOIN(B, init)(self->allocator, self->copy(value));
     JOIN(A, connect_after)(self, self->tail, node);
     // FIXME return iter
     return self->tail;
@@ -475,7 +487,7 @@ static inline I *JOIN(A, insert_count)(I *pos, size_t count, T value)
     B *node = NULL;
     for (size_t i = 0; i < count; i++)
     {
-        node = JOIN(B, init)(self->copy(&value));
+        node = JOIN(B, init)(self->allocator, self->copy(&value));
         if (pos->node)
             JOIN(A, connect_before)(self, pos->node, node);
         else
@@ -499,14 +511,14 @@ static inline I *JOIN(A, insert_range)(I *pos, I *range)
     {
         while (node != range->end)
         {
-            JOIN(A, connect_after)(self, self->tail, JOIN(B, init)(self->copy(&node->value)));
+            JOIN(A, connect_after)(self, self->tail, JOIN(B, init)(self->allocator, self->copy(&node->value)));
             node = node->next;
         }
     }
     else
         while (node != range->end)
         {
-            JOIN(A, connect_before)(self, pos->node, JOIN(B, init)(self->copy(&node->value)));
+            JOIN(A, connect_before)(self, pos->node, JOIN(B, init)(self->allocator, self->copy(&node->value)));
             node = node->next;
         }
     if (node)
@@ -530,7 +542,7 @@ static inline void JOIN(A, insert_generic)(I *pos, GI *range)
     {
         while (!done(range))
         {
-            JOIN(A, connect_after)(self, self->tail, JOIN(B, init)(self->copy(ref(range))));
+            JOIN(A, connect_after)(self, self->tail, JOIN(B, init)(self->allocator, self->copy(ref(range))));
             next(range);
         }
     }
@@ -538,7 +550,7 @@ static inline void JOIN(A, insert_generic)(I *pos, GI *range)
     {
         while (!done(range))
         {
-            JOIN(A, connect_before)(self, pos->node, JOIN(B, init)(self->copy(ref(range))));
+            JOIN(A, connect_before)(self, pos->node, JOIN(B, init)(self->allocator, self->copy(ref(range))));
             next(range);
         }
     }
@@ -18,7 +18,7 @@
 
 static inline I JOIN(A, insert_or_assign)(A *self, T key)
 {
-    B *insert = JOIN(B, init)(key, 0);
+    B *insert = JOIN(B, init)(self->allocator, key, 0);
     if (self->root)
     {
         B *node = self->root;
@@ -27,8 +27,13 @@ static inline I JOIN(A, insert_or_assign)(A *self, T key)
             int diff = self->compare(&key, &node->value);
             if (diff == 0)
             {
-                JOIN(A, free_node)(self, node);
-                *node = *insert;
+                // keep the node where it is in the tree, with the new value
+#ifndef POD
+                if (self->free)
+                    self->free(&node->value);
+#endif
+                node->value = insert->value;
+                ctl_free(self->allocator, insert, sizeof(B));
                 return JOIN(I, iter)(self, node);
             }
             else if (diff < 0)
@@ -66,7 +71,7 @@ static inline I JOIN(A, insert_or_assign)(A *self, T key)
 
 static inline I JOIN(A, insert_or_assign_found)(A *self, T key, int *foundp)
 {
-    B *insert = JOIN(B, init)(key, 0);
+    B *insert = JOIN(B, init)(self->allocator, key, 0);
     if (self->root)
     {
         B *node = self->root;
@@ -75,8 +80,13 @@ static inline I JOIN(A, insert_or_assign_found)(A *self, T key, int *foundp)
             int diff = self->compare(&key, &node->value);
             if (diff == 0)
             {
-                JOIN(A, free_node)(self, node);
-                *node = *insert;
+                // keep the node where it is in the tree, with the new value
+#ifndef POD
+                if (self->free)
+                    self->free(&node->value);
+#endif
+                node->value = insert->value;
+                ctl_free(self->allocator, insert, sizeof(B));
                 *foundp = 1;
                 return JOIN(I, iter)(self, node);
             }
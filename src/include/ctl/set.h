@@ -33,6 +33,7 @@ typedef struct A
     T (*copy)(T *);
     int (*compare)(T *, T *); // 2-way operator<
     int (*equal)(T *, T *);
+    ctl_allocator *allocator; // optional, else the heap
 } A;
 
 #include <ctl/bits/iterator_vtable.h>
@@ -253,18 +254,24 @@ static inline A JOIN(A, init_from)(A *copy)
 #endif
     self.compare = copy->compare;
     self.equal = copy->equal;
+    self.allocator = copy->allocator;
     return self;
 }
 
+// only while empty. Nodes are all the same size: a pool suits them (see <ctl/allocator.h>).
+static inline void JOIN(A, set_allocator)(A *self, ctl_allocator *allocator)
+{
+    ASSERT(!self->size || !"set_allocator on a non-empty set");
+    self->allocator = allocator;
+}
+
 static inline void JOIN(A, free_node)(A *self, B *node)
 {
 #ifndef POD
     if (self->free)
         self->free(&node->value);
-#else
-    (void)self;
 #endif
-    free(node);
+    ctl_free(self->allocator, node, sizeof(B));
 }
 
 static inline int JOIN(B, color)(B *node)
@@ -300,9 +307,9 @@ static inline B *JOIN(B, uncle)(B *node)
     return JOIN(B, sibling)(node->p);
 }
 
-static inline B *JOIN(B, init)(T key, int color)
+static inline B *JOIN(B, init)(ctl_allocator *allocator, T key, int color)
 {
-    B *node = (B *)malloc(sizeof(B));
+    B *node = (B *)ctl_alloc(allocator, sizeof(B));
     node->value = key;
     node->color = color;
     node->l = node->r = node->p = NULL;
@@ -548,7 +555,7 @@ static inline B *JOIN(A, insert)(A *self, T key)
                     node = node->l;
                 else
                 {
-                    insert = JOIN(B, init)(key, 0);
+                    insert = JOIN(B, init)(self->allocator, key, 0);
                     node->l = insert;
                     break;
                 }
@@ -559,7 +566,7 @@ static inline B *JOIN(A, insert)(A *self, T key)
                     node = node->r;
                 else
                 {
-                    insert = JOIN(B, init)(key, 0);
+                    insert = JOIN(B, init)(self->allocator, key, 0);
                     node->r = insert;
                     break;
                 }
@@ -569,7 +576,7 @@ static inline B *JOIN(A, insert)(A *self, T key)
     }
     else
     {
-        insert = JOIN(B, init)(key, 0);
+        insert = JOIN(B, init)(self->allocator, key, 0);
         self->root = insert;
     }
     JOIN(A, insert_1)(self, insert);
@@ -619,7 +626,7 @@ static inline B *JOIN(A, insert_found)(A *self, T key, int *foundp)
                     node = node->l;
                 else
                 {
-                    insert = JOIN(B, init)(key, 0);
+                    insert = JOIN(B, init)(self->allocator, key, 0);
                     node->l = insert;
                     break;
                 }
@@ -630,7 +637,7 @@ static inline B *JOIN(A, insert_found)(A *self, T key, int *foundp)
                     node = node->r;
                 else
                 {
-                    insert = JOIN(B, init)(key, 0);
+                    insert = JOIN(B, init)(self->allocator, key, 0);
                     node->r = insert;
                     break;
                 }
@@ -640,7 +647,7 @@ static inline B *JOIN(A, insert_found)(A *self, T key, int *foundp)
     }
     else
     {
-        insert = JOIN(B, init)(key, 0);
+        insert = JOIN(B, init)(self->allocator, key, 0);
         self->root = insert;
     }
     JOIN(A, insert_1)(self, insert);
@@ -863,13 +870,16 @@ static inline void JOIN(A, clear)(A *self)
 
 static inline void JOIN(A, free)(A *self)
 {
+    ctl_allocator *allocator = self->allocator;
     JOIN(A, clear)(self);
     *self = JOIN(A, init)(self->compare);
+    self->allocator = allocator;
 }
 
 static inline A JOIN(A, copy)(A *self)
 {
     A copy = JOIN(A, init)(self->compare);
+    copy.allocator = self->allocator;
     list_foreach_ref(A, self, it) JOIN(A, insert)(&copy, self->copy(it.ref));
     return copy;
 }
@@ -1020,6 +1030,7 @@ static inline A JOIN(A, difference)(A *a, A *b)
 static inline A JOIN(A, symmetric_difference)(A *a, A *b)
 {
     A self = JOIN(A, init)(a->compare);
+    self.allocator = a->allocator;
     B *node = JOIN(A, first)(a);
     while (node)
     {
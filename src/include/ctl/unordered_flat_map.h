@@ -0,0 +1,35 @@
+/* Unordered map as an open-addressing hashtable: the same table as
+   <ctl/unordered_flat_set.h>, of key-value structs.
+   SPDX-License-Identifier: MIT
+
+   As with <ctl/unordered_map.h>, T is a struct holding the key and the value,
+   and hash and equal only look at the key. Find and erase take a T with just
+   the key filled in.
+ */
+
+#ifndef T
+#error "Template struct type T undefined for <ctl/unordered_flat_map.h>"
+#endif
+
+#define CTL_UFSET_PREFIX ufmap
+#define HOLD
+#include <ctl/unordered_flat_set.h>
+
+#define A JOIN(ufmap, T)
+
+/// Insert a key-value pair, or replace (freeing) the value already there for its key.
+/// @return The pair in the map (valid until the next insert or erase).
+static inline T *JOIN(A, insert_or_assign)(A *self, T value)
+{
+    T *slot = JOIN(A, find)(self, value);
+    if (slot)
+    {
+        FREE_VALUE(self, *slot);
+        *slot = value;
+        return slot;
+    }
+    return JOIN(A, insert)(self, value);
+}
+
+#undef A
+#undef T
@@ -0,0 +1,498 @@
+/* Unordered set as an open-addressing hashtable (a "Swiss table").
+   SPDX-License-Identifier: MIT
+
+   Unlike <ctl/unordered_set.h>, which chains one malloc'd node per element,
+   values live in a single flat array, alongside an array of one control byte
+   per slot: empty, deleted, or 7 bits of the value's hash. Lookups scan the
+   control bytes a group (16) at a time, with SSE2 where available (SWAR on
+   two 64-bit words otherwise), and only compare values whose 7 bits match.
+   Capacities are powers of two, so slots are found by masking, and groups are
+   probed triangularly, which visits every group.
+
+   No per-element allocation, and no pointer chasing, at the cost that
+   inserting (which may grow the table) moves values: pointers into the set
+   are only valid until the next insert.
+
+   The hash is mixed (multiplied by a 64-bit odd constant) before use, so
+   identity hashes of small integers, such as ids, spread out evenly.
+
+   Usage, as for the other containers:
+
+     #define POD
+     #define T uint32_t
+     #include <ctl/unordered_flat_set.h>
+
+     ufset_uint32_t set = ufset_uint32_t_init(NULL, NULL);
+     ufset_uint32_t_insert(&set, 42);
+     ufset_foreach(uint32_t, &set, value) { ... }
+     ufset_uint32_t_free(&set);
+
+   Tunable policies:
+
+   - CTL_UFSET_MAX_LOAD: slots full (or deleted) per 8, before growing.
+     Defaults to 7.
+*/
+#ifndef T
+#error "Template type T undefined for <ctl/unordered_flat_set.h>"
+#endif
+
+#include <ctl/ctl.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+#ifndef CTL_UFSET_MAX_LOAD
+#define CTL_UFSET_MAX_LOAD 7
+#endif
+
+// Control bytes, and group scanning: shared by every instantiation.
+#ifndef CTL_UFSET_GROUP
+#define CTL_UFSET_GROUP 16
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CTL_UFSET_SSE2
+#endif
+
+/// Empty (never used), deleted (a tombstone), or full: the low 7 bits of the hash, 0..127.
+#define CTL_UFSET_EMPTY ((int8_t)-128)
+#define CTL_UFSET_DELETED ((int8_t)-2)
+
+/// Bits of a group's mask, one per slot (bit i for slot i).
+typedef uint32_t ctl_ufset_mask_t;
+
+#ifdef CTL_UFSET_SSE2
+
+static inline ctl_ufset_mask_t ctl_ufset_match(const int8_t *group, int8_t h2)
+{
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (ctl_ufset_mask_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)));
+}
+
+static inline ctl_ufset_mask_t ctl_ufset_match_empty(const int8_t *group)
+{
+    return ctl_ufset_match(group, CTL_UFSET_EMPTY);
+}
+
+static inline ctl_ufset_mask_t ctl_ufset_match_free(const int8_t *group)
+{
+    // Empty and deleted are the only negative bytes other than -1 (never used), so: < -1.
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (ctl_ufset_mask_t)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl));
+}
+
+#else
+
+/// Bytes of a word equal to zero, as the high bit of each (exact, unlike the classic trick).
+static inline uint64_t ctl_ufset_zero_bytes(uint64_t word)
+{
+    const uint64_t lows = 0x7F7F7F7F7F7F7F7Full;
+    return ~(((word & lows) + lows) | word | lows);
+}
+
+/// Gather the high bit of each byte of two words into a 16-bit mask.
+static inline ctl_ufset_mask_t ctl_ufset_gather(uint64_t lo, uint64_t hi)
+{
+    ctl_ufset_mask_t mask = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        mask |= (ctl_ufset_mask_t)((lo >> (8 * i + 7)) & 1) << i;
+        mask |= (ctl_ufset_mask_t)((hi >> (8 * i + 7)) & 1) << (i + 8);
+    }
+    return mask;
+}
+
+static inline void ctl_ufset_load(const int8_t *group, uint64_t *lo, uint64_t *hi)
+{
+    memcpy(lo, group, sizeof(uint64_t));
+    memcpy(hi, group + 8, sizeof(uint64_t));
+}
+
+static inline ctl_ufset_mask_t ctl_ufset_match(const int8_t *group, int8_t h2)
+{
+    uint64_t lo, hi;
+    ctl_ufset_load(group, &lo, &hi);
+    uint64_t splat = 0x0101010101010101ull * (uint8_t)h2;
+    return ctl_ufset_gather(ctl_ufset_zero_bytes(lo ^ splat), ctl_ufset_zero_bytes(hi ^ splat));
+}
+
+static inline ctl_ufset_mask_t ctl_ufset_match_empty(const int8_t *group)
+{
+    return ctl_ufset_match(group, CTL_UFSET_EMPTY);
+}
+
+static inline ctl_ufset_mask_t ctl_ufset_match_free(const int8_t *group)
+{
+    // High bit set, and not all bits set (-1 is never used): empty or deleted.
+    uint64_t lo, hi;
+    ctl_ufset_load(group, &lo, &hi);
+    const uint64_t highs = 0x8080808080808080ull;
+    return ctl_ufset_gather(lo & highs & ~(lo << 7), hi & highs & ~(hi << 7));
+}
+
+#endif
+
+/// The first slot set in a (non-zero) group mask.
+static inline unsigned ctl_ufset_first(ctl_ufset_mask_t mask)
+{
+#if __GNUC__ >= 3
+    return (unsigned)__builtin_ctz(mask);
+#else
+    unsigned i = 0;
+    while (!(mask & 1))
+    {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+/// Slots before the last set in a (non-zero) group mask: those after the last empty one.
+static inline unsigned ctl_ufset_leading(ctl_ufset_mask_t mask)
+{
+#if __GNUC__ >= 3
+    return (unsigned)__builtin_clz(mask) - (32 - CTL_UFSET_GROUP);
+#else
+    unsigned n = 0;
+    while (!(mask & (1u << (CTL_UFSET_GROUP - 1 - n))))
+        n++;
+    return n;
+#endif
+}
+
+/// Mix a hash, so that its low bits (for the slot) and high 7 bits (for the control byte) both
+/// depend on all of it.
+static inline uint64_t ctl_ufset_mix(size_t hash)
+{
+    uint64_t h = (uint64_t)hash * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+}
+
+static inline int8_t ctl_ufset_h2(uint64_t mixed)
+{
+    return (int8_t)(mixed >> 57);
+}
+
+/// Control bytes for an empty table (which has no slots, and finds nothing).
+static const int8_t ctl_ufset_empty_group[CTL_UFSET_GROUP] = {
+    CTL_UFSET_EMPTY, CTL_UFSET_EMPTY, CTL_UFSET_EMPTY, CTL_UFSET_EMPTY, CTL_UFSET_EMPTY, CTL_UFSET_EMPTY,
+    CTL_UFSET_EMPTY, CTL_UFSET_EMPTY, CTL_UFSET_EMPTY, CTL_UFSET_EMPTY, CTL_UFSET_EMPTY, CTL_UFSET_EMPTY,
+    CTL_UFSET_EMPTY, CTL_UFSET_EMPTY, CTL_UFSET_EMPTY, CTL_UFSET_EMPTY,
+};
+
+/// Iterate over every value in a set (or map), in no particular order.
+/// @note Do not insert into or erase from the set while iterating.
+#define ufset_foreach(T, self, value)                                                                                  \
+    for (size_t _ufset_i_##value = 0; _ufset_i_##value < (self)->capacity; _ufset_i_##value++)                        \
+        if ((self)->ctrl[_ufset_i_##value] >= 0)                                                                       \
+            for (T *value = &(self)->slots[_ufset_i_##value], *_ufset_once_##value = value; _ufset_once_##value;     \
+                 _ufset_once_##value = NULL)
+
+#define ufmap_foreach ufset_foreach
+
+#endif // CTL_UFSET_GROUP
+
+#ifndef CTL_UFSET_PREFIX
+#define CTL_UFSET_PREFIX ufset
+#endif
+
+#define A JOIN(CTL_UFSET_PREFIX, T)
+
+typedef struct A
+{
+    /// Control bytes: capacity of them, then the first group again, so that any group can be loaded
+    /// at once (those past the end mirroring those at the start).
+    int8_t *ctrl;
+    T *slots;
+    size_t size;
+    /// A power of two, at least a group (or 0).
+    size_t capacity;
+    /// Inserts into empty slots left before growing (deleted slots are not reused for free).
+    size_t growth_left;
+    void (*free)(T *);
+    T (*copy)(T *);
+    size_t (*hash)(T *);
+    int (*equal)(T *, T *);
+    /// Where ctrl and slots come from: NULL for the heap.
+    ctl_allocator *allocator;
+} A;
+
+#if defined(POD) && !defined(NOT_INTEGRAL)
+static inline size_t _JOIN(A, _default_hash)(T *a)
+{
+    return (size_t)*a;
+}
+
+static inline int _JOIN(A, _default_equal)(T *a, T *b)
+{
+    return *a == *b;
+}
+#endif
+
+#ifdef POD
+static inline T _JOIN(A, _implicit_copy)(T *self)
+{
+    return *self;
+}
+#endif
+
+static inline A JOIN(A, init)(size_t (*_hash)(T *), int (*_equal)(T *, T *))
+{
+    static A zero;
+    A self = zero;
+    self.ctrl = (int8_t *)ctl_ufset_empty_group;
+    self.hash = _hash;
+    self.equal = _equal;
+#ifdef POD
+    self.copy = _JOIN(A, _implicit_copy);
+#ifndef NOT_INTEGRAL
+    if (!self.hash)
+        self.hash = _JOIN(A, _default_hash);
+    if (!self.equal)
+        self.equal = _JOIN(A, _default_equal);
+#endif
+#else
+    self.free = JOIN(T, free);
+    self.copy = JOIN(T, copy);
+#endif
+    return self;
+}
+
+/// Take memory from an allocator (only while nothing is allocated: before the first insert).
+static inline void JOIN(A, set_allocator)(A *self, ctl_allocator *allocator)
+{
+    ASSERT(self->capacity == 0 || !"set_allocator after allocating");
+    self->allocator = allocator;
+}
+
+static inline size_t JOIN(A, size)(A *self)
+{
+    return self->size;
+}
+
+static inline int JOIN(A, empty)(A *self)
+{
+    return self->size == 0;
+}
+
+static inline size_t JOIN(A, capacity)(A *self)
+{
+    return self->capacity;
+}
+
+/// Set a slot's control byte (and its mirror, for slots in the first group).
+static inline void _JOIN(A, _set_ctrl)(A *self, size_t index, int8_t h2)
+{
+    self->ctrl[index] = h2;
+    if (index < CTL_UFSET_GROUP)
+        self->ctrl[self->capacity + index] = h2;
+}
+
+/// The slot of a value, or capacity if it is not in the set.
+static inline size_t _JOIN(A, _find_index)(A *self, T *value, uint64_t mixed)
+{
+    if (self->capacity == 0)
+        return 0;
+
+    const size_t mask = self->capacity - 1;
+    const int8_t h2 = ctl_ufset_h2(mixed);
+    size_t pos = (size_t)mixed & mask;
+    for (size_t step = CTL_UFSET_GROUP;; step += CTL_UFSET_GROUP)
+    {
+        const int8_t *group = &self->ctrl[pos];
+        for (ctl_ufset_mask_t match = ctl_ufset_match(group, h2); match; match &= match - 1)
+        {
+            size_t index = (pos + ctl_ufset_first(match)) & mask;
+            if (self->equal(&self->slots[index], value))
+                return index;
+        }
+        // An empty slot ends the probe sequence: the value would have gone there (or before).
+        if (ctl_ufset_match_empty(group))
+            return self->capacity;
+        pos = (pos + step) & mask;
+    }
+}
+
+/// The first empty or deleted slot along a hash's probe sequence.
+static inline size_t _JOIN(A, _find_free)(A *self, uint64_t mixed)
+{
+    const size_t mask = self->capacity - 1;
+    size_t pos = (size_t)mixed & mask;
+    for (size_t step = CTL_UFSET_GROUP;; step += CTL_UFSET_GROUP)
+    {
+        ctl_ufset_mask_t match = ctl_ufset_match_free(&self->ctrl[pos]);
+        if (match)
+            return (pos + ctl_ufset_first(match)) & mask;
+        pos = (pos + step) & mask;
+    }
+}
+
+/// Move every value into a table of a new capacity (dropping tombstones).
+static inline void _JOIN(A, _rehash)(A *self, size_t capacity)
+{
+    int8_t *old_ctrl = self->ctrl;
+    T *old_slots = self->slots;
+    size_t old_capacity = self->capacity;
+
+    self->ctrl = (int8_t *)ctl_alloc(self->allocator, capacity + CTL_UFSET_GROUP);
+    self->slots = (T *)ctl_alloc(self->allocator, capacity * sizeof(T));
+    self->capacity = capacity;
+    self->growth_left = capacity / 8 * CTL_UFSET_MAX_LOAD - self->size;
+    memset(self->ctrl, CTL_UFSET_EMPTY, capacity + CTL_UFSET_GROUP);
+
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old_ctrl[i] < 0)
+            continue;
+        uint64_t mixed = ctl_ufset_mix(self->hash(&old_slots[i]));
+        size_t index = _JOIN(A, _find_free)(self, mixed);
+        _JOIN(A, _set_ctrl)(self, index, ctl_ufset_h2(mixed));
+        self->slots[index] = old_slots[i];
+    }
+
+    if (old_capacity)
+    {
+        ctl_free(self->allocator, old_ctrl, old_capacity + CTL_UFSET_GROUP);
+        ctl_free(self->allocator, old_slots, old_capacity * sizeof(T));
+    }
+}
+
+/// Make room for a number of values in all, without growing again.
+static inline void JOIN(A, reserve)(A *self, size_t count)
+{
+    size_t capacity = self->capacity ? self->capacity : CTL_UFSET_GROUP;
+    while (capacity / 8 * CTL_UFSET_MAX_LOAD < count)
+        capacity *= 2;
+    if (capacity != self->capacity)
+        _JOIN(A, _rehash)(self, capacity);
+}
+
+/// Find a value in the set.
+/// @return The value in the set, or NULL (valid until the next insert or erase).
+static inline T *JOIN(A, find)(A *self, T value)
+{
+    size_t index = _JOIN(A, _find_index)(self, &value, ctl_ufset_mix(self->hash(&value)));
+    return index < self->capacity ? &self->slots[index] : NULL;
+}
+
+static inline bool JOIN(A, contains)(A *self, T value)
+{
+    return JOIN(A, find)(self, value) != NULL;
+}
+
+static inline size_t JOIN(A, count)(A *self, T value)
+{
+    return JOIN(A, contains)(self, value) ? 1 : 0;
+}
+
+/// Insert a value (taking ownership of it), unless an equal one is there already (then freeing it).
+/// @param foundp Set to whether an equal value was there already (may be NULL).
+/// @return The value in the set (valid until the next insert or erase).
+static inline T *JOIN(A, insert_found)(A *self, T value, int *foundp)
+{
+    uint64_t mixed = ctl_ufset_mix(self->hash(&value));
+    size_t index = _JOIN(A, _find_index)(self, &value, mixed);
+    if (foundp)
+        *foundp = index < self->capacity;
+    if (index < self->capacity)
+    {
+        FREE_VALUE(self, value);
+        return &self->slots[index];
+    }
+
+    index = self->capacity ? _JOIN(A, _find_free)(self, mixed) : 0;
+    if (self->capacity == 0 || (self->growth_left == 0 && self->ctrl[index] == CTL_UFSET_EMPTY))
+    {
+        // Full (of values, or of tombstones): grow if values fill more than half, else just clean up.
+        size_t capacity = self->capacity ? self->capacity : CTL_UFSET_GROUP;
+        if (self->size + 1 > capacity / 16 * CTL_UFSET_MAX_LOAD)
+            capacity *= 2;
+        _JOIN(A, _rehash)(self, capacity);
+        index = _JOIN(A, _find_free)(self, mixed);
+    }
+
+    if (self->ctrl[index] == CTL_UFSET_EMPTY)
+        self->growth_left--;
+    _JOIN(A, _set_ctrl)(self, index, ctl_ufset_h2(mixed));
+    self->slots[index] = value;
+    self->size++;
+    return &self->slots[index];
+}
+
+static inline T *JOIN(A, insert)(A *self, T value)
+{
+    return JOIN(A, insert_found)(self, value, NULL);
+}
+
+/// Erase (and free) the value equal to one given, if there is one (the one given is not freed).
+/// @return Whether there was one.
+static inline bool JOIN(A, erase)(A *self, T value)
+{
+    size_t index = _JOIN(A, _find_index)(self, &value, ctl_ufset_mix(self->hash(&value)));
+    if (index == self->capacity)
+        return false;
+
+    FREE_VALUE(self, self->slots[index]);
+    self->size--;
+
+    // If no group around the slot was ever full, no probe went past it: it can be empty again.
+    // Otherwise it must stay a tombstone, so that probes carry on past it.
+    const size_t mask = self->capacity - 1;
+    size_t before = (index - CTL_UFSET_GROUP) & mask;
+    ctl_ufset_mask_t empty_after = ctl_ufset_match_empty(&self->ctrl[index]);
+    ctl_ufset_mask_t empty_before = ctl_ufset_match_empty(&self->ctrl[before]);
+    unsigned full_after = empty_after ? ctl_ufset_first(empty_after) : CTL_UFSET_GROUP;
+    unsigned full_before = empty_before ? ctl_ufset_leading(empty_before) : CTL_UFSET_GROUP;
+    if (full_before + full_after < CTL_UFSET_GROUP)
+    {
+        _JOIN(A, _set_ctrl)(self, index, CTL_UFSET_EMPTY);
+        self->growth_left++;
+    }
+    else
+    {
+        _JOIN(A, _set_ctrl)(self, index, CTL_UFSET_DELETED);
+    }
+    return true;
+}
+
+/// Erase (and free) every value, keeping the capacity.
+static inline void JOIN(A, clear)(A *self)
+{
+    if (self->capacity == 0)
+        return;
+    if (self->free)
+    {
+        for (size_t i = 0; i < self->capacity; i++)
+        {
+            if (self->ctrl[i] >= 0)
+                self->free(&self->slots[i]);
+        }
+    }
+    memset(self->ctrl, CTL_UFSET_EMPTY, self->capacity + CTL_UFSET_GROUP);
+    self->size = 0;
+    self->growth_left = self->capacity / 8 * CTL_UFSET_MAX_LOAD;
+}
+
+static inline void JOIN(A, free)(A *self)
+{
+    JOIN(A, clear)(self);
+    ctl_allocator *allocator = self->allocator;
+    if (self->capacity)
+    {
+        ctl_free(allocator, self->ctrl, self->capacity + CTL_UFSET_GROUP);
+        ctl_free(allocator, self->slots, self->capacity * sizeof(T));
+    }
+    *self = JOIN(A, init)(self->hash, self->equal);
+    self->allocator = allocator;
+}
+
+#undef A
+#undef CTL_UFSET_PREFIX
+#undef POD
+#undef NOT_INTEGRAL
+#ifndef HOLD
+#undef T
+#else
+#undef HOLD
+#endif
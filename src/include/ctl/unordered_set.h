@@ -120,6 +120,7 @@ typedef struct A
     T (*copy)(T *);
     size_t (*hash)(T *);
     int (*equal)(T *, T *);
+    ctl_allocator *allocator; // optional, else the heap
 #if CTL_USET_SECURITY_COLLCOUNTING == 4
     bool is_sorted_vector;
 #elif CTL_USET_SECURITY_COLLCOUNTING == 5
@@ -441,18 +442,18 @@ static inline uint32_t JOIN(A, __next_power2)(uint32_t n)
 }
 #endif
 
-static inline B *JOIN(B, init)(T value)
+static inline B *JOIN(B, init)(ctl_allocator *allocator, T value)
 {
-    B *n = (B *)malloc(sizeof(B));
+    B *n = (B *)ctl_alloc(allocator, sizeof(B));
     n->value = value;
     n->next = NULL;
     return n;
 }
 
 #ifdef CTL_USET_CACHED_HASH
-static inline B *JOIN(B, init_cached)(T value, size_t hash)
+static inline B *JOIN(B, init_cached)(ctl_allocator *allocator, T value, size_t hash)
 {
-    B *n = (B *)malloc(sizeof(B));
+    B *n = (B *)ctl_alloc(allocator, sizeof(B));
     n->value = value;
     n->cached_hash = hash;
     n->next = NULL;
@@ -537,7 +538,7 @@ static inline void JOIN(A, _free_node)(A *self, B *n)
 #else
     ASSERT(!self->free || !"uset free with POD");
 #endif
-    free(n);
+    ctl_free(self->allocator, n, sizeof(B));
     self->size--;
 }
 
@@ -568,14 +569,14 @@ static inline void JOIN(A, _reserve)(A *self, const size_t new_size)
     if (self->buckets)
     {
         // LOG("_reserve %zu realloc => %zu\n", self->bucket_count, new_size);
-        self->buckets = (B **)realloc(self->buckets, new_size * sizeof(B *));
+        self->buckets = (B **)ctl_realloc(self->allocator, self->buckets, bucket_count * sizeof(B *), new_size * sizeof(B *));
         if (new_size > bucket_count)
             memset(&self->buckets[bucket_count], 0, (new_size - bucket_count) * sizeof(B *));
     }
     else
     {
         // LOG("_reserve %zu calloc => %zu\n", self->bucket_count, new_size);
-        self->buckets = (B **)calloc(new_size, sizeof(B *));
+        self->buckets = (B **)ctl_calloc(self->allocator, new_size, sizeof(B *));
     }
     self->bucket_max = new_size - 1;
     if (self->size > 127)
@@ -603,12 +604,13 @@ static inline void JOIN(A, reserve)(A *self, size_t desired_count)
     JOIN(A, _rehash)(self, new_size);
 }
 
-static inline A JOIN(A, init)(size_t (*_hash)(T *), int (*_equal)(T *, T *))
+static inline A JOIN(A, _init_with)(size_t (*_hash)(T *), int (*_equal)(T *, T *), ctl_allocator *allocator)
 {
     static A zero;
     A self = zero;
     self.hash = _hash;
     self.equal = _equal;
+    self.allocator = allocator;
 #ifdef POD
     self.copy = JOIN(A, implicit_copy);
     _JOIN(A, _set_default_methods)(&self);
@@ -621,6 +623,11 @@ static inline A JOIN(A, init)(size_t (*_hash)(T *), int (*_equal)(T *, T *))
     return self;
 }
 
+static inline A JOIN(A, init)(size_t (*_hash)(T *), int (*_equal)(T *, T *))
+{
+    return JOIN(A, _init_with)(_hash, _equal, NULL);
+}
+
 static inline A JOIN(A, init_from)(A *copy)
 {
     static A zero;
@@ -633,14 +640,33 @@ static inline A JOIN(A, init_from)(A *copy)
 #endif
     self.hash = copy->hash;
     self.equal = copy->equal;
+    self.allocator = copy->allocator;
     return self;
 }
 
+// only while empty (its buckets are moved over). Nodes are all the same size, so a pool
+// suits them (see <ctl/allocator.h>); the buckets, being larger, go to its fallback.
+static inline void JOIN(A, set_allocator)(A *self, ctl_allocator *allocator)
+{
+    ASSERT(!self->size || !"set_allocator on a non-empty uset");
+    if (self->buckets)
+    {
+        size_t bucket_count = self->bucket_max + 1;
+        ctl_free(self->allocator, self->buckets, bucket_count * sizeof(B *));
+        self->buckets = NULL;
+        self->bucket_max = 0;
+        self->allocator = allocator;
+        JOIN(A, _reserve)(self, bucket_count);
+    }
+    else
+        self->allocator = allocator;
+}
+
 static inline void JOIN(A, rehash)(A *self, size_t desired_count)
 {
     if (desired_count == (self->bucket_max + 1))
         return;
-    A rehashed = JOIN(A, init)(self->hash, self->equal);
+    A rehashed = JOIN(A, _init_with)(self->hash, self->equal, self->allocator);
     JOIN(A, reserve)(&rehashed, desired_count);
     if (LIKELY(self->buckets && self->size)) // if desired_count 0
     {
@@ -660,7 +686,7 @@ static inline void JOIN(A, rehash)(A *self, size_t desired_count)
     rehashed.size = self->size;
     // LOG ("rehash temp. from %lu to %lu, load %f\n", rehashed.size, rehashed.bucket_count,
     //     JOIN(A, load_factor)(self));
-    free(self->buckets);
+    ctl_free(self->allocator, self->buckets, (self->bucket_max + 1) * sizeof(B *));
     // LOG ("free old\n");
     *self = rehashed;
 }
@@ -671,7 +697,7 @@ static inline void JOIN(A, _rehash)(A *self, size_t count)
     // we do allow shrink here
     if (count == self->bucket_max + 1)
         return;
-    A rehashed = JOIN(A, init)(self->hash, self->equal);
+    A rehashed = JOIN(A, _init_with)(self->hash, self->equal, self->allocator);
     LOG("_rehash %zu => %zu\n", self->size, count);
     JOIN(A, _reserve)(&rehashed, count);
 
@@ -693,7 +719,7 @@ static inline void JOIN(A, _rehash)(A *self, size_t count)
     rehashed.size = self->size;
     LOG ("_rehash from %lu to %lu, load %f\n", rehashed.size, count,
          JOIN(A, load_factor)(self));
-    free(self->buckets);
+    ctl_free(self->allocator, self->buckets, (self->bucket_max + 1) * sizeof(B *));
     *self = rehashed;
 }
 
@@ -794,10 +820,10 @@ static inline B **JOIN(A, push_cached)(A *self, T *value)
 #ifdef CTL_USET_CACHED_HASH
     size_t hash = self->hash(value);
     B **buckets = JOIN(A, _bucket_hash)(self, hash);
-    JOIN(B, push)(buckets, JOIN(B, init_cached)(*value, hash));
+    JOIN(B, push)(buckets, JOIN(B, init_cached)(self->allocator, *value, hash));
 #else
     B **buckets = JOIN(A, _bucket)(self, *value);
-    JOIN(B, push)(buckets, JOIN(B, init)(*value));
+    JOIN(B, push)(buckets, JOIN(B, init)(self->allocator, *value));
 #endif
     // LOG ("push_bucket[%zu]\n", JOIN(B, bucket_size)(*buckets));
     self->size++;
@@ -948,7 +974,7 @@ static inline I JOIN(A, emplace_hint)(I *pos, T *value)
 #if CTL_USET_SECURITY_COLLCOUNTING == 4 || CTL_USET_SECURITY_COLLCOUNTING == 5
     not_found:
 #endif
-        B *node = (B *)calloc(1, sizeof(B));
+        B *node = (B *)ctl_calloc(self->allocator, 1, sizeof(B));
         memcpy(&node->value, value, sizeof(T));
 #if CTL_USET_SECURITY_COLLCOUNTING == 4
         if (self->is_sorted_vector)
@@ -1002,7 +1028,7 @@ static inline void JOIN(A, free)(A *self)
 {
     // LOG("free calloc %zu, %zu\n", self->bucket_max, self->size);
     JOIN(A, clear)(self);
-    free(self->buckets);
+    ctl_free(self->allocator, self->buckets, (self->bucket_max + 1) * sizeof(B *));
     self->buckets = NULL;
     self->bucket_max = 0;
 }
@@ -1105,7 +1131,7 @@ static inline size_t JOIN(A, erase_if)(A *self, int (*_match)(T *))
 static inline A JOIN(A, copy)(A *self)
 {
     // LOG ("copy\norig size: %lu\n", self->size);
-    A other = JOIN(A, init)(self->hash, self->equal);
+    A other = JOIN(A, _init_with)(self->hash, self->equal, self->allocator);
     JOIN(A, _reserve)(&other, self->bucket_max + 1);
     foreach (A, self, it)
     {
@@ -1144,7 +1170,7 @@ static inline void JOIN(A, erase_generic)(A* self, GI *range)
 
 static inline A JOIN(A, union)(A *a, A *b)
 {
-    A self = JOIN(A, init)(a->hash, a->equal);
+    A self = JOIN(A, _init_with)(a->hash, a->equal, a->allocator);
     JOIN(A, _reserve)(&self, 1 + MAX(a->bucket_max, b->bucket_max));
     foreach (A, a, it1)
         JOIN(A, insert)(&self, self.copy(it1.ref));
@@ -1172,7 +1198,7 @@ static inline A JOIN(A, union_range)(I *r1, GI *r2)
 
 static inline A JOIN(A, intersection)(A *a, A *b)
 {
-    A self = JOIN(A, init)(a->hash, a->equal);
+    A self = JOIN(A, _init_with)(a->hash, a->equal, a->allocator);
     foreach (A, a, it)
         if (JOIN(A, find_node)(b, *it.ref))
             JOIN(A, insert)(&self, self.copy(it.ref));
@@ -1182,7 +1208,7 @@ static inline A JOIN(A, intersection)(A *a, A *b)
 static inline A JOIN(A, intersection_range)(I *r1, GI *r2)
 {
     A *a = r1->container;
-    A self = JOIN(A, init)(a->hash, a->equal);
+    A self = JOIN(A, _init_with)(a->hash, a->equal, a->allocator);
     void (*next2)(struct I*) = r2->vtable.next;
     T* (*ref2)(struct I*) = r2->vtable.ref;
     int (*done2)(struct I*) = r2->vtable.done;
@@ -1204,7 +1230,7 @@ static inline A JOIN(A, intersection_range)(I *r1, GI *r2)
 
 static inline A JOIN(A, difference)(A *a, A *b)
 {
-    A self = JOIN(A, init)(a->hash, a->equal);
+    A self = JOIN(A, _init_with)(a->hash, a->equal, a->allocator);
     foreach (A, a, it)
         if (!JOIN(A, find_node)(b, *it.ref))
             JOIN(A, insert)(&self, self.copy(it.ref));
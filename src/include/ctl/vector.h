@@ -29,6 +29,7 @@ typedef struct A
     T (*copy)(T *);
     int (*compare)(T *, T *); // 2-way operator<
     int (*equal)(T *, T *);   // optional
+    ctl_allocator *allocator; // optional, else the heap
     size_t size;
     size_t capacity;
 } A;
@@ -199,9 +200,17 @@ static inline A JOIN(A, init_from)(A *copy)
     self.copy = copy->copy;
     self.compare = copy->compare;
     self.equal = copy->equal;
+    self.allocator = copy->allocator;
     return self;
 }
 
+// only while empty, and holding no memory: before the first push, say.
+static inline void JOIN(A, set_allocator)(A *self, ctl_allocator *allocator)
+{
+    ASSERT(!self->vector || !"set_allocator after allocating");
+    self->allocator = allocator;
+}
+
 // not bounds-checked. like operator[]
 static inline void JOIN(A, set)(A *self, size_t index, T value)
 {
@@ -226,7 +235,8 @@ static inline void JOIN(A, fit)(A *self, size_t capacity)
         overall++;
     if (self->vector)
     {
-        self->vector = (T *)realloc(self->vector, overall * sizeof(T));
+        size_t old_overall = self->capacity + (MUST_ALIGN_16(T) ? 1 : 0);
+        self->vector = (T *)ctl_realloc(self->allocator, self->vector, old_overall * sizeof(T), overall * sizeof(T));
         if (MUST_ALIGN_16(T))
         {
 #if 0
@@ -240,7 +250,7 @@ static inline void JOIN(A, fit)(A *self, size_t capacity)
         }
     }
     else
-        self->vector = (T *)calloc(overall, sizeof(T));
+        self->vector = (T *)ctl_calloc(self->allocator, overall, sizeof(T));
     self->capacity = capacity;
 }
 
@@ -268,10 +278,12 @@ static inline void JOIN(A, free)(A *self)
     JOIN(A, clear)(self);
     JOIN(A, compare_fn) *compare = &self->compare;
     JOIN(A, compare_fn) *equal = &self->equal;
-    free(self->vector);
+    ctl_allocator *allocator = self->allocator;
+    ctl_free(allocator, self->vector, (self->capacity + (MUST_ALIGN_16(T) ? 1 : 0)) * sizeof(T));
     *self = JOIN(A, init)();
     self->compare = *compare;
     self->equal = *equal;
+    self->allocator = allocator;
 }
 
 static inline void JOIN(A, reserve)(A *self, const size_t n)
@@ -613,44 +625,315 @@ static inline void JOIN(A, swap)(A *self, A *other)
     JOIN(A, shrink_to_fit)(self);
 }
 
+/* Sorting: introsort, a median-of-three quicksort which falls back to heapsort
+   past 2 log2(n) levels (so is never quadratic), finishing small ranges with
+   insertion sort. Integer PODs sorted by the default compare take a radix sort
+   instead: least significant byte first, skipping bytes that are all the same.
+
+   With CTL_PARALLEL_SORT defined (and pthreads), vec_T_parallel_sort sorts
+   large vectors on several threads: each sorts a run, then runs are merged
+   pairwise, in parallel too. */
+
+#ifndef CTL_SORT_INSERTION_CUTOFF
+#define CTL_SORT_INSERTION_CUTOFF 16
+#endif
+
+static inline void JOIN(A, _insertion_sort)(T *v, size_t n, int _compare(T *, T *))
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        T key = v[i];
+        size_t j = i;
+        for (; j > 0 && _compare(&key, &v[j - 1]); j--)
+            v[j] = v[j - 1];
+        v[j] = key;
+    }
+}
+
+static inline void JOIN(A, _sift_down)(T *v, size_t root, size_t n, int _compare(T *, T *))
+{
+    for (size_t child; (child = 2 * root + 1) < n; root = child)
+    {
+        if (child + 1 < n && _compare(&v[child], &v[child + 1]))
+            child++;
+        if (!_compare(&v[root], &v[child]))
+            return;
+        SWAP(T, &v[root], &v[child]);
+    }
+}
+
+static inline void JOIN(A, _heap_sort)(T *v, size_t n, int _compare(T *, T *))
+{
+    for (size_t i = n / 2; i-- > 0;)
+        JOIN(A, _sift_down)(v, i, n, _compare);
+    for (size_t end = n; end-- > 1;)
+    {
+        SWAP(T, &v[0], &v[end]);
+        JOIN(A, _sift_down)(v, 0, end, _compare);
+    }
+}
+
+static inline void JOIN(A, _intro_sort)(T *v, size_t n, size_t depth, int _compare(T *, T *))
+{
+    while (n > CTL_SORT_INSERTION_CUTOFF)
+    {
+        if (depth-- == 0)
+        {
+            JOIN(A, _heap_sort)(v, n, _compare);
+            return;
+        }
+
+        // Order first, middle and last; the median (the pivot) goes to v[0], and the
+        // other two stop the partition scans from running off either end.
+        size_t mid = n / 2;
+        if (_compare(&v[mid], &v[0]))
+            SWAP(T, &v[mid], &v[0]);
+        if (_compare(&v[n - 1], &v[mid]))
+        {
+            SWAP(T, &v[n - 1], &v[mid]);
+            if (_compare(&v[mid], &v[0]))
+                SWAP(T, &v[mid], &v[0]);
+        }
+        SWAP(T, &v[0], &v[mid]);
+
+        // Hoare partition: equal keys split evenly, so duplicates don't degrade it.
+        size_t i = 0, j = n;
+        for (;;)
+        {
+            do
+                i++;
+            while (_compare(&v[i], &v[0]));
+            do
+                j--;
+            while (_compare(&v[0], &v[j]));
+            if (i >= j)
+                break;
+            SWAP(T, &v[i], &v[j]);
+        }
+        SWAP(T, &v[0], &v[j]);
+
+        // Recurse into the smaller side and loop on the larger, so the stack stays logarithmic.
+        if (j < n - j - 1)
+        {
+            JOIN(A, _intro_sort)(v, j, depth, _compare);
+            v += j + 1;
+            n -= j + 1;
+        }
+        else
+        {
+            JOIN(A, _intro_sort)(v + j + 1, n - j - 1, depth, _compare);
+            n = j;
+        }
+    }
+    JOIN(A, _insertion_sort)(v, n, _compare);
+}
+
+static inline size_t JOIN(A, _sort_depth)(size_t n)
+{
+    size_t depth = 0;
+    while (n >>= 1)
+        depth++;
+    return 2 * depth;
+}
+
+// sorts [a, b], inclusive.
 static inline void JOIN(A, _ranged_sort)(A *self, size_t a, size_t b, int _compare(T *, T *))
 {
     if (UNLIKELY(a >= b))
         return;
-    // TODO insertion_sort cutoff
-    // long mid = (a + b) / 2; // overflow!
-    // Dietz formula http://aggregate.org/MAGIC/#Average%20of%20Integers
-    size_t mid = ((a ^ b) >> 1) + (a & b);
-    // LOG("sort \"%s\" %ld, %ld\n", self->vector, a, b);
-    SWAP(T, &self->vector[a], &self->vector[mid]);
-    size_t z = a;
-    // check overflow of a + 1
-    if (LIKELY(a + 1 > a))
-        for (size_t i = a + 1; i <= b; i++)
-            if (_compare(&self->vector[i], &self->vector[a]))
-            {
-                z++;
-                SWAP(T, &self->vector[z], &self->vector[i]);
-            }
-    SWAP(T, &self->vector[a], &self->vector[z]);
-    if (LIKELY(z))
-        JOIN(A, _ranged_sort)(self, a, z - 1, _compare);
-    // check overflow of z + 1
-    if (LIKELY(z + 1 > z))
-        JOIN(A, _ranged_sort)(self, z + 1, b, _compare);
+    size_t n = b - a + 1;
+    JOIN(A, _intro_sort)(&self->vector[a], n, JOIN(A, _sort_depth)(n), _compare);
+}
+
+#if defined(POD) && !defined(NOT_INTEGRAL) && !defined(CTL_STR)
+// Integral PODs may be floating point too, which radix sort doesn't order.
+#define CTL_SORT_IS_INTEGER _Generic((T)0, float : 0, double : 0, long double : 0, default : 1)
+#define CTL_SORT_RADIX_MIN 64
+
+// the value's bits, with the sign flipped, so keys order as values do.
+static inline uint64_t JOIN(A, _radix_key)(T value)
+{
+    uint64_t key = (uint64_t)value;
+    if ((T)-1 < (T)1) // signed
+        key ^= UINT64_C(1) << (sizeof(T) * 8 - 1);
+    return key;
+}
+
+// false if out of memory, leaving v as it was.
+static inline bool JOIN(A, _radix_sort)(T *v, size_t n)
+{
+    T *scratch = (T *)malloc(n * sizeof(T));
+    if (!scratch)
+        return false;
+
+    T *from = v, *to = scratch;
+    for (unsigned shift = 0; shift < sizeof(T) * 8; shift += 8)
+    {
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < n; i++)
+            counts[(JOIN(A, _radix_key)(from[i]) >> shift) & 0xFF]++;
+
+        // all in one bucket: this byte is the same throughout, and orders nothing.
+        if (counts[(JOIN(A, _radix_key)(from[0]) >> shift) & 0xFF] == n)
+            continue;
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            size_t count = counts[b];
+            counts[b] = offset;
+            offset += count;
+        }
+        for (size_t i = 0; i < n; i++)
+            to[counts[(JOIN(A, _radix_key)(from[i]) >> shift) & 0xFF]++] = from[i];
+
+        T *swap = from;
+        from = to;
+        to = swap;
+    }
+
+    if (from != v)
+        memcpy(v, from, n * sizeof(T));
+    free(scratch);
+    return true;
+}
+#endif
+
+// sorts n elements from v, as sort does.
+static inline void JOIN(A, _sort_run)(A *self, T *v, size_t n)
+{
+#if defined(POD) && !defined(NOT_INTEGRAL) && !defined(CTL_STR)
+    if (CTL_SORT_IS_INTEGER && n >= CTL_SORT_RADIX_MIN && self->compare == _JOIN(A, _default_integral_compare) &&
+        JOIN(A, _radix_sort)(v, n))
+        return;
+#else
+    (void)self;
+#endif
+    if (n > 1)
+        JOIN(A, _intro_sort)(v, n, JOIN(A, _sort_depth)(n), self->compare);
 }
 
 static inline void JOIN(A, sort)(A *self)
 {
     CTL_ASSERT_COMPARE
-    // TODO insertion_sort cutoff
-    if (self->size > 1)
-        JOIN(A, _ranged_sort)(self, 0, self->size - 1, self->compare);
+    JOIN(A, _sort_run)(self, self->vector, self->size);
     //#ifdef CTL_STR
     //    self->vector[self->size] = '\0';
     //#endif
 }
 
+#ifdef CTL_PARALLEL_SORT
+#include <pthread.h>
+
+// smaller vectors sort on the calling thread.
+#ifndef CTL_PARALLEL_SORT_MIN
+#define CTL_PARALLEL_SORT_MIN 32768
+#endif
+#ifndef CTL_PARALLEL_SORT_MAX_THREADS
+#define CTL_PARALLEL_SORT_MAX_THREADS 16
+#endif
+
+typedef struct JOIN(A, _sort_job)
+{
+    A *self;
+    T *v;
+    size_t n;
+    // merging only: where the second run starts, and where both go.
+    size_t mid;
+    T *out;
+} JOIN(A, _sort_job);
+
+static inline void *JOIN(A, _sort_job_run)(void *arg)
+{
+    JOIN(A, _sort_job) *job = (JOIN(A, _sort_job) *)arg;
+    JOIN(A, _sort_run)(job->self, job->v, job->n);
+    return NULL;
+}
+
+static inline void *JOIN(A, _merge_job_run)(void *arg)
+{
+    JOIN(A, _sort_job) *job = (JOIN(A, _sort_job) *)arg;
+    int (*_compare)(T *, T *) = job->self->compare;
+    T *a = job->v, *a_end = job->v + job->mid;
+    T *b = a_end, *b_end = job->v + job->n;
+    T *out = job->out;
+    // ties go to the first run.
+    while (a < a_end && b < b_end)
+        *out++ = _compare(b, a) ? *b++ : *a++;
+    while (a < a_end)
+        *out++ = *a++;
+    while (b < b_end)
+        *out++ = *b++;
+    return NULL;
+}
+
+// runs all jobs but the last on threads of their own, the last on this one, and waits.
+static inline void JOIN(A, _run_jobs)(void *(*run)(void *), JOIN(A, _sort_job) *jobs, unsigned count)
+{
+    pthread_t threads[CTL_PARALLEL_SORT_MAX_THREADS];
+    bool started[CTL_PARALLEL_SORT_MAX_THREADS] = {false};
+    for (unsigned i = 0; i + 1 < count; i++)
+        started[i] = pthread_create(&threads[i], NULL, run, &jobs[i]) == 0;
+    run(&jobs[count - 1]);
+    for (unsigned i = 0; i + 1 < count; i++)
+    {
+        // a thread that couldn't be started runs its job here instead.
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            run(&jobs[i]);
+    }
+}
+
+// sorts on up to `threads` threads, this one included. Small vectors (or one thread,
+// or no memory for merging) sort as sort does.
+static inline void JOIN(A, parallel_sort)(A *self, unsigned threads)
+{
+    CTL_ASSERT_COMPARE
+    if (threads > CTL_PARALLEL_SORT_MAX_THREADS)
+        threads = CTL_PARALLEL_SORT_MAX_THREADS;
+    T *scratch = threads > 1 && self->size >= CTL_PARALLEL_SORT_MIN ? (T *)malloc(self->size * sizeof(T)) : NULL;
+    if (!scratch)
+    {
+        JOIN(A, sort)(self);
+        return;
+    }
+
+    // runs as even as can be, each sorted on its own.
+    size_t bounds[CTL_PARALLEL_SORT_MAX_THREADS + 1];
+    JOIN(A, _sort_job) jobs[CTL_PARALLEL_SORT_MAX_THREADS];
+    for (unsigned i = 0; i <= threads; i++)
+        bounds[i] = self->size * i / threads;
+    for (unsigned i = 0; i < threads; i++)
+        jobs[i] = (JOIN(A, _sort_job)){self, &self->vector[bounds[i]], bounds[i + 1] - bounds[i], 0, NULL};
+    JOIN(A, _run_jobs)(JOIN(A, _sort_job_run), jobs, threads);
+
+    // merge neighbouring runs, back and forth between the vector and scratch, until one is left.
+    T *from = self->vector, *to = scratch;
+    for (unsigned runs = threads; runs > 1; runs = (runs + 1) / 2)
+    {
+        unsigned count = 0;
+        for (unsigned i = 0; i < runs; i += 2)
+        {
+            size_t start = bounds[i], mid = bounds[i + 1];
+            size_t end = i + 2 <= runs ? bounds[i + 2] : mid;
+            jobs[count++] = (JOIN(A, _sort_job)){self, &from[start], end - start, mid - start, &to[start]};
+            bounds[i / 2] = start;
+        }
+        bounds[count] = self->size;
+        JOIN(A, _run_jobs)(JOIN(A, _merge_job_run), jobs, count);
+
+        T *swap = from;
+        from = to;
+        to = swap;
+    }
+
+    if (from != self->vector)
+        memcpy(self->vector, from, self->size * sizeof(T));
+    free(scratch);
+}
+#endif // CTL_PARALLEL_SORT
+
 static inline A JOIN(A, copy)(A *self)
 {
     A other = JOIN(A, init_from)(self);
@@ -720,6 +1003,8 @@ static inline A *JOIN(A, move_range)(I *range, A *out)
 #undef I
 #undef MUST_ALIGN_16
 #undef INIT_SIZE
+#undef CTL_SORT_IS_INTEGER
+#undef CTL_SORT_RADIX_MIN
 
 // Hold preserves `T` if other containers
 // (eg. `priority_queue.h`) wish to extend `vector.h`.
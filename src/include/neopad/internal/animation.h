@@ -0,0 +1,136 @@
+//
+// Created by Dylan Lukes on 8/28/23.
+//
+// Animations: values moving toward targets in real time, independent of the frame rate. Each
+// channel is a critically damped spring (which carries velocity, so retargeting is smooth) or
+// an exponential decay, stepped exactly (not by Euler steps), so long frames never overshoot.
+//
+// Channels live in a fixed pool, a field per array, and are all stepped at once, by
+// neopad_animator_update, once a frame. Channels at rest cost nothing.
+//
+// Flights take the view from one place and zoom to another along the path that zooms out just
+// enough to keep both in sight (van Wijk and Nuij, "Smooth and Efficient Zooming and Panning"),
+// as for Pad++ portals.
+
+#ifndef NEOPAD_ANIMATION_INTERNAL_H
+#define NEOPAD_ANIMATION_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "neopad/types.h"
+
+/// Most channels at once.
+#define NEOPAD_ANIMATION_CHANNELS 64
+
+/// No channel (as returned when the pool is full).
+#define NEOPAD_ANIMATION_NONE (-1)
+
+/// Identifies a channel, until it is removed.
+typedef int32_t neopad_animation_id_t;
+
+typedef enum neopad_animation_kind_e {
+    /// A critically damped spring: as fast as possible without overshooting.
+    /// The rate is its angular frequency (settling in about 5 / rate seconds).
+    NEOPAD_ANIMATION_SPRING,
+
+    /// Exponential decay: the distance to the target shrinks by a factor of e every 1 / rate seconds.
+    NEOPAD_ANIMATION_DECAY,
+} neopad_animation_kind_t;
+
+typedef struct neopad_animator_s {
+    double value[NEOPAD_ANIMATION_CHANNELS];
+    double velocity[NEOPAD_ANIMATION_CHANNELS];
+    double target[NEOPAD_ANIMATION_CHANNELS];
+
+    /// Per second (see neopad_animation_kind_t).
+    double rate[NEOPAD_ANIMATION_CHANNELS];
+
+    /// How near its target (and how slow) a channel must be to come to rest there.
+    double precision[NEOPAD_ANIMATION_CHANNELS];
+
+    neopad_animation_kind_t kind[NEOPAD_ANIMATION_CHANNELS];
+
+    /// Channels in use, and channels not at rest, as bits.
+    uint64_t used;
+    uint64_t moving;
+} neopad_animator_t;
+
+_Static_assert(NEOPAD_ANIMATION_CHANNELS <= 64, "Channels must fit in a mask");
+
+void neopad_animator_init(neopad_animator_t *this);
+
+/// Add a channel, at rest at a value.
+/// @return The channel, or NEOPAD_ANIMATION_NONE if the pool is full.
+neopad_animation_id_t neopad_animator_add(neopad_animator_t *this,
+                                          neopad_animation_kind_t kind,
+                                          double value,
+                                          double rate,
+                                          double precision);
+
+void neopad_animator_remove(neopad_animator_t *this, neopad_animation_id_t id);
+
+/// Move a channel toward a target, from where it is (keeping its velocity).
+void neopad_animator_set_target(neopad_animator_t *this, neopad_animation_id_t id, double target);
+
+/// Put a channel at a value, at rest.
+void neopad_animator_set_value(neopad_animator_t *this, neopad_animation_id_t id, double value);
+
+void neopad_animator_set_precision(neopad_animator_t *this, neopad_animation_id_t id, double precision);
+
+/// Step every moving channel.
+/// @param dt Seconds since the last update.
+void neopad_animator_update(neopad_animator_t *this, double dt);
+
+static inline double neopad_animator_value(const neopad_animator_t *this, neopad_animation_id_t id) {
+    return this->value[id];
+}
+
+static inline double neopad_animator_target(const neopad_animator_t *this, neopad_animation_id_t id) {
+    return this->target[id];
+}
+
+static inline bool neopad_animator_is_channel_moving(const neopad_animator_t *this, neopad_animation_id_t id) {
+    return (this->moving & (UINT64_C(1) << id)) != 0;
+}
+
+/// Whether any channel is moving.
+static inline bool neopad_animator_is_moving(const neopad_animator_t *this) {
+    return this->moving != 0;
+}
+
+#pragma mark - Flights
+
+typedef struct neopad_flight_s {
+    bool is_active;
+
+    /// Centers of the views, and their widths (in world units), at each end.
+    neopad_dvec2_t from;
+    neopad_dvec2_t to;
+    double from_width;
+    double to_width;
+
+    /// The path: its length (in the paper's units, where zooming by e is one), and where it starts.
+    double length;
+    double r0;
+
+    double elapsed;
+    double duration;
+} neopad_flight_t;
+
+/// Start a flight between two views.
+/// @param duration In seconds, or 0 for one in proportion to the length of the path.
+void neopad_flight_begin(neopad_flight_t *this,
+                         neopad_dvec2_t from, double from_width,
+                         neopad_dvec2_t to, double to_width,
+                         double duration);
+
+/// Step a flight, getting the view along it.
+/// @param dt Seconds since the last step.
+/// @return Whether the flight goes on (if not, the view is the end of it).
+bool neopad_flight_update(neopad_flight_t *this, double dt, neopad_dvec2_t *center, double *width);
+
+/// The widest view along a flight (for working out what it might show).
+void neopad_flight_peak(const neopad_flight_t *this, neopad_dvec2_t *center, double *width);
+
+#endif //NEOPAD_ANIMATION_INTERNAL_H
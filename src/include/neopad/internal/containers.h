@@ -0,0 +1,34 @@
+//
+// Created by Dylan Lukes on 8/20/23.
+//
+// Instantiations of the CTL containers used internally. CTL containers are templated
+// through macros, so each one may only be instantiated once per translation unit: do it
+// here, and include this header instead of the CTL headers directly.
+
+#ifndef NEOPAD_CONTAINERS_INTERNAL_H
+#define NEOPAD_CONTAINERS_INTERNAL_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "neopad/types.h"
+#include "neopad/internal/renderer.h"
+
+// vec_uint32_t
+#define POD
+#define T uint32_t
+#include <ctl/vector.h>
+
+// vec_neopad_vec2_t
+#define POD
+#define NOT_INTEGRAL
+#define T neopad_vec2_t
+#include <ctl/vector.h>
+
+// vec_neopad_renderer_vertex_t
+#define POD
+#define NOT_INTEGRAL
+#define T neopad_renderer_vertex_t
+#include <ctl/vector.h>
+
+#endif //NEOPAD_CONTAINERS_INTERNAL_H
@@ -0,0 +1,70 @@
+//
+// Created by Dylan Lukes on 9/3/23.
+//
+// Job system: a pool of worker threads for spreading per-frame work (culling, tessellation, LOD
+// selection, rasterization) across cores. Each thread has a work-stealing deque (Chase-Lev): it
+// pushes and pops jobs at the bottom of its own, and idle threads steal from the top of others',
+// so work spreads out without a shared queue to contend on.
+//
+// Work is forked onto a counter, and joined by waiting for the counter to reach zero. A thread
+// waiting to join runs jobs (its own, or stolen) in the meantime, so jobs can fork and join jobs
+// of their own. Idle workers spin briefly, then sleep until more work is forked.
+//
+// The thread that creates the system (and any thread after it, one at a time) forks and joins
+// from a deque of its own, alongside the workers': it is never idle while it waits.
+
+#ifndef NEOPAD_JOBS_INTERNAL_H
+#define NEOPAD_JOBS_INTERNAL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Most worker threads (besides the thread that creates the system).
+#define NEOPAD_JOBS_MAX_WORKERS 63
+
+/// Jobs each thread's deque holds. Jobs forked onto a full deque are run there and then.
+#define NEOPAD_JOBS_DEQUE_CAPACITY 1024
+
+/// Times an idle worker looks for work before it sleeps.
+#define NEOPAD_JOBS_SPIN_COUNT 64
+
+typedef void (*neopad_job_fn)(void *data);
+
+/// Runs the items [begin, end) of a parallel for.
+typedef void (*neopad_job_range_fn)(void *context, size_t begin, size_t end);
+
+/// Jobs forked onto it, and not yet finished.
+typedef struct neopad_job_counter_s {
+    atomic_uint_fast32_t pending;
+} neopad_job_counter_t;
+
+#define NEOPAD_JOB_COUNTER_INIT {0}
+
+typedef struct neopad_jobs_s *neopad_jobs_t;
+
+/// Start a job system.
+/// @param workers Worker threads, or 0 for one per core (less the calling thread).
+/// @return The system, or NULL if it could not be started.
+neopad_jobs_t neopad_jobs_create(uint32_t workers);
+
+/// Stop the workers (after any jobs they are running) and free the system.
+/// @note Everything forked must have been joined.
+void neopad_jobs_destroy(neopad_jobs_t this);
+
+/// Threads that run jobs: the workers, and the thread joining.
+/// @note 1 for a NULL system (see below).
+uint32_t neopad_jobs_thread_count(neopad_jobs_t this);
+
+/// Fork a job onto a counter, to be run by any thread.
+/// @note With a NULL system, jobs are run there and then (as are parallel fors).
+void neopad_jobs_fork(neopad_jobs_t this, neopad_job_fn fn, void *data, neopad_job_counter_t *counter);
+
+/// Run jobs until every job forked onto a counter has finished.
+void neopad_jobs_join(neopad_jobs_t this, neopad_job_counter_t *counter);
+
+/// Run fn over [0, count) in ranges of (at most) `grain` items, across threads, and join them.
+/// @note Ranges run in no particular order, and concurrently: fn must only write what its items own.
+void neopad_jobs_parallel_for(neopad_jobs_t this, size_t count, size_t grain, neopad_job_range_fn fn, void *context);
+
+#endif //NEOPAD_JOBS_INTERNAL_H
@@ -0,0 +1,88 @@
+//
+// Created by Dylan Lukes on 8/22/23.
+//
+// The profiler records what each frame spent, and where, into a ring of recent frames.
+// It is embedded in the renderer; modules only bump the counters in their base.
+
+#ifndef NEOPAD_PROFILE_INTERNAL_H
+#define NEOPAD_PROFILE_INTERNAL_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "neopad/profile.h"
+
+typedef struct neopad_profiler_s {
+    bool enabled;
+
+    /// Ring of the last NEOPAD_PROFILE_FRAMES frames (allocated when first enabled).
+    neopad_profile_frame_t *frames;
+
+    /// Slot the next frame goes in, and the number of frames recorded.
+    size_t head;
+    size_t count;
+
+    /// Index of the next frame.
+    uint64_t next_index;
+
+    /// Counter value times are measured from, and how to convert counter ticks to milliseconds.
+    int64_t epoch;
+    double to_ms;
+
+    /// The frame in progress. Its module_count is zero when no frame is in progress.
+    neopad_profile_frame_t current;
+
+    /// Bumped around writes to the ring (and the fields above it), so that the application thread
+    /// of a threaded renderer can read it while the API thread records frames.
+    /// @note A seqlock: the sequence is odd while the ring is being written.
+    atomic_uint sequence;
+
+    /// The last frame read on the application thread (see neopad_profiler_read_frame).
+    neopad_profile_frame_t front;
+} neopad_profiler_t;
+
+void neopad_profiler_init(neopad_profiler_t *this);
+void neopad_profiler_free(neopad_profiler_t *this);
+
+/// Turn recording on (starting over) or off.
+void neopad_profiler_set_enabled(neopad_profiler_t *this, bool enabled);
+
+/// Milliseconds since the profiler was initialized.
+double neopad_profiler_now(const neopad_profiler_t *this);
+
+/// Start a new frame, made up of `module_count` modules.
+void neopad_profiler_begin_frame(neopad_profiler_t *this, uint32_t module_count);
+
+/// Record a module's part in a phase of the current frame.
+void neopad_profiler_record(neopad_profiler_t *this, uint32_t module, const char *name,
+                            neopad_profile_phase_t phase, double start_ms, double end_ms);
+
+/// Whether a frame has begun (and not yet ended).
+static inline bool neopad_profiler_in_frame(const neopad_profiler_t *this) {
+    return this->enabled && this->current.module_count > 0;
+}
+
+/// Finish the current frame, adding it to the ring.
+/// @param submit_ms When the frame was submitted (bgfx_frame was called).
+/// @param end_ms When submission finished.
+/// @param gpu_ms GPU time, as reported by bgfx.
+void neopad_profiler_end_frame(neopad_profiler_t *this, double submit_ms, double end_ms, double gpu_ms);
+
+/// Recorded frame by age (0 is the newest), or NULL.
+/// @note On the thread recording frames (or once it has stopped).
+const neopad_profile_frame_t *neopad_profiler_get_frame(const neopad_profiler_t *this, size_t age);
+
+/// The number of frames recorded, from any thread.
+size_t neopad_profiler_read_count(const neopad_profiler_t *this);
+
+/// Copy a recorded frame by age into `front`, from any thread (one at a time).
+/// @return The copy, valid until the next read, or NULL if there is no such frame.
+const neopad_profile_frame_t *neopad_profiler_read_frame(neopad_profiler_t *this, size_t age);
+
+/// Copy the ring (and what says where in it frames are) into `dst`, from any thread.
+/// @return Whether there was memory for it. Free it with neopad_profiler_free.
+bool neopad_profiler_read_all(const neopad_profiler_t *this, neopad_profiler_t *dst);
+
+#endif //NEOPAD_PROFILE_INTERNAL_H
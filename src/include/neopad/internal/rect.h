@@ -0,0 +1,34 @@
+//
+// Created by Dylan Lukes on 8/21/23.
+//
+// Helpers for axis-aligned rectangles (rect_t).
+
+#ifndef NEOPAD_RECT_INTERNAL_H
+#define NEOPAD_RECT_INTERNAL_H
+
+#include <float.h>
+#include <stdbool.h>
+
+#include "neopad/object.h"
+
+/// An empty rectangle: the identity for rect_union, and overlapping nothing.
+#define RECT_EMPTY ((rect_t) {.min = {FLT_MAX, FLT_MAX}, .max = {-FLT_MAX, -FLT_MAX}})
+
+static inline void rect_union(const rect_t *a, const rect_t *b, rect_t *dst) {
+    dst->min[0] = a->min[0] < b->min[0] ? a->min[0] : b->min[0];
+    dst->min[1] = a->min[1] < b->min[1] ? a->min[1] : b->min[1];
+    dst->max[0] = a->max[0] > b->max[0] ? a->max[0] : b->max[0];
+    dst->max[1] = a->max[1] > b->max[1] ? a->max[1] : b->max[1];
+}
+
+static inline bool rect_overlaps(const rect_t *a, const rect_t *b) {
+    return a->min[0] <= b->max[0] && b->min[0] <= a->max[0]
+           && a->min[1] <= b->max[1] && b->min[1] <= a->max[1];
+}
+
+/// Half the perimeter of a rectangle.
+static inline float rect_half_perimeter(const rect_t *r) {
+    return (r->max[0] - r->min[0]) + (r->max[1] - r->min[1]);
+}
+
+#endif //NEOPAD_RECT_INTERNAL_H
@@ -8,6 +8,8 @@
 #ifndef NEOPAD_RENDERER_INTERNAL_H
 #define NEOPAD_RENDERER_INTERNAL_H
 
+#include <stdatomic.h>
+
 #include <cglm/vec2.h>
 
 #include "neopad/internal/shims/bgfx/embedded_shader.h"
@@ -15,18 +17,49 @@
 
 #include "neopad/types.h"
 #include "neopad/renderer.h"
+#include "neopad/internal/animation.h"
+#include "neopad/internal/jobs.h"
+#include "neopad/internal/profile.h"
+#include "neopad/internal/renderer/graph.h"
 #include "neopad/internal/renderer/module.h"
+#include "neopad/internal/renderer/registry.h"
+#include "neopad/internal/renderer/scratch.h"
+#include "neopad/internal/renderer/uniforms.h"
+
+/// Most renderers sharing bgfx (see neopad_renderer_init_t), each with a range of views of its own.
+#define NEOPAD_RENDERER_MAX_SHARING 4
+
+_Static_assert(NEOPAD_RENDERER_MAX_SHARING * NEOPAD_RENDERER_GRAPH_VIEWS <= 256, "Views must fit bgfx's default limit");
+
+/// Renderers sharing bgfx. The first initialized bgfx and draws into the back buffer; the others
+/// each draw into their own window. The primary submits frames (for all of them) and keeps the
+/// finished strokes: the first, until it shuts down, and then one of those left.
+typedef struct neopad_renderer_group_s {
+    neopad_renderer_t members[NEOPAD_RENDERER_MAX_SHARING];
+    uint32_t count;
+    neopad_renderer_t primary;
+
+    /// The member whose uniforms bgfx has (the last to begin a frame).
+    neopad_renderer_t uniforms_owner;
+
+    /// The frame being built, as numbered by bgfx_frame (for frame scratch).
+    uint32_t frame;
+
+    /// Workers for per-frame work, joined from the thread drawing (see neopad_renderer_jobs).
+    neopad_jobs_t jobs;
+} neopad_renderer_group_t;
 
 typedef struct bx_thread_s *bx_thread_t;
+typedef struct bx_semaphore_s *bx_semaphore_t;
+typedef struct bx_spsc_blocking_queue_s *bx_spsc_blocking_queue_t;
 
 // todo: these defines could collide?
 
 #define NEOPAD_PROGRAM_BASIC 0
 #define NEOPAD_PROGRAM_BACKGROUND 1
-#define NEOPAD_PROGRAM_COUNT 2
-
-#define NEOPAD_VIEW_BACKGROUND 0
-#define NEOPAD_VIEW_CONTENT 1
+#define NEOPAD_PROGRAM_TEXTURED 2
+#define NEOPAD_PROGRAM_SHAPE 3
+#define NEOPAD_PROGRAM_COUNT 4
 
 /// @note This is a pad-world coordinate.
 /// @note At zoom 1.0, these coordinates map to logical pixels.
@@ -36,18 +69,46 @@ typedef struct __attribute__ ((__packed__)) {
     uint32_t argb;
 } neopad_renderer_vertex_t;
 
-/// Structure matching defines in shaders/uniforms.sh
+/// Largest magnitude of a packed coordinate.
+#define NEOPAD_PACKED_VERTEX_RANGE 32767
+
+/// A vertex with its position quantized to 16 bits, for geometry that is kept around.
+/// @note Positions are normalized (to [-1, 1]) by the GPU, so the draw's transform scales them
+///       back up: by NEOPAD_PACKED_VERTEX_RANGE times the quantum (see neopad_renderer_set_packed_origin).
+typedef struct __attribute__ ((__packed__)) {
+    int16_t x;
+    int16_t y;
+    uint32_t argb;
+} neopad_renderer_packed_vertex_t;
+
+/// A shape drawn instanced: a unit quad stretched over a box (turned to an axis), inside which
+/// the fragment shader evaluates the shape's signed distance.
+/// @note Matches i_data0, i_data1 and i_data2 in shaders/vs_shape.sc.
 typedef struct {
-    float time;
-    float zoom;
-    float _unused1;
-    float _unused2;
+    /// Center of the box, relative to the draw's origin, and half its size.
+    vec2 center;
+    vec2 half_size;
+
+    /// Direction of the box's x axis, the radius of rounded shapes (lines), and the kind of
+    /// shape (a neopad_scene_object_kind_t).
+    vec2 axis;
+    float radius;
+    float kind;
 
-    float _unused3;
-    float _unused4;
-    float grid_major;
-    float grid_minor;
-} neopad_renderer_uniforms_t;
+    /// Color, in the order the basic program receives vertex colors in.
+    vec4 color;
+} neopad_renderer_shape_instance_t;
+
+_Static_assert(sizeof(neopad_renderer_shape_instance_t) % 16 == 0, "Instance data is a whole number of vec4s");
+
+/// What is needed to convert coordinates: the camera and zoom as of a frame, and inverse
+/// transforms, from NDC back to (camera-relative) world and screen coordinates.
+typedef struct neopad_renderer_view_s {
+    neopad_dvec2_t camera;
+    float zoom;
+    mat4 ndc_to_world;
+    mat4 ndc_to_screen;
+} neopad_renderer_view_t;
 
 struct neopad_renderer_s {
     /// Our own initialization parameters.
@@ -56,8 +117,47 @@ struct neopad_renderer_s {
     /// BGFX initialization parameters.
     bgfx_init_t bgfx_init;
 
-    /// The rendering thread.
-    bx_thread_t render_thread;
+    /// Renderers sharing bgfx with this one (itself included), and its place among them.
+    neopad_renderer_group_t *group;
+    uint32_t group_slot;
+
+    /// What the back buffer's passes draw into: the back buffer itself (BGFX_INVALID_HANDLE), or,
+    /// sharing bgfx with another renderer, a framebuffer for this renderer's own window.
+    bgfx_frame_buffer_handle_t window;
+
+    /// Threaded mode (see neopad/internal/renderer/commands.h).
+    struct {
+        /// Plays back commands: tessellation and bgfx submission happen there.
+        bx_thread_t api_thread;
+
+        /// Commands recorded by the application thread.
+        bx_spsc_blocking_queue_t commands;
+
+        /// Permits to record a frame. One is given back as each frame is played back.
+        bx_semaphore_t frames;
+
+        /// Posted when the API thread has started (or failed to), and when it stops.
+        bx_semaphore_t signal;
+        atomic_int state;
+
+        /// Targets as last recorded, to work out what might come into view.
+        neopad_dvec2_t target_camera;
+        float target_zoom;
+        uint32_t width;
+        uint32_t height;
+        float content_scale;
+
+        /// Whether the camera was last recorded to move with the zoom (zooming about a point, or
+        /// flying), so that arresting the zoom stops it too.
+        bool is_camera_carried;
+
+        /// The widest view along the last flight recorded, until the view comes to rest.
+        rect_t flight_rect;
+
+        /// Frames recorded, and played back (through bgfx_frame), to tell whether any are in flight.
+        uint32_t recorded_frames;
+        atomic_uint played_frames;
+    } thread;
 
     /// Back-buffer resolution.
     /// @note For high-DPI displays, this is the resolution before scaling down.
@@ -77,8 +177,10 @@ struct neopad_renderer_s {
     /// Offset. This controls the position of the camera.
     /// @note A value of 0 means the content is centered at (0, 0).
     /// @note In pad-world coordinates.
-    vec2 camera;
-    vec2 target_camera;
+    /// @note Double precision. Nothing on the GPU sees this directly: geometry is drawn relative to
+    ///       the camera (see neopad_renderer_set_origin), so precision holds however far out it is.
+    neopad_dvec2_t camera;
+    neopad_dvec2_t target_camera;
 
     /// Zoom. This controls how much of the content is visible.
     /// @note - A value of 0.5 means the content is displayed at 50%.
@@ -86,30 +188,172 @@ struct neopad_renderer_s {
     float zoom;
     float target_zoom;
 
+    /// Animations, stepped once a frame (in begin_frame), against real time.
+    /// @note Modules may add channels of their own.
+    neopad_animator_t animator;
+
+    /// How the camera and zoom get to their targets.
+    struct {
+        /// The camera decays toward its target; zoom (in log2, so it goes evenly) springs.
+        neopad_animation_id_t camera_x;
+        neopad_animation_id_t camera_y;
+        neopad_animation_id_t log_zoom;
+
+        /// Zooming about a point (in pad-world coordinates), which stays put on screen meanwhile:
+        /// its offset from the center of the view (in logical pixels) is kept.
+        bool is_anchored;
+        neopad_dvec2_t anchor;
+        neopad_dvec2_t anchor_offset;
+
+        /// Flying to the targets, rather.
+        neopad_flight_t flight;
+
+        /// When the animations were last stepped (in hp counter ticks), and whether all were at rest.
+        int64_t time;
+        bool is_resting;
+    } motion;
+
     /// Matrices.
     /// @note These are kept around to facilitate things like dragging,
     ///       which requires being able to translate between screen and
     ///       pad-world coordinates.
+    /// @note The view does not include the camera: it maps camera-relative coordinates.
     mat4 model;
     mat4 view;
     mat4 model_view;
     mat4 proj;
 
+    /// The view as of the last frame ended.
+    /// @note Computed once per frame (in end_frame), rather than for every point converted.
+    neopad_renderer_view_t frame_view;
+
+    /// The view as converted with on the application thread, and window to world and screen
+    /// transforms for the last viewport converted from (recomputed when either changes).
+    struct {
+        neopad_renderer_view_t view;
+        unsigned sequence;
+
+        bool is_valid;
+        neopad_vec4_t viewport;
+        mat4 to_world;
+        mat4 to_screen;
+    } front;
+
+    /// In threaded mode, the view is published by the API thread for the application thread.
+    /// @note A seqlock: the sequence is odd while the view is being written.
+    struct {
+        atomic_uint sequence;
+        neopad_renderer_view_t view;
+    } published;
+
+    /// What has changed since the last frame ended (see neopad_renderer_needs_frame).
+    /// @note Kept by the application thread, when threaded.
+    struct {
+        /// Everything in view has: the size, scale, camera or zoom, or a scene drawn.
+        bool is_full;
+
+        /// Otherwise, the area of the world that has (RECT_EMPTY if nothing has).
+        rect_t rect;
+
+        /// The last scene drawn, and its revision as it was drawn.
+        neopad_scene_t scene;
+        uint64_t scene_revision;
+    } dirty;
+
+    /// The part of the back buffer redrawn this frame, in pixels from the top left, with
+    /// partial_redraw. Zero-sized when the whole frame is.
+    neopad_ivec4_t scissor;
+
     /// Vertex layout(s).
     bgfx_vertex_layout_t vertex_layout;
+    bgfx_vertex_layout_t packed_vertex_layout;
 
     /// Programs (shader pipelines)
     bgfx_program_handle_t programs[NEOPAD_PROGRAM_COUNT];
 
-    /// Uniforms
-    neopad_renderer_uniforms_t uniforms;
-    bgfx_uniform_handle_t uniform_handle;
+    /// Uniforms, uploaded as they change (see neopad/internal/renderer/uniforms.h).
+    neopad_uniforms_t uniforms;
+
+    /// Memory for the frame being drawn, taken back all at once (see neopad_renderer_scratch).
+    neopad_frame_scratch_t scratch;
+
+    /// Modules, and the order they are called in.
+    neopad_renderer_registry_t modules;
+
+    /// Passes, and the views they are drawn in.
+    neopad_renderer_graph_t graph;
 
-    /// Modules
-    /// @todo Fix this (temporary hack), re later...: but why?
-    neopad_renderer_module_t modules[NEOPAD_RENDERER_MODULE_COUNT];
+    /// The content pass, as drawn into by the renderer itself (see neopad_renderer_draw_test_rect).
+    neopad_renderer_pass_id_t content_pass;
+
+    /// The built-in modules, as registered in init.
+    struct {
+        neopad_renderer_module_id_t background;
+        neopad_renderer_module_id_t vector;
+        neopad_renderer_module_id_t scene;
+    } builtin;
+
+    /// Frame and per-module timings (when enabled).
+    neopad_profiler_t profiler;
 };
 
+/// Initialize bgfx and the modules. In threaded mode, this happens on the API thread.
+bool neopad_renderer_init_bgfx(neopad_renderer_t this);
+
+/// The renderer whose finished strokes, and frames, all renderers sharing bgfx with this one share.
+static inline neopad_renderer_t neopad_renderer_group_primary(neopad_renderer_const_t this) {
+    return this->group->primary;
+}
+
+/// Whether the renderer draws into a window of its own (sharing bgfx), but has none: its framebuffer
+/// could not be made again, at a new size. Its passes into the back buffer are skipped meanwhile.
+static inline bool neopad_renderer_is_window_lost(neopad_renderer_const_t this) {
+    return this->init.share && !BGFX_HANDLE_IS_VALID(this->window);
+}
+
+/// Frame scratch, for the frame being drawn: allocations are valid until bgfx has rendered it
+/// (see neopad/internal/renderer/scratch.h).
+/// @note For modules, on the thread drawing (the API thread, if threaded).
+static inline neopad_frame_scratch_t *neopad_renderer_scratch(neopad_renderer_t this) {
+    neopad_frame_scratch_use(&this->scratch, this->group->frame);
+    return &this->scratch;
+}
+
+/// Job system for per-frame work, or NULL to run it on the thread drawing.
+/// @note For modules, on the thread drawing (the API thread, if threaded).
+static inline neopad_jobs_t neopad_renderer_jobs(neopad_renderer_const_t this) {
+    return this->group ? this->group->jobs : NULL;
+}
+
+/// Whether changes are kept track of on this thread (see neopad_renderer_needs_frame): the
+/// application thread, if threaded. Calls played back on the API thread leave them alone.
+bool neopad_renderer_tracks_changes(neopad_renderer_const_t this);
+
+/// End a frame, redrawing only the given area of the world (all of it if the area is empty).
+/// @note neopad_renderer_end_frame works out the area on the application thread; this is the rest.
+void neopad_renderer_submit_frame(neopad_renderer_t this, const rect_t *area);
+
+/// Get the area of the world in view for the frame being ended.
+/// @note For modules. Unlike neopad_renderer_get_view_rect, this is for the API thread.
+void neopad_renderer_get_frame_rect(neopad_renderer_const_t this, rect_t *dst);
+
+/// Set the transform for the next draw, for geometry stored relative to `origin`.
+/// @note The translation (origin less camera) is worked out in double precision. As long as
+///       `origin` is near the geometry, its vertices stay small, and precise, wherever it is.
+/// @param this The renderer.
+/// @param origin The origin of the geometry, in pad-world coordinates.
+void neopad_renderer_set_origin(neopad_renderer_t this, neopad_dvec2_t origin);
+
+/// Set the transform for the next draw, for geometry stored relative to `origin`, in a view whose
+/// coordinates are relative to `base` (rather than to the camera), such as an offscreen tile.
+void neopad_renderer_set_relative_origin(neopad_renderer_t this, neopad_dvec2_t origin, neopad_dvec2_t base);
+
+/// Set the transform for the next draw, for packed geometry stored relative to `origin` in steps
+/// of `quantum` (in pad-world units), in a view whose coordinates are relative to `base`.
+void neopad_renderer_set_packed_origin(neopad_renderer_t this,
+                                       neopad_dvec2_t origin,
+                                       neopad_dvec2_t base,
+                                       float quantum);
 
 static const bgfx_embedded_shader_t embedded_shaders[] = {
         BGFX_EMBEDDED_SHADER(vs_basic),
@@ -117,6 +361,12 @@ static const bgfx_embedded_shader_t embedded_shaders[] = {
 
         BGFX_EMBEDDED_SHADER(vs_grid),
         BGFX_EMBEDDED_SHADER(fs_grid),
+
+        BGFX_EMBEDDED_SHADER(vs_textured),
+        BGFX_EMBEDDED_SHADER(fs_textured),
+
+        BGFX_EMBEDDED_SHADER(vs_shape),
+        BGFX_EMBEDDED_SHADER(fs_shape),
         BGFX_EMBEDDED_SHADER_END()
 };
 
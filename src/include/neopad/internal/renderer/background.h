@@ -6,6 +6,7 @@
 #ifndef NEOPAD_RENDERER_BACKGROUND_INTERNAL_H
 #define NEOPAD_RENDERER_BACKGROUND_INTERNAL_H
 
+#include "graph.h"
 #include "module.h"
 
 #include <stdbool.h>
@@ -19,11 +20,14 @@ typedef struct neopad_renderer_module_background_s {
     float grid_major;
     float grid_minor;
 
+    /// Drawn first, clearing the back buffer.
+    neopad_renderer_pass_id_t pass;
+
     // todo: use these instead of a transient (avoid copies)
     bgfx_vertex_buffer_handle_t vbo;
     bgfx_index_buffer_handle_t ibo;
 } *neopad_renderer_module_background_t;
 
-neopad_renderer_module_t neopad_renderer_module_background_create(bgfx_view_id_t view_id, uint32_t color, bool grid_enabled, float grid_major, float grid_minor);
+neopad_renderer_module_t neopad_renderer_module_background_create(uint32_t color, bool grid_enabled, float grid_major, float grid_minor);
 
 #endif //NEOPAD_RENDERER_BACKGROUND_INTERNAL_H
@@ -0,0 +1,93 @@
+//
+// Created by Dylan Lukes on 8/24/23.
+//
+// Threaded mode. The application thread records commands (rather than drawing), and the
+// renderer's API thread plays them back: tessellation and bgfx submission happen there.
+// Commands go through a single-producer, single-consumer queue, one allocation each.
+//
+// The public functions record when called on the application thread of a threaded renderer,
+// and do the work otherwise (on the API thread, or when not threaded), so playing a command
+// back is just calling the same function.
+
+#ifndef NEOPAD_RENDERER_COMMANDS_INTERNAL_H
+#define NEOPAD_RENDERER_COMMANDS_INTERNAL_H
+
+#include <stdbool.h>
+
+#include "neopad/renderer.h"
+#include "neopad/internal/scene.h"
+
+/// Frames the application thread may get ahead of the API thread before it waits.
+#define NEOPAD_COMMAND_MAX_FRAMES_IN_FLIGHT 2
+
+typedef enum neopad_command_type_e {
+    NEOPAD_COMMAND_RESIZE,
+    NEOPAD_COMMAND_RESCALE,
+    NEOPAD_COMMAND_ZOOM,
+    NEOPAD_COMMAND_ARREST_ZOOM,
+    NEOPAD_COMMAND_ZOOM_AT,
+    NEOPAD_COMMAND_FLY_TO,
+    NEOPAD_COMMAND_SET_CAMERA,
+    NEOPAD_COMMAND_BEGIN_FRAME,
+    NEOPAD_COMMAND_END_FRAME,
+    NEOPAD_COMMAND_DRAW_BACKGROUND,
+    NEOPAD_COMMAND_DRAW_SCENE,
+    NEOPAD_COMMAND_DRAW_TEST_RECT,
+    NEOPAD_COMMAND_SET_STROKE_STYLE,
+    NEOPAD_COMMAND_BEGIN_POINTS,
+    NEOPAD_COMMAND_ADD_POINT,
+    NEOPAD_COMMAND_END_POINTS,
+    NEOPAD_COMMAND_SET_PROFILING,
+    NEOPAD_COMMAND_SHUTDOWN,
+} neopad_command_type_t;
+
+typedef struct neopad_command_s {
+    neopad_command_type_t type;
+    union {
+        struct {
+            int width;
+            int height;
+        } size;
+        float content_scale;
+        float zoom;
+        neopad_dvec2_t camera;
+        neopad_dvec2_t point;
+        struct {
+            float zoom;
+            neopad_dvec2_t anchor;
+        } zoom_at;
+        struct {
+            neopad_dvec2_t camera;
+            float zoom;
+            float duration;
+        } flight;
+        struct {
+            float l, t, r, b;
+        } rect;
+        neopad_stroke_style_t style;
+        rect_t area;
+        bool enabled;
+
+        /// Owned by the command until it is played back.
+        neopad_scene_snapshot_t *snapshot;
+    };
+} neopad_command_t;
+
+/// Whether calls should be recorded (rather than done): threaded, and not on the API thread.
+bool neopad_renderer_is_recording(neopad_renderer_const_t this);
+
+/// Record a command, for the API thread to play back.
+void neopad_renderer_record(neopad_renderer_t this, neopad_command_t command);
+
+/// Area the application thread should record drawing for: what is in view, or soon will be
+/// (as the camera and zoom move toward their targets).
+void neopad_renderer_get_record_rect(neopad_renderer_const_t this, rect_t *dst);
+
+/// Start the API thread, which initializes bgfx and then plays back commands until shutdown.
+/// @return Whether bgfx was initialized.
+bool neopad_renderer_start_api_thread(neopad_renderer_t this);
+
+/// Stop the API thread (shutting the renderer down), and wait for it to exit.
+void neopad_renderer_stop_api_thread(neopad_renderer_t this);
+
+#endif //NEOPAD_RENDERER_COMMANDS_INTERNAL_H
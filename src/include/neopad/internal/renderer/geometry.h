@@ -0,0 +1,88 @@
+//
+// Created by Dylan Lukes on 9/2/23.
+//
+// Per-frame geometry, written straight into the memory bgfx draws it from: transient vertex and
+// index buffers (or instance data buffers), with no CPU-side batch to copy out of. Size a batch
+// first (neopad_stroke_measure, etc.), allocate it, write into it, then set it for a draw.
+//
+// The transient pools are a fixed size each frame. A batch they have no room left for is written
+// to frame scratch instead, and drawn from static buffers made for the draw (and destroyed right
+// after, which bgfx puts off until it has rendered the frame). So nothing is dropped, however
+// much is drawn; it just costs a buffer creation per batch past the budget.
+
+#ifndef NEOPAD_RENDERER_GEOMETRY_INTERNAL_H
+#define NEOPAD_RENDERER_GEOMETRY_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bgfx/c99/bgfx.h"
+
+#include "neopad/internal/renderer.h"
+#include "neopad/internal/renderer/stroke.h"
+
+/// Indexed triangles (neopad_renderer_vertex_t, 32-bit indices) for one draw.
+typedef struct neopad_geometry_s {
+    /// Where the next vertex and index are written: vertices[size.vertex_count], etc.
+    neopad_renderer_vertex_t *vertices;
+    uint32_t *indices;
+
+    /// Geometry written so far, and room for it.
+    neopad_stroke_size_t size;
+    neopad_stroke_size_t capacity;
+
+    /// Whether it is in transient buffers, rather than frame scratch.
+    bool is_transient;
+    bgfx_transient_vertex_buffer_t tvb;
+    bgfx_transient_index_buffer_t tib;
+} neopad_geometry_t;
+
+/// Allocate room for `capacity` (an upper bound, measured beforehand) for a draw this frame.
+/// @return Whether it could be allocated at all (out of memory, otherwise).
+bool neopad_geometry_alloc(neopad_geometry_t *this, neopad_renderer_t renderer, neopad_stroke_size_t capacity);
+
+/// Whether there is room left for `size` more.
+static inline bool neopad_geometry_fits(const neopad_geometry_t *this, neopad_stroke_size_t size) {
+    return this->size.vertex_count + size.vertex_count <= this->capacity.vertex_count
+           && this->size.index_count + size.index_count <= this->capacity.index_count;
+}
+
+/// Record `size` more as written, after writing it at vertices[size.vertex_count], etc.
+static inline void neopad_geometry_advance(neopad_geometry_t *this, neopad_stroke_size_t size) {
+    this->size.vertex_count += size.vertex_count;
+    this->size.index_count += size.index_count;
+}
+
+/// Set what has been written as the vertex and index buffers of the next draw.
+/// @return Bytes of it in transient buffers (for counters), or 0 if it went to frame scratch.
+uint64_t neopad_geometry_set(neopad_geometry_t *this, neopad_renderer_t renderer);
+
+/// Instance data, of one stride, for one draw.
+typedef struct neopad_instances_s {
+    /// Instances, `stride` bytes apart, and how many of them have been written (and are drawn).
+    uint8_t *data;
+    uint32_t count;
+    uint32_t capacity;
+    uint16_t stride;
+
+    /// Whether it is in a transient instance data buffer, rather than frame scratch.
+    bool is_transient;
+    bgfx_instance_data_buffer_t idb;
+} neopad_instances_t;
+
+/// Allocate room for `capacity` instances of `stride` bytes for a draw this frame.
+/// @return Whether it could be allocated at all (out of memory, otherwise).
+bool neopad_instances_alloc(neopad_instances_t *this, neopad_renderer_t renderer, uint32_t capacity, uint16_t stride);
+
+/// Room for the i-th instance (i < capacity), to be written in any order, by any thread.
+/// @note Set count once they have been.
+static inline void *neopad_instances_at(const neopad_instances_t *this, uint32_t i) {
+    return this->data + (size_t) i * this->stride;
+}
+
+/// Set what has been written as the instance data of the next draw.
+/// @param layout A layout of the same stride, for drawing from frame scratch.
+/// @return Bytes of it in transient buffers (for counters), or 0 if it went to frame scratch.
+uint64_t neopad_instances_set(neopad_instances_t *this, const bgfx_vertex_layout_t *layout);
+
+#endif //NEOPAD_RENDERER_GEOMETRY_INTERNAL_H
@@ -0,0 +1,177 @@
+//
+// Created by Dylan Lukes on 8/26/23.
+//
+// The render graph. Modules declare passes (once, in on_setup) by what they draw into, what they
+// read from, and where they go relative to other passes; the graph assigns the view IDs.
+//
+// - Passes are ordered so that each comes after the passes drawing into what it reads from,
+//   then by order (as for modules), then by when they were (first) declared.
+// - Passes declared the same way (same name, order, output, size and transform, and no inputs)
+//   are merged: they are one pass, on one view.
+// - Passes that are not used in a frame (see neopad_renderer_use_pass) are skipped entirely:
+//   their views are not set up, touched or cleared.
+// - An output is cleared at most once a frame, by the first pass drawing into it, if any pass
+//   drawing into it asks for a clear.
+// - When only part of the back buffer is redrawn (with partial_redraw), passes into it are
+//   scissored to that part, and only it is cleared: by a view of its own, ahead of every pass,
+//   since bgfx clears a view's whole rect whatever its scissor.
+//
+// View IDs are fixed when passes are declared (bgfx works out draw order from the view ID at
+// submission, so they cannot be assigned later in the frame), and may change as passes come
+// and go. Get them with neopad_renderer_use_pass each frame, rather than keeping them around.
+//
+// Each graph has a range of NEOPAD_RENDERER_GRAPH_VIEWS view IDs to itself, from its first view
+// (the clear view, then a view per pass), so that renderers sharing bgfx never share views. Passes
+// into the back buffer draw into the renderer's window instead, for renderers that have one of
+// their own (and are skipped while it has none, see neopad_renderer_is_window_lost).
+
+#ifndef NEOPAD_RENDERER_GRAPH_INTERNAL_H
+#define NEOPAD_RENDERER_GRAPH_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bgfx/c99/bgfx.h"
+
+#include "neopad/types.h"
+#include "module.h"
+
+// Forward declaration of the renderer opaque pointer type to avoid circular dependencies.
+typedef struct neopad_renderer_s *neopad_renderer_t;
+
+/// Most passes declared at once.
+#define NEOPAD_RENDERER_MAX_PASSES 31
+
+/// View IDs each graph has: one per pass, and one for clearing part of the back buffer.
+#define NEOPAD_RENDERER_GRAPH_VIEWS (NEOPAD_RENDERER_MAX_PASSES + 1)
+
+/// Most framebuffers a pass reads from.
+#define NEOPAD_RENDERER_MAX_PASS_INPUTS 4
+
+/// No pass (as returned when a declaration fails).
+#define NEOPAD_RENDERER_PASS_NONE (-1)
+
+/// No view (as used for a pass that does not exist). Nothing should be submitted to it.
+#define NEOPAD_RENDERER_VIEW_NONE UINT16_MAX
+
+/// Identifies a declared pass, until it is released.
+typedef int32_t neopad_renderer_pass_id_t;
+
+/// The view transform a pass is drawn with.
+typedef enum neopad_renderer_pass_transform_e {
+    /// Camera-relative world coordinates: the renderer's model-view and projection matrices.
+    NEOPAD_RENDERER_PASS_TRANSFORM_WORLD,
+
+    /// Set by the module, on the view returned by neopad_renderer_use_pass.
+    NEOPAD_RENDERER_PASS_TRANSFORM_CUSTOM,
+} neopad_renderer_pass_transform_t;
+
+typedef struct neopad_renderer_pass_desc_s {
+    /// Name, for debugging (and the view name).
+    const char *name;
+
+    /// Where this pass goes relative to others (see NEOPAD_RENDERER_ORDER_*).
+    int32_t order;
+
+    /// What this pass draws into: a framebuffer, or BGFX_INVALID_HANDLE for the back buffer.
+    bgfx_frame_buffer_handle_t output;
+
+    /// Size of the output. Ignored for the back buffer, which is the renderer's size.
+    uint16_t width;
+    uint16_t height;
+
+    /// What this pass reads from (as textures): these are drawn into first.
+    bgfx_frame_buffer_handle_t inputs[NEOPAD_RENDERER_MAX_PASS_INPUTS];
+    uint8_t input_count;
+
+    neopad_renderer_pass_transform_t transform;
+
+    /// How to clear the output (BGFX_CLEAR_*), if this pass is the first to draw into it.
+    uint16_t clear_flags;
+    uint32_t clear_color;
+} neopad_renderer_pass_desc_t;
+
+typedef struct neopad_renderer_pass_s {
+    neopad_renderer_pass_desc_t desc;
+
+    /// Declarations merged into this one. Zero for free slots.
+    uint32_t references;
+
+    /// When it was declared, for passes at the same order (IDs are reused, so they do not say).
+    uint32_t sequence;
+
+    /// Assigned when the graph changes.
+    bgfx_view_id_t view_id;
+
+    /// Used this frame.
+    bool is_used;
+} neopad_renderer_pass_t;
+
+typedef struct neopad_renderer_graph_s {
+    /// Passes by ID.
+    neopad_renderer_pass_t passes[NEOPAD_RENDERER_MAX_PASSES];
+
+    /// First view ID of the graph's range (set before any pass is declared).
+    bgfx_view_id_t first_view;
+
+    /// Pass IDs, in order (which is also view ID order).
+    uint32_t count;
+    neopad_renderer_pass_id_t sorted[NEOPAD_RENDERER_MAX_PASSES];
+
+    /// Sequence of the next pass declared.
+    uint32_t next_sequence;
+
+    /// How the back buffer was cleared last frame, and where (in pixels from the top left;
+    /// zero-sized when all of it was).
+    uint16_t clear_flags;
+    neopad_ivec4_t clear_rect;
+} neopad_renderer_graph_t;
+
+/// The pass for content drawn in the world (with the camera): into the back buffer, at
+/// NEOPAD_RENDERER_ORDER_CONTENT. Modules declaring it share one view.
+static inline neopad_renderer_pass_desc_t neopad_renderer_content_pass_desc(void) {
+    return (neopad_renderer_pass_desc_t) {
+            .name = "content",
+            .order = NEOPAD_RENDERER_ORDER_CONTENT,
+            .output = BGFX_INVALID_HANDLE,
+            .transform = NEOPAD_RENDERER_PASS_TRANSFORM_WORLD,
+    };
+}
+
+#pragma mark - Declaration
+
+/// Declare a pass. One declared the same way as an existing pass is merged with it.
+/// @return The pass's ID, or NEOPAD_RENDERER_PASS_NONE if there is no room, or if its inputs
+///         would have it drawn before itself.
+neopad_renderer_pass_id_t neopad_renderer_declare_pass(neopad_renderer_t this, const neopad_renderer_pass_desc_t *desc);
+
+/// Release a pass, as declared. It goes once every declaration merged into it is released.
+void neopad_renderer_release_pass(neopad_renderer_t this, neopad_renderer_pass_id_t id);
+
+/// Change what a pass draws into (and its size), for passes that draw into one of many framebuffers.
+/// @note This does not reorder anything, so nothing should read from the new output through inputs.
+/// @note Does nothing for a pass that does not exist.
+void neopad_renderer_set_pass_output(neopad_renderer_t this,
+                                     neopad_renderer_pass_id_t id,
+                                     bgfx_frame_buffer_handle_t output,
+                                     uint16_t width,
+                                     uint16_t height);
+
+#pragma mark - Frames
+
+/// Use a pass this frame, getting its view to submit to.
+/// @note Call this only when there is something to draw: passes not used are skipped.
+/// @note Uploads the uniforms that changed, for the draw to come: call it just before submitting.
+/// @return The view, or NEOPAD_RENDERER_VIEW_NONE if there is no such pass (its declaration failed),
+///         or it draws into a window the renderer has lost.
+bgfx_view_id_t neopad_renderer_use_pass(neopad_renderer_t this, neopad_renderer_pass_id_t id);
+
+/// Use a pass, and submit the draw set up so far to its view.
+/// @note For a pass that does not exist, the draw is discarded instead.
+void neopad_renderer_submit_pass(neopad_renderer_t this, neopad_renderer_pass_id_t id, bgfx_program_handle_t program);
+
+/// Set up the views of the passes used this frame (and only those), then start over.
+/// @note Called by the renderer just before bgfx_frame.
+void neopad_renderer_graph_end_frame(neopad_renderer_t this);
+
+#endif //NEOPAD_RENDERER_GRAPH_INTERNAL_H
@@ -7,9 +7,14 @@
 
 #include "bgfx/c99/bgfx.h"
 
-#define NEOPAD_RENDERER_MODULE_BACKGROUND 0
-#define NEOPAD_RENDERER_MODULE_VECTOR 1
-#define NEOPAD_RENDERER_MODULE_COUNT 2
+#include "neopad/profile.h"
+
+/// Orders, for modules and their passes to place themselves by (see neopad/internal/renderer/registry.h
+/// and neopad/internal/renderer/graph.h).
+#define NEOPAD_RENDERER_ORDER_OFFSCREEN (-100)
+#define NEOPAD_RENDERER_ORDER_BACKGROUND 0
+#define NEOPAD_RENDERER_ORDER_CONTENT 100
+#define NEOPAD_RENDERER_ORDER_OVERLAY 200
 
 // Forward declaration of the renderer opaque pointer type to avoid circular dependencies.
 typedef struct neopad_renderer_s *neopad_renderer_t;
@@ -18,19 +23,25 @@ typedef struct neopad_renderer_s *neopad_renderer_t;
 typedef struct neopad_renderer_module_base_s *neopad_renderer_module_base_t;
 typedef struct neopad_renderer_module_background_s *neopad_renderer_module_background_t;
 typedef struct neopad_renderer_module_vector_s *neopad_renderer_module_vector_t;
+typedef struct neopad_renderer_module_scene_s *neopad_renderer_module_scene_t;
 
 typedef union __attribute__((transparent_union)) {
     neopad_renderer_module_base_t base;
     neopad_renderer_module_background_t background;
     neopad_renderer_module_vector_t vector;
+    neopad_renderer_module_scene_t scene;
 } neopad_renderer_module_t;
 
 typedef struct neopad_renderer_module_base_s {
     /// Name of this module.
     const char *name;
 
-    /// View ID (pass/layer) for this module.
-    bgfx_view_id_t view_id;
+    /// Where this module goes in the frame, relative to others: lower orders are called first.
+    /// @note What is drawn first is up to the passes it draws in (see neopad/internal/renderer/graph.h).
+    int32_t order;
+
+    /// Work done this frame. Modules add to these as they draw; the renderer collects and resets them.
+    neopad_profile_counters_t counters;
 
     /// Called once when the renderer is initialized.
     /// @note This is where you should initialize any resources.
@@ -40,7 +51,8 @@ typedef struct neopad_renderer_module_base_s {
     /// @note This is where you should destroy any resources.
     void (*on_teardown)(neopad_renderer_module_t module, neopad_renderer_t renderer);
 
-    /// Called once at the beginning of each frame. This is where you should update renderer uniforms.
+    /// Called once at the beginning of each frame. This is where you should set your uniforms (declared
+    /// in neopad/internal/renderer/uniforms.def.h).
     /// @note At this point, the model, view, and projection matrices have *not* been set up.
     void (*on_begin_frame)(neopad_renderer_module_t module, neopad_renderer_t renderer);
 
@@ -0,0 +1,124 @@
+//
+// Created by Dylan Lukes on 8/25/23.
+//
+// The module registry. Modules are registered with the renderer (at any time), and are called
+// in order of their `order` for each phase of the frame; teardown and destruction go in reverse.
+//
+// Hooks are gathered into dense per-phase arrays as modules come and go, so the frame loop only
+// visits modules that implement a hook, without going through each module to find out.
+//
+// Modules may come and go from within a hook. While hooks are being called, the arrays are left
+// as they are (modules unregistered meanwhile are skipped), and modules unregistered are torn
+// down and destroyed only once the hooks have returned; the arrays are rebuilt then.
+
+#ifndef NEOPAD_RENDERER_REGISTRY_INTERNAL_H
+#define NEOPAD_RENDERER_REGISTRY_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "module.h"
+
+/// Most modules registered at once.
+#define NEOPAD_RENDERER_MAX_MODULES 16
+
+_Static_assert(NEOPAD_RENDERER_MAX_MODULES <= NEOPAD_PROFILE_MAX_MODULES, "Modules must fit in a profile");
+
+/// No module (as returned when registration fails).
+#define NEOPAD_RENDERER_MODULE_NONE (-1)
+
+/// Identifies a registered module, until it is unregistered.
+typedef int32_t neopad_renderer_module_id_t;
+
+/// A module hook, as called once per frame.
+typedef void (*neopad_renderer_module_hook_t)(neopad_renderer_module_t module, neopad_renderer_t renderer);
+
+/// The modules implementing one per-frame hook, in order.
+typedef struct neopad_renderer_phase_s {
+    uint32_t count;
+    neopad_renderer_module_hook_t hooks[NEOPAD_RENDERER_MAX_MODULES];
+    neopad_renderer_module_t modules[NEOPAD_RENDERER_MAX_MODULES];
+    neopad_renderer_module_id_t ids[NEOPAD_RENDERER_MAX_MODULES];
+
+    /// Each module's rank (its index in order), which is also its index in profiles.
+    uint32_t ranks[NEOPAD_RENDERER_MAX_MODULES];
+} neopad_renderer_phase_t;
+
+typedef struct neopad_renderer_registry_s {
+    /// Modules by ID. Free slots have a NULL base.
+    neopad_renderer_module_t slots[NEOPAD_RENDERER_MAX_MODULES];
+
+    /// Module IDs, in order.
+    uint32_t count;
+    neopad_renderer_module_id_t sorted[NEOPAD_RENDERER_MAX_MODULES];
+
+    neopad_renderer_phase_t begin_frame;
+    neopad_renderer_phase_t end_frame;
+
+    /// Whether modules have been set up (so those registered from now on are set up at once).
+    bool is_setup;
+
+    /// Hooks being called (see neopad_renderer_registry_enter), and whether modules have come or
+    /// gone meanwhile (so the order and phases are out of date).
+    uint32_t depth;
+    bool is_stale;
+
+    /// Modules unregistered while hooks were being called, by ID, to be torn down and destroyed after.
+    uint32_t removed_count;
+    neopad_renderer_module_t removed[NEOPAD_RENDERER_MAX_MODULES];
+} neopad_renderer_registry_t;
+
+#pragma mark - Registration
+
+/// Register a module. The renderer owns it from now on.
+/// @note If the renderer is already initialized, the module is set up at once.
+/// @note Threaded renderers: call this before init, or from a module hook (on the API thread).
+/// @return The module's ID, or NEOPAD_RENDERER_MODULE_NONE if there is no room (the module is
+///         then destroyed).
+neopad_renderer_module_id_t neopad_renderer_register_module(neopad_renderer_t this, neopad_renderer_module_t module);
+
+/// Unregister a module, tearing it down (if set up) and destroying it.
+/// @note From within a hook, once the hooks being called have returned (it is not called again).
+void neopad_renderer_unregister_module(neopad_renderer_t this, neopad_renderer_module_id_t id);
+
+/// Get a registered module.
+/// @return The module, or one with a NULL base if there is no such module.
+static inline neopad_renderer_module_t
+neopad_renderer_registry_get(const neopad_renderer_registry_t *this, neopad_renderer_module_id_t id) {
+    if (id < 0 || id >= NEOPAD_RENDERER_MAX_MODULES) {
+        return (neopad_renderer_module_t) {.base = NULL};
+    }
+    return this->slots[id];
+}
+
+/// Whether a phase's i-th hook is still registered (it may have been unregistered by an earlier one).
+static inline bool
+neopad_renderer_registry_has_hook(const neopad_renderer_registry_t *this, const neopad_renderer_phase_t *phase,
+                                  uint32_t i) {
+    return this->slots[phase->ids[i]].base == phase->modules[i].base;
+}
+
+/// Find a registered module by name.
+/// @return The module's ID, or NEOPAD_RENDERER_MODULE_NONE.
+neopad_renderer_module_id_t neopad_renderer_find_module(neopad_renderer_t this, const char *name);
+
+#pragma mark - Calling
+
+/// Start calling hooks: until the matching leave, the phases stay as they are.
+void neopad_renderer_registry_enter(neopad_renderer_t this);
+
+/// Finish calling hooks, applying whatever registration happened meanwhile.
+void neopad_renderer_registry_leave(neopad_renderer_t this);
+
+#pragma mark - Lifecycle
+
+/// Set up every registered module, in order.
+void neopad_renderer_setup_modules(neopad_renderer_t this);
+
+/// Tear down every registered module, in reverse order.
+void neopad_renderer_teardown_modules(neopad_renderer_t this);
+
+/// Destroy every registered module, in reverse order, leaving the registry empty.
+void neopad_renderer_destroy_modules(neopad_renderer_t this);
+
+#endif //NEOPAD_RENDERER_REGISTRY_INTERNAL_H
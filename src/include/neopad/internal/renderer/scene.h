@@ -0,0 +1,81 @@
+//
+// Created by Dylan Lukes on 8/21/23.
+//
+
+#ifndef NEOPAD_RENDERER_SCENE_INTERNAL_H
+#define NEOPAD_RENDERER_SCENE_INTERNAL_H
+
+#include "graph.h"
+#include "module.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "neopad/scene.h"
+#include "neopad/internal/containers.h"
+#include "neopad/internal/scene.h"
+#include "neopad/internal/renderer/geometry.h"
+
+/// Number of segments used to approximate an ellipse (when tessellated).
+#define NEOPAD_SCENE_ELLIPSE_SEGMENTS 32
+
+/// Most vertices in one draw (when tessellated).
+#define NEOPAD_SCENE_BATCH_VERTICES (1 << 16)
+
+/// Most shapes in one draw (when instanced).
+/// @note 48 bytes each, out of the transient instance data buffer.
+#define NEOPAD_SCENE_BATCH_INSTANCES (1 << 15)
+
+/// Shapes each job builds (when instanced), spread across the renderer's workers.
+#define NEOPAD_SCENE_INSTANCE_GRAIN 2048
+
+typedef struct neopad_renderer_module_scene_s {
+    struct neopad_renderer_module_base_s base;
+
+    /// Drawn in the content pass.
+    neopad_renderer_pass_id_t pass;
+
+    /// Scene to draw this frame, if any.
+    neopad_scene_t scene;
+
+    /// Or, in threaded mode, a snapshot of it (owned by the module until the frame ends).
+    neopad_scene_snapshot_t *snapshot;
+
+    /// Origin that vertices are made relative to this frame (the center of the view).
+    neopad_dvec2_t origin;
+
+    /// Objects in view this frame: ids in the scene, or indices into the snapshot.
+    vec_uint32_t visible;
+
+    /// Geometry for the next draw (when tessellated).
+    neopad_geometry_t geometry;
+
+    /// Whether shapes are drawn instanced (where the backend supports it), rather than tessellated.
+    bool is_instanced;
+
+    /// A unit quad, from (-1, -1) to (1, 1), drawn once per shape.
+    bgfx_vertex_layout_t quad_layout;
+    bgfx_vertex_buffer_handle_t quad_vbo;
+    bgfx_index_buffer_handle_t quad_ibo;
+
+    /// Instance data as vertices, for drawing it from frame scratch (past the transient budget).
+    bgfx_vertex_layout_t instance_layout;
+
+    /// Shapes for the next draw (when instanced).
+    neopad_instances_t instances;
+} *neopad_renderer_module_scene_t;
+
+neopad_renderer_module_t neopad_renderer_module_scene_create(void);
+
+/// Draw a snapshot of a scene this frame, taking ownership of it.
+void neopad_renderer_draw_scene_snapshot(neopad_renderer_t this, neopad_scene_snapshot_t *snapshot);
+
+/// How a line is stroked, when tessellated: with round caps, as it is shaded when instanced.
+neopad_stroke_style_t neopad_scene_line_style(const neopad_scene_object_t *object);
+
+/// The instance an object is drawn as (when instanced), relative to an origin.
+void neopad_scene_shape_instance(const neopad_scene_object_t *object,
+                                 neopad_dvec2_t origin,
+                                 neopad_renderer_shape_instance_t *instance);
+
+#endif //NEOPAD_RENDERER_SCENE_INTERNAL_H
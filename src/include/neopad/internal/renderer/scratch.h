@@ -0,0 +1,76 @@
+//
+// Created by Dylan Lukes on 9/1/23.
+//
+// Frame scratch: memory for work that only lasts as long as a frame (tessellation output, culling
+// lists, copies of geometry for bgfx), bumped out of an arena rather than malloc'd and freed.
+// Allocating is a pointer increment; nothing is freed one at a time, the whole arena is taken back
+// at once.
+//
+// bgfx reads what is passed to it by reference (bgfx_make_ref) as it renders, which on its render
+// thread is a frame behind: memory handed out while a frame is built stays valid until bgfx has
+// rendered it, by the end of the bgfx_frame after the one that submits it. So there are two arenas,
+// used in turn, and each is only taken back once the frame after next begins.
+//
+// Only for the thread drawing: the API thread, if threaded.
+
+#ifndef NEOPAD_RENDERER_SCRATCH_INTERNAL_H
+#define NEOPAD_RENDERER_SCRATCH_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ctl/allocator.h>
+
+#include "bgfx/c99/bgfx.h"
+
+/// Arenas used in turn (see above).
+#define NEOPAD_FRAME_SCRATCH_ARENAS 2
+
+/// Bytes per chunk of an arena. Frames needing more get more chunks, kept for the frames after.
+#define NEOPAD_FRAME_SCRATCH_CHUNK_SIZE (256 * 1024)
+
+typedef struct neopad_frame_scratch_s {
+    ctl_arena arenas[NEOPAD_FRAME_SCRATCH_ARENAS];
+
+    /// The arena in use, and the bgfx frame each was last used for.
+    uint32_t current;
+    uint32_t frames[NEOPAD_FRAME_SCRATCH_ARENAS];
+} neopad_frame_scratch_t;
+
+/// @note The scratch must not move afterward: its arenas point to themselves.
+void neopad_frame_scratch_init(neopad_frame_scratch_t *this);
+
+void neopad_frame_scratch_free(neopad_frame_scratch_t *this);
+
+/// Move on to the bgfx frame being built (as numbered by bgfx_frame), if it has changed: to the
+/// other arena, which bgfx is done with, taking it all back.
+static inline void neopad_frame_scratch_use(neopad_frame_scratch_t *this, uint32_t frame) {
+    if (this->frames[this->current] != frame) {
+        this->current = (this->current + 1) % NEOPAD_FRAME_SCRATCH_ARENAS;
+        this->frames[this->current] = frame;
+        ctl_arena_reset(&this->arenas[this->current]);
+    }
+}
+
+/// Allocate memory, valid until bgfx has rendered the frame (aligned for any type).
+/// @return The memory, or NULL if out of memory.
+static inline void *neopad_frame_scratch_alloc(neopad_frame_scratch_t *this, size_t size) {
+    return ctl_arena_alloc(&this->arenas[this->current], size);
+}
+
+/// An allocator for containers of frame scratch (see ctl/allocator.h).
+/// @note Containers from it must be re-initialized every frame.
+static inline ctl_allocator *neopad_frame_scratch_allocator(neopad_frame_scratch_t *this) {
+    return ctl_arena_allocator(&this->arenas[this->current]);
+}
+
+/// Copy data into frame scratch, for bgfx to read in place (rather than copying it again).
+/// @return The memory, for buffer creation or updates this frame, or NULL if out of memory.
+const bgfx_memory_t *neopad_frame_scratch_copy(neopad_frame_scratch_t *this, const void *data, uint32_t size);
+
+/// Bytes handed out since the current arena was last taken back.
+static inline size_t neopad_frame_scratch_used(const neopad_frame_scratch_t *this) {
+    return this->arenas[this->current].allocated;
+}
+
+#endif //NEOPAD_RENDERER_SCRATCH_INTERNAL_H
@@ -0,0 +1,121 @@
+//
+// Created by Dylan Lukes on 8/20/23.
+//
+// Stroke tessellation: turns a series of points into indexed triangles, with joins and caps.
+// The tessellator writes into caller-provided memory, so the same code can fill a CPU-side
+// batch or a GPU buffer directly. Use neopad_stroke_measure to size that memory first.
+//
+// Strokes can also be tessellated incrementally, as points arrive, with a stroke stream.
+// Everything a stream has emitted is final; only the end cap depends on the last point, and
+// it is emitted separately (and repeatedly, if need be) by neopad_stroke_stream_finish.
+
+#ifndef NEOPAD_RENDERER_STROKE_INTERNAL_H
+#define NEOPAD_RENDERER_STROKE_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cglm/vec2.h>
+
+#include "neopad/types.h"
+#include "neopad/renderer.h"
+#include "neopad/internal/renderer.h"
+
+/// Number of segments used to approximate a half-circle (round caps and joins).
+#define NEOPAD_STROKE_ROUND_SEGMENTS 8
+
+/// Most vertices emitted by a single neopad_stroke_stream_push or neopad_stroke_stream_finish.
+#define NEOPAD_STROKE_MAX_STEP_VERTICES (2 * NEOPAD_STROKE_ROUND_SEGMENTS + 4)
+
+/// Most indices emitted by a single neopad_stroke_stream_push or neopad_stroke_stream_finish.
+#define NEOPAD_STROKE_MAX_STEP_INDICES (6 * NEOPAD_STROKE_ROUND_SEGMENTS + 6)
+
+/// Amount of geometry produced (or needed) for a stroke.
+typedef struct neopad_stroke_size_s {
+    uint32_t vertex_count;
+    uint32_t index_count;
+} neopad_stroke_size_t;
+
+/// Incremental tessellation state for a single stroke.
+typedef struct neopad_stroke_stream_s {
+    neopad_stroke_style_t style;
+    float half_width;
+    float epsilon2;
+
+    /// Added to every index written.
+    uint32_t base_vertex;
+
+    /// Where the next vertex and index are written: vertices[size.vertex_count], etc.
+    /// @note The caller may move these (e.g. after growing them) between pushes.
+    neopad_renderer_vertex_t *vertices;
+    uint32_t *indices;
+
+    /// Geometry emitted so far.
+    neopad_stroke_size_t size;
+
+    /// Number of distinct points pushed so far.
+    uint32_t count;
+
+    /// The last distinct point, and the direction/normal of the segment into it.
+    vec2 last;
+    vec2 d_in;
+    vec2 n_in;
+
+    /// Vertex pair (left, right) at the end of the emitted geometry.
+    uint32_t prev_l;
+    uint32_t prev_r;
+} neopad_stroke_stream_t;
+
+/// Upper bound on the geometry produced by tessellating a stroke of `count` points.
+/// @note This is cheap, and does not look at the points themselves.
+neopad_stroke_size_t neopad_stroke_measure(size_t count, const neopad_stroke_style_t *style);
+
+/// Tessellate a stroke into indexed triangles.
+/// @param points The points of the stroke, in pad-world coordinates.
+/// @param count The number of points.
+/// @param style The stroke style.
+/// @param base_vertex Added to every index written, for appending to an existing buffer.
+/// @param vertices Output vertices, with room for at least neopad_stroke_measure().vertex_count.
+/// @param indices Output indices, with room for at least neopad_stroke_measure().index_count.
+/// @return The amount of geometry actually written.
+neopad_stroke_size_t neopad_stroke_tessellate(const neopad_vec2_t *points,
+                                              size_t count,
+                                              const neopad_stroke_style_t *style,
+                                              uint32_t base_vertex,
+                                              neopad_renderer_vertex_t *vertices,
+                                              uint32_t *indices);
+
+/// Simplify a stroke (Douglas-Peucker), dropping points that deviate from it by at most `tolerance`.
+/// @note The first and last points are always kept.
+/// @param points The points of the stroke.
+/// @param count The number of points.
+/// @param tolerance The largest deviation allowed, in pad-world units.
+/// @param scratch Scratch space, with room for at least 2 * count indices.
+/// @param out Output points, with room for at least `count` points. May not alias `points`.
+/// @return The number of points written.
+size_t neopad_stroke_simplify(const neopad_vec2_t *points,
+                              size_t count,
+                              float tolerance,
+                              uint32_t *scratch,
+                              neopad_vec2_t *out);
+
+/// Begin tessellating a stroke incrementally.
+/// @note Set stream->vertices and stream->indices before the first push.
+void neopad_stroke_stream_begin(neopad_stroke_stream_t *stream,
+                                const neopad_stroke_style_t *style,
+                                uint32_t base_vertex);
+
+/// Add a point to the stroke, emitting any geometry which is now final.
+/// @note Emits at most NEOPAD_STROKE_MAX_STEP_VERTICES and NEOPAD_STROKE_MAX_STEP_INDICES.
+/// @return Whether the point was distinct enough from the previous one to be used.
+bool neopad_stroke_stream_push(neopad_stroke_stream_t *stream, vec2 p);
+
+/// Emit the end of the stroke (the last segment and end cap) into separate memory.
+/// @note Does not change the stream; call it again after further pushes to redo the end.
+/// @note The geometry refers to vertices already emitted. Place it right after them.
+/// @return The amount of geometry written.
+neopad_stroke_size_t neopad_stroke_stream_finish(const neopad_stroke_stream_t *stream,
+                                                 neopad_renderer_vertex_t *vertices,
+                                                 uint32_t *indices);
+
+#endif //NEOPAD_RENDERER_STROKE_INTERNAL_H
@@ -0,0 +1,143 @@
+//
+// Created by Dylan Lukes on 8/27/23.
+//
+// A cache of tiles: squares of the world, rasterized offscreen at discrete zoom levels, and
+// composited as textured quads. Content that rarely changes is drawn into a tile once, and after
+// that costs one quad a frame wherever the camera goes, until the area is invalidated.
+//
+// Level L is rasterized at a zoom of 2^L, so a tile covers NEOPAD_TILE_TEXELS / (2^L * content
+// scale) pad-world units. Each frame is drawn at the level nearest the zoom, so tiles are scaled
+// by at most a factor of √2 either way.
+//
+// Tiles come from a pool (least recently used first), sized to hold twice what the back buffer can
+// show, and at most NEOPAD_TILE_RENDERS_PER_FRAME are rasterized a frame; until every tile in view
+// is ready, the owner draws live instead.
+
+#ifndef NEOPAD_RENDERER_TILES_INTERNAL_H
+#define NEOPAD_RENDERER_TILES_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bgfx/c99/bgfx.h"
+
+#include "neopad/types.h"
+#include "neopad/profile.h"
+#include "neopad/internal/rect.h"
+#include "graph.h"
+
+/// Size of a tile, in texels.
+#define NEOPAD_TILE_TEXELS 256
+
+/// Fewest tiles kept, in all (more for back buffers that show more).
+/// @note 256 KiB each, at NEOPAD_TILE_TEXELS 256, but only once used.
+#define NEOPAD_TILE_POOL 128
+
+/// Most tiles rasterized in one frame (each is a pass of its own).
+#define NEOPAD_TILE_RENDERS_PER_FRAME 16
+
+/// Range of levels (powers of two of zoom) tiles are kept at. Beyond them, the owner draws live.
+#define NEOPAD_TILE_MIN_LEVEL (-8)
+#define NEOPAD_TILE_MAX_LEVEL 6
+
+/// Blending for drawing into tiles: as usual for color, but with alpha accumulated, so that
+/// tiles come out premultiplied (and are composited as such).
+#define NEOPAD_TILE_BLEND BGFX_STATE_BLEND_FUNC_SEPARATE(BGFX_STATE_BLEND_SRC_ALPHA, \
+                                                          BGFX_STATE_BLEND_INV_SRC_ALPHA, \
+                                                          BGFX_STATE_BLEND_ONE, \
+                                                          BGFX_STATE_BLEND_INV_SRC_ALPHA)
+
+/// What is drawn into tiles, as provided by the cache's owner.
+typedef struct neopad_tile_source_s {
+    void *context;
+
+    /// Whether there is anything to draw in an area (tiles over nothing are skipped entirely).
+    bool (*is_empty)(void *context, const rect_t *area);
+
+    /// Draw the content in an area into a tile, using NEOPAD_TILE_BLEND.
+    /// @param view The tile's view, whose coordinates are relative to `base`
+    ///             (see neopad_renderer_set_relative_origin).
+    /// @param area The area of the tile, in pad-world coordinates.
+    /// @param zoom The zoom the tile is drawn at.
+    void (*draw)(void *context,
+                 neopad_renderer_t renderer,
+                 bgfx_view_id_t view,
+                 const rect_t *area,
+                 neopad_dvec2_t base,
+                 float zoom);
+} neopad_tile_source_t;
+
+typedef struct neopad_tile_s {
+    int32_t level;
+    int64_t x;
+    int64_t y;
+
+    /// Whether the tile holds this level, x and y (and whether it is up to date).
+    bool is_valid;
+    bool is_dirty;
+
+    /// Frame the tile was last composited in, for eviction.
+    uint64_t last_used;
+
+    /// Created as the slot is first used.
+    bgfx_frame_buffer_handle_t framebuffer;
+} neopad_tile_t;
+
+typedef struct neopad_tile_cache_s {
+    /// The pool, grown (never shrunk) as the back buffer grows.
+    neopad_tile_t *tiles;
+    uint32_t capacity;
+
+    /// Tiles composited this frame, room for the whole pool.
+    neopad_tile_t **visible;
+
+    /// Back buffer size the pool was sized for.
+    uint32_t width;
+    uint32_t height;
+
+    /// Whether more tiles were in view than the pool holds (warned about once).
+    bool is_short;
+
+    /// Passes tiles are rasterized in, pointed at a tile's framebuffer as needed.
+    neopad_renderer_pass_id_t passes[NEOPAD_TILE_RENDERS_PER_FRAME];
+
+    /// Pass tiles are composited in (the content pass).
+    neopad_renderer_pass_id_t composite;
+
+    /// A unit quad, textured with a tile.
+    bgfx_vertex_layout_t layout;
+    bgfx_vertex_buffer_handle_t vbo;
+    bgfx_index_buffer_handle_t ibo;
+    bgfx_uniform_handle_t sampler;
+
+    /// Content scale tiles were rasterized at. Tiles are all invalidated when it changes.
+    float content_scale;
+
+    /// Frames drawn.
+    uint64_t frame;
+} neopad_tile_cache_t;
+
+void neopad_tile_cache_init(neopad_tile_cache_t *this);
+
+/// Create the cache's GPU resources (and the textured program), and declare its passes.
+void neopad_tile_cache_setup(neopad_tile_cache_t *this, neopad_renderer_t renderer);
+
+/// Destroy the cache's GPU resources (and the pool), and release its passes.
+void neopad_tile_cache_teardown(neopad_tile_cache_t *this, neopad_renderer_t renderer);
+
+/// Mark tiles overlapping an area (at every level) to be drawn again.
+void neopad_tile_cache_invalidate(neopad_tile_cache_t *this, const rect_t *area);
+
+/// Mark every tile to be drawn again.
+void neopad_tile_cache_invalidate_all(neopad_tile_cache_t *this);
+
+/// Composite the tiles in view, rasterizing those missing or dirty (within the frame's budget).
+/// @param counters Added to, for what is drawn.
+/// @return Whether every tile in view was composited. If not, nothing was, and the owner should
+///         draw live this frame.
+bool neopad_tile_cache_draw(neopad_tile_cache_t *this,
+                            neopad_renderer_t renderer,
+                            const neopad_tile_source_t *source,
+                            neopad_profile_counters_t *counters);
+
+#endif //NEOPAD_RENDERER_TILES_INTERNAL_H
@@ -0,0 +1,31 @@
+//
+// Created by Dylan Lukes on 8/30/23.
+//
+// Uniform declarations: the one place uniforms are declared. The C side (see uniforms.h) and
+// the shader side (uniforms.sh, generated from this file at configure time by
+// cmake/neopad-uniforms.cmake) both come from it, so they cannot drift apart.
+//
+// - BLOCK(ID, name, size): a block, uploaded as `uniform vec4 u_<name>[size]`.
+// - FIELD(BLOCK_ID, ID, name, offset, components): a field of a block, `u_<name>` in shaders,
+//   starting `offset` floats into the block (without crossing a vec4).
+//
+// Blocks belong to whoever sets them, grouped here by owner. Keep entries to the forms above,
+// with literal numbers: the generator picks them out with regular expressions.
+
+#ifndef NEOPAD_RENDERER_UNIFORMS_DEF_INTERNAL_H
+#define NEOPAD_RENDERER_UNIFORMS_DEF_INTERNAL_H
+
+#define NEOPAD_UNIFORMS(BLOCK, FIELD) \
+    /* Renderer: set every frame. */ \
+    BLOCK(FRAME, frame, 2) \
+    FIELD(FRAME, TIME, time, 0, 1) \
+    FIELD(FRAME, ZOOM, zoom, 1, 1) \
+    FIELD(FRAME, ORIGIN, origin, 2, 2) \
+    FIELD(FRAME, CONTENT_SCALE, content_scale, 4, 1) \
+    /* Background module. */ \
+    BLOCK(GRID, grid, 1) \
+    FIELD(GRID, GRID_OFFSET, grid_offset, 0, 2) \
+    FIELD(GRID, GRID_MAJOR, grid_major, 2, 1) \
+    FIELD(GRID, GRID_MINOR, grid_minor, 3, 1)
+
+#endif //NEOPAD_RENDERER_UNIFORMS_DEF_INTERNAL_H
@@ -0,0 +1,95 @@
+//
+// Created by Dylan Lukes on 8/30/23.
+//
+// Uniforms, in named blocks of vec4s (declared in uniforms.def.h), each a bgfx uniform of its own.
+// Values are set by field, and a block is uploaded only when one of its fields has changed: on
+// the next neopad_renderer_use_pass, so before the draw that needs it.
+//
+// bgfx keeps uniform values from one draw (and frame) to the next, so blocks left alone stay as
+// they were. Renderers sharing bgfx share the uniforms too, so each uploads all of its blocks again
+// when it takes over from another (see neopad_uniforms_invalidate).
+
+#ifndef NEOPAD_RENDERER_UNIFORMS_INTERNAL_H
+#define NEOPAD_RENDERER_UNIFORMS_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bgfx/c99/bgfx.h"
+
+#include "uniforms.def.h"
+
+#define NEOPAD_UNIFORM_SKIP(...)
+
+/// Blocks, in order.
+typedef enum neopad_uniform_block_e {
+#define NEOPAD_UNIFORM_BLOCK_ID(ID, name, size) NEOPAD_UNIFORM_BLOCK_##ID,
+    NEOPAD_UNIFORMS(NEOPAD_UNIFORM_BLOCK_ID, NEOPAD_UNIFORM_SKIP)
+#undef NEOPAD_UNIFORM_BLOCK_ID
+    NEOPAD_UNIFORM_BLOCK_COUNT
+} neopad_uniform_block_t;
+
+/// Where each block starts, in floats, and how many there are in all.
+enum {
+#define NEOPAD_UNIFORM_BLOCK_BASE(ID, name, size) \
+    NEOPAD_UNIFORM_BASE_##ID, NEOPAD_UNIFORM_LAST_##ID = NEOPAD_UNIFORM_BASE_##ID + 4 * (size) - 1,
+    NEOPAD_UNIFORMS(NEOPAD_UNIFORM_BLOCK_BASE, NEOPAD_UNIFORM_SKIP)
+#undef NEOPAD_UNIFORM_BLOCK_BASE
+    NEOPAD_UNIFORM_FLOATS
+};
+
+/// Fields, by where they are, in floats.
+typedef enum neopad_uniform_e {
+#define NEOPAD_UNIFORM_FIELD_ID(BLOCK, ID, name, offset, components) \
+    NEOPAD_UNIFORM_##ID = NEOPAD_UNIFORM_BASE_##BLOCK + (offset),
+    NEOPAD_UNIFORMS(NEOPAD_UNIFORM_SKIP, NEOPAD_UNIFORM_FIELD_ID)
+#undef NEOPAD_UNIFORM_FIELD_ID
+} neopad_uniform_t;
+
+_Static_assert(NEOPAD_UNIFORM_BLOCK_COUNT <= 32, "Blocks must fit in a mask");
+
+typedef struct neopad_uniforms_s {
+    /// Every block's values, one after another.
+    float values[NEOPAD_UNIFORM_FLOATS];
+
+    /// Blocks changed since they were last uploaded, as bits.
+    uint32_t dirty;
+
+    bgfx_uniform_handle_t handles[NEOPAD_UNIFORM_BLOCK_COUNT];
+} neopad_uniforms_t;
+
+/// Create the blocks' uniforms, all zero (to be uploaded before the first draw).
+void neopad_uniforms_setup(neopad_uniforms_t *this);
+
+void neopad_uniforms_teardown(neopad_uniforms_t *this);
+
+/// Set a field (as many components as it has), marking its block if it changed.
+void neopad_uniforms_set(neopad_uniforms_t *this, neopad_uniform_t field, const float *value);
+
+static inline void neopad_uniforms_set_1f(neopad_uniforms_t *this, neopad_uniform_t field, float x) {
+    neopad_uniforms_set(this, field, &x);
+}
+
+static inline void neopad_uniforms_set_2f(neopad_uniforms_t *this, neopad_uniform_t field, float x, float y) {
+    neopad_uniforms_set(this, field, (const float[]) {x, y});
+}
+
+static inline float neopad_uniforms_get(const neopad_uniforms_t *this, neopad_uniform_t field) {
+    return this->values[field];
+}
+
+/// Upload every block on the next flush, changed or not.
+static inline void neopad_uniforms_invalidate(neopad_uniforms_t *this) {
+    this->dirty = (uint32_t) ((UINT64_C(1) << NEOPAD_UNIFORM_BLOCK_COUNT) - 1);
+}
+
+/// Upload the blocks that changed (for the next draw).
+void neopad_uniforms_upload(neopad_uniforms_t *this);
+
+static inline void neopad_uniforms_flush(neopad_uniforms_t *this) {
+    if (this->dirty != 0) {
+        neopad_uniforms_upload(this);
+    }
+}
+
+#endif //NEOPAD_RENDERER_UNIFORMS_INTERNAL_H
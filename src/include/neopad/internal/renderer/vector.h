@@ -5,15 +5,183 @@
 #ifndef NEOPAD_RENDERER_VECTOR_INTERNAL_H
 #define NEOPAD_RENDERER_VECTOR_INTERNAL_H
 
+#include "graph.h"
 #include "module.h"
+#include "tiles.h"
 
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "neopad/object.h"
+#include "neopad/renderer.h"
+#include "neopad/internal/containers.h"
+#include "neopad/internal/renderer/stroke.h"
+
+/// Vertex capacity of a chunk. Strokes bigger than this get a chunk of their own.
+#define NEOPAD_VECTOR_CHUNK_VERTICES (1 << 16)
+
+/// Index capacity of a chunk.
+#define NEOPAD_VECTOR_CHUNK_INDICES (3 * NEOPAD_VECTOR_CHUNK_VERTICES)
+
+/// Initial vertex capacity of the buffers for the stroke being drawn.
+#define NEOPAD_VECTOR_PEN_VERTICES 4096
+
+/// Size of the tiles that stroke geometry is stored relative to, in pad-world units.
+/// @note Vertices are floats relative to the origin of their tile; tiles' origins are doubles.
+#define NEOPAD_VECTOR_TILE_SIZE 4096.0
+
+/// Number of levels of detail. Level 0 is the full geometry; each level after it is simplified
+/// for zooms NEOPAD_VECTOR_LOD_SCALE times further out than the one before.
+#define NEOPAD_VECTOR_LOD_LEVELS 4
+
+/// Ratio of zoom between consecutive levels of detail.
+#define NEOPAD_VECTOR_LOD_SCALE 4.0f
+
+/// Largest deviation from the full geometry allowed at any level of detail, in pixels.
+#define NEOPAD_VECTOR_LOD_TOLERANCE 0.5f
+
+/// Steps per pixel that finished strokes are packed (see neopad_renderer_packed_vertex_t) with,
+/// at the zoom they were drawn at, or per tolerance, at coarser levels of detail. Strokes that do
+/// not fit in 16 bits at that (or that need a chunk of their own) are kept as floats.
+#define NEOPAD_VECTOR_PACKED_STEPS_PER_PIXEL 64.0f
+#define NEOPAD_VECTOR_PACKED_STEPS_PER_TOLERANCE 8.0f
+
+/// GPU-resident geometry for a number of finished strokes.
+/// @note Strokes are appended to a chunk once, and never re-uploaded.
+typedef struct neopad_vector_chunk_s {
+    /// Origin of the tile all geometry in this chunk is relative to.
+    neopad_dvec2_t origin;
+
+    /// Step of packed positions (in pad-world units), or 0 if positions are floats.
+    /// @note Packed chunks have 16-bit indices, and at most NEOPAD_VECTOR_CHUNK_VERTICES vertices.
+    float quantum;
+
+    bgfx_dynamic_vertex_buffer_handle_t vbo;
+    bgfx_dynamic_index_buffer_handle_t ibo;
+
+    uint32_t vertex_count;
+    uint32_t vertex_capacity;
+    uint32_t index_count;
+    uint32_t index_capacity;
+
+    /// Bounds of all strokes in this chunk, in pad-world coordinates.
+    rect_t bounds;
+} neopad_vector_chunk_t;
+
+/// Where a stroke's geometry is, within one level of detail.
+typedef struct neopad_vector_span_s {
+    uint32_t chunk;
+    uint32_t first_index;
+    uint32_t index_count;
+} neopad_vector_span_t;
+
+/// A finished stroke, as stored in chunks (once per level of detail).
+typedef struct neopad_vector_stroke_s {
+    neopad_vector_span_t lod[NEOPAD_VECTOR_LOD_LEVELS];
+
+    /// Bounds of the stroke (including its width), in pad-world coordinates.
+    rect_t bounds;
+} neopad_vector_stroke_t;
+
+// vec_neopad_vector_chunk_t
+#define POD
+#define NOT_INTEGRAL
+#define T neopad_vector_chunk_t
+#include <ctl/vector.h>
+
+// vec_neopad_vector_stroke_t
+#define POD
+#define NOT_INTEGRAL
+#define T neopad_vector_stroke_t
+#include <ctl/vector.h>
+
 typedef struct neopad_renderer_module_vector_s {
     struct neopad_renderer_module_base_s base;
+
+    /// Drawn in the content pass.
+    neopad_renderer_pass_id_t pass;
+
+    /// Style given to strokes when they are begun.
+    neopad_stroke_style_t style;
+
+    /// What the pen changes, as kept track of on the application thread (see
+    /// neopad_renderer_tracks_changes), to invalidate it.
+    struct {
+        /// How far strokes in the current style reach past their points.
+        float margin;
+
+        /// The last point added.
+        neopad_dvec2_t last;
+    } tracked;
+
+    /// The stroke currently being drawn (between begin_points and end_points).
+    struct {
+        bool is_active;
+
+        /// Origin of the tile the stroke is stored relative to (that of its first point).
+        neopad_dvec2_t origin;
+
+        /// Zoom the stroke was begun at, for how finely it is packed.
+        float zoom;
+
+        /// Incremental tessellation of the stroke.
+        neopad_stroke_stream_t stream;
+
+        /// Points of the stroke so far (relative to its origin), for simplifying it when it is finished.
+        vec_neopad_vec2_t points;
+
+        /// Bounds of the stroke so far.
+        rect_t bounds;
+
+        /// Final geometry emitted so far.
+        /// @note The (provisional) end of the stroke is written past the end of these.
+        vec_neopad_renderer_vertex_t vertices;
+        vec_uint32_t indices;
+
+        /// How much of the final geometry has been uploaded, and whether the end needs redoing.
+        uint32_t uploaded_vertices;
+        uint32_t uploaded_indices;
+        bool is_dirty;
+
+        /// Drawn geometry (final and provisional) in the buffers.
+        uint32_t vertex_count;
+        uint32_t index_count;
+
+        /// Buffers holding the stroke, appended to as points arrive.
+        bgfx_dynamic_vertex_buffer_handle_t vbo;
+        bgfx_dynamic_index_buffer_handle_t ibo;
+        uint32_t vertex_capacity;
+        uint32_t index_capacity;
+    } pen;
+
+    /// Storage for finished strokes, per level of detail.
+    vec_neopad_vector_chunk_t chunks[NEOPAD_VECTOR_LOD_LEVELS];
+    vec_neopad_vector_stroke_t strokes;
+
+    /// The module whose storage finished strokes go to, and are drawn from: this one, or, sharing
+    /// bgfx, that of the renderer shared with.
+    struct neopad_renderer_module_vector_s *store;
+
+    /// Level of detail drawn last frame.
+    uint32_t lod;
+
+    /// Finished strokes, rasterized into tiles (if the renderer was initialized with tile_cache).
+    bool use_tiles;
+    neopad_tile_cache_t tiles;
+
+    /// Scratch space for building simplified strokes.
+    struct {
+        vec_neopad_vec2_t points;
+        vec_uint32_t stack;
+        vec_neopad_renderer_vertex_t vertices;
+        vec_uint32_t indices;
+    } scratch;
 } *neopad_renderer_module_vector_t;
 
 neopad_renderer_module_t neopad_renderer_module_vector_create(void);
 
+/// Move the storage for finished strokes from the renderer keeping it (shutting down) to another
+/// sharing bgfx with it, which every renderer drawing from it then draws from instead.
+void neopad_renderer_module_vector_hand_off(neopad_renderer_t from, neopad_renderer_t to);
+
 #endif //NEOPAD_RENDERER_VECTOR_INTERNAL_H
@@ -0,0 +1,68 @@
+//
+// Created by Dylan Lukes on 8/21/23.
+//
+// This is the internal header for scenes. Implementation files (e.g. renderer modules) can
+// include this header to access the contents of the scene opaque pointer type.
+
+#ifndef NEOPAD_SCENE_INTERNAL_H
+#define NEOPAD_SCENE_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "neopad/scene.h"
+#include "neopad/internal/containers.h"
+#include "neopad/internal/spatial.h"
+
+/// Storage for an object, indexed by its id.
+typedef struct neopad_scene_slot_s {
+    neopad_scene_object_t object;
+
+    /// Leaf in the spatial index, or NEOPAD_SPATIAL_NULL if the slot is free.
+    uint32_t leaf;
+
+    /// When the object was added, relative to the others (ids are reused, so do not say).
+    uint64_t sequence;
+} neopad_scene_slot_t;
+
+// vec_neopad_scene_slot_t
+#define POD
+#define NOT_INTEGRAL
+#define T neopad_scene_slot_t
+#include <ctl/vector.h>
+
+struct neopad_scene_s {
+    vec_neopad_scene_slot_t slots;
+
+    /// Ids of free slots, to be reused.
+    vec_uint32_t free_ids;
+
+    /// Sequence of the next object added.
+    uint64_t next_sequence;
+
+    /// Index over the bounds of all objects.
+    neopad_spatial_t index;
+
+    /// Scratch space for queries.
+    vec_uint32_t found;
+
+    /// Bumped by every change, so renderers can tell whether it has changed since they drew it.
+    uint64_t revision;
+};
+
+/// Find the objects which intersect an area, appending their ids to `out`, in the order they were
+/// added (what is already in `out` is left as it is).
+/// @note This is neopad_scene_query, without the copy.
+size_t neopad_scene_query_into(neopad_scene_t this, const rect_t *area, vec_uint32_t *out);
+
+/// Copies of a scene's objects, as they were when it was taken.
+typedef struct neopad_scene_snapshot_s {
+    size_t count;
+    neopad_scene_object_t objects[];
+} neopad_scene_snapshot_t;
+
+/// Copy the objects which intersect an area, so they can be drawn on another thread while the
+/// scene changes. Free the snapshot with free().
+neopad_scene_snapshot_t *neopad_scene_snapshot(neopad_scene_t this, const rect_t *area);
+
+#endif //NEOPAD_SCENE_INTERNAL_H
@@ -0,0 +1,34 @@
+//
+// Created by Dylan Lukes on 8/24/23.
+//
+
+#ifndef NEOPAD_SHIMS_BX_SEMAPHORE_H
+#define NEOPAD_SHIMS_BX_SEMAPHORE_H
+
+/**
+ * Exposes a C99 API to bx::Semaphore.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Opaque pointer type for a semaphore.
+typedef struct bx_semaphore_s *bx_semaphore_t;
+
+bx_semaphore_t bx_semaphore_create();
+void bx_semaphore_destroy(bx_semaphore_t semaphore);
+
+void bx_semaphore_post(bx_semaphore_t semaphore, uint32_t count);
+
+/// Waits up to timeout_ms (-1 for no timeout). Returns false on timeout.
+bool bx_semaphore_wait(bx_semaphore_t semaphore, int32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //NEOPAD_SHIMS_BX_SEMAPHORE_H
@@ -5,7 +5,10 @@
 #ifndef NEOPAD_SHIMS_BX_SPSCQUEUE_H
 #define NEOPAD_SHIMS_BX_SPSCQUEUE_H
 
+#include <stdint.h>
+
 typedef struct bx_spsc_queue_s *bx_spsc_queue_t;
+typedef struct bx_spsc_blocking_queue_s *bx_spsc_blocking_queue_t;
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,6 +21,14 @@ void bx_spsc_queue_push(bx_spsc_queue_t queue, void *data);
 void *bx_spsc_queue_pop(bx_spsc_queue_t queue);
 void *bx_spsc_queue_peek(bx_spsc_queue_t queue);
 
+bx_spsc_blocking_queue_t bx_spsc_blocking_queue_create();
+void bx_spsc_blocking_queue_destroy(bx_spsc_blocking_queue_t queue);
+
+void bx_spsc_blocking_queue_push(bx_spsc_blocking_queue_t queue, void *data);
+/// Waits up to timeout_ms (-1 for no timeout) for something to pop. Returns NULL on timeout.
+void *bx_spsc_blocking_queue_pop(bx_spsc_blocking_queue_t queue, int32_t timeout_ms);
+void *bx_spsc_blocking_queue_peek(bx_spsc_blocking_queue_t queue);
+
 #ifdef __cplusplus
 }
 #endif
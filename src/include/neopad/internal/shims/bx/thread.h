@@ -30,6 +30,12 @@ void bx_thread_push(bx_thread_t thread, void *ptr);
 
 void *bx_thread_pop(bx_thread_t thread);
 
+/// Threads the hardware runs at once (cores, or hyperthreads), or 0 if unknown.
+uint32_t bx_thread_hardware_concurrency();
+
+/// Give up the rest of this thread's time slice.
+void bx_thread_yield();
+
 #ifdef __cplusplus
 }
 #endif
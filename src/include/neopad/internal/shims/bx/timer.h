@@ -0,0 +1,28 @@
+//
+// Created by Dylan Lukes on 8/22/23.
+//
+
+#ifndef NEOPAD_SHIMS_BX_TIMER_H
+#define NEOPAD_SHIMS_BX_TIMER_H
+
+/**
+ * Exposes a C99 API to bx's high-performance counter.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Current value of the high-performance counter.
+int64_t bx_get_hp_counter();
+
+/// Ticks per second of the high-performance counter.
+int64_t bx_get_hp_frequency();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //NEOPAD_SHIMS_BX_TIMER_H
@@ -0,0 +1,72 @@
+//
+// Created by Dylan Lukes on 8/21/23.
+//
+// Spatial index: a dynamic bounding volume hierarchy (a binary R-tree) over axis-aligned
+// rectangles. Leaves are inserted where they least enlarge the tree, and the tree is kept
+// balanced with AVL-style rotations, so queries, insertions and removals are logarithmic.
+
+#ifndef NEOPAD_SPATIAL_INTERNAL_H
+#define NEOPAD_SPATIAL_INTERNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "neopad/object.h"
+#include "neopad/internal/containers.h"
+
+/// Null node (and leaf) index.
+#define NEOPAD_SPATIAL_NULL UINT32_MAX
+
+/// A node of the tree.
+/// @note Leaves have no children. Free nodes have a height of -1, and chain through `parent`.
+typedef struct neopad_spatial_node_s {
+    rect_t bounds;
+    uint32_t parent;
+    uint32_t left;
+    uint32_t right;
+    int32_t height;
+
+    /// User value (leaves only).
+    uint32_t value;
+} neopad_spatial_node_t;
+
+// vec_neopad_spatial_node_t
+#define POD
+#define NOT_INTEGRAL
+#define T neopad_spatial_node_t
+#include <ctl/vector.h>
+
+typedef struct neopad_spatial_s {
+    vec_neopad_spatial_node_t nodes;
+    uint32_t root;
+    uint32_t free_list;
+    size_t count;
+
+    /// Scratch stack for queries.
+    vec_uint32_t stack;
+} neopad_spatial_t;
+
+/// Initialize an empty index.
+void neopad_spatial_init(neopad_spatial_t *this);
+
+/// Release all memory held by an index.
+void neopad_spatial_free(neopad_spatial_t *this);
+
+/// Insert a rectangle into the index.
+/// @return The leaf holding it, for use with neopad_spatial_remove and neopad_spatial_update.
+uint32_t neopad_spatial_insert(neopad_spatial_t *this, const rect_t *bounds, uint32_t value);
+
+/// Remove a leaf from the index.
+void neopad_spatial_remove(neopad_spatial_t *this, uint32_t leaf);
+
+/// Move a leaf to new bounds.
+/// @return The leaf, which may have changed.
+uint32_t neopad_spatial_update(neopad_spatial_t *this, uint32_t leaf, const rect_t *bounds);
+
+/// Find all values whose rectangles intersect the given area.
+/// @param out Values found are appended to this.
+/// @return The number of values found.
+size_t neopad_spatial_query(neopad_spatial_t *this, const rect_t *area, vec_uint32_t *out);
+
+#endif //NEOPAD_SPATIAL_INTERNAL_H
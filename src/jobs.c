@@ -0,0 +1,356 @@
+//
+// Created by Dylan Lukes on 9/3/23.
+//
+// The deques follow Lê et al., "Correct and Efficient Work-Stealing for Weak Memory Models"
+// (PPoPP '13), with a fixed capacity: a deque never grows, so slots are never freed out from
+// under a thief. Slots are read and written atomically (if relaxed), since a thief may read one
+// the owner is about to reuse; its claim on it (the CAS on top) then fails, and it is discarded.
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "neopad/internal/jobs.h"
+#include "neopad/internal/log.h"
+#include "neopad/internal/shims/bx/semaphore.h"
+#include "neopad/internal/shims/bx/thread.h"
+
+typedef struct job_s {
+    neopad_job_fn fn;
+    void *data;
+    neopad_job_counter_t *counter;
+} job_t;
+
+typedef struct slot_s {
+    _Atomic(neopad_job_fn) fn;
+    _Atomic(void *) data;
+    _Atomic(neopad_job_counter_t *) counter;
+} slot_t;
+
+/// A thread's deque (and, for workers, its thread).
+typedef struct worker_s {
+    /// Stolen from (by others).
+    atomic_int_fast64_t top;
+    char pad_top[64 - sizeof(atomic_int_fast64_t)];
+
+    /// Pushed and popped (by the owner).
+    atomic_int_fast64_t bottom;
+    char pad_bottom[64 - sizeof(atomic_int_fast64_t)];
+
+    slot_t slots[NEOPAD_JOBS_DEQUE_CAPACITY];
+
+    neopad_jobs_t jobs;
+    uint32_t index;
+    bx_thread_t thread;
+
+    /// Where the next steal starts (a random walk, so thieves spread out).
+    uint32_t victim;
+} worker_t;
+
+struct neopad_jobs_s {
+    /// The joining thread's deque, then one per worker.
+    worker_t *workers;
+    uint32_t count;
+
+    /// Workers asleep, and what wakes them.
+    atomic_uint_fast32_t sleeping;
+    bx_semaphore_t wake;
+
+    atomic_bool is_stopping;
+};
+
+/// The worker running on this thread, if any.
+static _Thread_local worker_t *current_worker = NULL;
+
+/// The deque this thread pushes and pops.
+static inline worker_t *own_worker(neopad_jobs_t this) {
+    worker_t *worker = current_worker;
+    return worker && worker->jobs == this ? worker : &this->workers[0];
+}
+
+#pragma mark - Deques
+
+/// Push a job at the bottom (owner only).
+/// @return Whether there was room.
+static bool push(worker_t *this, job_t job) {
+    const int_fast64_t b = atomic_load_explicit(&this->bottom, memory_order_relaxed);
+    const int_fast64_t t = atomic_load_explicit(&this->top, memory_order_acquire);
+    if (b - t >= NEOPAD_JOBS_DEQUE_CAPACITY) {
+        return false;
+    }
+
+    slot_t *slot = &this->slots[b % NEOPAD_JOBS_DEQUE_CAPACITY];
+    atomic_store_explicit(&slot->fn, job.fn, memory_order_relaxed);
+    atomic_store_explicit(&slot->data, job.data, memory_order_relaxed);
+    atomic_store_explicit(&slot->counter, job.counter, memory_order_relaxed);
+    atomic_store_explicit(&this->bottom, b + 1, memory_order_release);
+    return true;
+}
+
+static inline job_t load_slot(const slot_t *slot) {
+    return (job_t) {
+            .fn = atomic_load_explicit(&slot->fn, memory_order_relaxed),
+            .data = atomic_load_explicit(&slot->data, memory_order_relaxed),
+            .counter = atomic_load_explicit(&slot->counter, memory_order_relaxed),
+    };
+}
+
+/// Pop the job at the bottom, the last pushed (owner only).
+static bool pop(worker_t *this, job_t *job) {
+    const int_fast64_t b = atomic_load_explicit(&this->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&this->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int_fast64_t t = atomic_load_explicit(&this->top, memory_order_relaxed);
+
+    if (t > b) {
+        // Empty.
+        atomic_store_explicit(&this->bottom, b + 1, memory_order_relaxed);
+        return false;
+    }
+
+    *job = load_slot(&this->slots[b % NEOPAD_JOBS_DEQUE_CAPACITY]);
+    if (t < b) {
+        return true;
+    }
+
+    // The last job: race thieves for it.
+    const bool won = atomic_compare_exchange_strong_explicit(
+            &this->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+    atomic_store_explicit(&this->bottom, b + 1, memory_order_relaxed);
+    return won;
+}
+
+/// Steal the job at the top, the first pushed (any thread).
+static bool steal(worker_t *this, job_t *job) {
+    int_fast64_t t = atomic_load_explicit(&this->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    const int_fast64_t b = atomic_load_explicit(&this->bottom, memory_order_acquire);
+    if (t >= b) {
+        return false;
+    }
+
+    *job = load_slot(&this->slots[t % NEOPAD_JOBS_DEQUE_CAPACITY]);
+    return atomic_compare_exchange_strong_explicit(
+            &this->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+static inline bool is_empty(worker_t *this) {
+    return atomic_load(&this->top) >= atomic_load(&this->bottom);
+}
+
+#pragma mark - Running
+
+static void run(job_t job) {
+    job.fn(job.data);
+    atomic_fetch_sub_explicit(&job.counter->pending, 1, memory_order_release);
+}
+
+/// Run a job: one of our own, or else one stolen.
+/// @return Whether there was one to run.
+static bool run_one(neopad_jobs_t this, worker_t *self) {
+    job_t job;
+    if (pop(self, &job)) {
+        run(job);
+        return true;
+    }
+
+    // xorshift, so thieves pick different victims.
+    uint32_t x = self->victim;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    self->victim = x;
+
+    for (uint32_t i = 0; i < this->count; i++) {
+        worker_t *victim = &this->workers[(x + i) % this->count];
+        if (victim != self && steal(victim, &job)) {
+            run(job);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool has_work(neopad_jobs_t this) {
+    for (uint32_t i = 0; i < this->count; i++) {
+        if (!is_empty(&this->workers[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int32_t worker_entry(bx_thread_t thread, void *user_data) {
+    (void) thread;
+    worker_t *self = user_data;
+    neopad_jobs_t this = self->jobs;
+    current_worker = self;
+
+    uint32_t idle = 0;
+    while (!atomic_load_explicit(&this->is_stopping, memory_order_acquire)) {
+        if (run_one(this, self)) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < NEOPAD_JOBS_SPIN_COUNT) {
+            bx_thread_yield();
+            continue;
+        }
+
+        // Announced before looking one last time, so a fork either sees us asleep, or we see it.
+        atomic_fetch_add(&this->sleeping, 1);
+        if (!has_work(this) && !atomic_load(&this->is_stopping)) {
+            bx_semaphore_wait(this->wake, -1);
+        }
+        atomic_fetch_sub(&this->sleeping, 1);
+        idle = 0;
+    }
+    return 0;
+}
+
+#pragma mark - Lifecycle
+
+neopad_jobs_t neopad_jobs_create(uint32_t workers) {
+    if (workers == 0) {
+        const uint32_t cores = bx_thread_hardware_concurrency();
+        workers = cores > 1 ? cores - 1 : 0;
+    }
+    if (workers > NEOPAD_JOBS_MAX_WORKERS) {
+        workers = NEOPAD_JOBS_MAX_WORKERS;
+    }
+
+    neopad_jobs_t this = calloc(1, sizeof(struct neopad_jobs_s));
+    if (!this) {
+        return NULL;
+    }
+    this->count = 1 + workers;
+    this->workers = calloc(this->count, sizeof(worker_t));
+    if (!this->workers) {
+        free(this);
+        return NULL;
+    }
+    this->wake = bx_semaphore_create();
+    atomic_init(&this->sleeping, 0);
+    atomic_init(&this->is_stopping, false);
+
+    for (uint32_t i = 0; i < this->count; i++) {
+        worker_t *worker = &this->workers[i];
+        atomic_init(&worker->top, 0);
+        atomic_init(&worker->bottom, 0);
+        worker->jobs = this;
+        worker->index = i;
+        worker->victim = 0x9e3779b9u * (i + 1);
+    }
+
+    for (uint32_t i = 1; i < this->count; i++) {
+        worker_t *worker = &this->workers[i];
+        worker->thread = bx_thread_create();
+        if (!bx_thread_init(worker->thread, worker_entry, worker, 0, "neopad-jobs")) {
+            eprintf("Failed to start job worker %u.\n", i);
+            bx_thread_destroy(worker->thread);
+            worker->thread = NULL;
+            // Whatever started still runs jobs; the rest are left as deques nobody pushes to.
+        }
+    }
+    return this;
+}
+
+void neopad_jobs_destroy(neopad_jobs_t this) {
+    if (!this) {
+        return;
+    }
+
+    atomic_store_explicit(&this->is_stopping, true, memory_order_release);
+    bx_semaphore_post(this->wake, this->count);
+    for (uint32_t i = 1; i < this->count; i++) {
+        if (this->workers[i].thread) {
+            bx_thread_shutdown(this->workers[i].thread);
+            bx_thread_destroy(this->workers[i].thread);
+        }
+    }
+
+    bx_semaphore_destroy(this->wake);
+    free(this->workers);
+    free(this);
+}
+
+uint32_t neopad_jobs_thread_count(neopad_jobs_t this) {
+    return this ? this->count : 1;
+}
+
+#pragma mark - Fork/Join
+
+void neopad_jobs_fork(neopad_jobs_t this, neopad_job_fn fn, void *data, neopad_job_counter_t *counter) {
+    atomic_fetch_add_explicit(&counter->pending, 1, memory_order_relaxed);
+    const job_t job = {.fn = fn, .data = data, .counter = counter};
+
+    if (!this || !push(own_worker(this), job)) {
+        run(job);
+        return;
+    }
+
+    // Pairs with the sleeper's last look (see worker_entry).
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&this->sleeping, memory_order_relaxed) > 0) {
+        bx_semaphore_post(this->wake, 1);
+    }
+}
+
+void neopad_jobs_join(neopad_jobs_t this, neopad_job_counter_t *counter) {
+    worker_t *self = this ? own_worker(this) : NULL;
+    while (atomic_load_explicit(&counter->pending, memory_order_acquire) > 0) {
+        if (!run_one(this, self)) {
+            bx_thread_yield();
+        }
+    }
+}
+
+#pragma mark - Parallel For
+
+typedef struct range_s {
+    neopad_job_range_fn fn;
+    void *context;
+    size_t count;
+    size_t grain;
+
+    /// The first item not yet taken.
+    atomic_size_t next;
+} range_t;
+
+/// Take ranges until there are none left. Threads that get to it late find less (or nothing) to do.
+static void run_ranges(void *data) {
+    range_t *range = data;
+    for (;;) {
+        const size_t begin = atomic_fetch_add_explicit(&range->next, range->grain, memory_order_relaxed);
+        if (begin >= range->count) {
+            return;
+        }
+        const size_t end = range->count - begin > range->grain ? begin + range->grain : range->count;
+        range->fn(range->context, begin, end);
+    }
+}
+
+void neopad_jobs_parallel_for(neopad_jobs_t this, size_t count, size_t grain, neopad_job_range_fn fn, void *context) {
+    if (grain == 0) {
+        grain = 1;
+    }
+    if (!this || count <= grain) {
+        for (size_t begin = 0; begin < count; begin += grain) {
+            fn(context, begin, count - begin > grain ? begin + grain : count);
+        }
+        return;
+    }
+
+    range_t range = {.fn = fn, .context = context, .count = count, .grain = grain};
+    atomic_init(&range.next, 0);
+
+    // A helper per thread (or range) besides this one, which takes ranges as well.
+    const size_t ranges = (count + grain - 1) / grain;
+    const size_t helpers = ranges - 1 < this->count - 1 ? ranges - 1 : this->count - 1;
+
+    neopad_job_counter_t counter = NEOPAD_JOB_COUNTER_INIT;
+    for (size_t i = 0; i < helpers; i++) {
+        neopad_jobs_fork(this, run_ranges, &range, &counter);
+    }
+    run_ranges(&range);
+    neopad_jobs_join(this, &counter);
+}
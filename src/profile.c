@@ -0,0 +1,320 @@
+//
+// Created by Dylan Lukes on 8/22/23.
+//
+
+#include <inttypes.h>
+#include <memory.h>
+#include <stdlib.h>
+
+#include "neopad/profile.h"
+#include "neopad/internal/profile.h"
+#include "neopad/internal/log.h"
+#include "neopad/internal/renderer.h"
+#include "neopad/internal/renderer/commands.h"
+#include "neopad/internal/shims/bx/timer.h"
+
+static const char *const PHASE_NAMES[NEOPAD_PROFILE_PHASE_COUNT] = {
+        [NEOPAD_PROFILE_PHASE_BEGIN_FRAME] = "begin_frame",
+        [NEOPAD_PROFILE_PHASE_RENDER] = "render",
+        [NEOPAD_PROFILE_PHASE_END_FRAME] = "end_frame",
+};
+
+static void add_counters(neopad_profile_counters_t *dst, const neopad_profile_counters_t *src) {
+    dst->draw_calls += src->draw_calls;
+    dst->vertices += src->vertices;
+    dst->indices += src->indices;
+    dst->transient_bytes += src->transient_bytes;
+    dst->visible += src->visible;
+    dst->culled += src->culled;
+}
+
+#pragma mark - Publishing
+
+static inline void begin_write(neopad_profiler_t *this) {
+    atomic_fetch_add_explicit(&this->sequence, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void end_write(neopad_profiler_t *this) {
+    atomic_fetch_add_explicit(&this->sequence, 1, memory_order_release);
+}
+
+/// Wait out a write in progress, if any.
+/// @return The sequence to check again once read.
+static inline unsigned begin_read(const neopad_profiler_t *this) {
+    unsigned sequence;
+    do {
+        sequence = atomic_load_explicit(&this->sequence, memory_order_acquire);
+    } while (sequence & 1);
+    return sequence;
+}
+
+/// @return Whether what was read is whole (nothing was written meanwhile).
+static inline bool end_read(const neopad_profiler_t *this, unsigned sequence) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&this->sequence, memory_order_relaxed) == sequence;
+}
+
+#pragma mark - Profiler
+
+void neopad_profiler_init(neopad_profiler_t *this) {
+    memset(this, 0, sizeof(neopad_profiler_t));
+    atomic_init(&this->sequence, 0);
+    this->epoch = bx_get_hp_counter();
+    this->to_ms = 1000.0 / (double) bx_get_hp_frequency();
+}
+
+void neopad_profiler_free(neopad_profiler_t *this) {
+    free(this->frames);
+    this->frames = NULL;
+    this->enabled = false;
+}
+
+void neopad_profiler_set_enabled(neopad_profiler_t *this, bool enabled) {
+    if (enabled && !this->enabled) {
+        neopad_profile_frame_t *frames = this->frames;
+        if (!frames) {
+            frames = malloc(NEOPAD_PROFILE_FRAMES * sizeof(neopad_profile_frame_t));
+            if (!frames) {
+                eprintf("Out of memory for profiling.\n");
+                return;
+            }
+        }
+        begin_write(this);
+        this->frames = frames;
+        this->head = 0;
+        this->count = 0;
+        this->next_index = 0;
+        end_write(this);
+        memset(&this->current, 0, sizeof(neopad_profile_frame_t));
+    }
+    this->enabled = enabled;
+}
+
+double neopad_profiler_now(const neopad_profiler_t *this) {
+    return (double) (bx_get_hp_counter() - this->epoch) * this->to_ms;
+}
+
+void neopad_profiler_begin_frame(neopad_profiler_t *this, uint32_t module_count) {
+    memset(&this->current, 0, sizeof(neopad_profile_frame_t));
+    this->current.index = this->next_index;
+    this->current.start_ms = neopad_profiler_now(this);
+    this->current.module_count = module_count < NEOPAD_PROFILE_MAX_MODULES ? module_count : NEOPAD_PROFILE_MAX_MODULES;
+}
+
+void neopad_profiler_record(neopad_profiler_t *this, uint32_t module, const char *name,
+                            neopad_profile_phase_t phase, double start_ms, double end_ms) {
+    if (module >= this->current.module_count) {
+        return;
+    }
+    neopad_profile_module_t *m = &this->current.modules[module];
+    m->name = name;
+    m->start_ms[phase] = start_ms;
+    m->duration_ms[phase] += end_ms - start_ms;
+}
+
+void neopad_profiler_end_frame(neopad_profiler_t *this, double submit_ms, double end_ms, double gpu_ms) {
+    neopad_profile_frame_t *frame = &this->current;
+    frame->cpu_ms = submit_ms - frame->start_ms;
+    frame->submit_ms = end_ms - submit_ms;
+    frame->gpu_ms = gpu_ms;
+
+    for (uint32_t i = 0; i < frame->module_count; i++) {
+        add_counters(&frame->totals, &frame->modules[i].counters);
+    }
+
+    begin_write(this);
+    this->frames[this->head] = *frame;
+    this->head = (this->head + 1) % NEOPAD_PROFILE_FRAMES;
+    if (this->count < NEOPAD_PROFILE_FRAMES) {
+        this->count++;
+    }
+    this->next_index++;
+    end_write(this);
+
+    // Nothing is in progress until the next frame begins.
+    frame->module_count = 0;
+}
+
+const neopad_profile_frame_t *neopad_profiler_get_frame(const neopad_profiler_t *this, size_t age) {
+    if (age >= this->count) {
+        return NULL;
+    }
+    size_t slot = (this->head + NEOPAD_PROFILE_FRAMES - 1 - age) % NEOPAD_PROFILE_FRAMES;
+    return &this->frames[slot];
+}
+
+size_t neopad_profiler_read_count(const neopad_profiler_t *this) {
+    size_t count;
+    unsigned sequence;
+    do {
+        sequence = begin_read(this);
+        count = this->count;
+    } while (!end_read(this, sequence));
+    return count;
+}
+
+const neopad_profile_frame_t *neopad_profiler_read_frame(neopad_profiler_t *this, size_t age) {
+    for (;;) {
+        const unsigned sequence = begin_read(this);
+        const neopad_profile_frame_t *frame = neopad_profiler_get_frame(this, age);
+        if (frame) {
+            this->front = *frame;
+        }
+        if (end_read(this, sequence)) {
+            return frame ? &this->front : NULL;
+        }
+    }
+}
+
+bool neopad_profiler_read_all(const neopad_profiler_t *this, neopad_profiler_t *dst) {
+    memset(dst, 0, sizeof(neopad_profiler_t));
+    dst->frames = malloc(NEOPAD_PROFILE_FRAMES * sizeof(neopad_profile_frame_t));
+    if (!dst->frames) {
+        return false;
+    }
+
+    unsigned sequence;
+    do {
+        sequence = begin_read(this);
+        dst->head = this->head;
+        dst->count = this->count;
+        if (this->frames) {
+            memcpy(dst->frames, this->frames, NEOPAD_PROFILE_FRAMES * sizeof(neopad_profile_frame_t));
+        }
+    } while (!end_read(this, sequence));
+    return true;
+}
+
+#pragma mark - Output
+
+static void write_counters_json(FILE *file, const neopad_profile_counters_t *c) {
+    fprintf(file,
+            "{\"draw_calls\": %" PRIu32 ", \"vertices\": %" PRIu32 ", \"indices\": %" PRIu32
+            ", \"transient_bytes\": %" PRIu64 ", \"visible\": %" PRIu32 ", \"culled\": %" PRIu32 "}",
+            c->draw_calls, c->vertices, c->indices, c->transient_bytes, c->visible, c->culled);
+}
+
+static void write_json(const neopad_profiler_t *this, FILE *file) {
+    fprintf(file, "[\n");
+    for (size_t age = this->count; age-- > 0;) {
+        const neopad_profile_frame_t *frame = neopad_profiler_get_frame(this, age);
+        fprintf(file,
+                "  {\"index\": %" PRIu64 ", \"start_ms\": %.4f, \"cpu_ms\": %.4f, \"submit_ms\": %.4f, \"gpu_ms\": %.4f,\n",
+                frame->index, frame->start_ms, frame->cpu_ms, frame->submit_ms, frame->gpu_ms);
+        fprintf(file, "   \"totals\": ");
+        write_counters_json(file, &frame->totals);
+        fprintf(file, ",\n   \"modules\": [\n");
+        for (uint32_t i = 0; i < frame->module_count; i++) {
+            const neopad_profile_module_t *m = &frame->modules[i];
+            fprintf(file, "     {\"name\": \"%s\"", m->name ? m->name : "");
+            for (int phase = 0; phase < NEOPAD_PROFILE_PHASE_COUNT; phase++) {
+                fprintf(file, ", \"%s_ms\": %.4f", PHASE_NAMES[phase], m->duration_ms[phase]);
+            }
+            fprintf(file, ", \"counters\": ");
+            write_counters_json(file, &m->counters);
+            fprintf(file, "}%s\n", i + 1 < frame->module_count ? "," : "");
+        }
+        fprintf(file, "   ]}%s\n", age > 0 ? "," : "");
+    }
+    fprintf(file, "]\n");
+}
+
+/// Chrome's trace format: complete ("X") events for frames and module phases, in microseconds,
+/// and counter ("C") events for the frame totals.
+static void write_chrome_trace(const neopad_profiler_t *this, FILE *file) {
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    for (size_t age = this->count; age-- > 0;) {
+        const neopad_profile_frame_t *frame = neopad_profiler_get_frame(this, age);
+        const double ts = frame->start_ms * 1000.0;
+
+        fprintf(file,
+                "%s  {\"name\": \"frame %" PRIu64 "\", \"cat\": \"frame\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, "
+                "\"ts\": %.3f, \"dur\": %.3f}",
+                first ? "" : ",\n", frame->index, ts, (frame->cpu_ms + frame->submit_ms) * 1000.0);
+        first = false;
+
+        fprintf(file,
+                ",\n  {\"name\": \"submit\", \"cat\": \"frame\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, "
+                "\"ts\": %.3f, \"dur\": %.3f}",
+                ts + frame->cpu_ms * 1000.0, frame->submit_ms * 1000.0);
+
+        for (uint32_t i = 0; i < frame->module_count; i++) {
+            const neopad_profile_module_t *m = &frame->modules[i];
+            for (int phase = 0; phase < NEOPAD_PROFILE_PHASE_COUNT; phase++) {
+                if (m->duration_ms[phase] <= 0.0) {
+                    continue;
+                }
+                fprintf(file,
+                        ",\n  {\"name\": \"%s.%s\", \"cat\": \"module\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, "
+                        "\"ts\": %.3f, \"dur\": %.3f}",
+                        m->name ? m->name : "", PHASE_NAMES[phase],
+                        m->start_ms[phase] * 1000.0, m->duration_ms[phase] * 1000.0);
+            }
+        }
+
+        fprintf(file, ",\n  {\"name\": \"counters\", \"ph\": \"C\", \"pid\": 0, \"ts\": %.3f, \"args\": ", ts);
+        write_counters_json(file, &frame->totals);
+        fprintf(file, "}");
+
+        fprintf(file, ",\n  {\"name\": \"gpu_ms\", \"ph\": \"C\", \"pid\": 0, \"ts\": %.3f, \"args\": "
+                      "{\"gpu_ms\": %.4f}}", ts, frame->gpu_ms);
+    }
+    fprintf(file, "\n]}\n");
+}
+
+#pragma mark - Renderer
+
+void neopad_renderer_set_profiling(neopad_renderer_t this, bool enabled) {
+    if (neopad_renderer_is_recording(this)) {
+        neopad_renderer_record(this, (neopad_command_t) {
+                .type = NEOPAD_COMMAND_SET_PROFILING,
+                .enabled = enabled,
+        });
+        return;
+    }
+    neopad_profiler_set_enabled(&this->profiler, enabled);
+}
+
+// The application thread of a threaded renderer reads copies, as the API thread records frames.
+
+size_t neopad_renderer_get_profile_frame_count(neopad_renderer_const_t this) {
+    if (neopad_renderer_is_recording(this)) {
+        return neopad_profiler_read_count(&this->profiler);
+    }
+    return this->profiler.count;
+}
+
+const neopad_profile_frame_t *neopad_renderer_get_profile_frame(neopad_renderer_const_t this, size_t age) {
+    if (neopad_renderer_is_recording(this)) {
+        return neopad_profiler_read_frame(&this->profiler, age);
+    }
+    return neopad_profiler_get_frame(&this->profiler, age);
+}
+
+bool neopad_renderer_dump_profile(neopad_renderer_const_t this, FILE *file, neopad_profile_format_t format) {
+    if (format != NEOPAD_PROFILE_FORMAT_JSON && format != NEOPAD_PROFILE_FORMAT_CHROME_TRACE) {
+        return false;
+    }
+
+    neopad_profiler_t copy;
+    const neopad_profiler_t *profiler = &this->profiler;
+    if (neopad_renderer_is_recording(this)) {
+        if (!neopad_profiler_read_all(&this->profiler, &copy)) {
+            return false;
+        }
+        profiler = &copy;
+    }
+
+    if (format == NEOPAD_PROFILE_FORMAT_JSON) {
+        write_json(profiler, file);
+    } else {
+        write_chrome_trace(profiler, file);
+    }
+
+    if (profiler == &copy) {
+        neopad_profiler_free(&copy);
+    }
+    return fflush(file) == 0 && !ferror(file);
+}
@@ -8,50 +8,224 @@
 #include "neopad/types.h"
 #include "neopad/renderer.h"
 #include "neopad/internal/log.h"
+#include "neopad/internal/rect.h"
 #include "neopad/internal/renderer.h"
 #include "neopad/internal/renderer/background.h"
+#include "neopad/internal/renderer/commands.h"
+#include "neopad/internal/renderer/geometry.h"
+#include "neopad/internal/renderer/scene.h"
 #include "neopad/internal/renderer/vector.h"
-#include "neopad/internal/shims/bx/thread.h"
+#include "neopad/internal/scene.h"
+#include "neopad/internal/shims/bx/timer.h"
+
+/// How quickly the camera follows its target: the distance left shrinks by e every 1 / rate seconds.
+static const double CAMERA_RATE = 20.0;
+
+/// Stiffness of the zoom spring (which settles in about a quarter second), and how near its
+/// target (in log2) it comes to rest.
+static const double ZOOM_RATE = 20.0;
+static const double ZOOM_PRECISION = 1e-4;
+
+/// The step taken on the first frame after the view has been at rest (however long it was).
+static const double RESTING_STEP = 1.0 / 60.0;
+
+/// Call one module's hook for a phase of the frame, timing it if profiling.
+static inline void call_hook(neopad_renderer_t this,
+                             neopad_renderer_module_hook_t hook,
+                             neopad_renderer_module_t module,
+                             uint32_t rank,
+                             neopad_profile_phase_t phase) {
+    if (!neopad_profiler_in_frame(&this->profiler)) {
+        hook(module, this);
+        return;
+    }
 
-#pragma mark - Lifecycle
+    double start = neopad_profiler_now(&this->profiler);
+    hook(module, this);
+    double end = neopad_profiler_now(&this->profiler);
+    neopad_profiler_record(&this->profiler, rank, module.base->name, phase, start, end);
+}
+
+/// Call every module's hook for a phase of the frame, in order.
+/// @note Modules registered meanwhile are called from the next phase; those unregistered are not called again.
+static void call_phase(neopad_renderer_t this, const neopad_renderer_phase_t *hooks, neopad_profile_phase_t phase) {
+    neopad_renderer_registry_enter(this);
+    for (uint32_t i = 0; i < hooks->count; i++) {
+        if (neopad_renderer_registry_has_hook(&this->modules, hooks, i)) {
+            call_hook(this, hooks->hooks[i], hooks->modules[i], hooks->ranks[i], phase);
+        }
+    }
+    neopad_renderer_registry_leave(this);
+}
 
-int api_thread_entry(bx_thread_t self, void *user_data) {
-    bx_thread_set_name(self, "bgfx-api-thread");
+/// Render a module (if it renders).
+static void render_module(neopad_renderer_t this, neopad_renderer_module_id_t id) {
+    neopad_renderer_module_t module = neopad_renderer_registry_get(&this->modules, id);
+    if (!module.base || !module.base->render) {
+        return;
+    }
 
-    return 0;
+    // Not yet ranked if registered by a hook still being called (and then not profiled).
+    uint32_t rank = 0;
+    while (rank < this->modules.count && this->modules.sorted[rank] != id) {
+        rank++;
+    }
+    neopad_renderer_registry_enter(this);
+    call_hook(this, module.base->render, module, rank, NEOPAD_PROFILE_PHASE_RENDER);
+    neopad_renderer_registry_leave(this);
 }
 
+#pragma mark - Lifecycle
 
 neopad_renderer_t neopad_renderer_create() {
     neopad_renderer_t renderer = malloc(sizeof(struct neopad_renderer_s));
     memset(renderer, 0, sizeof(struct neopad_renderer_s));
+    neopad_frame_scratch_init(&renderer->scratch);
     return renderer;
 }
 
-void neopad_renderer_init(neopad_renderer_t this, neopad_renderer_init_t init) {
+/// Take a place among the renderers sharing bgfx, and with it a range of views.
+static bool join_group(neopad_renderer_t this, neopad_renderer_group_t *group) {
+    uint32_t slot = 0;
+    while (slot < NEOPAD_RENDERER_MAX_SHARING && group->members[slot]) {
+        slot++;
+    }
+    if (slot == NEOPAD_RENDERER_MAX_SHARING) {
+        eprintf("Too many renderers sharing bgfx (at most %d).\n", NEOPAD_RENDERER_MAX_SHARING);
+        return false;
+    }
+
+    group->members[slot] = this;
+    if (group->count++ == 0) {
+        group->primary = this;
+    }
+    this->group = group;
+    this->group_slot = slot;
+    this->graph.first_view = (bgfx_view_id_t) (slot * NEOPAD_RENDERER_GRAPH_VIEWS);
+    return true;
+}
+
+/// Create the framebuffer a renderer sharing bgfx draws into: its window's, or, headless, one of its own.
+static bgfx_frame_buffer_handle_t create_window(neopad_renderer_t this) {
+    if (this->init.headless) {
+        return bgfx_create_frame_buffer((uint16_t) this->width, (uint16_t) this->height,
+                                        BGFX_TEXTURE_FORMAT_BGRA8, BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP);
+    }
+    return bgfx_create_frame_buffer_from_nwh(this->init.native_window_handle,
+                                             (uint16_t) this->width, (uint16_t) this->height,
+                                             BGFX_TEXTURE_FORMAT_COUNT, BGFX_TEXTURE_FORMAT_COUNT);
+}
+
+/// Create what the renderer draws with, declare its passes, and set up the modules.
+/// @note Renderers sharing bgfx each do this: bgfx hands the same programs back, counting references.
+static void setup_resources(neopad_renderer_t this) {
+    // Initialize vertex layout
+    bgfx_vertex_layout_begin(&this->vertex_layout, BGFX_RENDERER_TYPE_NOOP);
+    bgfx_vertex_layout_add(&this->vertex_layout, BGFX_ATTRIB_POSITION, 4, BGFX_ATTRIB_TYPE_FLOAT, false, false);
+    bgfx_vertex_layout_add(&this->vertex_layout, BGFX_ATTRIB_COLOR0, 4, BGFX_ATTRIB_TYPE_UINT8, true, false);
+    bgfx_vertex_layout_end(&this->vertex_layout);
+
+    // The same, packed: z and w are always 0 and 1, which is what missing components default to.
+    bgfx_vertex_layout_begin(&this->packed_vertex_layout, BGFX_RENDERER_TYPE_NOOP);
+    bgfx_vertex_layout_add(&this->packed_vertex_layout, BGFX_ATTRIB_POSITION, 2, BGFX_ATTRIB_TYPE_INT16, true, false);
+    bgfx_vertex_layout_add(&this->packed_vertex_layout, BGFX_ATTRIB_COLOR0, 4, BGFX_ATTRIB_TYPE_UINT8, true, false);
+    bgfx_vertex_layout_end(&this->packed_vertex_layout);
+
+    // Initialize basic program (others handled in modules)
+    bgfx_renderer_type_t renderer_type = bgfx_get_renderer_type();
+    this->programs[NEOPAD_PROGRAM_BASIC] = bgfx_create_embedded_program(
+            embedded_shaders,
+            renderer_type,
+            "vs_basic",
+            "fs_basic",
+            NULL);
+
+    // Initialize uniforms (all of them, modules' included; modules set their own)
+    neopad_uniforms_setup(&this->uniforms);
+    neopad_uniforms_set_1f(&this->uniforms, NEOPAD_UNIFORM_ZOOM, this->zoom);
+    neopad_uniforms_set_1f(&this->uniforms, NEOPAD_UNIFORM_CONTENT_SCALE, this->content_scale);
+
+    // Passes (others declared by modules), then per-module setup
+    neopad_renderer_pass_desc_t content_pass = neopad_renderer_content_pass_desc();
+    this->content_pass = neopad_renderer_declare_pass(this, &content_pass);
+    neopad_renderer_setup_modules(this);
+}
+
+static bool init_shared(neopad_renderer_t this, neopad_renderer_t share) {
+    if (!share->group) {
+        eprintf("Renderers can only share bgfx with an initialized renderer.\n");
+        return false;
+    }
+    if (!join_group(this, share->group)) {
+        return false;
+    }
+
+    this->bgfx_init = share->bgfx_init;
+    this->window = create_window(this);
+    if (!BGFX_HANDLE_IS_VALID(this->window)) {
+        eprintf("Failed to create a framebuffer for the renderer's window.\n");
+        this->group->members[this->group_slot] = NULL;
+        this->group->count--;
+        this->group = NULL;
+        return false;
+    }
+
+    setup_resources(this);
+    return true;
+}
+
+bool neopad_renderer_init(neopad_renderer_t this, neopad_renderer_init_t init) {
     this->init = init;
 
     // Populate ourselves
     this->width = this->target_width = this->init.width;
     this->height = this->target_height = this->init.height;
     this->content_scale = this->init.content_scale > 0 ? this->init.content_scale : 1.0f;
-    glm_vec2_zero(this->camera);
-    glm_vec2_zero(this->target_camera);
+    this->camera = this->target_camera = (neopad_dvec2_t) {0.0, 0.0};
     this->zoom = this->target_zoom = 1.0f;
+    neopad_animator_init(&this->animator);
+    this->motion.camera_x = neopad_animator_add(&this->animator, NEOPAD_ANIMATION_DECAY, 0.0, CAMERA_RATE, 0.01);
+    this->motion.camera_y = neopad_animator_add(&this->animator, NEOPAD_ANIMATION_DECAY, 0.0, CAMERA_RATE, 0.01);
+    this->motion.log_zoom = neopad_animator_add(&this->animator, NEOPAD_ANIMATION_SPRING, 0.0, ZOOM_RATE, ZOOM_PRECISION);
+    this->motion.is_resting = true;
+    this->dirty.is_full = true;
+    this->dirty.rect = RECT_EMPTY;
+    neopad_profiler_init(&this->profiler);
 
     // Populate modules
-    this->modules[NEOPAD_RENDERER_MODULE_BACKGROUND] = neopad_renderer_module_background_create(
-            NEOPAD_VIEW_BACKGROUND,
+    this->builtin.background = neopad_renderer_register_module(this, neopad_renderer_module_background_create(
             this->init.background.color,
             this->init.background.grid_enabled,
             this->init.background.grid_major,
-            this->init.background.grid_minor);
-    this->modules[NEOPAD_RENDERER_MODULE_VECTOR] = neopad_renderer_module_vector_create();
+            this->init.background.grid_minor));
+    this->builtin.vector = neopad_renderer_register_module(this, neopad_renderer_module_vector_create());
+    this->builtin.scene = neopad_renderer_register_module(this, neopad_renderer_module_scene_create());
+    this->window = (bgfx_frame_buffer_handle_t) BGFX_INVALID_HANDLE;
+
+    // Sharing: bgfx is already initialized, by the renderer shared with, on this thread.
+    if (this->init.share) {
+        if (this->init.threaded || this->init.share->init.threaded) {
+            eprintf("Renderers sharing bgfx cannot be threaded.\n");
+            return false;
+        }
+        return init_shared(this, this->init.share);
+    }
 
-    // Set up the API thread.
-    this->render_thread = bx_thread_create();
-    bx_thread_init(this->render_thread, api_thread_entry, this, 0, NULL);
+    // Threaded: bgfx is initialized on the API thread, which then plays back what is recorded.
+    if (this->init.threaded) {
+        this->thread.target_camera = this->camera;
+        this->thread.target_zoom = this->zoom;
+        this->thread.width = this->width;
+        this->thread.height = this->height;
+        this->thread.content_scale = this->content_scale;
+        this->thread.flight_rect = RECT_EMPTY;
+        return neopad_renderer_start_api_thread(this);
+    }
 
+    return neopad_renderer_init_bgfx(this);
+}
+
+bool neopad_renderer_init_bgfx(neopad_renderer_t this) {
     // Initialize BGFX
     bgfx_init_ctor(&this->bgfx_init);
 #pragma clang diagnostic push
@@ -65,9 +239,17 @@ void neopad_renderer_init(neopad_renderer_t this, neopad_renderer_init_t init) {
     this->bgfx_init.platformData.nwh = this->init.native_window_handle;
     this->bgfx_init.platformData.ndt = this->init.native_display_type;
 
+    // Headless: no window, no GPU. Render on the API thread (as if await_frame had been called).
+    if (this->init.headless) {
+        this->bgfx_init.type = BGFX_RENDERER_TYPE_NOOP;
+        this->bgfx_init.platformData.nwh = NULL;
+        this->bgfx_init.platformData.ndt = NULL;
+        bgfx_render_frame(0);
+    }
+
     if (!bgfx_init(&this->bgfx_init)) {
         eprintf("Failed to initialize BGFX.\n");
-        exit(EXIT_FAILURE);
+        return false;
     }
 
     // Initial reset.
@@ -75,86 +257,216 @@ void neopad_renderer_init(neopad_renderer_t this, neopad_renderer_init_t init) {
     bgfx_reset(this->width, this->height, reset_flags, this->bgfx_init.resolution.format);
     bgfx_set_debug(this->init.debug ? BGFX_DEBUG_TEXT : 0);
 
-    // Initialize vertex layout
-    bgfx_vertex_layout_begin(&this->vertex_layout, BGFX_RENDERER_TYPE_NOOP);
-    bgfx_vertex_layout_add(&this->vertex_layout, BGFX_ATTRIB_POSITION, 4, BGFX_ATTRIB_TYPE_FLOAT, false, false);
-    bgfx_vertex_layout_add(&this->vertex_layout, BGFX_ATTRIB_COLOR0, 4, BGFX_ATTRIB_TYPE_UINT8, true, false);
-    bgfx_vertex_layout_end(&this->vertex_layout);
-
-    // Initialize basic program (others handled in modules)
-    bgfx_renderer_type_t renderer_type = bgfx_get_renderer_type();
-    this->programs[NEOPAD_PROGRAM_BASIC] = bgfx_create_embedded_program(
-            embedded_shaders,
-            renderer_type,
-            "vs_basic",
-            "fs_basic",
-            NULL);
+    // The first of (possibly) several renderers sharing bgfx, and its workers.
+    neopad_renderer_group_t *group = calloc(1, sizeof(neopad_renderer_group_t));
+    if (!group || !join_group(this, group)) {
+        eprintf("Out of memory for the renderer.\n");
+        free(group);
+        bgfx_shutdown();
+        return false;
+    }
+    this->group->jobs = neopad_jobs_create(this->init.worker_threads);
 
-    // Initialize uniforms (others handled in modules)
-    this->uniforms = (neopad_renderer_uniforms_t) {
-            .time = 0.0f,
-            .zoom = this->zoom
-    };
-    this->uniform_handle = bgfx_create_uniform("u_params", BGFX_UNIFORM_TYPE_VEC4, 2);
+    setup_resources(this);
+    return true;
+}
 
-    // Per-module setup
-    for (int i = 0; i < NEOPAD_RENDERER_MODULE_COUNT; i++) {
-        neopad_renderer_module_t mod = this->modules[i];
-        if (mod.base->on_setup) {
-            mod.base->on_setup(mod, this);
+/// Make another renderer sharing bgfx the primary, with the finished strokes.
+static void hand_off(neopad_renderer_t this) {
+    neopad_renderer_t heir = NULL;
+    for (uint32_t i = 0; i < NEOPAD_RENDERER_MAX_SHARING && !heir; i++) {
+        if (this->group->members[i] != this) {
+            heir = this->group->members[i];
         }
     }
+
+    this->group->primary = heir;
+    neopad_renderer_module_vector_hand_off(this, heir);
 }
 
 void neopad_renderer_shutdown(neopad_renderer_t this) {
-    // Per-module teardown, in reverse setup order.
-    for (int i = NEOPAD_RENDERER_MODULE_COUNT - 1; i >= 0; i--) {
-        neopad_renderer_module_t mod = this->modules[i];
-        if (mod.base->on_teardown) {
-            mod.base->on_teardown(mod, this);
-        }
+    if (neopad_renderer_is_recording(this)) {
+        // The API thread shuts down (calling this again), then stops.
+        neopad_renderer_stop_api_thread(this);
+        return;
+    }
+
+    // The primary hands the finished strokes, and submitting, to a renderer still sharing bgfx.
+    if (this->group && this->group->primary == this && this->group->count > 1) {
+        hand_off(this);
     }
 
-    bgfx_destroy_uniform(this->uniform_handle);
+    // Per-module teardown, in reverse setup order.
+    neopad_renderer_teardown_modules(this);
+    neopad_renderer_release_pass(this, this->content_pass);
+
+    neopad_uniforms_teardown(&this->uniforms);
     bgfx_destroy_program(this->programs[NEOPAD_PROGRAM_BACKGROUND]);
     bgfx_destroy_program(this->programs[NEOPAD_PROGRAM_BASIC]);
+    if (BGFX_HANDLE_IS_VALID(this->window)) {
+        bgfx_destroy_frame_buffer(this->window);
+    }
+
+    // bgfx goes with the last renderer sharing it.
+    neopad_renderer_group_t *group = this->group;
+    if (!group) {
+        return;
+    }
+    if (group->uniforms_owner == this) {
+        group->uniforms_owner = NULL;
+    }
+    group->members[this->group_slot] = NULL;
+    this->group = NULL;
+    if (--group->count > 0) {
+        return;
+    }
+    neopad_jobs_destroy(group->jobs);
+    free(group);
     bgfx_shutdown();
 }
 
 void neopad_renderer_destroy(neopad_renderer_t this) {
-    // Per-module destruction, in reverse creation order
-    for (int i = NEOPAD_RENDERER_MODULE_COUNT - 1; i >= 0; i--) {
-        neopad_renderer_module_t mod = this->modules[i];
-        if (mod.base->destroy) {
-            mod.base->destroy(mod);
-        }
-    }
+    // Per-module destruction, in reverse order
+    neopad_renderer_destroy_modules(this);
+    neopad_profiler_free(&this->profiler);
+    neopad_frame_scratch_free(&this->scratch);
     free(this);
 }
 
 #pragma mark - Coordinate Transformations
 
+/// Recompute the frame's view (the inverse transforms), after the matrices change, and pass it on.
+static void update_frame_view(neopad_renderer_t this) {
+    mat4 inv_proj;
+    mat4 inv_model;
+    mat4 inv_model_view;
+    glm_mat4_inv(this->proj, inv_proj);
+    glm_mat4_inv(this->model, inv_model);
+    glm_mat4_inv(this->model_view, inv_model_view);
+
+    neopad_renderer_view_t *view = &this->frame_view;
+    view->camera = this->camera;
+    view->zoom = this->zoom;
+    glm_mat4_mul(inv_model_view, inv_proj, view->ndc_to_world);
+    glm_mat4_mul(inv_model, inv_proj, view->ndc_to_screen);
+
+    if (!this->init.threaded) {
+        this->front.view = *view;
+        this->front.is_valid = false;
+        return;
+    }
+
+    // Publish it for the application thread.
+    atomic_fetch_add_explicit(&this->published.sequence, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    this->published.view = *view;
+    atomic_fetch_add_explicit(&this->published.sequence, 1, memory_order_release);
+}
+
+/// Bring the application thread's view up to date with the last one published (if threaded).
+static void refresh_front(neopad_renderer_const_t this) {
+    if (!neopad_renderer_is_recording(this)) {
+        return;
+    }
+
+    unsigned sequence = atomic_load_explicit(&this->published.sequence, memory_order_acquire);
+    if (sequence == this->front.sequence) {
+        return;
+    }
+
+    neopad_renderer_view_t view;
+    for (;;) {
+        sequence = atomic_load_explicit(&this->published.sequence, memory_order_acquire);
+        if (sequence & 1) {
+            continue;
+        }
+        view = this->published.view;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&this->published.sequence, memory_order_relaxed) == sequence) {
+            break;
+        }
+    }
+
+    this->front.view = view;
+    this->front.sequence = sequence;
+    this->front.is_valid = false;
+}
+
+/// Bring the window transforms up to date for a viewport.
+static void update_window_transforms(neopad_renderer_const_t this, const neopad_vec4_t viewport) {
+    refresh_front(this);
+    if (this->front.is_valid && memcmp(&this->front.viewport, &viewport, sizeof(neopad_vec4_t)) == 0) {
+        return;
+    }
+
+    mat4 window_to_ndc;
+    glm_ortho(viewport.left, viewport.right, viewport.bottom, viewport.top, -1.0f, 1.0f, window_to_ndc);
+    glm_mat4_mul(this->front.view.ndc_to_world, window_to_ndc, this->front.to_world);
+    glm_mat4_mul(this->front.view.ndc_to_screen, window_to_ndc, this->front.to_screen);
+
+    this->front.viewport = viewport;
+    this->front.is_valid = true;
+}
+
+/// The area of the world in view.
+static void view_rect(const neopad_renderer_view_t *view, rect_t *dst) {
+    // The corners of NDC space are the corners of the view.
+    vec4 corners[] = {
+            {-1.0f, -1.0f, 0.0f, 1.0f},
+            {1.0f,  -1.0f, 0.0f, 1.0f},
+            {1.0f,  1.0f,  0.0f, 1.0f},
+            {-1.0f, 1.0f,  0.0f, 1.0f},
+    };
+
+    *dst = RECT_EMPTY;
+    for (int i = 0; i < 4; i++) {
+        vec4 w;
+        glm_mat4_mulv((vec4 *) view->ndc_to_world, corners[i], w);
+        float x = (float) ((double) w[0] - view->camera.x);
+        float y = (float) ((double) w[1] - view->camera.y);
+        rect_t corner = {.min = {x, y}, .max = {x, y}};
+        rect_union(dst, &corner, dst);
+    }
+}
+
 void neopad_renderer_window_to_world(neopad_renderer_const_t this,
                                      const neopad_vec4_t viewport,
                                      const neopad_vec2_t p,
                                      neopad_vec2_t *q) {
-    // Create the transforms we need.
-    mat4 viewport_to_ndc;
-    mat4 inv_model_view;
-    mat4 inv_proj;
-    glm_ortho(viewport.left, viewport.right, viewport.bottom, viewport.top, -1.0f, 1.0f, viewport_to_ndc);
-
-    glm_mat4_inv(this->model_view, inv_model_view);
-    glm_mat4_inv(this->proj, inv_proj);
-
-    vec4 v = {p.x, p.y, 0.0f, 1.0f};
-    vec4 w;
+    neopad_dvec2_t w;
+    neopad_renderer_window_to_world_n(this, viewport, &p, &w, 1);
+    q->x = (float) w.x;
+    q->y = (float) w.y;
+}
 
-    glm_mat4_mulv(viewport_to_ndc, v, w);
-    glm_mat4_mulv(inv_proj, w, w);
-    glm_mat4_mulv(inv_model_view, w, w);
+void neopad_renderer_window_to_world_d(neopad_renderer_const_t this,
+                                       const neopad_vec4_t viewport,
+                                       const neopad_vec2_t p,
+                                       neopad_dvec2_t *q) {
+    neopad_renderer_window_to_world_n(this, viewport, &p, q, 1);
+}
 
-    glm_vec2_copy((vec2) {w[0], w[1]}, q->vec);
+void neopad_renderer_window_to_world_n(neopad_renderer_const_t this,
+                                       const neopad_vec4_t viewport,
+                                       const neopad_vec2_t *p,
+                                       neopad_dvec2_t *q,
+                                       size_t count) {
+    update_window_transforms(this, viewport);
+
+    // The transform is affine, and z is always 0, so only the 2x2 part and the translation matter.
+    // That gives camera-relative coordinates: the camera is undone in double precision.
+    mat4 *m = &this->front.to_world;
+    const float a = (*m)[0][0], b = (*m)[0][1];
+    const float c = (*m)[1][0], d = (*m)[1][1];
+    const double tx = (double) (*m)[3][0] - this->front.view.camera.x;
+    const double ty = (double) (*m)[3][1] - this->front.view.camera.y;
+
+    for (size_t i = 0; i < count; i++) {
+        const float x = p[i].x;
+        const float y = p[i].y;
+        q[i].x = (double) (a * x + c * y) + tx;
+        q[i].y = (double) (b * x + d * y) + ty;
+    }
 }
 
 void
@@ -162,127 +474,522 @@ neopad_renderer_window_to_screen(neopad_renderer_const_t this,
                                  const neopad_vec4_t viewport,
                                  const neopad_vec2_t p,
                                  neopad_vec2_t *q) {
-    // Create the transforms we need.
-    mat4 viewport_to_ndc;
-    mat4 inv_model;
-    mat4 inv_proj;
-    glm_ortho(viewport.left, viewport.right, viewport.bottom, viewport.top, -1.0f, 1.0f, viewport_to_ndc);
-
-    glm_mat4_inv(this->model, inv_model);
-    glm_mat4_inv(this->proj, inv_proj);
+    update_window_transforms(this, viewport);
 
     vec4 v = {p.x, p.y, 0.0f, 1.0f};
     vec4 w;
-
-    glm_mat4_mulv(viewport_to_ndc, v, w);
-    glm_mat4_mulv(inv_proj, w, w);
-    glm_mat4_mulv(inv_model, w, w);
+    glm_mat4_mulv(this->front.to_screen, v, w);
 
     glm_vec2_copy((vec2) {w[0], w[1]}, q->vec);
 }
 
+void neopad_renderer_get_view_rect(neopad_renderer_const_t this, rect_t *dst) {
+    refresh_front(this);
+    view_rect(&this->front.view, dst);
+}
+
+void neopad_renderer_get_frame_rect(neopad_renderer_const_t this, rect_t *dst) {
+    view_rect(&this->frame_view, dst);
+}
+
+/// The area in view for a camera and zoom (centered on the opposite of the camera).
+static void rect_at(neopad_renderer_const_t this, neopad_dvec2_t camera, float zoom, rect_t *dst) {
+    double half_width = (double) this->thread.width / (2.0 * this->thread.content_scale * zoom);
+    double half_height = (double) this->thread.height / (2.0 * this->thread.content_scale * zoom);
+    *dst = (rect_t) {
+            .min = {(float) (-camera.x - half_width), (float) (-camera.y - half_height)},
+            .max = {(float) (-camera.x + half_width), (float) (-camera.y + half_height)},
+    };
+}
+
+void neopad_renderer_get_record_rect(neopad_renderer_const_t this, rect_t *dst) {
+    // The view moves from where it was last toward the targets, so it stays within both.
+    refresh_front(this);
+    rect_t from, to;
+    rect_at(this, this->front.view.camera, this->front.view.zoom > 0.0f ? this->front.view.zoom : 1.0f, &from);
+    rect_at(this, this->thread.target_camera, this->thread.target_zoom, &to);
+    rect_union(&from, &to, dst);
+
+    // Flying, it may go wider than either end.
+    rect_union(dst, &this->thread.flight_rect, dst);
+}
+
+void neopad_renderer_set_origin(neopad_renderer_t this, neopad_dvec2_t origin) {
+    // The camera is an offset: the view is centered on its opposite.
+    neopad_renderer_set_relative_origin(this, origin, (neopad_dvec2_t) {-this->camera.x, -this->camera.y});
+}
+
+void neopad_renderer_set_relative_origin(neopad_renderer_t this, neopad_dvec2_t origin, neopad_dvec2_t base) {
+    mat4 model;
+    glm_translate_make(model, (vec3) {
+            (float) (origin.x - base.x),
+            (float) (origin.y - base.y),
+            0.0f});
+    bgfx_set_transform(model, 1);
+}
+
+void neopad_renderer_set_packed_origin(neopad_renderer_t this,
+                                       neopad_dvec2_t origin,
+                                       neopad_dvec2_t base,
+                                       float quantum) {
+    mat4 model;
+    float scale = (float) NEOPAD_PACKED_VERTEX_RANGE * quantum;
+    glm_translate_make(model, (vec3) {
+            (float) (origin.x - base.x),
+            (float) (origin.y - base.y),
+            0.0f});
+    glm_scale(model, (vec3) {scale, scale, 1.0f});
+    bgfx_set_transform(model, 1);
+}
+
 #pragma mark - Manipualtion
 
+/// Stop zooming about a point, or flying: the camera (and, flying, the zoom) stays where it is,
+/// to be moved on from there by its channels.
+static void stop_motion(neopad_renderer_t this) {
+    if (this->motion.is_anchored || this->motion.flight.is_active) {
+        this->target_camera = this->camera;
+        neopad_animator_set_value(&this->animator, this->motion.camera_x, this->camera.x);
+        neopad_animator_set_value(&this->animator, this->motion.camera_y, this->camera.y);
+    }
+    if (this->motion.flight.is_active) {
+        this->target_zoom = this->zoom;
+        neopad_animator_set_value(&this->animator, this->motion.log_zoom, log2(this->zoom));
+    }
+    this->motion.is_anchored = false;
+    this->motion.flight.is_active = false;
+}
+
 void neopad_renderer_resize(neopad_renderer_t this, int width, int height) {
+    neopad_renderer_invalidate(this);
+    if (neopad_renderer_is_recording(this)) {
+        this->thread.width = width;
+        this->thread.height = height;
+        neopad_renderer_record(this, (neopad_command_t) {
+                .type = NEOPAD_COMMAND_RESIZE,
+                .size = {width, height}});
+        return;
+    }
     this->target_width = width;
     this->target_height = height;
 }
 
 void neopad_renderer_rescale(neopad_renderer_t this, float content_scale) {
+    neopad_renderer_invalidate(this);
+    if (neopad_renderer_is_recording(this)) {
+        this->thread.content_scale = content_scale;
+        neopad_renderer_record(this, (neopad_command_t) {
+                .type = NEOPAD_COMMAND_RESCALE,
+                .content_scale = content_scale});
+        return;
+    }
     this->content_scale = content_scale;
 }
 
 void neopad_renderer_zoom(neopad_renderer_t this, float zoom) {
+    neopad_renderer_invalidate(this);
+    if (neopad_renderer_is_recording(this)) {
+        this->thread.target_zoom = zoom;
+        this->thread.is_camera_carried = false;
+        this->thread.flight_rect = RECT_EMPTY;
+        neopad_renderer_record(this, (neopad_command_t) {.type = NEOPAD_COMMAND_ZOOM, .zoom = zoom});
+        return;
+    }
+    stop_motion(this);
     this->target_zoom = zoom;
+    neopad_animator_set_target(&this->animator, this->motion.log_zoom, log2(zoom));
 }
 
 float neopad_renderer_arrest_zoom(neopad_renderer_t this) {
+    neopad_renderer_invalidate(this);
+    if (neopad_renderer_is_recording(this)) {
+        refresh_front(this);
+        this->thread.target_zoom = this->front.view.zoom;
+        if (this->thread.is_camera_carried) {
+            this->thread.target_camera = this->front.view.camera;
+            this->thread.is_camera_carried = false;
+            this->thread.flight_rect = RECT_EMPTY;
+        }
+        neopad_renderer_record(this, (neopad_command_t) {.type = NEOPAD_COMMAND_ARREST_ZOOM});
+        return this->front.view.zoom;
+    }
+    // Zooming about a point (or flying) moves the camera with the zoom, so it stops too.
+    stop_motion(this);
     this->target_zoom = this->zoom;
+    neopad_animator_set_value(&this->animator, this->motion.log_zoom, log2(this->zoom));
     return this->zoom;
 }
 
+void neopad_renderer_zoom_at(neopad_renderer_t this, float zoom, neopad_dvec2_t anchor) {
+    neopad_renderer_invalidate(this);
+    if (neopad_renderer_is_recording(this)) {
+        refresh_front(this);
+        neopad_dvec2_t camera = this->front.view.camera;
+        float from = this->front.view.zoom > 0.0f ? this->front.view.zoom : this->thread.target_zoom;
+        this->thread.target_zoom = zoom;
+        this->thread.target_camera = (neopad_dvec2_t) {
+                (anchor.x + camera.x) * from / zoom - anchor.x,
+                (anchor.y + camera.y) * from / zoom - anchor.y,
+        };
+        this->thread.is_camera_carried = true;
+        this->thread.flight_rect = RECT_EMPTY;
+        neopad_renderer_record(this, (neopad_command_t) {
+                .type = NEOPAD_COMMAND_ZOOM_AT,
+                .zoom_at = {zoom, anchor}});
+        return;
+    }
+    stop_motion(this);
+    this->motion.is_anchored = true;
+    this->motion.anchor = anchor;
+    this->motion.anchor_offset = (neopad_dvec2_t) {
+            (anchor.x + this->camera.x) * this->zoom,
+            (anchor.y + this->camera.y) * this->zoom,
+    };
+    this->target_zoom = zoom;
+    this->target_camera = (neopad_dvec2_t) {
+            this->motion.anchor_offset.x / zoom - anchor.x,
+            this->motion.anchor_offset.y / zoom - anchor.y,
+    };
+    neopad_animator_set_target(&this->animator, this->motion.log_zoom, log2(zoom));
+}
+
+/// Start a flight from one view to another, in a viewport of the given logical width.
+static void begin_flight(neopad_flight_t *flight,
+                         double width,
+                         neopad_dvec2_t from_camera, float from_zoom,
+                         neopad_dvec2_t to_camera, float to_zoom,
+                         float duration) {
+    neopad_flight_begin(flight,
+                        (neopad_dvec2_t) {-from_camera.x, -from_camera.y}, width / from_zoom,
+                        (neopad_dvec2_t) {-to_camera.x, -to_camera.y}, width / to_zoom,
+                        duration);
+}
+
+void neopad_renderer_fly_to(neopad_renderer_t this, neopad_dvec2_t camera, float zoom, float duration) {
+    neopad_renderer_invalidate(this);
+    if (neopad_renderer_is_recording(this)) {
+        // What the flight will show, at its widest, is worked out here, so it gets recorded for.
+        refresh_front(this);
+        float from = this->front.view.zoom > 0.0f ? this->front.view.zoom : this->thread.target_zoom;
+        double width = (double) this->thread.width / this->thread.content_scale;
+        neopad_flight_t flight;
+        begin_flight(&flight, width, this->front.view.camera, from, camera, zoom, duration);
+        neopad_dvec2_t center;
+        double peak_width;
+        neopad_flight_peak(&flight, &center, &peak_width);
+        rect_at(this, (neopad_dvec2_t) {-center.x, -center.y}, (float) (width / peak_width), &this->thread.flight_rect);
+
+        this->thread.target_camera = camera;
+        this->thread.target_zoom = zoom;
+        this->thread.is_camera_carried = true;
+        neopad_renderer_record(this, (neopad_command_t) {
+                .type = NEOPAD_COMMAND_FLY_TO,
+                .flight = {camera, zoom, duration}});
+        return;
+    }
+    stop_motion(this);
+    begin_flight(&this->motion.flight, (double) this->width / this->content_scale,
+                 this->camera, this->zoom, camera, zoom, duration);
+    this->target_camera = camera;
+    this->target_zoom = zoom;
+}
+
 void neopad_renderer_get_camera(neopad_renderer_const_t this, neopad_vec2_t *dst) {
-    glm_vec2_copy(this->camera, dst->vec);
+    neopad_dvec2_t camera;
+    neopad_renderer_get_camera_d(this, &camera);
+    dst->x = (float) camera.x;
+    dst->y = (float) camera.y;
 }
 
 void neopad_renderer_set_camera(neopad_renderer_t this, neopad_vec2_t src) {
-    glm_vec2_copy(src.vec, this->target_camera);
+    neopad_renderer_set_camera_d(this, (neopad_dvec2_t) {src.x, src.y});
+}
+
+void neopad_renderer_get_camera_d(neopad_renderer_const_t this, neopad_dvec2_t *dst) {
+    if (neopad_renderer_is_recording(this)) {
+        refresh_front(this);
+        *dst = this->front.view.camera;
+        return;
+    }
+    *dst = this->camera;
+}
+
+void neopad_renderer_set_camera_d(neopad_renderer_t this, neopad_dvec2_t src) {
+    neopad_renderer_invalidate(this);
+    if (neopad_renderer_is_recording(this)) {
+        this->thread.target_camera = src;
+        this->thread.is_camera_carried = false;
+        this->thread.flight_rect = RECT_EMPTY;
+        neopad_renderer_record(this, (neopad_command_t) {.type = NEOPAD_COMMAND_SET_CAMERA, .camera = src});
+        return;
+    }
+    stop_motion(this);
+    this->target_camera = src;
+    neopad_animator_set_target(&this->animator, this->motion.camera_x, src.x);
+    neopad_animator_set_target(&this->animator, this->motion.camera_y, src.y);
+}
+
+#pragma mark - Invalidation
+
+bool neopad_renderer_tracks_changes(neopad_renderer_const_t this) {
+    return !this->init.threaded || neopad_renderer_is_recording(this);
+}
+
+/// Whether the view is still moving toward its targets (or resizing).
+static bool is_moving(neopad_renderer_const_t this) {
+    if (neopad_renderer_is_recording(this)) {
+        refresh_front(this);
+        return this->front.view.zoom != this->thread.target_zoom
+               || this->front.view.camera.x != this->thread.target_camera.x
+               || this->front.view.camera.y != this->thread.target_camera.y;
+    }
+    return this->zoom != this->target_zoom
+           || this->camera.x != this->target_camera.x
+           || this->camera.y != this->target_camera.y
+           || this->width != this->target_width
+           || this->height != this->target_height;
+}
+
+/// Whether the last scene drawn has changed since.
+static bool is_scene_changed(neopad_renderer_const_t this) {
+    return this->dirty.scene && this->dirty.scene->revision != this->dirty.scene_revision;
+}
+
+/// Whether the renderer's own window needs a frame.
+static bool needs_own_frame(neopad_renderer_const_t this) {
+    if (this->dirty.is_full || is_moving(this) || is_scene_changed(this)) {
+        return true;
+    }
+
+    // Threaded, frames recorded but not yet played back are still to come.
+    if (neopad_renderer_is_recording(this)
+        && atomic_load_explicit(&this->thread.played_frames, memory_order_acquire) != this->thread.recorded_frames) {
+        return true;
+    }
+
+    rect_t view;
+    neopad_renderer_get_view_rect(this, &view);
+    return rect_overlaps(&this->dirty.rect, &view);
+}
+
+bool neopad_renderer_needs_frame(neopad_renderer_const_t this) {
+    if (needs_own_frame(this)) {
+        return true;
+    }
+
+    // The primary submits the frames of those sharing bgfx with it too.
+    if (this->group && this->group->primary == this) {
+        for (uint32_t i = 0; i < NEOPAD_RENDERER_MAX_SHARING; i++) {
+            neopad_renderer_const_t member = this->group->members[i];
+            if (member && member != this && needs_own_frame(member)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void neopad_renderer_get_dirty_rect(neopad_renderer_const_t this, rect_t *dst) {
+    if (this->dirty.is_full || is_moving(this) || is_scene_changed(this)) {
+        neopad_renderer_get_view_rect(this, dst);
+        return;
+    }
+    *dst = this->dirty.rect;
+}
+
+void neopad_renderer_invalidate(neopad_renderer_t this) {
+    if (neopad_renderer_tracks_changes(this)) {
+        this->dirty.is_full = true;
+    }
+}
+
+void neopad_renderer_invalidate_rect(neopad_renderer_t this, rect_t area) {
+    if (neopad_renderer_tracks_changes(this)) {
+        rect_union(&this->dirty.rect, &area, &this->dirty.rect);
+    }
 }
 
 #pragma mark - Frames
 
+/// Start modules' counters over for the next frame.
+static void reset_counters(neopad_renderer_t this) {
+    for (uint32_t i = 0; i < this->modules.count; i++) {
+        this->modules.slots[this->modules.sorted[i]].base->counters = (neopad_profile_counters_t) {0};
+    }
+}
+
 void neopad_renderer_await_frame(neopad_renderer_t this, int timeout_ms) {
+    // Headless and threaded, the API thread renders its own frames.
+    if (this->init.threaded && this->init.headless) {
+        return;
+    }
     bgfx_render_frame(timeout_ms);
 }
 
+/// Step the animations (all at once), and move the camera and zoom along.
+static void update_motion(neopad_renderer_t this, double dt) {
+    // The camera comes to rest (exactly on target) once it is within a hundredth of a pixel.
+    double camera_precision = 0.01 / (double) (this->content_scale * this->zoom);
+    neopad_animator_set_precision(&this->animator, this->motion.camera_x, camera_precision);
+    neopad_animator_set_precision(&this->animator, this->motion.camera_y, camera_precision);
+    neopad_animator_update(&this->animator, dt);
+
+    if (this->motion.flight.is_active) {
+        neopad_dvec2_t center;
+        double width;
+        if (neopad_flight_update(&this->motion.flight, dt, &center, &width)) {
+            this->camera = (neopad_dvec2_t) {-center.x, -center.y};
+            this->zoom = (float) ((double) this->width / (this->content_scale * width));
+        } else {
+            this->camera = this->target_camera;
+            this->zoom = this->target_zoom;
+            neopad_animator_set_value(&this->animator, this->motion.camera_x, this->camera.x);
+            neopad_animator_set_value(&this->animator, this->motion.camera_y, this->camera.y);
+            neopad_animator_set_value(&this->animator, this->motion.log_zoom, log2(this->zoom));
+        }
+    } else {
+        // At rest, exactly the target (which log2 and back might not quite be).
+        bool is_zooming = neopad_animator_is_channel_moving(&this->animator, this->motion.log_zoom);
+        this->zoom = is_zooming
+                     ? (float) exp2(neopad_animator_value(&this->animator, this->motion.log_zoom))
+                     : this->target_zoom;
+
+        if (this->motion.is_anchored) {
+            // The camera goes wherever keeps the anchor in place.
+            this->camera = (neopad_dvec2_t) {
+                    this->motion.anchor_offset.x / this->zoom - this->motion.anchor.x,
+                    this->motion.anchor_offset.y / this->zoom - this->motion.anchor.y,
+            };
+            if (!is_zooming) {
+                stop_motion(this);
+            }
+        } else {
+            this->camera.x = neopad_animator_value(&this->animator, this->motion.camera_x);
+            this->camera.y = neopad_animator_value(&this->animator, this->motion.camera_y);
+        }
+    }
+
+    this->motion.is_resting = !neopad_animator_is_moving(&this->animator)
+                              && !this->motion.is_anchored
+                              && !this->motion.flight.is_active;
+}
+
 void neopad_renderer_begin_frame(neopad_renderer_t this) {
-    float SMOOTHNESS = 50.0f * this->content_scale;
+    if (neopad_renderer_is_recording(this)) {
+        neopad_renderer_record(this, (neopad_command_t) {.type = NEOPAD_COMMAND_BEGIN_FRAME});
+        return;
+    }
 
-    // Calculate and update delta time.
-    const bgfx_stats_t *stats = bgfx_get_stats();
-    const double freq = (double) stats->cpuTimerFreq;
-    const float to_ms = 1000.0f / (float) freq;
-    const float delta_t = (float) stats->cpuTimeFrame * to_ms;
+    if (this->profiler.enabled) {
+        neopad_profiler_begin_frame(&this->profiler, this->modules.count);
+    }
 
-    if (this->width != this->target_width || this->height != this->target_height) {
-        this->width = this->target_width;
-        this->height = this->target_height;
+    const bool is_resized = this->width != this->target_width || this->height != this->target_height;
+    this->width = this->target_width;
+    this->height = this->target_height;
+    if (this->init.share && (is_resized || !BGFX_HANDLE_IS_VALID(this->window))) {
+        // A window of its own is resized by creating its framebuffer again (and, lost, tried again).
+        if (BGFX_HANDLE_IS_VALID(this->window)) {
+            bgfx_destroy_frame_buffer(this->window);
+        }
+        this->window = create_window(this);
+        if (!BGFX_HANDLE_IS_VALID(this->window) && is_resized) {
+            eprintf("Failed to create a framebuffer for the renderer's window, at %ux%u.\n",
+                    this->width, this->height);
+        }
+    } else if (is_resized) {
         const uint32_t reset_flags = BGFX_RESET_VSYNC;
         bgfx_reset(this->width, this->height, reset_flags, this->bgfx_init.resolution.format);
     }
 
-    if (!glm_vec2_eqv(this->camera, this->target_camera)) {
-        vec2 delta_camera;
-        vec2 interp_camera;
-        glm_vec2_sub(this->target_camera, this->camera, delta_camera);
-        glm_vec2_scale(delta_camera, delta_t / SMOOTHNESS, interp_camera);
-        glm_vec2_add(this->camera, interp_camera, interp_camera);
-        glm_vec2_copy(interp_camera, this->camera);
+    // Real time since the last step, except after a rest, however long: then, a frame's worth.
+    int64_t now = bx_get_hp_counter();
+    double dt = this->motion.is_resting
+                ? RESTING_STEP
+                : (double) (now - this->motion.time) / (double) bx_get_hp_frequency();
+    this->motion.time = now;
+    update_motion(this, dt);
+
+    // Scratch from two frames ago, which bgfx is done with, is taken back.
+    neopad_frame_scratch_use(&this->scratch, this->group->frame);
+
+    // Sharing bgfx, the uniforms there are whichever renderer's began a frame last.
+    if (this->group->uniforms_owner != this) {
+        this->group->uniforms_owner = this;
+        neopad_uniforms_invalidate(&this->uniforms);
     }
 
-    float zoom_tol = 0.03f;
-    if (fabsf(this->zoom - this->target_zoom) < zoom_tol) {
-        this->zoom = this->target_zoom;
-        this->uniforms.zoom = this->zoom;
-    } else {
-        float delta_zoom = this->target_zoom - this->zoom;
-        float interp_zoom = delta_zoom * (delta_t / SMOOTHNESS);
-        this->zoom += interp_zoom;
-        this->uniforms.zoom = this->zoom;
+    // Where the world origin is, relative to the camera (for the axes).
+    neopad_uniforms_set_2f(&this->uniforms, NEOPAD_UNIFORM_ORIGIN, (float) this->camera.x, (float) this->camera.y);
+    neopad_uniforms_set_1f(&this->uniforms, NEOPAD_UNIFORM_ZOOM, this->zoom);
+    neopad_uniforms_set_1f(&this->uniforms, NEOPAD_UNIFORM_CONTENT_SCALE, this->content_scale);
+
+    // Per-module begin frame. Uniforms that changed are uploaded before the first draw.
+    call_phase(this, &this->modules.begin_frame, NEOPAD_PROFILE_PHASE_BEGIN_FRAME);
+}
+
+void neopad_renderer_end_frame(neopad_renderer_t this) {
+    // Redraw everything, unless all that changed was some areas (and only those are to be redrawn).
+    rect_t area = RECT_EMPTY;
+    if (this->init.partial_redraw && !this->dirty.is_full && !is_moving(this) && !is_scene_changed(this)) {
+        area = this->dirty.rect;
     }
+    this->dirty.is_full = false;
+    this->dirty.rect = RECT_EMPTY;
 
-    // Per-module begin frame.
-    for (int i = 0; i < NEOPAD_RENDERER_MODULE_COUNT; i++) {
-        neopad_renderer_module_t mod = this->modules[i];
-        if (mod.base->on_begin_frame) {
-            mod.base->on_begin_frame(mod, this);
+    if (neopad_renderer_is_recording(this)) {
+        if (!is_moving(this)) {
+            this->thread.is_camera_carried = false;
+            this->thread.flight_rect = RECT_EMPTY;
         }
+        this->thread.recorded_frames++;
+        neopad_renderer_record(this, (neopad_command_t) {.type = NEOPAD_COMMAND_END_FRAME, .area = area});
+        return;
+    }
+    neopad_renderer_submit_frame(this, &area);
+}
+
+/// Work out the part of the back buffer an area of the world covers (none, if the area is empty).
+static void update_scissor(neopad_renderer_t this, const rect_t *area) {
+    this->scissor = (neopad_ivec4_t) {.x = 0, .y = 0, .width = 0, .height = 0};
+    if (area->min[0] > area->max[0] || area->min[1] > area->max[1]) {
+        return;
     }
 
-    // Update any uniforms that have changed (or really, just all of them).
-    bgfx_set_uniform(this->uniform_handle, &this->uniforms, 2);
+    // Camera-relative, then to pixels (from the top left), with a pixel more each way for antialiasing.
+    double scale = (double) (this->content_scale * this->zoom);
+    double half_width = (double) this->width / 2.0;
+    double half_height = (double) this->height / 2.0;
+    double l = floor(half_width + ((double) area->min[0] + this->camera.x) * scale) - 1.0;
+    double r = ceil(half_width + ((double) area->max[0] + this->camera.x) * scale) + 1.0;
+    double t = floor(half_height - ((double) area->max[1] + this->camera.y) * scale) - 1.0;
+    double b = ceil(half_height - ((double) area->min[1] + this->camera.y) * scale) + 1.0;
+    l = fmax(l, 0.0);
+    t = fmax(t, 0.0);
+    r = fmin(r, (double) this->width);
+    b = fmin(b, (double) this->height);
+    if (r <= l || b <= t) {
+        return;
+    }
+    this->scissor = (neopad_ivec4_t) {.x = (int) l, .y = (int) t, .width = (int) (r - l), .height = (int) (b - t)};
 }
 
-void neopad_renderer_end_frame(neopad_renderer_t this) {
+void neopad_renderer_submit_frame(neopad_renderer_t this, const rect_t *area) {
     float width = (float) this->width;
     float height = (float) this->height;
     float zoom = this->zoom;
 
-    vec3 camera = {0.0f, 0.0f, 0.0f};
-    glm_vec2_copy(this->camera, camera);
-
     // Model matrix applies the content_scale to x and y (leaves z and w alone).
     // - On non-retina displays, this is an identity matrix.
     // - On retina displays, this will make the content appear at the same size as on non-retina displays.
     glm_mat4_identity(this->model);
     glm_scale(this->model, (vec3) {this->content_scale, this->content_scale, 1.0f});
 
-    // View matrix applies camera (camera position).
+    // View matrix looks at the camera. The camera itself is applied per draw, in double precision,
+    // by neopad_renderer_set_origin, so everything here is camera-relative.
     vec3 eye = {0.0f, 0.0f, 1.0f};
     vec3 center = {0.0f, 0.0f, 0.0f};
     vec3 up = {0.0f, 1.0f, 0.0f};
-    glm_vec3_sub(eye, camera, eye);
-    glm_vec3_sub(center, camera, center);
     glm_lookat(eye, center, up, this->view);
 
     // Premultiply the model and view matrices.
@@ -296,17 +1003,10 @@ void neopad_renderer_end_frame(neopad_renderer_t this) {
     float b = -height / 2.0f;
     float t = height / 2.0f;
     glm_ortho(l / zoom, r / zoom, b / zoom, t / zoom, -1.0f, 1.0f, this->proj);
+    update_frame_view(this);
+    update_scissor(this, area);
 
-    bgfx_set_view_transform(NEOPAD_VIEW_CONTENT, this->model_view, this->proj);
-    bgfx_set_view_rect(NEOPAD_VIEW_CONTENT, 0, 0, this->width, this->height);
-    bgfx_touch(NEOPAD_VIEW_CONTENT);
-
-    for (int i = 0; i < NEOPAD_RENDERER_MODULE_COUNT; i++) {
-        neopad_renderer_module_t mod = this->modules[i];
-        if (mod.base->on_end_frame) {
-            mod.base->on_end_frame(mod, this);
-        }
-    }
+    call_phase(this, &this->modules.end_frame, NEOPAD_PROFILE_PHASE_END_FRAME);
 
     if (this->init.debug) {
         const bgfx_stats_t *stats = bgfx_get_stats();
@@ -318,54 +1018,97 @@ void neopad_renderer_end_frame(neopad_renderer_t this) {
         bgfx_dbg_text_clear(0, false);
         bgfx_dbg_text_printf(0, 0, 0x0f, "   CPU FPS: %.2f", freq / frameTime);
         bgfx_dbg_text_printf(0, 1, 0x0f, "Delta Time: %.2fms", frameTime * toMs);
-        bgfx_dbg_text_printf(0, 5, 0x0f, "    Camera: (%f, %f)", camera[0], camera[1]);
+        bgfx_dbg_text_printf(0, 5, 0x0f, "    Camera: (%f, %f)", this->camera.x, this->camera.y);
         bgfx_dbg_text_printf(0, 6, 0x0f, "      Zoom: %f -> %f", this->zoom, this->target_zoom);
         bgfx_dbg_text_printf(0, 7, 0x0f, "     Scale: %f", this->content_scale);
     }
 
-    bgfx_frame(false);
+    // Only the passes something was drawn in are set up.
+    neopad_renderer_graph_end_frame(this);
+
+    // Sharing bgfx, only the primary submits (its frame carries every window's views).
+    bool is_submitting = this->group->primary == this;
+
+    if (!neopad_profiler_in_frame(&this->profiler)) {
+        if (is_submitting) {
+            this->group->frame = bgfx_frame(false);
+        }
+        reset_counters(this);
+        return;
+    }
+
+    double submit = neopad_profiler_now(&this->profiler);
+    if (is_submitting) {
+        this->group->frame = bgfx_frame(false);
+    }
+    double end = neopad_profiler_now(&this->profiler);
+
+    // Stats are for the last frame bgfx finished rendering, which may lag a frame or two behind.
+    const bgfx_stats_t *stats = bgfx_get_stats();
+    double gpu_ms = is_submitting && stats->gpuTimerFreq > 0
+                    ? (double) (stats->gpuTimeEnd - stats->gpuTimeBegin) * 1000.0 / (double) stats->gpuTimerFreq
+                    : 0.0;
+
+    for (uint32_t i = 0; i < this->modules.count; i++) {
+        neopad_renderer_module_t module = this->modules.slots[this->modules.sorted[i]];
+        this->profiler.current.modules[i].name = module.base->name;
+        this->profiler.current.modules[i].counters = module.base->counters;
+    }
+    neopad_profiler_end_frame(&this->profiler, submit, end, gpu_ms);
+    reset_counters(this);
 }
 
 #pragma mark - Drawing
 
 void neopad_renderer_draw_background(neopad_renderer_t this) {
-    neopad_renderer_module_t mod = this->modules[NEOPAD_RENDERER_MODULE_BACKGROUND];
-    mod.base->render(mod, this);
+    if (neopad_renderer_is_recording(this)) {
+        neopad_renderer_record(this, (neopad_command_t) {.type = NEOPAD_COMMAND_DRAW_BACKGROUND});
+        return;
+    }
+    render_module(this, this->builtin.background);
 }
 
 #pragma mark - Testing
 
 void neopad_renderer_draw_test_rect(neopad_renderer_t this, float l, float t, float r, float b) {
-    bgfx_transient_vertex_buffer_t tvb;
-    bgfx_transient_index_buffer_t tib;
+    if (neopad_renderer_is_recording(this)) {
+        neopad_renderer_record(this, (neopad_command_t) {
+                .type = NEOPAD_COMMAND_DRAW_TEST_RECT,
+                .rect = {l, t, r, b}});
+        return;
+    }
 
-    bgfx_alloc_transient_vertex_buffer(&tvb, 4, &this->vertex_layout);
-    bgfx_alloc_transient_index_buffer(&tib, 6, false);
+    neopad_geometry_t geometry;
+    if (!neopad_geometry_alloc(&geometry, this, (neopad_stroke_size_t) {4, 6})) {
+        return;
+    }
 
     // Linear map the value of this->zoom from [1, 10] to [0.8, 0.0].
     // For values less than 1.0, the alpha will be 1.0.
     uint8_t a = this->zoom < 1 ? 0xCC : (uint8_t) (255.0f * (0.8f - (this->zoom - 1.0f) / 9.0f));
     uint32_t alpha = a << 24;
 
-    neopad_renderer_vertex_t vertices[] = {
-            {l, t, 0, 1, alpha | 0x0000ff00},
-            {r, t, 0, 1, alpha | 0x00ff0000},
-            {r, b, 0, 1, alpha | 0x00ffffff},
-            {l, b, 0, 1, alpha | 0x000000ff},
-    };
-    memcpy(tvb.data, vertices, sizeof(vertices));
-
-    uint16_t indices[] = {
-            0, 1, 2,
-            0, 2, 3,
-    };
-    memcpy(tib.data, indices, sizeof(indices));
-
-    bgfx_set_transient_vertex_buffer(0, &tvb, 0, 4);
-    bgfx_set_transient_index_buffer(&tib, 0, 6);
+    // Written in place, where bgfx draws it from.
+    neopad_renderer_vertex_t *v = geometry.vertices;
+    v[0] = (neopad_renderer_vertex_t) {l, t, 0, 1, alpha | 0x0000ff00};
+    v[1] = (neopad_renderer_vertex_t) {r, t, 0, 1, alpha | 0x00ff0000};
+    v[2] = (neopad_renderer_vertex_t) {r, b, 0, 1, alpha | 0x00ffffff};
+    v[3] = (neopad_renderer_vertex_t) {l, b, 0, 1, alpha | 0x000000ff};
+
+    uint32_t *i = geometry.indices;
+    i[0] = 0;
+    i[1] = 1;
+    i[2] = 2;
+    i[3] = 0;
+    i[4] = 2;
+    i[5] = 3;
+
+    neopad_geometry_advance(&geometry, (neopad_stroke_size_t) {4, 6});
+    neopad_geometry_set(&geometry, this);
+    neopad_renderer_set_origin(this, (neopad_dvec2_t) {0.0, 0.0});
 
     bgfx_set_state(BGFX_STATE_WRITE_RGB
                    | BGFX_STATE_WRITE_A
                    | BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA), 0);
-    bgfx_submit(NEOPAD_VIEW_CONTENT, this->programs[NEOPAD_PROGRAM_BASIC], 0, false);
+    neopad_renderer_submit_pass(this, this->content_pass, this->programs[NEOPAD_PROGRAM_BASIC]);
 }
@@ -5,6 +5,7 @@
 #include "neopad/internal/renderer.h"
 #include "neopad/internal/renderer/background.h"
 
+#include <math.h>
 #include <memory.h>
 
 static const neopad_renderer_vertex_t NDC_QUAD_VERTICES[] = {
@@ -20,6 +21,22 @@ uint16_t NDC_QUAD_INDICES[] = {
 };
 
 void on_setup(neopad_renderer_module_background_t this, neopad_renderer_t renderer) {
+    // The background uses the same view and projection matrices as the content, but
+    // it does not use them in the same way. The background is always drawn at the same
+    // size, regardless of the content scale or zoom. It renders geometry provided in
+    // clip-space coordinates. It needs the same view and projection matrices, so it can
+    // invert them and use them to transform the clip-space coordinates into world-space
+    // coordinates. This allows the background to be drawn in the same world-space as the
+    // content, but at a fixed size.
+    this->pass = neopad_renderer_declare_pass(renderer, &(neopad_renderer_pass_desc_t) {
+            .name = "background",
+            .order = NEOPAD_RENDERER_ORDER_BACKGROUND,
+            .output = BGFX_INVALID_HANDLE,
+            .transform = NEOPAD_RENDERER_PASS_TRANSFORM_WORLD,
+            .clear_flags = BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH,
+            .clear_color = this->color,
+    });
+
     renderer->programs[NEOPAD_PROGRAM_BACKGROUND] = bgfx_create_embedded_program(
             embedded_shaders,
             bgfx_get_renderer_type(),
@@ -39,48 +56,49 @@ void on_setup(neopad_renderer_module_background_t this, neopad_renderer_t render
 void on_teardown(neopad_renderer_module_background_t this, neopad_renderer_t renderer) {
     bgfx_destroy_index_buffer(this->ibo);
     bgfx_destroy_vertex_buffer(this->vbo);
+    neopad_renderer_release_pass(renderer, this->pass);
 }
 
 void on_begin_frame(neopad_renderer_module_background_t this, neopad_renderer_t renderer) {
-    renderer->uniforms.grid_major = this->grid_major;
-    renderer->uniforms.grid_minor = this->grid_minor;
+    neopad_uniforms_set_1f(&renderer->uniforms, NEOPAD_UNIFORM_GRID_MAJOR, this->grid_major);
+    neopad_uniforms_set_1f(&renderer->uniforms, NEOPAD_UNIFORM_GRID_MINOR, this->grid_minor);
+
+    // Shift the grid by the camera, modulo the (major, and so minor) spacing, in double precision.
+    // The shader only works in camera-relative coordinates, where this stays small.
+    if (this->grid_major > 0.0f) {
+        neopad_uniforms_set_2f(&renderer->uniforms, NEOPAD_UNIFORM_GRID_OFFSET,
+                               (float) -fmod(renderer->camera.x, (double) this->grid_major),
+                               (float) -fmod(renderer->camera.y, (double) this->grid_major));
+    }
 }
 
 void on_render(neopad_renderer_module_background_t this, neopad_renderer_t renderer) {
-    bgfx_view_id_t view_id = this->base.view_id;
-
     if (!this->grid_enabled) {
         return;
     }
 
+    bgfx_view_id_t view_id = neopad_renderer_use_pass(renderer, this->pass);
+    if (view_id == NEOPAD_RENDERER_VIEW_NONE) {
+        return;
+    }
     bgfx_set_vertex_buffer(0, this->vbo, 0, 4);
     bgfx_set_index_buffer(this->ibo, 0, 6);
 
-    bgfx_set_view_clear(view_id, BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, this->color, 1.0f, 0);
-
     bgfx_set_state(BGFX_STATE_WRITE_RGB
                    | BGFX_STATE_WRITE_A
                    | BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_DST_ALPHA),
                    0);
 
     bgfx_submit(view_id, renderer->programs[NEOPAD_PROGRAM_BACKGROUND], 0, false);
+
+    this->base.counters.draw_calls++;
+    this->base.counters.vertices += 4;
+    this->base.counters.indices += 6;
 }
 
 void on_end_frame(neopad_renderer_module_background_t this, neopad_renderer_t renderer) {
-    // The background uses the same view and projection matrices as the content, but
-    // it does not use them in the same way. The background is always drawn at the same
-    // size, regardless of the content scale or zoom. It renders geometry provided in
-    // clip-space coordinates. It needs the same view and projection matrices, so it can
-    // invert them and use them to transform the clip-space coordinates into world-space
-    // coordinates. This allows the background to be drawn in the same world-space as the
-    // content, but at a fixed size.
-    bgfx_view_id_t view_id = this->base.view_id;
-
-    bgfx_set_view_clear(view_id, BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, this->color, 1.0f, 0);
-    bgfx_set_view_transform(view_id, renderer->model_view, renderer->proj);
-    bgfx_set_view_rect(view_id, 0, 0, renderer->width, renderer->height);
-
-    bgfx_touch(view_id);
+    // The back buffer is cleared every frame, whether or not the background was drawn.
+    neopad_renderer_use_pass(renderer, this->pass);
 }
 
 void destroy(neopad_renderer_module_background_t this) {
@@ -89,7 +107,6 @@ void destroy(neopad_renderer_module_background_t this) {
 
 neopad_renderer_module_t
 neopad_renderer_module_background_create(
-        bgfx_view_id_t view_id,
         uint32_t color,
         bool grid_enabled,
         float grid_major,
@@ -100,7 +117,7 @@ neopad_renderer_module_background_create(
     memcpy(module, &(struct neopad_renderer_module_background_s) {
             .base = {
                     .name = "background",
-                    .view_id = view_id,
+                    .order = NEOPAD_RENDERER_ORDER_BACKGROUND,
                     .on_setup = on_setup,
                     .on_teardown = on_teardown,
                     .on_begin_frame = on_begin_frame,
@@ -111,7 +128,8 @@ neopad_renderer_module_background_create(
             .color = color,
             .grid_enabled = grid_enabled,
             .grid_major = grid_major,
-            .grid_minor = grid_minor
+            .grid_minor = grid_minor,
+            .pass = NEOPAD_RENDERER_PASS_NONE,
     }, sizeof(struct neopad_renderer_module_background_s));
 
     return (neopad_renderer_module_t) {.background = module};
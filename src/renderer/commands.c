@@ -0,0 +1,201 @@
+//
+// Created by Dylan Lukes on 8/24/23.
+//
+
+#include <stdlib.h>
+
+#include "neopad/internal/renderer.h"
+#include "neopad/internal/renderer/commands.h"
+#include "neopad/internal/renderer/scene.h"
+#include "neopad/internal/shims/bx/semaphore.h"
+#include "neopad/internal/shims/bx/spscqueue.h"
+#include "neopad/internal/shims/bx/thread.h"
+
+#define API_THREAD_STARTING 0
+#define API_THREAD_RUNNING 1
+#define API_THREAD_STOPPED 2
+#define API_THREAD_FAILED (-1)
+
+/// Set on the API thread, so that calls made there (in playback) are done rather than recorded.
+static _Thread_local bool is_api_thread = false;
+
+/// Whether the application thread is bgfx's render thread (and must keep rendering while it waits).
+/// @note Headless renderers render on the API thread.
+static inline bool app_renders(neopad_renderer_const_t this) {
+    return !this->init.headless;
+}
+
+#pragma mark - Recording
+
+bool neopad_renderer_is_recording(neopad_renderer_const_t this) {
+    return this->init.threaded && !is_api_thread;
+}
+
+void neopad_renderer_record(neopad_renderer_t this, neopad_command_t command) {
+    neopad_command_t *copy = malloc(sizeof(neopad_command_t));
+    *copy = command;
+    bx_spsc_blocking_queue_push(this->thread.commands, copy);
+
+    // Don't get too far ahead: wait for a frame to be played back if there are too many in flight.
+    if (command.type == NEOPAD_COMMAND_END_FRAME) {
+        if (app_renders(this)) {
+            // The API thread may itself be waiting for us to render (in bgfx_frame).
+            while (!bx_semaphore_wait(this->thread.frames, 0)) {
+                bgfx_render_frame(1);
+            }
+        } else {
+            bx_semaphore_wait(this->thread.frames, -1);
+        }
+    }
+}
+
+#pragma mark - Playback
+
+static void play(neopad_renderer_t this, neopad_command_t *command) {
+    switch (command->type) {
+        case NEOPAD_COMMAND_RESIZE:
+            neopad_renderer_resize(this, command->size.width, command->size.height);
+            break;
+        case NEOPAD_COMMAND_RESCALE:
+            neopad_renderer_rescale(this, command->content_scale);
+            break;
+        case NEOPAD_COMMAND_ZOOM:
+            neopad_renderer_zoom(this, command->zoom);
+            break;
+        case NEOPAD_COMMAND_ARREST_ZOOM:
+            neopad_renderer_arrest_zoom(this);
+            break;
+        case NEOPAD_COMMAND_ZOOM_AT:
+            neopad_renderer_zoom_at(this, command->zoom_at.zoom, command->zoom_at.anchor);
+            break;
+        case NEOPAD_COMMAND_FLY_TO:
+            neopad_renderer_fly_to(this, command->flight.camera, command->flight.zoom, command->flight.duration);
+            break;
+        case NEOPAD_COMMAND_SET_CAMERA:
+            neopad_renderer_set_camera_d(this, command->camera);
+            break;
+        case NEOPAD_COMMAND_BEGIN_FRAME:
+            neopad_renderer_begin_frame(this);
+            break;
+        case NEOPAD_COMMAND_END_FRAME:
+            neopad_renderer_submit_frame(this, &command->area);
+            atomic_fetch_add_explicit(&this->thread.played_frames, 1, memory_order_release);
+            bx_semaphore_post(this->thread.frames, 1);
+            break;
+        case NEOPAD_COMMAND_DRAW_BACKGROUND:
+            neopad_renderer_draw_background(this);
+            break;
+        case NEOPAD_COMMAND_DRAW_SCENE:
+            neopad_renderer_draw_scene_snapshot(this, command->snapshot);
+            break;
+        case NEOPAD_COMMAND_DRAW_TEST_RECT:
+            neopad_renderer_draw_test_rect(this, command->rect.l, command->rect.t, command->rect.r, command->rect.b);
+            break;
+        case NEOPAD_COMMAND_SET_STROKE_STYLE:
+            neopad_renderer_set_stroke_style(this, command->style);
+            break;
+        case NEOPAD_COMMAND_BEGIN_POINTS:
+            neopad_renderer_begin_points_d(this, command->point);
+            break;
+        case NEOPAD_COMMAND_ADD_POINT:
+            neopad_renderer_pen_add_point_d(this, command->point);
+            break;
+        case NEOPAD_COMMAND_END_POINTS:
+            neopad_renderer_end_points(this);
+            break;
+        case NEOPAD_COMMAND_SET_PROFILING:
+            neopad_renderer_set_profiling(this, command->enabled);
+            break;
+        case NEOPAD_COMMAND_SHUTDOWN:
+            neopad_renderer_shutdown(this);
+            break;
+    }
+}
+
+static int32_t api_thread_entry(bx_thread_t self, void *user_data) {
+    neopad_renderer_t this = user_data;
+    is_api_thread = true;
+
+    if (!neopad_renderer_init_bgfx(this)) {
+        atomic_store(&this->thread.state, API_THREAD_FAILED);
+        bx_semaphore_post(this->thread.signal, 1);
+        return 1;
+    }
+    atomic_store(&this->thread.state, API_THREAD_RUNNING);
+    bx_semaphore_post(this->thread.signal, 1);
+
+    for (;;) {
+        neopad_command_t *command = bx_spsc_blocking_queue_pop(this->thread.commands, -1);
+        if (!command) {
+            continue;
+        }
+
+        play(this, command);
+        bool is_shutdown = command->type == NEOPAD_COMMAND_SHUTDOWN;
+        free(command);
+
+        if (is_shutdown) {
+            atomic_store(&this->thread.state, API_THREAD_STOPPED);
+            bx_semaphore_post(this->thread.signal, 1);
+            return 0;
+        }
+    }
+}
+
+#pragma mark - Lifecycle
+
+/// Wait for the API thread to signal, rendering meanwhile if that is our job.
+static void await_signal(neopad_renderer_t this) {
+    if (app_renders(this)) {
+        while (!bx_semaphore_wait(this->thread.signal, 0)) {
+            bgfx_render_frame(1);
+        }
+    } else {
+        bx_semaphore_wait(this->thread.signal, -1);
+    }
+}
+
+bool neopad_renderer_start_api_thread(neopad_renderer_t this) {
+    this->thread.commands = bx_spsc_blocking_queue_create();
+    this->thread.frames = bx_semaphore_create();
+    this->thread.signal = bx_semaphore_create();
+    bx_semaphore_post(this->thread.frames, NEOPAD_COMMAND_MAX_FRAMES_IN_FLIGHT);
+    atomic_store(&this->thread.state, API_THREAD_STARTING);
+
+    // This thread renders; the API thread initializes bgfx (and so becomes bgfx's API thread).
+    if (app_renders(this)) {
+        bgfx_render_frame(0);
+    }
+
+    this->thread.api_thread = bx_thread_create();
+    bx_thread_init(this->thread.api_thread, api_thread_entry, this, 0, "neopad-api");
+
+    // Initialization needs the render thread to be rendering.
+    await_signal(this);
+
+    if (atomic_load(&this->thread.state) == API_THREAD_FAILED) {
+        bx_thread_shutdown(this->thread.api_thread);
+        bx_thread_destroy(this->thread.api_thread);
+        bx_spsc_blocking_queue_destroy(this->thread.commands);
+        bx_semaphore_destroy(this->thread.frames);
+        bx_semaphore_destroy(this->thread.signal);
+        this->thread.api_thread = NULL;
+        return false;
+    }
+    return true;
+}
+
+void neopad_renderer_stop_api_thread(neopad_renderer_t this) {
+    neopad_renderer_record(this, (neopad_command_t) {.type = NEOPAD_COMMAND_SHUTDOWN});
+
+    // Keep rendering until bgfx has shut down.
+    await_signal(this);
+
+    bx_thread_shutdown(this->thread.api_thread);
+    bx_thread_destroy(this->thread.api_thread);
+    this->thread.api_thread = NULL;
+
+    bx_spsc_blocking_queue_destroy(this->thread.commands);
+    bx_semaphore_destroy(this->thread.frames);
+    bx_semaphore_destroy(this->thread.signal);
+}
@@ -0,0 +1,95 @@
+//
+// Created by Dylan Lukes on 9/2/23.
+//
+
+#include "neopad/internal/renderer/geometry.h"
+#include "neopad/internal/log.h"
+
+#pragma mark - Geometry
+
+bool neopad_geometry_alloc(neopad_geometry_t *this, neopad_renderer_t renderer, neopad_stroke_size_t capacity) {
+    this->size = (neopad_stroke_size_t) {0, 0};
+    this->capacity = capacity;
+
+    this->is_transient =
+            bgfx_get_avail_transient_vertex_buffer(capacity.vertex_count, &renderer->vertex_layout) >= capacity.vertex_count
+            && bgfx_get_avail_transient_index_buffer(capacity.index_count, true) >= capacity.index_count;
+
+    if (this->is_transient) {
+        bgfx_alloc_transient_vertex_buffer(&this->tvb, capacity.vertex_count, &renderer->vertex_layout);
+        bgfx_alloc_transient_index_buffer(&this->tib, capacity.index_count, true);
+        this->vertices = (neopad_renderer_vertex_t *) this->tvb.data;
+        this->indices = (uint32_t *) this->tib.data;
+        return true;
+    }
+
+    // Past the transient budget: frame scratch, drawn from buffers made just for it.
+    neopad_frame_scratch_t *scratch = neopad_renderer_scratch(renderer);
+    this->vertices = neopad_frame_scratch_alloc(scratch, capacity.vertex_count * sizeof(neopad_renderer_vertex_t));
+    this->indices = neopad_frame_scratch_alloc(scratch, capacity.index_count * sizeof(uint32_t));
+    if (!this->vertices || !this->indices) {
+        eprintf("Out of memory for %u vertices.\n", capacity.vertex_count);
+        this->capacity = (neopad_stroke_size_t) {0, 0};
+        return false;
+    }
+    return true;
+}
+
+uint64_t neopad_geometry_set(neopad_geometry_t *this, neopad_renderer_t renderer) {
+    const uint32_t vertex_count = this->size.vertex_count;
+    const uint32_t index_count = this->size.index_count;
+
+    if (this->is_transient) {
+        bgfx_set_transient_vertex_buffer(0, &this->tvb, 0, vertex_count);
+        bgfx_set_transient_index_buffer(&this->tib, 0, index_count);
+        return (uint64_t) vertex_count * sizeof(neopad_renderer_vertex_t) + (uint64_t) index_count * sizeof(uint32_t);
+    }
+
+    // Destroyed right away: bgfx keeps them until the frame has been rendered.
+    bgfx_vertex_buffer_handle_t vbo = bgfx_create_vertex_buffer(
+            bgfx_make_ref(this->vertices, vertex_count * sizeof(neopad_renderer_vertex_t)),
+            &renderer->vertex_layout, BGFX_BUFFER_NONE);
+    bgfx_index_buffer_handle_t ibo = bgfx_create_index_buffer(
+            bgfx_make_ref(this->indices, index_count * sizeof(uint32_t)), BGFX_BUFFER_INDEX32);
+    bgfx_set_vertex_buffer(0, vbo, 0, vertex_count);
+    bgfx_set_index_buffer(ibo, 0, index_count);
+    bgfx_destroy_vertex_buffer(vbo);
+    bgfx_destroy_index_buffer(ibo);
+    return 0;
+}
+
+#pragma mark - Instances
+
+bool neopad_instances_alloc(neopad_instances_t *this, neopad_renderer_t renderer, uint32_t capacity, uint16_t stride) {
+    this->count = 0;
+    this->capacity = capacity;
+    this->stride = stride;
+
+    this->is_transient = bgfx_get_avail_instance_data_buffer(capacity, stride) >= capacity;
+    if (this->is_transient) {
+        bgfx_alloc_instance_data_buffer(&this->idb, capacity, stride);
+        this->data = this->idb.data;
+        return true;
+    }
+
+    this->data = neopad_frame_scratch_alloc(neopad_renderer_scratch(renderer), (size_t) capacity * stride);
+    if (!this->data) {
+        eprintf("Out of memory for %u instances.\n", capacity);
+        this->capacity = 0;
+        return false;
+    }
+    return true;
+}
+
+uint64_t neopad_instances_set(neopad_instances_t *this, const bgfx_vertex_layout_t *layout) {
+    if (this->is_transient) {
+        bgfx_set_instance_data_buffer(&this->idb, 0, this->count);
+        return (uint64_t) this->count * this->stride;
+    }
+
+    bgfx_vertex_buffer_handle_t vbo = bgfx_create_vertex_buffer(
+            bgfx_make_ref(this->data, this->count * this->stride), layout, BGFX_BUFFER_NONE);
+    bgfx_set_instance_data_from_vertex_buffer(vbo, 0, this->count);
+    bgfx_destroy_vertex_buffer(vbo);
+    return 0;
+}
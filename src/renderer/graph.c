@@ -0,0 +1,277 @@
+//
+// Created by Dylan Lukes on 8/26/23.
+//
+
+#include <string.h>
+
+#include "neopad/internal/log.h"
+#include "neopad/internal/renderer.h"
+#include "neopad/internal/renderer/graph.h"
+
+static inline bool is_same_buffer(bgfx_frame_buffer_handle_t a, bgfx_frame_buffer_handle_t b) {
+    return a.idx == b.idx;
+}
+
+/// Whether pass `a` must be drawn before pass `b` (as `b` reads from what `a` draws into).
+static bool is_input_of(const neopad_renderer_pass_t *a, const neopad_renderer_pass_t *b) {
+    for (uint8_t i = 0; i < b->desc.input_count; i++) {
+        if (is_same_buffer(a->desc.output, b->desc.inputs[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline bool is_declared(const neopad_renderer_graph_t *this, neopad_renderer_pass_id_t id) {
+    return id >= 0 && id < NEOPAD_RENDERER_MAX_PASSES && this->passes[id].references > 0;
+}
+
+/// Whether pass `a` goes before pass `b`, all else being equal: by order, then declaration.
+static inline bool is_before(const neopad_renderer_pass_t *a, const neopad_renderer_pass_t *b) {
+    return a->desc.order != b->desc.order ? a->desc.order < b->desc.order : a->sequence < b->sequence;
+}
+
+/// Whether two declarations can be one pass.
+static bool is_mergeable(const neopad_renderer_pass_desc_t *a, const neopad_renderer_pass_desc_t *b) {
+    return strcmp(a->name, b->name) == 0
+           && a->order == b->order
+           && is_same_buffer(a->output, b->output)
+           && a->width == b->width
+           && a->height == b->height
+           && a->transform == b->transform
+           && a->input_count == 0
+           && b->input_count == 0;
+}
+
+#pragma mark - Ordering
+
+/// Order the passes and assign their views.
+/// @return Whether they could be ordered (there is no cycle through inputs).
+static bool rebuild(neopad_renderer_graph_t *this) {
+    neopad_renderer_pass_id_t sorted[NEOPAD_RENDERER_MAX_PASSES];
+    bool is_placed[NEOPAD_RENDERER_MAX_PASSES] = {false};
+    uint32_t count = 0;
+    uint32_t total = 0;
+    for (neopad_renderer_pass_id_t id = 0; id < NEOPAD_RENDERER_MAX_PASSES; id++) {
+        total += this->passes[id].references > 0;
+    }
+
+    // Repeatedly place the first pass (by order, then declaration) whose inputs are all drawn.
+    // (There are few passes, and this happens only as they are declared, so n^3 is fine.)
+    while (count < total) {
+        neopad_renderer_pass_id_t next = NEOPAD_RENDERER_PASS_NONE;
+        for (neopad_renderer_pass_id_t id = 0; id < NEOPAD_RENDERER_MAX_PASSES; id++) {
+            const neopad_renderer_pass_t *pass = &this->passes[id];
+            if (pass->references == 0 || is_placed[id]) {
+                continue;
+            }
+            if (next != NEOPAD_RENDERER_PASS_NONE && !is_before(pass, &this->passes[next])) {
+                continue;
+            }
+
+            bool is_ready = true;
+            for (neopad_renderer_pass_id_t other = 0; other < NEOPAD_RENDERER_MAX_PASSES && is_ready; other++) {
+                is_ready = other == id
+                           || this->passes[other].references == 0
+                           || is_placed[other]
+                           || !is_input_of(&this->passes[other], pass);
+            }
+            if (is_ready) {
+                next = id;
+            }
+        }
+
+        if (next == NEOPAD_RENDERER_PASS_NONE) {
+            return false;
+        }
+        is_placed[next] = true;
+        sorted[count++] = next;
+    }
+
+    // The first view is the clear view.
+    for (uint32_t i = 0; i < count; i++) {
+        this->passes[sorted[i]].view_id = (bgfx_view_id_t) (this->first_view + 1 + i);
+    }
+    memcpy(this->sorted, sorted, sizeof(sorted));
+    this->count = count;
+    return true;
+}
+
+#pragma mark - Declaration
+
+neopad_renderer_pass_id_t neopad_renderer_declare_pass(neopad_renderer_t this, const neopad_renderer_pass_desc_t *desc) {
+    neopad_renderer_graph_t *graph = &this->graph;
+
+    for (neopad_renderer_pass_id_t id = 0; id < NEOPAD_RENDERER_MAX_PASSES; id++) {
+        neopad_renderer_pass_t *pass = &graph->passes[id];
+        if (pass->references > 0 && is_mergeable(&pass->desc, desc)) {
+            pass->references++;
+            pass->desc.clear_flags |= desc->clear_flags;
+            if (desc->clear_flags) {
+                pass->desc.clear_color = desc->clear_color;
+            }
+            return id;
+        }
+    }
+
+    neopad_renderer_pass_id_t id = 0;
+    while (id < NEOPAD_RENDERER_MAX_PASSES && graph->passes[id].references > 0) {
+        id++;
+    }
+    if (id == NEOPAD_RENDERER_MAX_PASSES) {
+        eprintf("Too many render passes (at most %d).\n", NEOPAD_RENDERER_MAX_PASSES);
+        return NEOPAD_RENDERER_PASS_NONE;
+    }
+
+    graph->passes[id] = (neopad_renderer_pass_t) {.desc = *desc, .references = 1, .sequence = graph->next_sequence++};
+    if (!rebuild(graph)) {
+        eprintf("Render pass '%s' reads from what it draws into (perhaps through other passes).\n", desc->name);
+        graph->passes[id].references = 0;
+        rebuild(graph);
+        return NEOPAD_RENDERER_PASS_NONE;
+    }
+    return id;
+}
+
+void neopad_renderer_release_pass(neopad_renderer_t this, neopad_renderer_pass_id_t id) {
+    if (!is_declared(&this->graph, id)) {
+        return;
+    }
+    if (--this->graph.passes[id].references == 0) {
+        rebuild(&this->graph);
+    }
+}
+
+void neopad_renderer_set_pass_output(neopad_renderer_t this,
+                                     neopad_renderer_pass_id_t id,
+                                     bgfx_frame_buffer_handle_t output,
+                                     uint16_t width,
+                                     uint16_t height) {
+    if (!is_declared(&this->graph, id)) {
+        return;
+    }
+    neopad_renderer_pass_t *pass = &this->graph.passes[id];
+    pass->desc.output = output;
+    pass->desc.width = width;
+    pass->desc.height = height;
+}
+
+#pragma mark - Frames
+
+bgfx_view_id_t neopad_renderer_use_pass(neopad_renderer_t this, neopad_renderer_pass_id_t id) {
+    if (!is_declared(&this->graph, id)) {
+        return NEOPAD_RENDERER_VIEW_NONE;
+    }
+    neopad_renderer_pass_t *pass = &this->graph.passes[id];
+
+    // Without a window to draw into, not into the back buffer (another renderer's) either.
+    if (!BGFX_HANDLE_IS_VALID(pass->desc.output) && neopad_renderer_is_window_lost(this)) {
+        return NEOPAD_RENDERER_VIEW_NONE;
+    }
+    pass->is_used = true;
+
+    // A draw is about to be submitted: it needs the uniforms as they are now.
+    neopad_uniforms_flush(&this->uniforms);
+    return pass->view_id;
+}
+
+void neopad_renderer_submit_pass(neopad_renderer_t this, neopad_renderer_pass_id_t id, bgfx_program_handle_t program) {
+    bgfx_view_id_t view = neopad_renderer_use_pass(this, id);
+    if (view == NEOPAD_RENDERER_VIEW_NONE) {
+        bgfx_discard(BGFX_DISCARD_ALL);
+        return;
+    }
+    bgfx_submit(view, program, 0, false);
+}
+
+void neopad_renderer_graph_end_frame(neopad_renderer_t this) {
+    neopad_renderer_graph_t *graph = &this->graph;
+
+    // With partial_redraw, only the part of the back buffer that changed (zero-sized: all of it).
+    const neopad_ivec4_t scissor = this->scissor;
+    const bool is_partial = scissor.width > 0 && scissor.height > 0;
+    uint16_t back_clear_flags = BGFX_CLEAR_NONE;
+    uint32_t back_clear_color = 0;
+
+    for (uint32_t i = 0; i < graph->count; i++) {
+        neopad_renderer_pass_t *pass = &graph->passes[graph->sorted[i]];
+        bgfx_view_id_t view = pass->view_id;
+
+        // Views keep their settings from frame to frame, so unused ones are left clear of work.
+        if (!pass->is_used) {
+            bgfx_set_view_clear(view, BGFX_CLEAR_NONE, 0, 1.0f, 0);
+            continue;
+        }
+
+        // The first pass used on an output clears it, for every pass on it that wants it cleared.
+        bool is_first = true;
+        uint16_t clear_flags = 0;
+        uint32_t clear_color = 0;
+        for (uint32_t j = 0; j < graph->count; j++) {
+            const neopad_renderer_pass_t *other = &graph->passes[graph->sorted[j]];
+            if (!other->is_used || !is_same_buffer(other->desc.output, pass->desc.output)) {
+                continue;
+            }
+            if (j < i) {
+                is_first = false;
+                break;
+            }
+            if (other->desc.clear_flags && !clear_flags) {
+                clear_color = other->desc.clear_color;
+            }
+            clear_flags |= other->desc.clear_flags;
+        }
+        if (!is_first) {
+            clear_flags = BGFX_CLEAR_NONE;
+        }
+
+        bool is_back_buffer = !BGFX_HANDLE_IS_VALID(pass->desc.output);
+        uint16_t width = is_back_buffer ? (uint16_t) this->width : pass->desc.width;
+        uint16_t height = is_back_buffer ? (uint16_t) this->height : pass->desc.height;
+        if (is_back_buffer && is_first) {
+            back_clear_flags = clear_flags;
+            back_clear_color = clear_color;
+        }
+
+        bgfx_set_view_name(view, pass->desc.name, INT32_MAX);
+        bgfx_set_view_frame_buffer(view, is_back_buffer ? this->window : pass->desc.output);
+        bgfx_set_view_rect(view, 0, 0, width, height);
+
+        if (is_back_buffer && is_partial) {
+            // Cleared by the clear view instead: a clear here would take the whole view rect.
+            bgfx_set_view_scissor(view,
+                                  (uint16_t) scissor.x, (uint16_t) scissor.y,
+                                  (uint16_t) scissor.width, (uint16_t) scissor.height);
+            clear_flags = BGFX_CLEAR_NONE;
+        } else {
+            bgfx_set_view_scissor(view, 0, 0, 0, 0);
+        }
+
+        bgfx_set_view_clear(view, clear_flags, clear_color, 1.0f, 0);
+        if (pass->desc.transform == NEOPAD_RENDERER_PASS_TRANSFORM_WORLD) {
+            bgfx_set_view_transform(view, this->model_view, this->proj);
+        }
+        bgfx_touch(view);
+    }
+
+    // The clear view clears just the part redrawn, ahead of every pass (its rect is all it clears).
+    const bgfx_view_id_t clear_view = graph->first_view;
+    if (is_partial && back_clear_flags) {
+        bgfx_set_view_name(clear_view, "clear", INT32_MAX);
+        bgfx_set_view_frame_buffer(clear_view, this->window);
+        bgfx_set_view_rect(clear_view,
+                           (uint16_t) scissor.x, (uint16_t) scissor.y,
+                           (uint16_t) scissor.width, (uint16_t) scissor.height);
+        bgfx_set_view_clear(clear_view, back_clear_flags, back_clear_color, 1.0f, 0);
+        bgfx_touch(clear_view);
+        graph->clear_rect = scissor;
+    } else {
+        bgfx_set_view_clear(clear_view, BGFX_CLEAR_NONE, 0, 1.0f, 0);
+        graph->clear_rect = (neopad_ivec4_t) {0};
+    }
+    graph->clear_flags = back_clear_flags;
+
+    for (uint32_t i = 0; i < graph->count; i++) {
+        graph->passes[graph->sorted[i]].is_used = false;
+    }
+}
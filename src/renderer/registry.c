@@ -0,0 +1,206 @@
+//
+// Created by Dylan Lukes on 8/25/23.
+//
+
+#include <string.h>
+
+#include "neopad/internal/log.h"
+#include "neopad/internal/renderer.h"
+#include "neopad/internal/renderer/registry.h"
+
+#pragma mark - Ordering
+
+/// Add a module's hook to a phase, if it has one.
+static void add_hook(neopad_renderer_phase_t *phase, neopad_renderer_module_hook_t hook,
+                     neopad_renderer_module_t module, neopad_renderer_module_id_t id, uint32_t rank) {
+    if (!hook) {
+        return;
+    }
+    phase->hooks[phase->count] = hook;
+    phase->modules[phase->count] = module;
+    phase->ids[phase->count] = id;
+    phase->ranks[phase->count] = rank;
+    phase->count++;
+}
+
+/// Rebuild the order and phases, after a module comes or goes.
+static void rebuild(neopad_renderer_registry_t *this) {
+    // Insertion sort by order; stable, so modules at the same order keep their registration order.
+    // (Slots fill lowest first, but that is not registration order once modules are removed, so
+    // the existing order is kept and only new IDs are inserted.)
+    neopad_renderer_module_id_t sorted[NEOPAD_RENDERER_MAX_MODULES];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < this->count; i++) {
+        if (this->slots[this->sorted[i]].base) {
+            sorted[count++] = this->sorted[i];
+        }
+    }
+    for (neopad_renderer_module_id_t id = 0; id < NEOPAD_RENDERER_MAX_MODULES; id++) {
+        if (!this->slots[id].base) {
+            continue;
+        }
+        bool is_sorted = false;
+        for (uint32_t i = 0; i < count && !is_sorted; i++) {
+            is_sorted = sorted[i] == id;
+        }
+        if (!is_sorted) {
+            sorted[count++] = id;
+        }
+    }
+    for (uint32_t i = 1; i < count; i++) {
+        neopad_renderer_module_id_t id = sorted[i];
+        int32_t order = this->slots[id].base->order;
+        uint32_t j = i;
+        for (; j > 0 && this->slots[sorted[j - 1]].base->order > order; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = id;
+    }
+    memcpy(this->sorted, sorted, sizeof(sorted));
+    this->count = count;
+
+    this->begin_frame.count = 0;
+    this->end_frame.count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        neopad_renderer_module_t module = this->slots[sorted[i]];
+        add_hook(&this->begin_frame, module.base->on_begin_frame, module, sorted[i], i);
+        add_hook(&this->end_frame, module.base->on_end_frame, module, sorted[i], i);
+    }
+    this->is_stale = false;
+}
+
+/// Rebuild now, or once the hooks being called have returned.
+static void invalidate(neopad_renderer_registry_t *this) {
+    if (this->depth > 0) {
+        this->is_stale = true;
+    } else {
+        rebuild(this);
+    }
+}
+
+/// Tear down (if set up) and destroy a module that has been unregistered.
+static void retire(neopad_renderer_t this, neopad_renderer_module_t module) {
+    if (this->modules.is_setup && module.base->on_teardown) {
+        module.base->on_teardown(module, this);
+    }
+    if (module.base->destroy) {
+        module.base->destroy(module);
+    }
+}
+
+#pragma mark - Registration
+
+neopad_renderer_module_id_t neopad_renderer_register_module(neopad_renderer_t this, neopad_renderer_module_t module) {
+    neopad_renderer_registry_t *registry = &this->modules;
+
+    // Slots freed while hooks are being called are taken again only once the module is gone.
+    neopad_renderer_module_id_t id = 0;
+    while (id < NEOPAD_RENDERER_MAX_MODULES && (registry->slots[id].base || registry->removed[id].base)) {
+        id++;
+    }
+    if (id == NEOPAD_RENDERER_MAX_MODULES) {
+        eprintf("Too many renderer modules (at most %d).\n", NEOPAD_RENDERER_MAX_MODULES);
+        if (module.base->destroy) {
+            module.base->destroy(module);
+        }
+        return NEOPAD_RENDERER_MODULE_NONE;
+    }
+
+    registry->slots[id] = module;
+    invalidate(registry);
+
+    if (registry->is_setup && module.base->on_setup) {
+        module.base->on_setup(module, this);
+    }
+    return id;
+}
+
+void neopad_renderer_unregister_module(neopad_renderer_t this, neopad_renderer_module_id_t id) {
+    neopad_renderer_registry_t *registry = &this->modules;
+    neopad_renderer_module_t module = neopad_renderer_registry_get(registry, id);
+    if (!module.base) {
+        return;
+    }
+
+    registry->slots[id].base = NULL;
+    invalidate(registry);
+
+    if (registry->depth > 0) {
+        registry->removed[id] = module;
+        registry->removed_count++;
+    } else {
+        retire(this, module);
+    }
+}
+
+neopad_renderer_module_id_t neopad_renderer_find_module(neopad_renderer_t this, const char *name) {
+    for (neopad_renderer_module_id_t id = 0; id < NEOPAD_RENDERER_MAX_MODULES; id++) {
+        neopad_renderer_module_t module = this->modules.slots[id];
+        if (module.base && strcmp(module.base->name, name) == 0) {
+            return id;
+        }
+    }
+    return NEOPAD_RENDERER_MODULE_NONE;
+}
+
+#pragma mark - Calling
+
+void neopad_renderer_registry_enter(neopad_renderer_t this) {
+    this->modules.depth++;
+}
+
+void neopad_renderer_registry_leave(neopad_renderer_t this) {
+    neopad_renderer_registry_t *registry = &this->modules;
+    if (--registry->depth > 0) {
+        return;
+    }
+    if (registry->is_stale) {
+        rebuild(registry);
+    }
+
+    for (neopad_renderer_module_id_t id = 0; registry->removed_count > 0 && id < NEOPAD_RENDERER_MAX_MODULES; id++) {
+        neopad_renderer_module_t module = registry->removed[id];
+        if (module.base) {
+            registry->removed[id].base = NULL;
+            registry->removed_count--;
+            retire(this, module);
+        }
+    }
+}
+
+#pragma mark - Lifecycle
+
+void neopad_renderer_setup_modules(neopad_renderer_t this) {
+    neopad_renderer_registry_t *registry = &this->modules;
+    for (uint32_t i = 0; i < registry->count; i++) {
+        neopad_renderer_module_t module = registry->slots[registry->sorted[i]];
+        if (module.base->on_setup) {
+            module.base->on_setup(module, this);
+        }
+    }
+    registry->is_setup = true;
+}
+
+void neopad_renderer_teardown_modules(neopad_renderer_t this) {
+    neopad_renderer_registry_t *registry = &this->modules;
+    for (uint32_t i = registry->count; i-- > 0;) {
+        neopad_renderer_module_t module = registry->slots[registry->sorted[i]];
+        if (module.base->on_teardown) {
+            module.base->on_teardown(module, this);
+        }
+    }
+    registry->is_setup = false;
+}
+
+void neopad_renderer_destroy_modules(neopad_renderer_t this) {
+    neopad_renderer_registry_t *registry = &this->modules;
+    for (uint32_t i = registry->count; i-- > 0;) {
+        neopad_renderer_module_id_t id = registry->sorted[i];
+        neopad_renderer_module_t module = registry->slots[id];
+        registry->slots[id].base = NULL;
+        if (module.base->destroy) {
+            module.base->destroy(module);
+        }
+    }
+    rebuild(registry);
+}
@@ -0,0 +1,475 @@
+//
+// Created by Dylan Lukes on 8/21/23.
+//
+// Draws scene objects. Only objects whose bounds intersect the view are looked at: the scene's
+// spatial index is queried with the view rect when the frame ends (once the view is known).
+//
+// Scene geometry is rebuilt every frame, so it is rebased on the CPU: vertices are made relative
+// to the center of the view (in double precision), where floats are always precise enough.
+//
+// Where the backend supports instancing, each object is one instance of a unit quad (48 bytes,
+// rather than tessellated geometry), shaded by its signed distance, so ellipses are exact and
+// lines have round caps at any zoom. Objects are batched in scene order, whatever their kind, so
+// a whole scene is a draw call per NEOPAD_SCENE_BATCH_INSTANCES objects.
+//
+// Either way, each batch is measured before it is allocated, then written straight into the
+// memory bgfx draws it from (see neopad/internal/renderer/geometry.h): nothing is copied, and a
+// frame past the transient budget still draws everything.
+
+#include "neopad/renderer.h"
+#include "neopad/internal/log.h"
+#include "neopad/internal/rect.h"
+#include "neopad/internal/renderer.h"
+#include "neopad/internal/renderer/commands.h"
+#include "neopad/internal/renderer/geometry.h"
+#include "neopad/internal/renderer/scene.h"
+#include "neopad/internal/renderer/stroke.h"
+#include "neopad/internal/scene.h"
+
+#include <math.h>
+#include <memory.h>
+
+static inline neopad_renderer_module_scene_t get_module(neopad_renderer_t renderer) {
+    return neopad_renderer_registry_get(&renderer->modules, renderer->builtin.scene).scene;
+}
+
+/// Make a point relative to the frame's origin.
+static inline void rebase(neopad_dvec2_t origin, const vec2 p, float *x, float *y) {
+    *x = (float) ((double) p[0] - origin.x);
+    *y = (float) ((double) p[1] - origin.y);
+}
+
+/// Drawn over whatever is beneath, whether tessellated or instanced.
+#define SCENE_STATE (BGFX_STATE_WRITE_RGB \
+                     | BGFX_STATE_WRITE_A \
+                     | BGFX_STATE_MSAA \
+                     | BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA))
+
+#pragma mark - Batching
+
+/// The i-th object to draw this frame.
+static inline const neopad_scene_object_t *object_at(neopad_renderer_module_scene_t this, size_t i) {
+    const uint32_t id = this->visible.vector[i];
+    return this->scene ? neopad_scene_get(this->scene, id) : &this->snapshot->objects[id];
+}
+
+/// Submit the geometry written so far as one draw.
+static void submit_geometry(neopad_renderer_module_scene_t this, neopad_renderer_t renderer) {
+    const neopad_stroke_size_t size = this->geometry.size;
+    if (size.index_count == 0) {
+        return;
+    }
+
+    this->base.counters.transient_bytes += neopad_geometry_set(&this->geometry, renderer);
+    neopad_renderer_set_origin(renderer, this->origin);
+    bgfx_set_state(SCENE_STATE, 0);
+    neopad_renderer_submit_pass(renderer, this->pass, renderer->programs[NEOPAD_PROGRAM_BASIC]);
+
+    this->base.counters.draw_calls++;
+    this->base.counters.vertices += size.vertex_count;
+    this->base.counters.indices += size.index_count;
+}
+
+#pragma mark - Tessellation
+
+neopad_stroke_style_t neopad_scene_line_style(const neopad_scene_object_t *object) {
+    return (neopad_stroke_style_t) {
+            .width = object->width,
+            .color = object->color,
+            .join = NEOPAD_STROKE_JOIN_MITER,
+            .cap = NEOPAD_STROKE_CAP_ROUND,
+            .miter_limit = 4.0f,
+    };
+}
+
+/// Upper bound on the geometry an object is tessellated into.
+static neopad_stroke_size_t measure_object(const neopad_scene_object_t *object) {
+    switch (object->kind) {
+        case NEOPAD_SCENE_OBJECT_LINE: {
+            const neopad_stroke_style_t style = neopad_scene_line_style(object);
+            return neopad_stroke_measure(2, &style);
+        }
+        case NEOPAD_SCENE_OBJECT_RECT:
+            return (neopad_stroke_size_t) {4, 6};
+        case NEOPAD_SCENE_OBJECT_ELLIPSE:
+            return (neopad_stroke_size_t) {NEOPAD_SCENE_ELLIPSE_SEGMENTS + 1, 3 * NEOPAD_SCENE_ELLIPSE_SEGMENTS};
+    }
+    return (neopad_stroke_size_t) {0, 0};
+}
+
+static void add_line(neopad_renderer_module_scene_t this, const neopad_scene_object_t *object) {
+    const neopad_stroke_style_t style = neopad_scene_line_style(object);
+    neopad_vec2_t points[2];
+    rebase(this->origin, object->line.start, &points[0].x, &points[0].y);
+    rebase(this->origin, object->line.end, &points[1].x, &points[1].y);
+
+    neopad_geometry_t *g = &this->geometry;
+    neopad_geometry_advance(g, neopad_stroke_tessellate(
+            points, 2, &style, g->size.vertex_count,
+            &g->vertices[g->size.vertex_count],
+            &g->indices[g->size.index_count]));
+}
+
+static void add_rect(neopad_renderer_module_scene_t this, const neopad_scene_object_t *object) {
+    const uint32_t c = object->color;
+    rect_t r;
+    rebase(this->origin, object->rect.min, &r.min[0], &r.min[1]);
+    rebase(this->origin, object->rect.max, &r.max[0], &r.max[1]);
+
+    neopad_geometry_t *g = &this->geometry;
+    const uint32_t base = g->size.vertex_count;
+    neopad_renderer_vertex_t *v = &g->vertices[g->size.vertex_count];
+    uint32_t *i = &g->indices[g->size.index_count];
+
+    v[0] = (neopad_renderer_vertex_t) {r.min[0], r.min[1], 0, 1, c};
+    v[1] = (neopad_renderer_vertex_t) {r.max[0], r.min[1], 0, 1, c};
+    v[2] = (neopad_renderer_vertex_t) {r.max[0], r.max[1], 0, 1, c};
+    v[3] = (neopad_renderer_vertex_t) {r.min[0], r.max[1], 0, 1, c};
+
+    i[0] = base;
+    i[1] = base + 1;
+    i[2] = base + 2;
+    i[3] = base;
+    i[4] = base + 2;
+    i[5] = base + 3;
+
+    neopad_geometry_advance(g, (neopad_stroke_size_t) {4, 6});
+}
+
+static void add_ellipse(neopad_renderer_module_scene_t this, const neopad_scene_object_t *object) {
+    const ellipse_t *e = &object->ellipse;
+    const uint32_t c = object->color;
+    const uint32_t n = NEOPAD_SCENE_ELLIPSE_SEGMENTS;
+
+    neopad_geometry_t *g = &this->geometry;
+    const uint32_t base = g->size.vertex_count;
+    neopad_renderer_vertex_t *v = &g->vertices[g->size.vertex_count];
+    uint32_t *i = &g->indices[g->size.index_count];
+
+    float cx, cy;
+    rebase(this->origin, e->center, &cx, &cy);
+
+    // A fan around the center.
+    v[0] = (neopad_renderer_vertex_t) {cx, cy, 0, 1, c};
+    for (uint32_t k = 0; k < n; k++) {
+        float theta = 2.0f * GLM_PIf * (float) k / (float) n;
+        v[k + 1] = (neopad_renderer_vertex_t) {
+                cx + e->radii[0] * cosf(theta),
+                cy + e->radii[1] * sinf(theta),
+                0, 1, c};
+
+        i[3 * k + 0] = base;
+        i[3 * k + 1] = base + 1 + k;
+        i[3 * k + 2] = base + 1 + (k + 1) % n;
+    }
+
+    neopad_geometry_advance(g, (neopad_stroke_size_t) {n + 1, 3 * n});
+}
+
+#pragma mark - Instancing
+
+static const float QUAD_VERTICES[] = {
+        -1.0f, -1.0f,
+        1.0f, -1.0f,
+        1.0f, 1.0f,
+        -1.0f, 1.0f,
+};
+
+static const uint16_t QUAD_INDICES[] = {
+        0, 1, 2,
+        0, 2, 3,
+};
+
+/// Submit the shapes written so far as one instanced draw.
+static void submit_instances(neopad_renderer_module_scene_t this, neopad_renderer_t renderer) {
+    const uint32_t count = this->instances.count;
+    if (count == 0) {
+        return;
+    }
+
+    bgfx_set_vertex_buffer(0, this->quad_vbo, 0, 4);
+    bgfx_set_index_buffer(this->quad_ibo, 0, 6);
+    this->base.counters.transient_bytes += neopad_instances_set(&this->instances, &this->instance_layout);
+    neopad_renderer_set_origin(renderer, this->origin);
+    bgfx_set_state(SCENE_STATE, 0);
+    neopad_renderer_submit_pass(renderer, this->pass, renderer->programs[NEOPAD_PROGRAM_SHAPE]);
+
+    this->base.counters.draw_calls++;
+    this->base.counters.vertices += 4 * count;
+    this->base.counters.indices += 6 * count;
+}
+
+/// Unpack a color into floats, in the order the basic program receives vertex colors in.
+static inline void unpack_color(uint32_t c, vec4 dst) {
+    for (int k = 0; k < 4; k++) {
+        dst[k] = (float) ((c >> (8 * k)) & 0xff) / 255.0f;
+    }
+}
+
+void neopad_scene_shape_instance(const neopad_scene_object_t *object,
+                                 neopad_dvec2_t origin,
+                                 neopad_renderer_shape_instance_t *instance) {
+    *instance = (neopad_renderer_shape_instance_t) {
+            .axis = {1.0f, 0.0f},
+            .kind = (float) object->kind,
+    };
+    unpack_color(object->color, instance->color);
+
+    switch (object->kind) {
+        case NEOPAD_SCENE_OBJECT_LINE: {
+            // A box around the line's length, turned along it, with a radius of half its width.
+            // The box reaches a radius past each end, for the round caps (as when tessellated).
+            vec2 start, end, delta;
+            rebase(origin, object->line.start, &start[0], &start[1]);
+            rebase(origin, object->line.end, &end[0], &end[1]);
+            glm_vec2_sub(end, start, delta);
+            float length = glm_vec2_norm(delta);
+            if (length > 0.0f) {
+                glm_vec2_scale(delta, 1.0f / length, instance->axis);
+            }
+            instance->radius = 0.5f * object->width;
+            glm_vec2_lerp(start, end, 0.5f, instance->center);
+            instance->half_size[0] = 0.5f * length + instance->radius;
+            instance->half_size[1] = instance->radius;
+            break;
+        }
+        case NEOPAD_SCENE_OBJECT_RECT: {
+            vec2 min, max;
+            rebase(origin, object->rect.min, &min[0], &min[1]);
+            rebase(origin, object->rect.max, &max[0], &max[1]);
+            glm_vec2_lerp(min, max, 0.5f, instance->center);
+            instance->half_size[0] = 0.5f * fabsf(max[0] - min[0]);
+            instance->half_size[1] = 0.5f * fabsf(max[1] - min[1]);
+            break;
+        }
+        case NEOPAD_SCENE_OBJECT_ELLIPSE:
+            rebase(origin, object->ellipse.center, &instance->center[0], &instance->center[1]);
+            instance->half_size[0] = fabsf(object->ellipse.radii[0]);
+            instance->half_size[1] = fabsf(object->ellipse.radii[1]);
+            break;
+    }
+
+}
+
+#pragma mark - Objects
+
+static void add_object(neopad_renderer_module_scene_t this, const neopad_scene_object_t *object) {
+    switch (object->kind) {
+        case NEOPAD_SCENE_OBJECT_LINE:
+            add_line(this, object);
+            break;
+        case NEOPAD_SCENE_OBJECT_RECT:
+            add_rect(this, object);
+            break;
+        case NEOPAD_SCENE_OBJECT_ELLIPSE:
+            add_ellipse(this, object);
+            break;
+    }
+}
+
+/// Draw the objects in view tessellated, a batch at a time.
+static void draw_tessellated(neopad_renderer_module_scene_t this, neopad_renderer_t renderer) {
+    const size_t count = this->visible.size;
+    size_t first = 0;
+    while (first < count) {
+        // Measure the batch first, so it is written where it is drawn from, with little to spare.
+        neopad_stroke_size_t capacity = {0, 0};
+        size_t last = first;
+        for (; last < count; last++) {
+            neopad_stroke_size_t size = measure_object(object_at(this, last));
+            if (last > first && capacity.vertex_count + size.vertex_count > NEOPAD_SCENE_BATCH_VERTICES) {
+                break;
+            }
+            capacity.vertex_count += size.vertex_count;
+            capacity.index_count += size.index_count;
+        }
+
+        if (neopad_geometry_alloc(&this->geometry, renderer, capacity)) {
+            for (size_t i = first; i < last; i++) {
+                add_object(this, object_at(this, i));
+            }
+            submit_geometry(this, renderer);
+        }
+        first = last;
+    }
+}
+
+/// A batch of instances being built.
+typedef struct {
+    neopad_renderer_module_scene_t module;
+    size_t first;
+} instance_batch_t;
+
+/// Build instances [begin, end) of a batch: each object is read, and its instance written, by one job.
+static void add_instances(void *context, size_t begin, size_t end) {
+    const instance_batch_t *batch = context;
+    neopad_renderer_module_scene_t this = batch->module;
+    for (size_t i = begin; i < end; i++) {
+        neopad_scene_shape_instance(object_at(this, batch->first + i), this->origin,
+                                    neopad_instances_at(&this->instances, (uint32_t) i));
+    }
+}
+
+/// Draw the objects in view instanced, a batch at a time, each built across the renderer's workers.
+static void draw_instanced(neopad_renderer_module_scene_t this, neopad_renderer_t renderer) {
+    const size_t count = this->visible.size;
+    const uint16_t stride = sizeof(neopad_renderer_shape_instance_t);
+    for (size_t first = 0; first < count; first += NEOPAD_SCENE_BATCH_INSTANCES) {
+        const size_t last = count - first > NEOPAD_SCENE_BATCH_INSTANCES ? first + NEOPAD_SCENE_BATCH_INSTANCES : count;
+        if (neopad_instances_alloc(&this->instances, renderer, (uint32_t) (last - first), stride)) {
+            instance_batch_t batch = {.module = this, .first = first};
+            neopad_jobs_parallel_for(neopad_renderer_jobs(renderer), last - first, NEOPAD_SCENE_INSTANCE_GRAIN,
+                                     add_instances, &batch);
+            this->instances.count = (uint32_t) (last - first);
+            submit_instances(this, renderer);
+        }
+    }
+}
+
+#pragma mark - Drawing
+
+void neopad_renderer_draw_scene(neopad_renderer_t this, neopad_scene_t scene) {
+    // A different scene, or one changed since it was last drawn, is redrawn whole.
+    if (scene != this->dirty.scene || scene->revision != this->dirty.scene_revision) {
+        neopad_renderer_invalidate(this);
+    }
+    this->dirty.scene = scene;
+    this->dirty.scene_revision = scene->revision;
+
+    if (neopad_renderer_is_recording(this)) {
+        // Only what might be in view is copied; the scene is free to change once this returns.
+        rect_t area;
+        neopad_renderer_get_record_rect(this, &area);
+        neopad_renderer_record(this, (neopad_command_t) {
+                .type = NEOPAD_COMMAND_DRAW_SCENE,
+                .snapshot = neopad_scene_snapshot(scene, &area),
+        });
+        return;
+    }
+    get_module(this)->scene = scene;
+}
+
+void neopad_renderer_draw_scene_snapshot(neopad_renderer_t this, neopad_scene_snapshot_t *snapshot) {
+    neopad_renderer_module_scene_t module = get_module(this);
+    free(module->snapshot);
+    module->snapshot = snapshot;
+}
+
+#pragma mark - Lifecycle
+
+static void on_setup(neopad_renderer_module_scene_t this, neopad_renderer_t renderer) {
+    neopad_renderer_pass_desc_t pass = neopad_renderer_content_pass_desc();
+    this->pass = neopad_renderer_declare_pass(renderer, &pass);
+
+    this->is_instanced = (bgfx_get_caps()->supported & BGFX_CAPS_INSTANCING) != 0;
+    if (!this->is_instanced) {
+        return;
+    }
+
+    renderer->programs[NEOPAD_PROGRAM_SHAPE] = bgfx_create_embedded_program(
+            embedded_shaders,
+            bgfx_get_renderer_type(),
+            "vs_shape",
+            "fs_shape",
+            NULL);
+
+    bgfx_vertex_layout_begin(&this->quad_layout, BGFX_RENDERER_TYPE_NOOP);
+    bgfx_vertex_layout_add(&this->quad_layout, BGFX_ATTRIB_POSITION, 2, BGFX_ATTRIB_TYPE_FLOAT, false, false);
+    bgfx_vertex_layout_end(&this->quad_layout);
+
+    // Instance data as vertices (i_data0 to i_data2), for drawing it from frame scratch.
+    bgfx_vertex_layout_begin(&this->instance_layout, BGFX_RENDERER_TYPE_NOOP);
+    bgfx_vertex_layout_add(&this->instance_layout, BGFX_ATTRIB_TEXCOORD7, 4, BGFX_ATTRIB_TYPE_FLOAT, false, false);
+    bgfx_vertex_layout_add(&this->instance_layout, BGFX_ATTRIB_TEXCOORD6, 4, BGFX_ATTRIB_TYPE_FLOAT, false, false);
+    bgfx_vertex_layout_add(&this->instance_layout, BGFX_ATTRIB_TEXCOORD5, 4, BGFX_ATTRIB_TYPE_FLOAT, false, false);
+    bgfx_vertex_layout_end(&this->instance_layout);
+
+    this->quad_vbo = bgfx_create_vertex_buffer(
+            bgfx_make_ref(QUAD_VERTICES, sizeof(QUAD_VERTICES)), &this->quad_layout, BGFX_BUFFER_NONE);
+    this->quad_ibo = bgfx_create_index_buffer(bgfx_make_ref(QUAD_INDICES, sizeof(QUAD_INDICES)), BGFX_BUFFER_NONE);
+}
+
+static void on_teardown(neopad_renderer_module_scene_t this, neopad_renderer_t renderer) {
+    if (this->is_instanced) {
+        bgfx_destroy_index_buffer(this->quad_ibo);
+        bgfx_destroy_vertex_buffer(this->quad_vbo);
+        bgfx_destroy_program(renderer->programs[NEOPAD_PROGRAM_SHAPE]);
+        this->is_instanced = false;
+    }
+    neopad_renderer_release_pass(renderer, this->pass);
+}
+
+static void on_end_frame(neopad_renderer_module_scene_t this, neopad_renderer_t renderer) {
+    neopad_scene_t scene = this->scene;
+    neopad_scene_snapshot_t *snapshot = this->snapshot;
+    if (!scene && !snapshot) {
+        return;
+    }
+
+    rect_t view;
+    neopad_renderer_get_frame_rect(renderer, &view);
+
+    // The center of the view (the camera is an offset, so the opposite of it).
+    this->origin = (neopad_dvec2_t) {-renderer->camera.x, -renderer->camera.y};
+
+    vec_uint32_t_clear(&this->visible);
+    if (scene) {
+        neopad_scene_query_into(scene, &view, &this->visible);
+        this->base.counters.culled += (uint32_t) (neopad_scene_count(scene) - this->visible.size);
+    } else {
+        // Snapshots are taken for a (slightly) larger area than ends up in view.
+        for (size_t i = 0; i < snapshot->count; i++) {
+            rect_t bounds;
+            neopad_scene_object_bounds(&snapshot->objects[i], &bounds);
+            if (!rect_overlaps(&bounds, &view)) {
+                this->base.counters.culled++;
+                continue;
+            }
+            vec_uint32_t_push_back(&this->visible, (uint32_t) i);
+        }
+    }
+    this->base.counters.visible += (uint32_t) this->visible.size;
+
+    if (this->is_instanced) {
+        draw_instanced(this, renderer);
+    } else {
+        draw_tessellated(this, renderer);
+    }
+
+    // The scene must be drawn again next frame to be seen.
+    this->scene = NULL;
+    free(this->snapshot);
+    this->snapshot = NULL;
+}
+
+void neopad_renderer_module_scene_destroy(neopad_renderer_module_scene_t module) {
+    free(module->snapshot);
+    vec_uint32_t_free(&module->visible);
+    free(module);
+}
+
+neopad_renderer_module_t neopad_renderer_module_scene_create(void) {
+    neopad_renderer_module_scene_t module = malloc(sizeof(struct neopad_renderer_module_scene_s));
+    memcpy(module, &(struct neopad_renderer_module_scene_s) {
+            .base = {
+                    .name = "scene",
+                    .order = NEOPAD_RENDERER_ORDER_CONTENT,
+                    .on_setup = on_setup,
+                    .on_teardown = on_teardown,
+                    .on_begin_frame = NULL,
+                    .on_end_frame = on_end_frame,
+                    .render = NULL,
+                    .destroy = neopad_renderer_module_scene_destroy
+            },
+            .pass = NEOPAD_RENDERER_PASS_NONE,
+            .scene = NULL,
+            .snapshot = NULL,
+            .origin = {0.0, 0.0},
+            .visible = vec_uint32_t_init(),
+            .is_instanced = false,
+            .quad_vbo = BGFX_INVALID_HANDLE,
+            .quad_ibo = BGFX_INVALID_HANDLE,
+    }, sizeof(struct neopad_renderer_module_scene_s));
+
+    return (neopad_renderer_module_t) { .scene = module };
+}
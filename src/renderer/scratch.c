@@ -0,0 +1,30 @@
+//
+// Created by Dylan Lukes on 9/1/23.
+//
+
+#include <memory.h>
+
+#include "neopad/internal/renderer/scratch.h"
+
+void neopad_frame_scratch_init(neopad_frame_scratch_t *this) {
+    for (uint32_t i = 0; i < NEOPAD_FRAME_SCRATCH_ARENAS; i++) {
+        ctl_arena_init(&this->arenas[i], NEOPAD_FRAME_SCRATCH_CHUNK_SIZE);
+        this->frames[i] = 0;
+    }
+    this->current = 0;
+}
+
+void neopad_frame_scratch_free(neopad_frame_scratch_t *this) {
+    for (uint32_t i = 0; i < NEOPAD_FRAME_SCRATCH_ARENAS; i++) {
+        ctl_arena_free(&this->arenas[i]);
+    }
+}
+
+const bgfx_memory_t *neopad_frame_scratch_copy(neopad_frame_scratch_t *this, const void *data, uint32_t size) {
+    void *copy = neopad_frame_scratch_alloc(this, size);
+    if (!copy) {
+        return NULL;
+    }
+    memcpy(copy, data, size);
+    return bgfx_make_ref(copy, size);
+}
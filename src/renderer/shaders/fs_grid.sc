@@ -45,27 +45,32 @@ void main()
     vec2 xy_ndc = -1. + 2. * (xy / u_viewRect.zw);
     xy_ndc = vec2(1., -1.) * xy_ndc; // flip y-axis
 
-    // Transform back to world coordinates using the inverse viewProj matrix.
-    // This accounts for the camera's position and zoom.
+    // Transform back to (camera-relative) world coordinates using the inverse viewProj matrix.
+    // This accounts for the zoom, but not the camera's position, which is kept out of the
+    // matrices so that they stay precise however far the camera goes.
     vec2 xy_world = mul(u_invViewProj, vec4(xy_ndc, 0.0, 1.0)).xy;
 
+    // The grid repeats, so only the camera's position modulo the grid spacing matters.
+    vec2 xy_grid = xy_world + u_grid_offset;
+
     vec3 color = vec3(0.0, 0.0, 0.0);
 
     // Scale the width inversely with zoom to keep the grid lines fine.
     float width = 1.0 / u_zoom;
 
     // Single world-pixel major and minor grid lines.
-    color += gray333 * pixgrid(xy_world, u_grid_major, width);
+    color += gray333 * pixgrid(xy_grid, u_grid_major, width);
 
     // Only draw minor grid lines if the zoom level is high enough.
-    color += step(1.0, u_zoom) * gray111 * pixgrid(xy_world, u_grid_minor, width);
+    color += step(1.0, u_zoom) * gray111 * pixgrid(xy_grid, u_grid_minor, width);
 
-    // Single world-pixel axes lines.
-    color += red   * pixline(xy_world.y, 0., width);
-    color += green * pixline(xy_world.x, 0., width);
+    // Single world-pixel axes lines, through the world origin.
+    vec2 xy_axes = xy_world - u_origin;
+    color += red   * pixline(xy_axes.y, 0., width);
+    color += green * pixline(xy_axes.x, 0., width);
     // Add a blue dot for the origin 0,0 (making the origin a white dot)
-    color += blue * (step(-width/2.0, xy_world.x) - step(width/2.0, xy_world.x))
-                  * (step(-width/2.0, xy_world.y) - step(width/2.0, xy_world.y));
+    color += blue * (step(-width/2.0, xy_axes.x) - step(width/2.0, xy_axes.x))
+                  * (step(-width/2.0, xy_axes.y) - step(width/2.0, xy_axes.y));
 
 	gl_FragColor = vec4(color, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+$input v_color0, v_texcoord0, v_shape
+
+#include <bgfx_shader.sh>
+
+// Kinds of shape (as neopad_scene_object_kind_t).
+#define SHAPE_LINE 0.0
+#define SHAPE_RECT 1.0
+#define SHAPE_ELLIPSE 2.0
+
+// Signed distance to a box, centered at the origin.
+// @param b: half size
+float sd_box(vec2 p, vec2 b) {
+    vec2 d = abs(p) - b;
+    return length(max(d, vec2_splat(0.0))) + min(max(d.x, d.y), 0.0);
+}
+
+// Signed distance to an ellipse, centered at the origin (a close approximation, good near the edge).
+// @param r: radii
+float sd_ellipse(vec2 p, vec2 r) {
+    r = max(r, vec2_splat(1e-6));
+    float k0 = length(p / r);
+    float k1 = length(p / (r * r));
+    return k0 * (k0 - 1.0) / max(k1, 1e-6);
+}
+
+// Signed distance to a segment along the x axis, rounded.
+// @param half_length: half the length of the segment
+// @param radius: how far out from it the edge is
+float sd_capsule(vec2 p, float half_length, float radius) {
+    p.x -= clamp(p.x, -half_length, half_length);
+    return length(p) - radius;
+}
+
+void main()
+{
+    vec2 p = v_texcoord0;
+    vec2 half_size = v_shape.xy;
+    float radius = v_shape.z;
+    float kind = v_shape.w;
+
+    float d;
+    if (kind < SHAPE_RECT - 0.5) {
+        d = sd_capsule(p, half_size.x - radius, radius);
+    } else if (kind < SHAPE_ELLIPSE - 0.5) {
+        d = sd_box(p, half_size);
+    } else {
+        d = sd_ellipse(p, half_size);
+    }
+
+    // Antialiased over about a pixel, whatever the zoom.
+    float coverage = clamp(0.5 - d / max(fwidth(d), 1e-6), 0.0, 1.0);
+
+	gl_FragColor = vec4(v_color0.rgb, v_color0.a * coverage);
+}
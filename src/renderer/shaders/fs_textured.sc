@@ -0,0 +1,10 @@
+$input v_texcoord0
+
+#include <bgfx_shader.sh>
+
+SAMPLER2D(s_texture, 0);
+
+void main()
+{
+	gl_FragColor = texture2D(s_texture, v_texcoord0);
+}
\ No newline at end of file
@@ -1,7 +0,0 @@
-uniform vec4 u_params[2];
-
-#define u_time            u_params[0].x
-#define u_zoom            u_params[0].y
-
-#define u_grid_major      u_params[1].z
-#define u_grid_minor      u_params[1].w
\ No newline at end of file
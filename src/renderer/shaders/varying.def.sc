@@ -1,5 +1,14 @@
 vec4 a_position  : POSITION;
 vec4 a_color0    : COLOR;
+vec2 a_texcoord0 : TEXCOORD0;
 
 vec4 v_color0    : COLOR
-   = vec4(1.0, 0.0, 0.0, 1.0);
\ No newline at end of file
+   = vec4(1.0, 0.0, 0.0, 1.0);
+vec2 v_texcoord0 : TEXCOORD0
+   = vec2(0.0, 0.0);
+vec4 v_shape     : TEXCOORD1
+   = vec4(0.0, 0.0, 0.0, 0.0);
+
+vec4 i_data0     : TEXCOORD7;
+vec4 i_data1     : TEXCOORD6;
+vec4 i_data2     : TEXCOORD5;
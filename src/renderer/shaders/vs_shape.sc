@@ -0,0 +1,23 @@
+$input a_position, i_data0, i_data1, i_data2
+$output v_color0, v_texcoord0, v_shape
+
+#include <bgfx_shader.sh>
+#include "uniforms.sh"
+
+void main()
+{
+    // Each instance is a box: its center and half size (i_data0), its x axis (i_data1.xy),
+    // the shape's radius and kind (i_data1.zw), and its color (i_data2).
+    vec2 center = i_data0.xy;
+    vec2 half_size = i_data0.zw;
+    vec2 axis = i_data1.xy;
+
+    // Grown by a pixel and a half (of the back buffer's), so the shape's edge can fade out inside the quad.
+    vec2 local = a_position.xy * (half_size + vec2_splat(1.5 / (u_zoom * u_content_scale)));
+    vec2 xy = center + local.x * axis + local.y * vec2(-axis.y, axis.x);
+
+	gl_Position = mul(u_modelViewProj, vec4(xy, 0.0, 1.0));
+	v_color0 = i_data2;
+	v_texcoord0 = local;
+	v_shape = vec4(half_size, i_data1.zw);
+}
@@ -0,0 +1,393 @@
+//
+// Created by Dylan Lukes on 8/20/23.
+//
+// The tessellator walks the (deduplicated) points of a stroke once. Each segment becomes
+// a quad between a pair of vertices (left, right) at either end. Where segments meet, the
+// outer corner is filled with a miter, a bevel triangle, or a fan around the point. The
+// inner corner is left to the overlap of the two quads.
+
+#include "neopad/internal/renderer/stroke.h"
+
+#include <math.h>
+#include <string.h>
+#include <cglm/vec2.h>
+
+/// A pair of vertex indices either side of a point on the stroke.
+typedef struct {
+    uint32_t l;
+    uint32_t r;
+} pair_t;
+
+#pragma mark - Emission
+
+static uint32_t emit_vertex(neopad_stroke_stream_t *t, vec2 p) {
+    neopad_renderer_vertex_t *v = &t->vertices[t->size.vertex_count];
+    v->xyzw[0] = p[0];
+    v->xyzw[1] = p[1];
+    v->xyzw[2] = 0.0f;
+    v->xyzw[3] = 1.0f;
+    v->argb = t->style.color;
+    return t->base_vertex + t->size.vertex_count++;
+}
+
+static void emit_triangle(neopad_stroke_stream_t *t, uint32_t a, uint32_t b, uint32_t c) {
+    uint32_t *i = &t->indices[t->size.index_count];
+    i[0] = a;
+    i[1] = b;
+    i[2] = c;
+    t->size.index_count += 3;
+}
+
+static void emit_quad(neopad_stroke_stream_t *t, pair_t from, pair_t to) {
+    emit_triangle(t, from.l, from.r, to.l);
+    emit_triangle(t, from.r, to.r, to.l);
+}
+
+/// Emit a pair of vertices at p + shift, offset either side along the normal n.
+static pair_t emit_pair(neopad_stroke_stream_t *t, vec2 p, vec2 n, float offset, vec2 shift) {
+    vec2 l, r;
+    glm_vec2_add(p, shift, l);
+    glm_vec2_copy(l, r);
+    glm_vec2_muladds(n, offset, l);
+    glm_vec2_muladds(n, -offset, r);
+    return (pair_t) {emit_vertex(t, l), emit_vertex(t, r)};
+}
+
+/// Emit a triangle fan around center, sweeping from `from` by `angle` radians to `to`.
+/// @param from_offset The offset of `from` from the center.
+static void emit_fan(neopad_stroke_stream_t *t, vec2 center, uint32_t center_index,
+                     uint32_t from, vec2 from_offset, float angle, uint32_t to) {
+    int steps = (int) ceilf(fabsf(angle) / (GLM_PIf / NEOPAD_STROKE_ROUND_SEGMENTS));
+    steps = steps < 1 ? 1 : steps > NEOPAD_STROKE_ROUND_SEGMENTS ? NEOPAD_STROKE_ROUND_SEGMENTS : steps;
+
+    uint32_t prev = from;
+    for (int k = 1; k < steps; k++) {
+        float a = angle * (float) k / (float) steps;
+        float c = cosf(a), s = sinf(a);
+        vec2 p = {
+                center[0] + from_offset[0] * c - from_offset[1] * s,
+                center[1] + from_offset[0] * s + from_offset[1] * c,
+        };
+        uint32_t next = emit_vertex(t, p);
+        emit_triangle(t, center_index, prev, next);
+        prev = next;
+    }
+    emit_triangle(t, center_index, prev, to);
+}
+
+#pragma mark - Geometry
+
+static void direction(vec2 a, vec2 b, vec2 d, vec2 n) {
+    glm_vec2_sub(b, a, d);
+    glm_vec2_normalize(d);
+    // Left-hand normal (d rotated by +90 degrees).
+    n[0] = -d[1];
+    n[1] = d[0];
+}
+
+#pragma mark - Caps and Joins
+
+static pair_t start_cap(neopad_stroke_stream_t *t, vec2 p, vec2 d, vec2 n) {
+    float hw = t->half_width;
+    vec2 shift = {0.0f, 0.0f};
+
+    if (t->style.cap == NEOPAD_STROKE_CAP_SQUARE) {
+        glm_vec2_scale(d, -hw, shift);
+    }
+
+    pair_t pair = emit_pair(t, p, n, hw, shift);
+
+    if (t->style.cap == NEOPAD_STROKE_CAP_ROUND) {
+        // Sweep from the left side, around the back, to the right side.
+        vec2 offset;
+        glm_vec2_scale(n, hw, offset);
+        uint32_t center = emit_vertex(t, p);
+        emit_fan(t, p, center, pair.l, offset, GLM_PIf, pair.r);
+    }
+
+    return pair;
+}
+
+static void end_cap(neopad_stroke_stream_t *t, pair_t prev, vec2 p, vec2 d, vec2 n) {
+    float hw = t->half_width;
+    vec2 shift = {0.0f, 0.0f};
+
+    if (t->style.cap == NEOPAD_STROKE_CAP_SQUARE) {
+        glm_vec2_scale(d, hw, shift);
+    }
+
+    pair_t pair = emit_pair(t, p, n, hw, shift);
+    emit_quad(t, prev, pair);
+
+    if (t->style.cap == NEOPAD_STROKE_CAP_ROUND) {
+        // Sweep from the right side, around the front, to the left side.
+        vec2 offset;
+        glm_vec2_scale(n, -hw, offset);
+        uint32_t center = emit_vertex(t, p);
+        emit_fan(t, p, center, pair.r, offset, GLM_PIf, pair.l);
+    }
+}
+
+static pair_t join(neopad_stroke_stream_t *t, pair_t prev, vec2 p,
+                   vec2 d0, vec2 n0, vec2 d1, vec2 n1) {
+    vec2 no_shift = {0.0f, 0.0f};
+    float hw = t->half_width;
+
+    float cross = d0[0] * d1[1] - d0[1] * d1[0];
+    float dot = glm_vec2_dot(d0, d1);
+
+    // (Nearly) straight on: no join needed.
+    if (fabsf(cross) < 1e-4f && dot > 0.0f) {
+        pair_t pair = emit_pair(t, p, n1, hw, no_shift);
+        emit_quad(t, prev, pair);
+        return pair;
+    }
+
+    if (t->style.join == NEOPAD_STROKE_JOIN_MITER) {
+        vec2 miter;
+        glm_vec2_add(n0, n1, miter);
+        glm_vec2_normalize(miter);
+        float cos_half = glm_vec2_dot(miter, n1);
+        if (cos_half > 1e-4f && 1.0f / cos_half <= t->style.miter_limit) {
+            pair_t pair = emit_pair(t, p, miter, hw / cos_half, no_shift);
+            emit_quad(t, prev, pair);
+            return pair;
+        }
+    }
+
+    // Bevel or round: end the incoming segment, and start the outgoing one, at p.
+    pair_t in = emit_pair(t, p, n0, hw, no_shift);
+    emit_quad(t, prev, in);
+    pair_t out = emit_pair(t, p, n1, hw, no_shift);
+    uint32_t center = emit_vertex(t, p);
+
+    // Turning left, the outer corner is on the right (and vice versa).
+    bool left_turn = cross > 0.0f;
+    uint32_t from = left_turn ? in.r : in.l;
+    uint32_t to = left_turn ? out.r : out.l;
+
+    if (t->style.join == NEOPAD_STROKE_JOIN_ROUND) {
+        vec2 offset;
+        glm_vec2_scale(n0, left_turn ? -hw : hw, offset);
+        emit_fan(t, p, center, from, offset, atan2f(cross, dot), to);
+    } else {
+        emit_triangle(t, center, from, to);
+    }
+
+    return out;
+}
+
+static void emit_dot(neopad_stroke_stream_t *t, vec2 p) {
+    float hw = t->half_width;
+
+    switch (t->style.cap) {
+        case NEOPAD_STROKE_CAP_BUTT:
+            // A zero-length stroke with butt caps has no area.
+            break;
+        case NEOPAD_STROKE_CAP_SQUARE: {
+            vec2 n = {0.0f, 1.0f};
+            pair_t back = emit_pair(t, p, n, hw, (vec2) {-hw, 0.0f});
+            pair_t front = emit_pair(t, p, n, hw, (vec2) {hw, 0.0f});
+            emit_quad(t, back, front);
+            break;
+        }
+        case NEOPAD_STROKE_CAP_ROUND: {
+            // Two half-discs, back to back.
+            vec2 n = {0.0f, 1.0f};
+            pair_t pair = emit_pair(t, p, n, hw, (vec2) {0.0f, 0.0f});
+            uint32_t center = emit_vertex(t, p);
+            emit_fan(t, p, center, pair.l, (vec2) {0.0f, hw}, GLM_PIf, pair.r);
+            emit_fan(t, p, center, pair.r, (vec2) {0.0f, -hw}, GLM_PIf, pair.l);
+            break;
+        }
+    }
+}
+
+#pragma mark - Public
+
+neopad_stroke_size_t neopad_stroke_measure(size_t count, const neopad_stroke_style_t *style) {
+    const uint32_t segments = NEOPAD_STROKE_ROUND_SEGMENTS;
+
+    if (count == 0 || style->width <= 0.0f) {
+        return (neopad_stroke_size_t) {0, 0};
+    }
+
+    // Enough for a round dot: a pair, a center, and two fans.
+    if (count == 1) {
+        return (neopad_stroke_size_t) {
+                .vertex_count = 3 + 2 * (segments - 1),
+                .index_count = 3 * 2 * segments,
+        };
+    }
+
+    // Caps: a pair, a center, and a fan, each. Joins: two pairs, a center, and a fan, each.
+    // Every segment contributes one quad. A round dot (all points coincident) fits in this too.
+    uint32_t n = (uint32_t) count;
+    return (neopad_stroke_size_t) {
+            .vertex_count = 2 * (segments + 2) + (n - 2) * (segments + 4),
+            .index_count = 6 * (n - 1) + 3 * segments * (n - 2) + 2 * 3 * segments,
+    };
+}
+
+neopad_stroke_size_t neopad_stroke_tessellate(const neopad_vec2_t *points,
+                                              size_t count,
+                                              const neopad_stroke_style_t *style,
+                                              uint32_t base_vertex,
+                                              neopad_renderer_vertex_t *vertices,
+                                              uint32_t *indices) {
+    neopad_stroke_stream_t stream;
+    neopad_stroke_stream_begin(&stream, style, base_vertex);
+    stream.vertices = vertices;
+    stream.indices = indices;
+
+    for (size_t i = 0; i < count; i++) {
+        vec2 p = {points[i].x, points[i].y};
+        neopad_stroke_stream_push(&stream, p);
+    }
+
+    neopad_stroke_size_t tail = neopad_stroke_stream_finish(
+            &stream,
+            &vertices[stream.size.vertex_count],
+            &indices[stream.size.index_count]);
+
+    return (neopad_stroke_size_t) {
+            .vertex_count = stream.size.vertex_count + tail.vertex_count,
+            .index_count = stream.size.index_count + tail.index_count,
+    };
+}
+
+/// Squared distance from p to the segment ab.
+static float segment_distance2(const neopad_vec2_t *p, const neopad_vec2_t *a, const neopad_vec2_t *b) {
+    float dx = b->x - a->x;
+    float dy = b->y - a->y;
+    float px = p->x - a->x;
+    float py = p->y - a->y;
+
+    float len2 = dx * dx + dy * dy;
+    if (len2 > 0.0f) {
+        float u = (px * dx + py * dy) / len2;
+        u = u < 0.0f ? 0.0f : u > 1.0f ? 1.0f : u;
+        px -= u * dx;
+        py -= u * dy;
+    }
+    return px * px + py * py;
+}
+
+size_t neopad_stroke_simplify(const neopad_vec2_t *points,
+                              size_t count,
+                              float tolerance,
+                              uint32_t *scratch,
+                              neopad_vec2_t *out) {
+    if (count <= 2) {
+        memcpy(out, points, count * sizeof(neopad_vec2_t));
+        return count;
+    }
+
+    const float tolerance2 = tolerance * tolerance;
+    size_t written = 0;
+
+    // Spans (first, last) still to be looked at, as a stack. The leftmost span is always on top,
+    // so spans are finished in order, and each one finished emits its first point.
+    uint32_t *stack = scratch;
+    size_t top = 0;
+    stack[top++] = (uint32_t) count - 1;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        uint32_t first = stack[--top];
+        uint32_t last = stack[--top];
+
+        float farthest2 = 0.0f;
+        uint32_t farthest = first;
+        for (uint32_t i = first + 1; i < last; i++) {
+            float d2 = segment_distance2(&points[i], &points[first], &points[last]);
+            if (d2 > farthest2) {
+                farthest2 = d2;
+                farthest = i;
+            }
+        }
+
+        if (farthest2 > tolerance2) {
+            stack[top++] = last;
+            stack[top++] = farthest;
+            stack[top++] = farthest;
+            stack[top++] = first;
+        } else {
+            out[written++] = points[first];
+        }
+    }
+
+    out[written++] = points[count - 1];
+    return written;
+}
+
+void neopad_stroke_stream_begin(neopad_stroke_stream_t *stream,
+                                const neopad_stroke_style_t *style,
+                                uint32_t base_vertex) {
+    float half_width = style->width / 2.0f;
+
+    // Points closer than this to their predecessor are dropped; they only add noise.
+    float epsilon = 0.01f * half_width;
+
+    *stream = (neopad_stroke_stream_t) {
+            .style = *style,
+            .half_width = half_width,
+            .epsilon2 = epsilon * epsilon,
+            .base_vertex = base_vertex,
+            .vertices = NULL,
+            .indices = NULL,
+            .size = {0, 0},
+            .count = 0,
+    };
+}
+
+bool neopad_stroke_stream_push(neopad_stroke_stream_t *stream, vec2 p) {
+    if (stream->style.width <= 0.0f) {
+        return false;
+    }
+
+    if (stream->count > 0 && glm_vec2_distance2(stream->last, p) <= stream->epsilon2) {
+        return false;
+    }
+
+    if (stream->count == 1) {
+        // Now that there is a direction, the start cap can be emitted.
+        direction(stream->last, p, stream->d_in, stream->n_in);
+        pair_t pair = start_cap(stream, stream->last, stream->d_in, stream->n_in);
+        stream->prev_l = pair.l;
+        stream->prev_r = pair.r;
+    } else if (stream->count > 1) {
+        vec2 d_out, n_out;
+        direction(stream->last, p, d_out, n_out);
+        pair_t prev = {stream->prev_l, stream->prev_r};
+        pair_t pair = join(stream, prev, stream->last, stream->d_in, stream->n_in, d_out, n_out);
+        stream->prev_l = pair.l;
+        stream->prev_r = pair.r;
+        glm_vec2_copy(d_out, stream->d_in);
+        glm_vec2_copy(n_out, stream->n_in);
+    }
+
+    glm_vec2_copy(p, stream->last);
+    stream->count++;
+    return true;
+}
+
+neopad_stroke_size_t neopad_stroke_stream_finish(const neopad_stroke_stream_t *stream,
+                                                 neopad_renderer_vertex_t *vertices,
+                                                 uint32_t *indices) {
+    // Emit through a copy of the stream, redirected to the given memory.
+    neopad_stroke_stream_t t = *stream;
+    t.base_vertex = stream->base_vertex + stream->size.vertex_count;
+    t.vertices = vertices;
+    t.indices = indices;
+    t.size = (neopad_stroke_size_t) {0, 0};
+
+    if (stream->count == 1) {
+        emit_dot(&t, t.last);
+    } else if (stream->count > 1) {
+        pair_t prev = {t.prev_l, t.prev_r};
+        end_cap(&t, prev, t.last, t.d_in, t.n_in);
+    }
+
+    return t.size;
+}
@@ -0,0 +1,390 @@
+//
+// Created by Dylan Lukes on 8/27/23.
+//
+
+#include <cglm/affine.h>
+#include <cglm/cam.h>
+#include <math.h>
+#include <memory.h>
+#include <stdlib.h>
+
+#include "neopad/internal/log.h"
+#include "neopad/internal/rect.h"
+#include "neopad/internal/renderer.h"
+#include "neopad/internal/renderer/tiles.h"
+
+typedef struct neopad_tile_vertex_s {
+    float x, y, z;
+    float u, v;
+} neopad_tile_vertex_t;
+
+static const uint16_t QUAD_INDICES[] = {
+        0, 1, 2,
+        0, 2, 3,
+};
+
+/// Names of the tile passes (and their views).
+static const char *PASS_NAMES[NEOPAD_TILE_RENDERS_PER_FRAME] = {
+        "tile 0", "tile 1", "tile 2", "tile 3", "tile 4", "tile 5", "tile 6", "tile 7",
+        "tile 8", "tile 9", "tile 10", "tile 11", "tile 12", "tile 13", "tile 14", "tile 15",
+};
+
+static const uint64_t COMPOSITE_STATE = BGFX_STATE_WRITE_RGB
+                                        | BGFX_STATE_WRITE_A
+                                        | BGFX_STATE_MSAA
+                                        | BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE,
+                                                                BGFX_STATE_BLEND_INV_SRC_ALPHA);
+
+#pragma mark - Geometry
+
+/// Size of a tile at a level, in pad-world units.
+static inline double tile_size(const neopad_tile_cache_t *this, int32_t level) {
+    return (double) NEOPAD_TILE_TEXELS / ((double) this->content_scale * ldexp(1.0, level));
+}
+
+static void tile_rect(const neopad_tile_cache_t *this, int32_t level, int64_t x, int64_t y, rect_t *dst) {
+    double size = tile_size(this, level);
+    dst->min[0] = (float) ((double) x * size);
+    dst->min[1] = (float) ((double) y * size);
+    dst->max[0] = (float) ((double) (x + 1) * size);
+    dst->max[1] = (float) ((double) (y + 1) * size);
+}
+
+#pragma mark - Slots
+
+/// Most tiles a back buffer can show: at the level nearest the zoom, a tile is at least
+/// NEOPAD_TILE_TEXELS / √2 pixels across, and the view may straddle one more each way.
+static uint32_t tiles_in_view(uint32_t width, uint32_t height) {
+    const double min_size = (double) NEOPAD_TILE_TEXELS / GLM_SQRT2;
+    const uint32_t columns = (uint32_t) ceil((double) width / min_size) + 1;
+    const uint32_t rows = (uint32_t) ceil((double) height / min_size) + 1;
+    return columns * rows;
+}
+
+/// Grow the pool to twice what the back buffer can show (so there are tiles to spare for panning).
+static void fit(neopad_tile_cache_t *this, uint32_t width, uint32_t height) {
+    if (this->tiles && width == this->width && height == this->height) {
+        return;
+    }
+    this->width = width;
+    this->height = height;
+
+    uint32_t capacity = 2 * tiles_in_view(width, height);
+    if (capacity < NEOPAD_TILE_POOL) {
+        capacity = NEOPAD_TILE_POOL;
+    }
+    if (capacity <= this->capacity) {
+        return;
+    }
+
+    neopad_tile_t *tiles = realloc(this->tiles, capacity * sizeof(neopad_tile_t));
+    if (!tiles) {
+        eprintf("Out of memory for %u tiles.\n", capacity);
+        return;
+    }
+    this->tiles = tiles;
+    neopad_tile_t **visible = realloc(this->visible, capacity * sizeof(neopad_tile_t *));
+    if (!visible) {
+        eprintf("Out of memory for %u tiles.\n", capacity);
+        return;
+    }
+    this->visible = visible;
+
+    for (uint32_t i = this->capacity; i < capacity; i++) {
+        this->tiles[i] = (neopad_tile_t) {.framebuffer = BGFX_INVALID_HANDLE};
+    }
+    this->capacity = capacity;
+}
+
+static neopad_tile_t *find(neopad_tile_cache_t *this, int32_t level, int64_t x, int64_t y) {
+    for (uint32_t i = 0; i < this->capacity; i++) {
+        neopad_tile_t *tile = &this->tiles[i];
+        if (tile->is_valid && tile->level == level && tile->x == x && tile->y == y) {
+            return tile;
+        }
+    }
+    return NULL;
+}
+
+/// Take the least recently used slot not in use this frame.
+/// @return The slot (invalid, with a framebuffer), or NULL if every slot is in use.
+static neopad_tile_t *take(neopad_tile_cache_t *this) {
+    neopad_tile_t *oldest = NULL;
+    for (uint32_t i = 0; i < this->capacity; i++) {
+        neopad_tile_t *tile = &this->tiles[i];
+        if (!tile->is_valid) {
+            oldest = tile;
+            break;
+        }
+        if (tile->last_used != this->frame && (!oldest || tile->last_used < oldest->last_used)) {
+            oldest = tile;
+        }
+    }
+    if (!oldest) {
+        return NULL;
+    }
+
+    if (!BGFX_HANDLE_IS_VALID(oldest->framebuffer)) {
+        oldest->framebuffer = bgfx_create_frame_buffer(
+                NEOPAD_TILE_TEXELS, NEOPAD_TILE_TEXELS,
+                BGFX_TEXTURE_FORMAT_BGRA8,
+                BGFX_TEXTURE_RT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP);
+    }
+    oldest->is_valid = false;
+    return oldest;
+}
+
+#pragma mark - Lifecycle
+
+void neopad_tile_cache_init(neopad_tile_cache_t *this) {
+    memset(this, 0, sizeof(neopad_tile_cache_t));
+    for (uint32_t i = 0; i < NEOPAD_TILE_RENDERS_PER_FRAME; i++) {
+        this->passes[i] = NEOPAD_RENDERER_PASS_NONE;
+    }
+    this->composite = NEOPAD_RENDERER_PASS_NONE;
+    this->vbo = (bgfx_vertex_buffer_handle_t) BGFX_INVALID_HANDLE;
+    this->ibo = (bgfx_index_buffer_handle_t) BGFX_INVALID_HANDLE;
+    this->sampler = (bgfx_uniform_handle_t) BGFX_INVALID_HANDLE;
+}
+
+void neopad_tile_cache_setup(neopad_tile_cache_t *this, neopad_renderer_t renderer) {
+    // Tiles are drawn before everything else, each into a framebuffer assigned as it is drawn.
+    for (uint32_t i = 0; i < NEOPAD_TILE_RENDERS_PER_FRAME; i++) {
+        this->passes[i] = neopad_renderer_declare_pass(renderer, &(neopad_renderer_pass_desc_t) {
+                .name = PASS_NAMES[i],
+                .order = NEOPAD_RENDERER_ORDER_OFFSCREEN,
+                .output = BGFX_INVALID_HANDLE,
+                .width = NEOPAD_TILE_TEXELS,
+                .height = NEOPAD_TILE_TEXELS,
+                .transform = NEOPAD_RENDERER_PASS_TRANSFORM_CUSTOM,
+                .clear_flags = BGFX_CLEAR_COLOR,
+                .clear_color = 0x00000000,
+        });
+    }
+    neopad_renderer_pass_desc_t composite = neopad_renderer_content_pass_desc();
+    this->composite = neopad_renderer_declare_pass(renderer, &composite);
+
+    renderer->programs[NEOPAD_PROGRAM_TEXTURED] = bgfx_create_embedded_program(
+            embedded_shaders,
+            bgfx_get_renderer_type(),
+            "vs_textured",
+            "fs_textured",
+            NULL);
+    this->sampler = bgfx_create_uniform("s_texture", BGFX_UNIFORM_TYPE_SAMPLER, 1);
+
+    bgfx_vertex_layout_begin(&this->layout, BGFX_RENDERER_TYPE_NOOP);
+    bgfx_vertex_layout_add(&this->layout, BGFX_ATTRIB_POSITION, 3, BGFX_ATTRIB_TYPE_FLOAT, false, false);
+    bgfx_vertex_layout_add(&this->layout, BGFX_ATTRIB_TEXCOORD0, 2, BGFX_ATTRIB_TYPE_FLOAT, false, false);
+    bgfx_vertex_layout_end(&this->layout);
+
+    // Tiles are drawn y-up, so their bottom row is first in memory only where textures start at
+    // the bottom left (OpenGL); elsewhere, the quad samples them flipped.
+    const bgfx_caps_t *caps = bgfx_get_caps();
+    float bottom = caps->originBottomLeft ? 0.0f : 1.0f;
+    float top = 1.0f - bottom;
+    const neopad_tile_vertex_t vertices[] = {
+            {0.0f, 0.0f, 0.0f, 0.0f, bottom},
+            {1.0f, 0.0f, 0.0f, 1.0f, bottom},
+            {1.0f, 1.0f, 0.0f, 1.0f, top},
+            {0.0f, 1.0f, 0.0f, 0.0f, top},
+    };
+    this->vbo = bgfx_create_vertex_buffer(bgfx_copy(vertices, sizeof(vertices)), &this->layout, BGFX_BUFFER_NONE);
+    this->ibo = bgfx_create_index_buffer(bgfx_make_ref(QUAD_INDICES, sizeof(QUAD_INDICES)), BGFX_BUFFER_NONE);
+
+    this->content_scale = renderer->content_scale;
+}
+
+void neopad_tile_cache_teardown(neopad_tile_cache_t *this, neopad_renderer_t renderer) {
+    for (uint32_t i = 0; i < this->capacity; i++) {
+        if (BGFX_HANDLE_IS_VALID(this->tiles[i].framebuffer)) {
+            bgfx_destroy_frame_buffer(this->tiles[i].framebuffer);
+        }
+    }
+    free(this->tiles);
+    free(this->visible);
+    this->tiles = NULL;
+    this->visible = NULL;
+    this->capacity = 0;
+
+    bgfx_destroy_index_buffer(this->ibo);
+    bgfx_destroy_vertex_buffer(this->vbo);
+    bgfx_destroy_uniform(this->sampler);
+    bgfx_destroy_program(renderer->programs[NEOPAD_PROGRAM_TEXTURED]);
+
+    neopad_renderer_release_pass(renderer, this->composite);
+    for (uint32_t i = 0; i < NEOPAD_TILE_RENDERS_PER_FRAME; i++) {
+        neopad_renderer_release_pass(renderer, this->passes[i]);
+        this->passes[i] = NEOPAD_RENDERER_PASS_NONE;
+    }
+    this->composite = NEOPAD_RENDERER_PASS_NONE;
+}
+
+#pragma mark - Invalidation
+
+void neopad_tile_cache_invalidate(neopad_tile_cache_t *this, const rect_t *area) {
+    for (uint32_t i = 0; i < this->capacity; i++) {
+        neopad_tile_t *tile = &this->tiles[i];
+        if (!tile->is_valid) {
+            continue;
+        }
+        rect_t rect;
+        tile_rect(this, tile->level, tile->x, tile->y, &rect);
+        if (rect_overlaps(&rect, area)) {
+            tile->is_dirty = true;
+        }
+    }
+}
+
+void neopad_tile_cache_invalidate_all(neopad_tile_cache_t *this) {
+    for (uint32_t i = 0; i < this->capacity; i++) {
+        this->tiles[i].is_dirty = true;
+    }
+}
+
+#pragma mark - Drawing
+
+/// Rasterize a tile, in the given pass.
+static void render(neopad_tile_cache_t *this,
+                   neopad_renderer_t renderer,
+                   neopad_renderer_pass_id_t pass,
+                   const neopad_tile_t *tile,
+                   const neopad_tile_source_t *source) {
+    double size = tile_size(this, tile->level);
+    rect_t area;
+    tile_rect(this, tile->level, tile->x, tile->y, &area);
+    neopad_dvec2_t base = {(double) tile->x * size, (double) tile->y * size};
+
+    neopad_renderer_set_pass_output(renderer, pass, tile->framebuffer, NEOPAD_TILE_TEXELS, NEOPAD_TILE_TEXELS);
+    bgfx_view_id_t view = neopad_renderer_use_pass(renderer, pass);
+    if (view == NEOPAD_RENDERER_VIEW_NONE) {
+        return;
+    }
+
+    // Tile-relative pad-world coordinates, [0, size), fill the tile.
+    mat4 identity, proj;
+    glm_mat4_identity(identity);
+    glm_ortho(0.0f, (float) size, 0.0f, (float) size, -1.0f, 1.0f, proj);
+    bgfx_set_view_transform(view, identity, proj);
+
+    source->draw(source->context, renderer, view, &area, base, (float) ldexp(1.0, tile->level));
+}
+
+/// Draw a tile, as a quad over its area, in the composite pass.
+static void composite(neopad_tile_cache_t *this,
+                      neopad_renderer_t renderer,
+                      const neopad_tile_t *tile,
+                      neopad_profile_counters_t *counters) {
+    double size = tile_size(this, tile->level);
+
+    // Camera-relative, as for neopad_renderer_set_origin.
+    mat4 model;
+    glm_translate_make(model, (vec3) {
+            (float) ((double) tile->x * size + renderer->camera.x),
+            (float) ((double) tile->y * size + renderer->camera.y),
+            0.0f});
+    glm_scale(model, (vec3) {(float) size, (float) size, 1.0f});
+    bgfx_set_transform(model, 1);
+
+    bgfx_set_vertex_buffer(0, this->vbo, 0, 4);
+    bgfx_set_index_buffer(this->ibo, 0, 6);
+    bgfx_set_texture(0, this->sampler, bgfx_get_texture(tile->framebuffer, 0), UINT32_MAX);
+    bgfx_set_state(COMPOSITE_STATE, 0);
+    neopad_renderer_submit_pass(renderer, this->composite, renderer->programs[NEOPAD_PROGRAM_TEXTURED]);
+
+    counters->draw_calls++;
+    counters->vertices += 4;
+    counters->indices += 6;
+}
+
+bool neopad_tile_cache_draw(neopad_tile_cache_t *this,
+                            neopad_renderer_t renderer,
+                            const neopad_tile_source_t *source,
+                            neopad_profile_counters_t *counters) {
+    if (this->content_scale != renderer->content_scale) {
+        this->content_scale = renderer->content_scale;
+        neopad_tile_cache_invalidate_all(this);
+    }
+
+    // The level nearest the zoom, so tiles are scaled by at most √2 either way.
+    int32_t level = (int32_t) lroundf(log2f(renderer->zoom));
+    if (level < NEOPAD_TILE_MIN_LEVEL || level > NEOPAD_TILE_MAX_LEVEL) {
+        return false;
+    }
+
+    fit(this, renderer->width, renderer->height);
+    if (this->capacity == 0) {
+        return false;
+    }
+    this->frame++;
+
+    rect_t view;
+    neopad_renderer_get_frame_rect(renderer, &view);
+    double size = tile_size(this, level);
+    int64_t x0 = (int64_t) floor((double) view.min[0] / size);
+    int64_t y0 = (int64_t) floor((double) view.min[1] / size);
+    int64_t x1 = (int64_t) floor((double) view.max[0] / size);
+    int64_t y1 = (int64_t) floor((double) view.max[1] / size);
+
+    // Gather the tiles in view, drawing those that need it (as the budget allows).
+    neopad_tile_t **visible = this->visible;
+    uint32_t visible_count = 0;
+    uint32_t render_count = 0;
+    bool is_complete = true;
+
+    for (int64_t y = y0; y <= y1; y++) {
+        for (int64_t x = x0; x <= x1; x++) {
+            rect_t area;
+            tile_rect(this, level, x, y, &area);
+            if (source->is_empty(source->context, &area)) {
+                continue;
+            }
+
+            neopad_tile_t *tile = find(this, level, x, y);
+            if (tile && !tile->is_dirty) {
+                tile->last_used = this->frame;
+                visible[visible_count++] = tile;
+                continue;
+            }
+
+            if (render_count == NEOPAD_TILE_RENDERS_PER_FRAME) {
+                is_complete = false;
+                continue;
+            }
+            if (!tile) {
+                tile = take(this);
+                if (!tile) {
+                    // Every tile is in view already.
+                    if (!this->is_short) {
+                        eprintf("The view needs more tiles than the pool holds (%u); drawing live.\n",
+                                this->capacity);
+                        this->is_short = true;
+                    }
+                    is_complete = false;
+                    continue;
+                }
+            }
+
+            *tile = (neopad_tile_t) {
+                    .level = level,
+                    .x = x,
+                    .y = y,
+                    .is_valid = true,
+                    .is_dirty = false,
+                    .last_used = this->frame,
+                    .framebuffer = tile->framebuffer,
+            };
+            render(this, renderer, this->passes[render_count++], tile, source);
+            visible[visible_count++] = tile;
+        }
+    }
+
+    if (!is_complete) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < visible_count; i++) {
+        composite(this, renderer, visible[i], counters);
+    }
+    counters->visible += visible_count;
+    return true;
+}
@@ -0,0 +1,75 @@
+//
+// Created by Dylan Lukes on 8/30/23.
+//
+
+#include <memory.h>
+
+#include "neopad/internal/renderer/uniforms.h"
+
+/// Each block's uniform name, and size (in vec4s).
+static const char *BLOCK_NAMES[NEOPAD_UNIFORM_BLOCK_COUNT] = {
+#define BLOCK_NAME(ID, name, size) [NEOPAD_UNIFORM_BLOCK_##ID] = "u_" #name,
+        NEOPAD_UNIFORMS(BLOCK_NAME, NEOPAD_UNIFORM_SKIP)
+#undef BLOCK_NAME
+};
+
+static const uint16_t BLOCK_SIZES[NEOPAD_UNIFORM_BLOCK_COUNT] = {
+#define BLOCK_SIZE(ID, name, size) [NEOPAD_UNIFORM_BLOCK_##ID] = (size),
+        NEOPAD_UNIFORMS(BLOCK_SIZE, NEOPAD_UNIFORM_SKIP)
+#undef BLOCK_SIZE
+};
+
+static const uint16_t BLOCK_BASES[NEOPAD_UNIFORM_BLOCK_COUNT] = {
+#define BLOCK_BASE(ID, name, size) [NEOPAD_UNIFORM_BLOCK_##ID] = NEOPAD_UNIFORM_BASE_##ID,
+        NEOPAD_UNIFORMS(BLOCK_BASE, NEOPAD_UNIFORM_SKIP)
+#undef BLOCK_BASE
+};
+
+/// Each field's block and number of components, by where it is.
+static const uint8_t FIELD_BLOCKS[NEOPAD_UNIFORM_FLOATS] = {
+#define FIELD_BLOCK(BLOCK, ID, name, offset, components) [NEOPAD_UNIFORM_##ID] = NEOPAD_UNIFORM_BLOCK_##BLOCK,
+        NEOPAD_UNIFORMS(NEOPAD_UNIFORM_SKIP, FIELD_BLOCK)
+#undef FIELD_BLOCK
+};
+
+static const uint8_t FIELD_COMPONENTS[NEOPAD_UNIFORM_FLOATS] = {
+#define FIELD_COMPONENT_COUNT(BLOCK, ID, name, offset, components) [NEOPAD_UNIFORM_##ID] = (components),
+        NEOPAD_UNIFORMS(NEOPAD_UNIFORM_SKIP, FIELD_COMPONENT_COUNT)
+#undef FIELD_COMPONENT_COUNT
+};
+
+// Fields stay within a vec4 (so the generated swizzles are valid).
+#define CHECK_FIELD(BLOCK, ID, name, offset, components) \
+    _Static_assert((offset) % 4 + (components) <= 4, "Uniform " #name " crosses a vec4");
+NEOPAD_UNIFORMS(NEOPAD_UNIFORM_SKIP, CHECK_FIELD)
+#undef CHECK_FIELD
+
+void neopad_uniforms_setup(neopad_uniforms_t *this) {
+    memset(this->values, 0, sizeof(this->values));
+    for (uint32_t i = 0; i < NEOPAD_UNIFORM_BLOCK_COUNT; i++) {
+        this->handles[i] = bgfx_create_uniform(BLOCK_NAMES[i], BGFX_UNIFORM_TYPE_VEC4, BLOCK_SIZES[i]);
+    }
+    neopad_uniforms_invalidate(this);
+}
+
+void neopad_uniforms_teardown(neopad_uniforms_t *this) {
+    for (uint32_t i = 0; i < NEOPAD_UNIFORM_BLOCK_COUNT; i++) {
+        bgfx_destroy_uniform(this->handles[i]);
+    }
+}
+
+void neopad_uniforms_set(neopad_uniforms_t *this, neopad_uniform_t field, const float *value) {
+    size_t size = FIELD_COMPONENTS[field] * sizeof(float);
+    if (memcmp(&this->values[field], value, size) != 0) {
+        memcpy(&this->values[field], value, size);
+        this->dirty |= UINT32_C(1) << FIELD_BLOCKS[field];
+    }
+}
+
+void neopad_uniforms_upload(neopad_uniforms_t *this) {
+    for (uint32_t dirty = this->dirty; dirty != 0; dirty &= dirty - 1) {
+        int block = __builtin_ctz(dirty);
+        bgfx_set_uniform(this->handles[block], &this->values[BLOCK_BASES[block]], BLOCK_SIZES[block]);
+    }
+    this->dirty = 0;
+}
@@ -1,25 +1,709 @@
 //
 // Created by Dylan Lukes on 4/30/23.
 //
+// Finished strokes live on the GPU, in chunks: pairs of dynamic vertex/index buffers that
+// strokes are appended to exactly once, when they are finished. The stroke being drawn has
+// buffers of its own, which are appended to as points arrive; only its provisional end (the
+// last segment and end cap) is re-uploaded as it changes.
+//
+// Finished strokes are packed, where they fit: 16-bit positions relative to an origin near the
+// stroke, and 16-bit indices, 8 + 2 bytes a vertex rather than 20 + 4 (see neopad_renderer_packed_vertex_t).
 
 #include "neopad/renderer.h"
+#include "neopad/internal/log.h"
+#include "neopad/internal/rect.h"
+#include "neopad/internal/renderer.h"
+#include "neopad/internal/renderer/commands.h"
+#include "neopad/internal/renderer/stroke.h"
 #include "neopad/internal/renderer/vector.h"
 
+#include <math.h>
 #include <memory.h>
 
-void neopad_renderer_begin_points(neopad_renderer_t this, vec2 p) {
+static const neopad_stroke_style_t DEFAULT_STROKE_STYLE = {
+        .width = 2.0f,
+        .color = 0xFFFFFFFF,
+        .join = NEOPAD_STROKE_JOIN_ROUND,
+        .cap = NEOPAD_STROKE_CAP_ROUND,
+        .miter_limit = 4.0f,
+};
+
+static const uint64_t STROKE_STATE = BGFX_STATE_WRITE_RGB
+                                     | BGFX_STATE_WRITE_A
+                                     | BGFX_STATE_MSAA
+                                     | BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA,
+                                                             BGFX_STATE_BLEND_INV_SRC_ALPHA);
+
+static const uint64_t TILE_STROKE_STATE = BGFX_STATE_WRITE_RGB
+                                          | BGFX_STATE_WRITE_A
+                                          | NEOPAD_TILE_BLEND;
+
+static inline neopad_renderer_module_vector_t get_module(neopad_renderer_t renderer) {
+    return neopad_renderer_registry_get(&renderer->modules, renderer->builtin.vector).vector;
+}
+
+#pragma mark - Levels of Detail
+
+/// Level of detail to draw at a given zoom.
+static uint32_t lod_for_zoom(float zoom) {
+    uint32_t level = 0;
+    float threshold = 1.0f / NEOPAD_VECTOR_LOD_SCALE;
+    while (level + 1 < NEOPAD_VECTOR_LOD_LEVELS && zoom <= threshold) {
+        level++;
+        threshold /= NEOPAD_VECTOR_LOD_SCALE;
+    }
+    return level;
+}
+
+/// Deviation allowed at a level of detail, in pad-world units.
+/// @note A level is drawn at zooms of at most SCALE^-level, where one pad-world unit is at most
+///       SCALE^-level pixels.
+static float lod_tolerance(uint32_t level) {
+    return NEOPAD_VECTOR_LOD_TOLERANCE * powf(NEOPAD_VECTOR_LOD_SCALE, (float) level);
+}
+
+#pragma mark - Chunks
+
+/// Find (or create) a chunk for a tile (and quantum, if packed), with room for the given amount of geometry.
+static uint32_t reserve_chunk(vec_neopad_vector_chunk_t *chunks,
+                              neopad_renderer_t renderer,
+                              neopad_dvec2_t origin,
+                              float quantum,
+                              neopad_stroke_size_t size) {
+    // Most recent chunks first: strokes tend to be drawn near the last ones.
+    for (size_t i = chunks->size; i-- > 0;) {
+        neopad_vector_chunk_t *chunk = &chunks->vector[i];
+        if (chunk->origin.x == origin.x && chunk->origin.y == origin.y && chunk->quantum == quantum
+            && chunk->vertex_count + size.vertex_count <= chunk->vertex_capacity
+            && chunk->index_count + size.index_count <= chunk->index_capacity) {
+            return (uint32_t) i;
+        }
+    }
+
+    neopad_vector_chunk_t chunk = {
+            .origin = origin,
+            .quantum = quantum,
+            .vertex_count = 0,
+            .vertex_capacity = size.vertex_count > NEOPAD_VECTOR_CHUNK_VERTICES
+                               ? size.vertex_count : NEOPAD_VECTOR_CHUNK_VERTICES,
+            .index_count = 0,
+            .index_capacity = size.index_count > NEOPAD_VECTOR_CHUNK_INDICES
+                              ? size.index_count : NEOPAD_VECTOR_CHUNK_INDICES,
+            .bounds = RECT_EMPTY,
+    };
+    if (quantum > 0.0f) {
+        chunk.vbo = bgfx_create_dynamic_vertex_buffer(chunk.vertex_capacity, &renderer->packed_vertex_layout, BGFX_BUFFER_NONE);
+        chunk.ibo = bgfx_create_dynamic_index_buffer(chunk.index_capacity, BGFX_BUFFER_NONE);
+    } else {
+        chunk.vbo = bgfx_create_dynamic_vertex_buffer(chunk.vertex_capacity, &renderer->vertex_layout, BGFX_BUFFER_NONE);
+        chunk.ibo = bgfx_create_dynamic_index_buffer(chunk.index_capacity, BGFX_BUFFER_INDEX32);
+    }
+    vec_neopad_vector_chunk_t_push_back(chunks, chunk);
+
+    return (uint32_t) chunks->size - 1;
+}
+
+/// Set the transform for drawing a chunk, in a view relative to `base`.
+static void set_chunk_origin(neopad_renderer_t renderer, const neopad_vector_chunk_t *chunk, neopad_dvec2_t base) {
+    if (chunk->quantum > 0.0f) {
+        neopad_renderer_set_packed_origin(renderer, chunk->origin, base, chunk->quantum);
+    } else {
+        neopad_renderer_set_relative_origin(renderer, chunk->origin, base);
+    }
+}
+
+#pragma mark - Packing
+
+/// Step to pack the pen stroke with at a level of detail: finer than the pointer could place
+/// points at the zoom the stroke was drawn at (or, if coarser, than the level's tolerance), and a
+/// power of two, so that strokes drawn at about the same zoom share chunks.
+static float packed_quantum(neopad_renderer_module_vector_t this, uint32_t level) {
+    float quantum = 1.0f / (NEOPAD_VECTOR_PACKED_STEPS_PER_PIXEL * this->pen.zoom);
+    if (level > 0) {
+        quantum = fmaxf(quantum, lod_tolerance(level) / NEOPAD_VECTOR_PACKED_STEPS_PER_TOLERANCE);
+    }
+    return exp2f(floorf(log2f(quantum)));
+}
+
+/// Find an origin to pack geometry (relative to the pen's origin) around, in steps of `quantum`.
+/// @return Whether every vertex is in range of it.
+static bool find_packed_origin(neopad_renderer_module_vector_t this,
+                               const neopad_renderer_vertex_t *vertices,
+                               uint32_t count,
+                               float quantum,
+                               neopad_dvec2_t *origin) {
+    // The center of the stroke, snapped to a grid as wide as the range, so nearby strokes share it.
+    const double range = (double) NEOPAD_PACKED_VERTEX_RANGE * quantum;
+    const rect_t *bounds = &this->pen.bounds;
+    *origin = (neopad_dvec2_t) {
+            round(0.5 * ((double) bounds->min[0] + bounds->max[0]) / range) * range,
+            round(0.5 * ((double) bounds->min[1] + bounds->max[1]) / range) * range,
+    };
+
+    const double dx = this->pen.origin.x - origin->x;
+    const double dy = this->pen.origin.y - origin->y;
+    for (uint32_t i = 0; i < count; i++) {
+        if (fabs(vertices[i].xyzw[0] + dx) > range || fabs(vertices[i].xyzw[1] + dy) > range) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Pack geometry (relative to the pen's origin) around `origin`, in steps of `quantum`.
+/// @return The packed geometry, or NULL if out of memory.
+static const bgfx_memory_t *pack_vertices(neopad_renderer_module_vector_t this,
+                                          neopad_frame_scratch_t *scratch,
+                                          const neopad_renderer_vertex_t *vertices,
+                                          uint32_t count,
+                                          neopad_dvec2_t origin,
+                                          float quantum) {
+    const uint32_t size = count * (uint32_t) sizeof(neopad_renderer_packed_vertex_t);
+    neopad_renderer_packed_vertex_t *packed = neopad_frame_scratch_alloc(scratch, size);
+    if (!packed) {
+        return NULL;
+    }
+
+    const double dx = this->pen.origin.x - origin.x;
+    const double dy = this->pen.origin.y - origin.y;
+    for (uint32_t i = 0; i < count; i++) {
+        packed[i] = (neopad_renderer_packed_vertex_t) {
+                .x = (int16_t) lrint((vertices[i].xyzw[0] + dx) / quantum),
+                .y = (int16_t) lrint((vertices[i].xyzw[1] + dy) / quantum),
+                .argb = vertices[i].argb,
+        };
+    }
+    return bgfx_make_ref(packed, size);
+}
+
+/// Copy indices, offset by `base`, into 16 bits.
+/// @return The packed indices, or NULL if out of memory.
+static const bgfx_memory_t *pack_indices(neopad_frame_scratch_t *scratch,
+                                         const uint32_t *indices,
+                                         uint32_t count,
+                                         uint32_t base) {
+    const uint32_t size = count * (uint32_t) sizeof(uint16_t);
+    uint16_t *packed = neopad_frame_scratch_alloc(scratch, size);
+    if (!packed) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        packed[i] = (uint16_t) (indices[i] + base);
+    }
+    return bgfx_make_ref(packed, size);
+}
+
+/// Append the pen stroke's geometry (indexed from zero) to a chunk of the given level of detail,
+/// packed if it fits.
+/// @note Unpacked, the indices are rebased in place.
+/// @return Where it went, or an empty span if it was dropped (out of memory).
+static neopad_vector_span_t commit(neopad_renderer_module_vector_t this,
+                                   neopad_renderer_t renderer,
+                                   uint32_t level,
+                                   const neopad_renderer_vertex_t *vertices,
+                                   uint32_t *indices,
+                                   neopad_stroke_size_t size,
+                                   const rect_t *bounds) {
+    if (size.index_count == 0) {
+        return (neopad_vector_span_t) {0, 0, 0};
+    }
+
+    neopad_dvec2_t origin;
+    float quantum = packed_quantum(this, level);
+    if (size.vertex_count > NEOPAD_VECTOR_CHUNK_VERTICES
+        || !find_packed_origin(this, vertices, size.vertex_count, quantum, &origin)) {
+        origin = this->pen.origin;
+        quantum = 0.0f;
+    }
+
+    uint32_t index = reserve_chunk(&this->store->chunks[level], renderer, origin, quantum, size);
+    neopad_vector_chunk_t *chunk = &this->store->chunks[level].vector[index];
+
+    // Uploads are read by bgfx straight out of frame scratch, rather than copied again.
+    neopad_frame_scratch_t *scratch = neopad_renderer_scratch(renderer);
+    const bgfx_memory_t *vertex_memory;
+    const bgfx_memory_t *index_memory;
+    if (quantum > 0.0f) {
+        vertex_memory = pack_vertices(this, scratch, vertices, size.vertex_count, origin, quantum);
+        index_memory = pack_indices(scratch, indices, size.index_count, chunk->vertex_count);
+    } else {
+        for (uint32_t i = 0; i < size.index_count; i++) {
+            indices[i] += chunk->vertex_count;
+        }
+        vertex_memory = neopad_frame_scratch_copy(scratch, vertices,
+                                                  size.vertex_count * (uint32_t) sizeof(neopad_renderer_vertex_t));
+        index_memory = neopad_frame_scratch_copy(scratch, indices, size.index_count * (uint32_t) sizeof(uint32_t));
+    }
+    if (!vertex_memory || !index_memory) {
+        eprintf("Out of memory for %u vertices, at level of detail %u: dropped.\n", size.vertex_count, level);
+        return (neopad_vector_span_t) {0, 0, 0};
+    }
+    bgfx_update_dynamic_vertex_buffer(chunk->vbo, chunk->vertex_count, vertex_memory);
+    bgfx_update_dynamic_index_buffer(chunk->ibo, chunk->index_count, index_memory);
+
+    neopad_vector_span_t span = {
+            .chunk = index,
+            .first_index = chunk->index_count,
+            .index_count = size.index_count,
+    };
+
+    chunk->vertex_count += size.vertex_count;
+    chunk->index_count += size.index_count;
+    rect_union(&chunk->bounds, bounds, &chunk->bounds);
+
+    return span;
+}
+
+/// Simplify and tessellate the finished pen stroke for a coarser level of detail, and commit it.
+static neopad_vector_span_t commit_lod(neopad_renderer_module_vector_t this,
+                                       neopad_renderer_t renderer,
+                                       uint32_t level) {
+    const float tolerance = lod_tolerance(level);
+    const rect_t *bounds = &this->pen.bounds;
+
+    // Strokes that are no bigger than the tolerance are not worth drawing at all.
+    float extent = glm_max(bounds->max[0] - bounds->min[0], bounds->max[1] - bounds->min[1]);
+    if (extent <= tolerance) {
+        return (neopad_vector_span_t) {0, 0, 0};
+    }
+
+    const size_t count = this->pen.points.size;
+    vec_neopad_vec2_t_reserve(&this->scratch.points, count);
+    vec_uint32_t_reserve(&this->scratch.stack, 2 * count);
+    size_t simplified = neopad_stroke_simplify(this->pen.points.vector, count, tolerance,
+                                               this->scratch.stack.vector, this->scratch.points.vector);
+
+    // Where the stroke is only a few pixels wide, round joins are indistinguishable from bevels.
+    neopad_stroke_style_t style = this->pen.stream.style;
+    if (style.width <= 4.0f * tolerance && style.join == NEOPAD_STROKE_JOIN_ROUND) {
+        style.join = NEOPAD_STROKE_JOIN_BEVEL;
+    }
+
+    neopad_stroke_size_t size = neopad_stroke_measure(simplified, &style);
+    vec_neopad_renderer_vertex_t_reserve(&this->scratch.vertices, size.vertex_count);
+    vec_uint32_t_reserve(&this->scratch.indices, size.index_count);
+    size = neopad_stroke_tessellate(this->scratch.points.vector, simplified, &style, 0,
+                                    this->scratch.vertices.vector, this->scratch.indices.vector);
+
+    return commit(this, renderer, level, this->scratch.vertices.vector, this->scratch.indices.vector, size, bounds);
+}
+
+/// Move the finished pen stroke into chunks, at every level of detail.
+static void commit_pen(neopad_renderer_module_vector_t this, neopad_renderer_t renderer) {
+    if (this->pen.vertex_count == 0) {
+        return;
+    }
+
+    neopad_vector_stroke_t stroke = {.bounds = this->pen.bounds};
+
+    // The pen geometry is the full detail.
+    stroke.lod[0] = commit(this, renderer, 0,
+                           this->pen.vertices.vector, this->pen.indices.vector,
+                           (neopad_stroke_size_t) {this->pen.vertex_count, this->pen.index_count},
+                           &this->pen.bounds);
+
+    for (uint32_t level = 1; level < NEOPAD_VECTOR_LOD_LEVELS; level++) {
+        stroke.lod[level] = commit_lod(this, renderer, level);
+    }
+
+    vec_neopad_vector_stroke_t_push_back(&this->store->strokes, stroke);
+
+    // Every renderer drawing from the same storage sees the stroke (this one already knows).
+    for (uint32_t i = 0; i < NEOPAD_RENDERER_MAX_SHARING; i++) {
+        neopad_renderer_t member = renderer->group->members[i];
+        if (!member || get_module(member)->store != this->store) {
+            continue;
+        }
+        neopad_renderer_module_vector_t module = get_module(member);
+        if (module->use_tiles) {
+            neopad_tile_cache_invalidate(&module->tiles, &stroke.bounds);
+        }
+        if (member != renderer) {
+            neopad_renderer_invalidate_rect(member, stroke.bounds);
+        }
+    }
+}
+
+#pragma mark - Pen Buffers
+
+/// Make room on the CPU side for the pen's next step (or its end).
+static void reserve_pen_step(neopad_renderer_module_vector_t this) {
+    vec_neopad_renderer_vertex_t_reserve(&this->pen.vertices,
+                                         this->pen.vertices.size + NEOPAD_STROKE_MAX_STEP_VERTICES);
+    vec_uint32_t_reserve(&this->pen.indices,
+                         this->pen.indices.size + NEOPAD_STROKE_MAX_STEP_INDICES);
+    this->pen.stream.vertices = this->pen.vertices.vector;
+    this->pen.stream.indices = this->pen.indices.vector;
+}
+
+static void create_pen_buffers(neopad_renderer_module_vector_t this, neopad_renderer_t renderer,
+                               uint32_t vertex_capacity, uint32_t index_capacity) {
+    this->pen.vertex_capacity = vertex_capacity;
+    this->pen.index_capacity = index_capacity;
+    this->pen.vbo = bgfx_create_dynamic_vertex_buffer(vertex_capacity, &renderer->vertex_layout, BGFX_BUFFER_NONE);
+    this->pen.ibo = bgfx_create_dynamic_index_buffer(index_capacity, BGFX_BUFFER_INDEX32);
+}
+
+static void destroy_pen_buffers(neopad_renderer_module_vector_t this) {
+    bgfx_destroy_dynamic_index_buffer(this->pen.ibo);
+    bgfx_destroy_dynamic_vertex_buffer(this->pen.vbo);
+}
+
+/// Write the provisional end of the pen stroke, and upload whatever has changed.
+/// @note Out of memory to upload it from, the pen is left dirty (and is not drawn).
+static void update_pen(neopad_renderer_module_vector_t this, neopad_renderer_t renderer) {
+    if (!this->pen.is_dirty) {
+        return;
+    }
+
+    const uint32_t final_vertices = (uint32_t) this->pen.vertices.size;
+    const uint32_t final_indices = (uint32_t) this->pen.indices.size;
+
+    // The end goes right after the final geometry (there is always room reserved for it).
+    neopad_stroke_size_t end = neopad_stroke_stream_finish(
+            &this->pen.stream,
+            &this->pen.vertices.vector[final_vertices],
+            &this->pen.indices.vector[final_indices]);
+
+    this->pen.vertex_count = final_vertices + end.vertex_count;
+    this->pen.index_count = final_indices + end.index_count;
 
+    // Out of room: start over with bigger buffers (and re-upload everything, just this once).
+    if (this->pen.vertex_count > this->pen.vertex_capacity || this->pen.index_count > this->pen.index_capacity) {
+        destroy_pen_buffers(this);
+        create_pen_buffers(this, renderer, 2 * this->pen.vertex_count, 2 * this->pen.index_count);
+        this->pen.uploaded_vertices = 0;
+        this->pen.uploaded_indices = 0;
+    }
+
+    // Upload everything new since last time, including the end.
+    const uint32_t vertex_offset = this->pen.uploaded_vertices;
+    const uint32_t index_offset = this->pen.uploaded_indices;
+    neopad_frame_scratch_t *scratch = neopad_renderer_scratch(renderer);
+    const bgfx_memory_t *vertex_memory = neopad_frame_scratch_copy(
+            scratch, &this->pen.vertices.vector[vertex_offset],
+            (this->pen.vertex_count - vertex_offset) * (uint32_t) sizeof(neopad_renderer_vertex_t));
+    const bgfx_memory_t *index_memory = neopad_frame_scratch_copy(
+            scratch, &this->pen.indices.vector[index_offset],
+            (this->pen.index_count - index_offset) * (uint32_t) sizeof(uint32_t));
+    if (!vertex_memory || !index_memory) {
+        // Still dirty: not drawn, and uploaded again next frame.
+        eprintf("Out of memory for %u vertices of the pen.\n", this->pen.vertex_count - vertex_offset);
+        return;
+    }
+    bgfx_update_dynamic_vertex_buffer(this->pen.vbo, vertex_offset, vertex_memory);
+    bgfx_update_dynamic_index_buffer(this->pen.ibo, index_offset, index_memory);
+
+    // Next time, the end is overwritten in place.
+    this->pen.uploaded_vertices = final_vertices;
+    this->pen.uploaded_indices = final_indices;
+    this->pen.is_dirty = false;
+}
+
+#pragma mark - Pen
+
+/// How far strokes in a style reach past their points: half the width, or more at miter joins (up
+/// to the miter limit) and square caps (whose corners are half the width diagonally from the end).
+/// @note For bounds (culling, tiles) and dirty rects alike.
+static float stroke_margin(const neopad_stroke_style_t *style) {
+    return style->width / 2.0f * fmaxf(style->miter_limit, (float) GLM_SQRT2);
+}
+
+/// Invalidate the pen's reach from the last point added to `p`, which becomes the last.
+static void invalidate_pen(neopad_renderer_t renderer, neopad_dvec2_t p, bool is_first) {
+    if (!neopad_renderer_tracks_changes(renderer)) {
+        return;
+    }
+
+    neopad_renderer_module_vector_t this = get_module(renderer);
+    neopad_dvec2_t q = is_first ? p : this->tracked.last;
+    float m = this->tracked.margin;
+    neopad_renderer_invalidate_rect(renderer, (rect_t) {
+            .min = {(float) fmin(p.x, q.x) - m, (float) fmin(p.y, q.y) - m},
+            .max = {(float) fmax(p.x, q.x) + m, (float) fmax(p.y, q.y) + m},
+    });
+    this->tracked.last = p;
+}
+
+void neopad_renderer_set_stroke_style(neopad_renderer_t this, neopad_stroke_style_t style) {
+    if (neopad_renderer_tracks_changes(this)) {
+        get_module(this)->tracked.margin = stroke_margin(&style);
+    }
+    if (neopad_renderer_is_recording(this)) {
+        neopad_renderer_record(this, (neopad_command_t) {.type = NEOPAD_COMMAND_SET_STROKE_STYLE, .style = style});
+        return;
+    }
+    get_module(this)->style = style;
+}
+
+void neopad_renderer_begin_points(neopad_renderer_t this, vec2 p) {
+    neopad_renderer_begin_points_d(this, (neopad_dvec2_t) {p[0], p[1]});
 }
 
 void neopad_renderer_pen_add_point(neopad_renderer_t this, vec2 p) {
+    neopad_renderer_pen_add_point_d(this, (neopad_dvec2_t) {p[0], p[1]});
+}
+
+void neopad_renderer_begin_points_d(neopad_renderer_t this, neopad_dvec2_t p) {
+    invalidate_pen(this, p, true);
+    if (neopad_renderer_is_recording(this)) {
+        neopad_renderer_record(this, (neopad_command_t) {.type = NEOPAD_COMMAND_BEGIN_POINTS, .point = p});
+        return;
+    }
+
+    neopad_renderer_module_vector_t module = get_module(this);
 
+    if (module->pen.is_active) {
+        neopad_renderer_end_points(this);
+    }
+
+    module->pen.is_active = true;
+    module->pen.origin = (neopad_dvec2_t) {
+            floor(p.x / NEOPAD_VECTOR_TILE_SIZE) * NEOPAD_VECTOR_TILE_SIZE,
+            floor(p.y / NEOPAD_VECTOR_TILE_SIZE) * NEOPAD_VECTOR_TILE_SIZE,
+    };
+    module->pen.zoom = this->zoom;
+    module->pen.bounds = RECT_EMPTY;
+    module->pen.uploaded_vertices = 0;
+    module->pen.uploaded_indices = 0;
+    module->pen.vertex_count = 0;
+    module->pen.index_count = 0;
+    vec_neopad_renderer_vertex_t_clear(&module->pen.vertices);
+    vec_uint32_t_clear(&module->pen.indices);
+    vec_neopad_vec2_t_clear(&module->pen.points);
+    neopad_stroke_stream_begin(&module->pen.stream, &module->style, 0);
+
+    neopad_renderer_pen_add_point_d(this, p);
+}
+
+void neopad_renderer_pen_add_point_d(neopad_renderer_t this, neopad_dvec2_t p) {
+    invalidate_pen(this, p, false);
+    if (neopad_renderer_is_recording(this)) {
+        neopad_renderer_record(this, (neopad_command_t) {.type = NEOPAD_COMMAND_ADD_POINT, .point = p});
+        return;
+    }
+
+    neopad_renderer_module_vector_t module = get_module(this);
+
+    if (!module->pen.is_active) {
+        return;
+    }
+
+    // Geometry is stored relative to the stroke's origin, where floats are precise enough.
+    vec2 q = {(float) (p.x - module->pen.origin.x), (float) (p.y - module->pen.origin.y)};
+
+    reserve_pen_step(module);
+    if (!neopad_stroke_stream_push(&module->pen.stream, q)) {
+        return;
+    }
+    module->pen.vertices.size = module->pen.stream.size.vertex_count;
+    module->pen.indices.size = module->pen.stream.size.index_count;
+    vec_neopad_vec2_t_push_back(&module->pen.points, (neopad_vec2_t) {.x = q[0], .y = q[1]});
+
+    // Leave room for the end, too.
+    reserve_pen_step(module);
+
+    // Bounds are for culling, which does not need to be as precise (but must reach miters and caps).
+    float m = stroke_margin(&module->pen.stream.style);
+    float x = (float) p.x;
+    float y = (float) p.y;
+    rect_t point_bounds = {
+            .min = {x - m, y - m},
+            .max = {x + m, y + m},
+    };
+    rect_union(&module->pen.bounds, &point_bounds, &module->pen.bounds);
+
+    module->pen.is_dirty = true;
 }
 
 void neopad_renderer_end_points(neopad_renderer_t this) {
+    if (neopad_renderer_is_recording(this)) {
+        neopad_renderer_record(this, (neopad_command_t) {.type = NEOPAD_COMMAND_END_POINTS});
+        return;
+    }
+
+    neopad_renderer_module_vector_t module = get_module(this);
+
+    if (!module->pen.is_active) {
+        return;
+    }
+
+    // Bring the end up to date, then move the whole stroke into a chunk.
+    module->pen.is_dirty = true;
+    update_pen(module, this);
+    commit_pen(module, this);
+
+    module->pen.is_active = false;
+    module->pen.vertex_count = 0;
+    module->pen.index_count = 0;
+}
+
+#pragma mark - Lifecycle
+
+static void on_setup(neopad_renderer_module_vector_t this, neopad_renderer_t renderer) {
+    this->store = get_module(neopad_renderer_group_primary(renderer));
+
+    neopad_renderer_pass_desc_t pass = neopad_renderer_content_pass_desc();
+    this->pass = neopad_renderer_declare_pass(renderer, &pass);
+    create_pen_buffers(this, renderer, NEOPAD_VECTOR_PEN_VERTICES, 3 * NEOPAD_VECTOR_PEN_VERTICES);
+
+    this->use_tiles = renderer->init.tile_cache;
+    if (this->use_tiles) {
+        neopad_tile_cache_setup(&this->tiles, renderer);
+    }
+}
+
+static void on_teardown(neopad_renderer_module_vector_t this, neopad_renderer_t renderer) {
+    // Shared storage is the primary's to tear down (handed to another, if it goes first).
+    if (this->store == this) {
+        for (uint32_t level = 0; level < NEOPAD_VECTOR_LOD_LEVELS; level++) {
+            vec_foreach(neopad_vector_chunk_t, &this->chunks[level], chunk) {
+                bgfx_destroy_dynamic_index_buffer(chunk->ibo);
+                bgfx_destroy_dynamic_vertex_buffer(chunk->vbo);
+            }
+            vec_neopad_vector_chunk_t_clear(&this->chunks[level]);
+        }
+        vec_neopad_vector_stroke_t_clear(&this->strokes);
+    }
 
+    if (this->use_tiles) {
+        neopad_tile_cache_teardown(&this->tiles, renderer);
+    }
+    destroy_pen_buffers(this);
+    neopad_renderer_release_pass(renderer, this->pass);
+}
+
+void neopad_renderer_module_vector_hand_off(neopad_renderer_t from, neopad_renderer_t to) {
+    neopad_renderer_module_vector_t store = get_module(from);
+    neopad_renderer_module_vector_t heir = get_module(to);
+    if (!store || !heir || store->store != store) {
+        return;
+    }
+
+    // The chunks' buffers are bgfx's, shared by both: only who tears them down changes.
+    for (uint32_t level = 0; level < NEOPAD_VECTOR_LOD_LEVELS; level++) {
+        vec_neopad_vector_chunk_t_free(&heir->chunks[level]);
+        heir->chunks[level] = store->chunks[level];
+        store->chunks[level] = vec_neopad_vector_chunk_t_init();
+    }
+    vec_neopad_vector_stroke_t_free(&heir->strokes);
+    heir->strokes = store->strokes;
+    store->strokes = vec_neopad_vector_stroke_t_init();
+
+    for (uint32_t i = 0; i < NEOPAD_RENDERER_MAX_SHARING; i++) {
+        neopad_renderer_t member = from->group->members[i];
+        if (member && get_module(member) && get_module(member)->store == store) {
+            get_module(member)->store = heir;
+        }
+    }
+}
+
+static inline void count_draw(neopad_renderer_module_vector_t this, uint32_t vertex_count, uint32_t index_count) {
+    this->base.counters.draw_calls++;
+    this->base.counters.vertices += vertex_count;
+    this->base.counters.indices += index_count;
+    this->base.counters.visible++;
+}
+
+#pragma mark - Tiles
+
+static bool is_tile_empty(void *context, const rect_t *area) {
+    neopad_renderer_module_vector_t this = context;
+    vec_foreach(neopad_vector_chunk_t, &this->store->chunks[0], chunk) {
+        if (chunk->index_count > 0 && rect_overlaps(&chunk->bounds, area)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Draw the finished strokes in a tile's area into it.
+static void draw_tile(void *context,
+                      neopad_renderer_t renderer,
+                      bgfx_view_id_t view,
+                      const rect_t *area,
+                      neopad_dvec2_t base,
+                      float zoom) {
+    neopad_renderer_module_vector_t this = context;
+    bgfx_program_handle_t program = renderer->programs[NEOPAD_PROGRAM_BASIC];
+    vec_foreach(neopad_vector_chunk_t, &this->store->chunks[lod_for_zoom(zoom)], chunk) {
+        if (chunk->index_count == 0 || !rect_overlaps(&chunk->bounds, area)) {
+            continue;
+        }
+        bgfx_set_dynamic_vertex_buffer(0, chunk->vbo, 0, chunk->vertex_count);
+        bgfx_set_dynamic_index_buffer(chunk->ibo, 0, chunk->index_count);
+        set_chunk_origin(renderer, chunk, base);
+        bgfx_set_state(TILE_STROKE_STATE, 0);
+        bgfx_submit(view, program, 0, false);
+        count_draw(this, chunk->vertex_count, chunk->index_count);
+    }
+}
+
+#pragma mark - Frames
+
+/// Draw the finished strokes in view, one draw per chunk.
+static void draw_chunks(neopad_renderer_module_vector_t this, neopad_renderer_t renderer) {
+    bgfx_program_handle_t program = renderer->programs[NEOPAD_PROGRAM_BASIC];
+
+    rect_t view;
+    neopad_renderer_get_frame_rect(renderer, &view);
+
+    vec_foreach(neopad_vector_chunk_t, &this->store->chunks[this->lod], chunk) {
+        if (chunk->index_count == 0) {
+            continue;
+        }
+        if (!rect_overlaps(&chunk->bounds, &view)) {
+            this->base.counters.culled++;
+            continue;
+        }
+        bgfx_set_dynamic_vertex_buffer(0, chunk->vbo, 0, chunk->vertex_count);
+        bgfx_set_dynamic_index_buffer(chunk->ibo, 0, chunk->index_count);
+        set_chunk_origin(renderer, chunk, (neopad_dvec2_t) {-renderer->camera.x, -renderer->camera.y});
+        bgfx_set_state(STROKE_STATE, 0);
+        neopad_renderer_submit_pass(renderer, this->pass, program);
+        count_draw(this, chunk->vertex_count, chunk->index_count);
+    }
+}
+
+static void on_end_frame(neopad_renderer_module_vector_t this, neopad_renderer_t renderer) {
+    bgfx_program_handle_t program = renderer->programs[NEOPAD_PROGRAM_BASIC];
+
+    // Coarser geometry when zoomed out, so the amount drawn stays about the same.
+    this->lod = lod_for_zoom(renderer->zoom);
+
+    // Finished strokes come from tiles, once those in view are all drawn (until then, or without
+    // tiles, they are drawn as they are).
+    const neopad_tile_source_t source = {.context = this, .is_empty = is_tile_empty, .draw = draw_tile};
+    if (!this->use_tiles || !neopad_tile_cache_draw(&this->tiles, renderer, &source, &this->base.counters)) {
+        draw_chunks(this, renderer);
+    }
+
+    // Plus one for the stroke being drawn.
+    if (this->pen.is_active) {
+        update_pen(this, renderer);
+        if (this->pen.index_count > 0 && !this->pen.is_dirty) {
+            bgfx_set_dynamic_vertex_buffer(0, this->pen.vbo, 0, this->pen.vertex_count);
+            bgfx_set_dynamic_index_buffer(this->pen.ibo, 0, this->pen.index_count);
+            neopad_renderer_set_origin(renderer, this->pen.origin);
+            bgfx_set_state(STROKE_STATE, 0);
+            neopad_renderer_submit_pass(renderer, this->pass, program);
+            count_draw(this, this->pen.vertex_count, this->pen.index_count);
+        }
+    }
 }
 
 void neopad_renderer_module_vector_destroy(neopad_renderer_module_vector_t module) {
+    vec_neopad_renderer_vertex_t_free(&module->pen.vertices);
+    vec_uint32_t_free(&module->pen.indices);
+    vec_neopad_vec2_t_free(&module->pen.points);
+    for (uint32_t level = 0; level < NEOPAD_VECTOR_LOD_LEVELS; level++) {
+        vec_neopad_vector_chunk_t_free(&module->chunks[level]);
+    }
+    vec_neopad_vec2_t_free(&module->scratch.points);
+    vec_uint32_t_free(&module->scratch.stack);
+    vec_neopad_renderer_vertex_t_free(&module->scratch.vertices);
+    vec_uint32_t_free(&module->scratch.indices);
+    vec_neopad_vector_stroke_t_free(&module->strokes);
     free(module);
 }
 
@@ -28,14 +712,39 @@ neopad_renderer_module_t neopad_renderer_module_vector_create(void) {
     memcpy(module, &(struct neopad_renderer_module_vector_s) {
             .base = {
                     .name = "vector",
-                    .on_setup = NULL,
-                    .on_teardown = NULL,
+                    .order = NEOPAD_RENDERER_ORDER_CONTENT,
+                    .on_setup = on_setup,
+                    .on_teardown = on_teardown,
                     .on_begin_frame = NULL,
-                    .on_end_frame = NULL,
+                    .on_end_frame = on_end_frame,
                     .render = NULL,
                     .destroy = neopad_renderer_module_vector_destroy
-            }
+            },
+            .pass = NEOPAD_RENDERER_PASS_NONE,
+            .style = DEFAULT_STROKE_STYLE,
+            .tracked = {.margin = stroke_margin(&DEFAULT_STROKE_STYLE)},
+            .pen = {
+                    .is_active = false,
+                    .vertices = vec_neopad_renderer_vertex_t_init(),
+                    .indices = vec_uint32_t_init(),
+                    .points = vec_neopad_vec2_t_init(),
+            },
+            .strokes = vec_neopad_vector_stroke_t_init(),
+            .store = NULL,
+            .lod = 0,
+            .use_tiles = false,
+            .scratch = {
+                    .points = vec_neopad_vec2_t_init(),
+                    .stack = vec_uint32_t_init(),
+                    .vertices = vec_neopad_renderer_vertex_t_init(),
+                    .indices = vec_uint32_t_init(),
+            },
     }, sizeof(struct neopad_renderer_module_vector_s));
 
+    for (uint32_t level = 0; level < NEOPAD_VECTOR_LOD_LEVELS; level++) {
+        module->chunks[level] = vec_neopad_vector_chunk_t_init();
+    }
+    neopad_tile_cache_init(&module->tiles);
+
     return (neopad_renderer_module_t) { .vector = module };
 }
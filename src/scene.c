@@ -0,0 +1,163 @@
+//
+// Created by Dylan Lukes on 8/21/23.
+//
+
+#include "neopad/scene.h"
+#include "neopad/internal/scene.h"
+
+#include <memory.h>
+
+static inline bool is_live(neopad_scene_t this, neopad_scene_id_t id) {
+    return id < this->slots.size && this->slots.vector[id].leaf != NEOPAD_SPATIAL_NULL;
+}
+
+#pragma mark - Lifecycle
+
+neopad_scene_t neopad_scene_create() {
+    neopad_scene_t scene = malloc(sizeof(struct neopad_scene_s));
+    memset(scene, 0, sizeof(struct neopad_scene_s));
+
+    scene->slots = vec_neopad_scene_slot_t_init();
+    scene->free_ids = vec_uint32_t_init();
+    scene->found = vec_uint32_t_init();
+    neopad_spatial_init(&scene->index);
+
+    return scene;
+}
+
+void neopad_scene_destroy(neopad_scene_t this) {
+    neopad_spatial_free(&this->index);
+    vec_uint32_t_free(&this->found);
+    vec_uint32_t_free(&this->free_ids);
+    vec_neopad_scene_slot_t_free(&this->slots);
+    free(this);
+}
+
+#pragma mark - Objects
+
+void neopad_scene_object_bounds(const neopad_scene_object_t *object, rect_t *dst) {
+    switch (object->kind) {
+        case NEOPAD_SCENE_OBJECT_LINE: {
+            const line_t *line = &object->line;
+            float hw = object->width / 2.0f;
+            dst->min[0] = (line->start[0] < line->end[0] ? line->start[0] : line->end[0]) - hw;
+            dst->min[1] = (line->start[1] < line->end[1] ? line->start[1] : line->end[1]) - hw;
+            dst->max[0] = (line->start[0] > line->end[0] ? line->start[0] : line->end[0]) + hw;
+            dst->max[1] = (line->start[1] > line->end[1] ? line->start[1] : line->end[1]) + hw;
+            break;
+        }
+        case NEOPAD_SCENE_OBJECT_RECT:
+            *dst = object->rect;
+            break;
+        case NEOPAD_SCENE_OBJECT_ELLIPSE: {
+            const ellipse_t *ellipse = &object->ellipse;
+            dst->min[0] = ellipse->center[0] - ellipse->radii[0];
+            dst->min[1] = ellipse->center[1] - ellipse->radii[1];
+            dst->max[0] = ellipse->center[0] + ellipse->radii[0];
+            dst->max[1] = ellipse->center[1] + ellipse->radii[1];
+            break;
+        }
+    }
+}
+
+neopad_scene_id_t neopad_scene_add(neopad_scene_t this, neopad_scene_object_t object) {
+    neopad_scene_id_t id;
+    if (this->free_ids.size > 0) {
+        id = this->free_ids.vector[--this->free_ids.size];
+    } else {
+        id = (neopad_scene_id_t) this->slots.size;
+        vec_neopad_scene_slot_t_push_back(&this->slots, (neopad_scene_slot_t) {.leaf = NEOPAD_SPATIAL_NULL});
+    }
+
+    rect_t bounds;
+    neopad_scene_object_bounds(&object, &bounds);
+
+    neopad_scene_slot_t *slot = &this->slots.vector[id];
+    slot->object = object;
+    slot->leaf = neopad_spatial_insert(&this->index, &bounds, id);
+    slot->sequence = this->next_sequence++;
+    this->revision++;
+
+    return id;
+}
+
+void neopad_scene_set(neopad_scene_t this, neopad_scene_id_t id, neopad_scene_object_t object) {
+    if (!is_live(this, id)) {
+        return;
+    }
+
+    rect_t bounds;
+    neopad_scene_object_bounds(&object, &bounds);
+
+    neopad_scene_slot_t *slot = &this->slots.vector[id];
+    slot->object = object;
+    slot->leaf = neopad_spatial_update(&this->index, slot->leaf, &bounds);
+    this->revision++;
+}
+
+void neopad_scene_remove(neopad_scene_t this, neopad_scene_id_t id) {
+    if (!is_live(this, id)) {
+        return;
+    }
+
+    neopad_scene_slot_t *slot = &this->slots.vector[id];
+    neopad_spatial_remove(&this->index, slot->leaf);
+    slot->leaf = NEOPAD_SPATIAL_NULL;
+    vec_uint32_t_push_back(&this->free_ids, id);
+    this->revision++;
+}
+
+const neopad_scene_object_t *neopad_scene_get(neopad_scene_t this, neopad_scene_id_t id) {
+    return is_live(this, id) ? &this->slots.vector[id].object : NULL;
+}
+
+size_t neopad_scene_count(neopad_scene_t this) {
+    return this->index.count;
+}
+
+#pragma mark - Queries
+
+/// The slots of the scene being queried, for by_sequence (compare functions take no context).
+static _Thread_local const neopad_scene_slot_t *sorted_slots = NULL;
+
+static int by_sequence(uint32_t *a, uint32_t *b) {
+    return sorted_slots[*a].sequence < sorted_slots[*b].sequence;
+}
+
+size_t neopad_scene_query_into(neopad_scene_t this, const rect_t *area, vec_uint32_t *out) {
+    const size_t first = out->size;
+    size_t found = neopad_spatial_query(&this->index, area, out);
+
+    // The index finds objects in the order of its nodes, which changes as they move: sorted, what
+    // is drawn over what stays put. By when they were added, since ids are reused.
+    if (found > 1) {
+        sorted_slots = this->slots.vector;
+        vec_uint32_t__ranged_sort(out, first, out->size - 1, by_sequence);
+        sorted_slots = NULL;
+    }
+    return found;
+}
+
+size_t neopad_scene_query(neopad_scene_t this, rect_t area, neopad_scene_id_t *ids, size_t capacity) {
+    vec_uint32_t_clear(&this->found);
+    size_t found = neopad_scene_query_into(this, &area, &this->found);
+
+    size_t n = found < capacity ? found : capacity;
+    if (n > 0) {
+        memcpy(ids, this->found.vector, n * sizeof(neopad_scene_id_t));
+    }
+
+    return found;
+}
+
+neopad_scene_snapshot_t *neopad_scene_snapshot(neopad_scene_t this, const rect_t *area) {
+    vec_uint32_t_clear(&this->found);
+    size_t found = neopad_scene_query_into(this, area, &this->found);
+
+    neopad_scene_snapshot_t *snapshot = malloc(sizeof(neopad_scene_snapshot_t) + found * sizeof(neopad_scene_object_t));
+    snapshot->count = found;
+    for (size_t i = 0; i < found; i++) {
+        snapshot->objects[i] = *neopad_scene_get(this, this->found.vector[i]);
+    }
+    return snapshot;
+}
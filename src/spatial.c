@@ -0,0 +1,322 @@
+//
+// Created by Dylan Lukes on 8/21/23.
+//
+
+#include "neopad/internal/rect.h"
+#include "neopad/internal/spatial.h"
+
+#define NODE(i) (&this->nodes.vector[i])
+
+/// Cost of a node. Perimeter is cheaper than area, and does not degenerate for lines (zero area).
+static inline float rect_cost(const rect_t *r) {
+    return rect_half_perimeter(r);
+}
+
+static inline int32_t max_i32(int32_t a, int32_t b) {
+    return a > b ? a : b;
+}
+
+#pragma mark - Nodes
+
+static uint32_t allocate_node(neopad_spatial_t *this) {
+    uint32_t index;
+    if (this->free_list != NEOPAD_SPATIAL_NULL) {
+        index = this->free_list;
+        this->free_list = NODE(index)->parent;
+    } else {
+        index = (uint32_t) this->nodes.size;
+        vec_neopad_spatial_node_t_push_back(&this->nodes, (neopad_spatial_node_t) {0});
+    }
+
+    *NODE(index) = (neopad_spatial_node_t) {
+            .parent = NEOPAD_SPATIAL_NULL,
+            .left = NEOPAD_SPATIAL_NULL,
+            .right = NEOPAD_SPATIAL_NULL,
+            .height = 0,
+            .value = NEOPAD_SPATIAL_NULL,
+    };
+    return index;
+}
+
+static void release_node(neopad_spatial_t *this, uint32_t index) {
+    NODE(index)->parent = this->free_list;
+    NODE(index)->height = -1;
+    this->free_list = index;
+}
+
+static inline bool is_leaf(const neopad_spatial_node_t *node) {
+    return node->left == NEOPAD_SPATIAL_NULL;
+}
+
+/// Rotate the subtree at `a` if it is out of balance.
+/// @return The new root of the subtree.
+static uint32_t balance(neopad_spatial_t *this, uint32_t ia) {
+    neopad_spatial_node_t *a = NODE(ia);
+    if (is_leaf(a) || a->height < 2) {
+        return ia;
+    }
+
+    uint32_t ib = a->left;
+    uint32_t ic = a->right;
+    neopad_spatial_node_t *b = NODE(ib);
+    neopad_spatial_node_t *c = NODE(ic);
+
+    int32_t skew = c->height - b->height;
+
+    // Rotate c up (and one of its children across to a).
+    if (skew > 1) {
+        uint32_t i_f = c->left;
+        uint32_t ig = c->right;
+        neopad_spatial_node_t *f = NODE(i_f);
+        neopad_spatial_node_t *g = NODE(ig);
+
+        c->left = ia;
+        c->parent = a->parent;
+        a->parent = ic;
+
+        if (c->parent != NEOPAD_SPATIAL_NULL) {
+            neopad_spatial_node_t *p = NODE(c->parent);
+            if (p->left == ia) p->left = ic;
+            else p->right = ic;
+        } else {
+            this->root = ic;
+        }
+
+        if (f->height > g->height) {
+            c->right = i_f;
+            a->right = ig;
+            g->parent = ia;
+            rect_union(&b->bounds, &g->bounds, &a->bounds);
+            rect_union(&a->bounds, &f->bounds, &c->bounds);
+            a->height = 1 + max_i32(b->height, g->height);
+            c->height = 1 + max_i32(a->height, f->height);
+        } else {
+            c->right = ig;
+            a->right = i_f;
+            f->parent = ia;
+            rect_union(&b->bounds, &f->bounds, &a->bounds);
+            rect_union(&a->bounds, &g->bounds, &c->bounds);
+            a->height = 1 + max_i32(b->height, f->height);
+            c->height = 1 + max_i32(a->height, g->height);
+        }
+        return ic;
+    }
+
+    // Rotate b up (and one of its children across to a).
+    if (skew < -1) {
+        uint32_t id = b->left;
+        uint32_t ie = b->right;
+        neopad_spatial_node_t *d = NODE(id);
+        neopad_spatial_node_t *e = NODE(ie);
+
+        b->left = ia;
+        b->parent = a->parent;
+        a->parent = ib;
+
+        if (b->parent != NEOPAD_SPATIAL_NULL) {
+            neopad_spatial_node_t *p = NODE(b->parent);
+            if (p->left == ia) p->left = ib;
+            else p->right = ib;
+        } else {
+            this->root = ib;
+        }
+
+        if (d->height > e->height) {
+            b->right = id;
+            a->left = ie;
+            e->parent = ia;
+            rect_union(&c->bounds, &e->bounds, &a->bounds);
+            rect_union(&a->bounds, &d->bounds, &b->bounds);
+            a->height = 1 + max_i32(c->height, e->height);
+            b->height = 1 + max_i32(a->height, d->height);
+        } else {
+            b->right = ie;
+            a->left = id;
+            d->parent = ia;
+            rect_union(&c->bounds, &d->bounds, &a->bounds);
+            rect_union(&a->bounds, &e->bounds, &b->bounds);
+            a->height = 1 + max_i32(c->height, d->height);
+            b->height = 1 + max_i32(a->height, e->height);
+        }
+        return ib;
+    }
+
+    return ia;
+}
+
+/// Refit bounds and heights from `index` up to the root, rebalancing on the way.
+static void refit(neopad_spatial_t *this, uint32_t index) {
+    while (index != NEOPAD_SPATIAL_NULL) {
+        index = balance(this, index);
+
+        neopad_spatial_node_t *node = NODE(index);
+        neopad_spatial_node_t *left = NODE(node->left);
+        neopad_spatial_node_t *right = NODE(node->right);
+        node->height = 1 + max_i32(left->height, right->height);
+        rect_union(&left->bounds, &right->bounds, &node->bounds);
+
+        index = node->parent;
+    }
+}
+
+/// Find the best sibling for a new leaf: descend toward whichever child grows the least.
+static uint32_t find_sibling(neopad_spatial_t *this, const rect_t *bounds) {
+    uint32_t index = this->root;
+
+    while (!is_leaf(NODE(index))) {
+        const neopad_spatial_node_t *node = NODE(index);
+        const neopad_spatial_node_t *left = NODE(node->left);
+        const neopad_spatial_node_t *right = NODE(node->right);
+
+        rect_t combined;
+        rect_union(&node->bounds, bounds, &combined);
+        float cost = rect_cost(&node->bounds);
+        float combined_cost = rect_cost(&combined);
+
+        // Cost of making a new parent for this node and the leaf.
+        float here = 2.0f * combined_cost;
+
+        // Minimum cost of pushing the leaf further down.
+        float inherited = 2.0f * (combined_cost - cost);
+
+        rect_t with_left;
+        rect_union(&left->bounds, bounds, &with_left);
+        float left_cost = is_leaf(left)
+                          ? rect_cost(&with_left) + inherited
+                          : rect_cost(&with_left) - rect_cost(&left->bounds) + inherited;
+
+        rect_t with_right;
+        rect_union(&right->bounds, bounds, &with_right);
+        float right_cost = is_leaf(right)
+                           ? rect_cost(&with_right) + inherited
+                           : rect_cost(&with_right) - rect_cost(&right->bounds) + inherited;
+
+        if (here < left_cost && here < right_cost) {
+            break;
+        }
+
+        index = left_cost < right_cost ? node->left : node->right;
+    }
+
+    return index;
+}
+
+#pragma mark - Lifecycle
+
+void neopad_spatial_init(neopad_spatial_t *this) {
+    this->nodes = vec_neopad_spatial_node_t_init();
+    this->root = NEOPAD_SPATIAL_NULL;
+    this->free_list = NEOPAD_SPATIAL_NULL;
+    this->count = 0;
+    this->stack = vec_uint32_t_init();
+}
+
+void neopad_spatial_free(neopad_spatial_t *this) {
+    vec_neopad_spatial_node_t_free(&this->nodes);
+    vec_uint32_t_free(&this->stack);
+    this->root = NEOPAD_SPATIAL_NULL;
+    this->free_list = NEOPAD_SPATIAL_NULL;
+    this->count = 0;
+}
+
+#pragma mark - Modification
+
+uint32_t neopad_spatial_insert(neopad_spatial_t *this, const rect_t *bounds, uint32_t value) {
+    uint32_t leaf = allocate_node(this);
+    NODE(leaf)->bounds = *bounds;
+    NODE(leaf)->value = value;
+    this->count++;
+
+    if (this->root == NEOPAD_SPATIAL_NULL) {
+        this->root = leaf;
+        return leaf;
+    }
+
+    uint32_t sibling = find_sibling(this, bounds);
+
+    // Make a new parent for the sibling and the leaf.
+    uint32_t parent = allocate_node(this);
+    uint32_t old_parent = NODE(sibling)->parent;
+    NODE(parent)->parent = old_parent;
+    NODE(parent)->left = sibling;
+    NODE(parent)->right = leaf;
+    NODE(sibling)->parent = parent;
+    NODE(leaf)->parent = parent;
+
+    if (old_parent != NEOPAD_SPATIAL_NULL) {
+        if (NODE(old_parent)->left == sibling) NODE(old_parent)->left = parent;
+        else NODE(old_parent)->right = parent;
+    } else {
+        this->root = parent;
+    }
+
+    refit(this, parent);
+    return leaf;
+}
+
+void neopad_spatial_remove(neopad_spatial_t *this, uint32_t leaf) {
+    this->count--;
+
+    if (leaf == this->root) {
+        this->root = NEOPAD_SPATIAL_NULL;
+        release_node(this, leaf);
+        return;
+    }
+
+    // Replace the parent with the sibling.
+    uint32_t parent = NODE(leaf)->parent;
+    uint32_t grandparent = NODE(parent)->parent;
+    uint32_t sibling = NODE(parent)->left == leaf ? NODE(parent)->right : NODE(parent)->left;
+
+    NODE(sibling)->parent = grandparent;
+    if (grandparent != NEOPAD_SPATIAL_NULL) {
+        if (NODE(grandparent)->left == parent) NODE(grandparent)->left = sibling;
+        else NODE(grandparent)->right = sibling;
+    } else {
+        this->root = sibling;
+    }
+
+    release_node(this, parent);
+    release_node(this, leaf);
+
+    refit(this, grandparent);
+}
+
+uint32_t neopad_spatial_update(neopad_spatial_t *this, uint32_t leaf, const rect_t *bounds) {
+    uint32_t value = NODE(leaf)->value;
+    neopad_spatial_remove(this, leaf);
+    return neopad_spatial_insert(this, bounds, value);
+}
+
+#pragma mark - Queries
+
+size_t neopad_spatial_query(neopad_spatial_t *this, const rect_t *area, vec_uint32_t *out) {
+    if (this->root == NEOPAD_SPATIAL_NULL) {
+        return 0;
+    }
+
+    size_t found = 0;
+    vec_uint32_t_clear(&this->stack);
+    vec_uint32_t_push_back(&this->stack, this->root);
+
+    while (this->stack.size > 0) {
+        uint32_t index = this->stack.vector[--this->stack.size];
+        const neopad_spatial_node_t *node = NODE(index);
+
+        if (!rect_overlaps(&node->bounds, area)) {
+            continue;
+        }
+
+        if (is_leaf(node)) {
+            vec_uint32_t_push_back(out, node->value);
+            found++;
+        } else {
+            uint32_t left = node->left;
+            uint32_t right = node->right;
+            vec_uint32_t_push_back(&this->stack, left);
+            vec_uint32_t_push_back(&this->stack, right);
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,29 @@
+//
+// Created by Dylan Lukes on 8/24/23.
+//
+
+#include "bx/semaphore.h"
+#include "neopad/internal/shims/bx/semaphore.h"
+
+struct bx_semaphore_s {
+    bx::Semaphore impl;
+};
+
+// Just to be safe...
+static_assert(sizeof(bx_semaphore_s) == sizeof(bx::Semaphore), "Size mismatch");
+
+bx_semaphore_t bx_semaphore_create() {
+    return new struct bx_semaphore_s;
+}
+
+void bx_semaphore_destroy(bx_semaphore_t semaphore) {
+    delete semaphore;
+}
+
+void bx_semaphore_post(bx_semaphore_t semaphore, uint32_t count) {
+    semaphore->impl.post(count);
+}
+
+bool bx_semaphore_wait(bx_semaphore_t semaphore, int32_t timeout_ms) {
+    return semaphore->impl.wait(timeout_ms);
+}
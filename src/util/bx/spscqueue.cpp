@@ -13,8 +13,14 @@ struct bx_spsc_queue_s {
     bx_spsc_queue_s() : impl(&default_allocator) {}
 };
 
+struct bx_spsc_blocking_queue_s {
+    bx::SpScBlockingUnboundedQueue impl;
+    bx_spsc_blocking_queue_s() : impl(&default_allocator) {}
+};
+
 // Just to be safe...
 static_assert(sizeof(bx_spsc_queue_s) == sizeof(bx::SpScUnboundedQueue), "Size mismatch");
+static_assert(sizeof(bx_spsc_blocking_queue_s) == sizeof(bx::SpScBlockingUnboundedQueue), "Size mismatch");
 
 bx_spsc_queue_s *bx_spsc_queue_create() {
     return new struct bx_spsc_queue_s;
@@ -36,3 +42,22 @@ void *bx_spsc_queue_peek(bx_spsc_queue_s *queue) {
     return queue->impl.peek();
 }
 
+bx_spsc_blocking_queue_s *bx_spsc_blocking_queue_create() {
+    return new struct bx_spsc_blocking_queue_s;
+}
+
+void bx_spsc_blocking_queue_destroy(bx_spsc_blocking_queue_s *queue) {
+    delete queue;
+}
+
+void bx_spsc_blocking_queue_push(bx_spsc_blocking_queue_s *queue, void *data) {
+    queue->impl.push(data);
+}
+
+void *bx_spsc_blocking_queue_pop(bx_spsc_blocking_queue_s *queue, int32_t timeout_ms) {
+    return queue->impl.pop(timeout_ms);
+}
+
+void *bx_spsc_blocking_queue_peek(bx_spsc_blocking_queue_s *queue) {
+    return queue->impl.peek();
+}
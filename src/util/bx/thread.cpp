@@ -2,6 +2,8 @@
 // Created by Dylan Lukes on 8/16/23.
 //
 
+#include <thread>
+
 #include "bx/thread.h"
 #include "neopad/internal/shims/bx/thread.h"
 
@@ -51,4 +53,12 @@ void bx_thread_push(bx_thread_t thread, void *ptr) {
 
 void *bx_thread_pop(bx_thread_t thread) {
     return thread->impl.pop();
-}
\ No newline at end of file
+}
+
+uint32_t bx_thread_hardware_concurrency() {
+    return std::thread::hardware_concurrency();
+}
+
+void bx_thread_yield() {
+    std::this_thread::yield();
+}
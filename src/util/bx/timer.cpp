@@ -0,0 +1,14 @@
+//
+// Created by Dylan Lukes on 8/22/23.
+//
+
+#include "bx/timer.h"
+#include "neopad/internal/shims/bx/timer.h"
+
+int64_t bx_get_hp_counter() {
+    return bx::getHPCounter();
+}
+
+int64_t bx_get_hp_frequency() {
+    return bx::getHPFrequency();
+}
@@ -1,17 +1,1557 @@
 #include <neopad/neopad.h>
+#include <neopad/profile.h>
+#include <neopad/renderer.h>
+#include <neopad/scene.h>
 
+#include "neopad/internal/animation.h"
+#include "neopad/internal/jobs.h"
+#include "neopad/internal/renderer.h"
+#include "neopad/internal/renderer/graph.h"
+#include "neopad/internal/renderer/registry.h"
+#include "neopad/internal/renderer/scene.h"
+#include "neopad/internal/renderer/stroke.h"
+#include "neopad/internal/renderer/vector.h"
+
+#include <math.h>
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <setjmp.h>
 #include <cmocka.h>
 
+// vec_int32_t: signed, for the radix sort's sign flip, and sorted in parallel too (with pthreads).
+#ifndef _WIN32
+#define CTL_PARALLEL_SORT
+#endif
+#define POD
+#define T int32_t
+#include <ctl/vector.h>
+
+// ufset_uint32_t
+#define POD
+#define T uint32_t
+#include <ctl/unordered_flat_set.h>
+
+/// A map entry owning its name, so that replacing or erasing it must free it.
+typedef struct named_s {
+    uint32_t id;
+    char *name;
+} named_t;
+
+static char *name_of(uint32_t id) {
+    char *name = malloc(16);
+    snprintf(name, 16, "#%u", id);
+    return name;
+}
+
+static void named_t_free(named_t *named) {
+    free(named->name);
+}
+
+static named_t named_t_copy(named_t *named) {
+    return (named_t) {named->id, named->name ? name_of(named->id) : NULL};
+}
+
+static size_t named_hash(named_t *named) {
+    return named->id;
+}
+
+static int named_equal(named_t *a, named_t *b) {
+    return a->id == b->id;
+}
+
+// ufmap_named_t
+#define T named_t
+#include <ctl/unordered_flat_map.h>
+
+// map_named_t
+#define T named_t
+#include <ctl/map.h>
+
+#include <ctl/allocator.h>
+
+static void draw_frame(neopad_renderer_t renderer) {
+    neopad_renderer_begin_frame(renderer);
+    neopad_renderer_end_frame(renderer);
+}
+
 static void test_dummy(void **state) {
     assert_int_equal(13, pad_dummy());
 }
 
+static void test_scene_query(void **state) {
+    neopad_scene_t scene = neopad_scene_create();
+
+    // A row of 10x10 rects, 100 apart.
+    neopad_scene_id_t ids[100];
+    for (int i = 0; i < 100; i++) {
+        ids[i] = neopad_scene_add(scene, (neopad_scene_object_t) {
+                .kind = NEOPAD_SCENE_OBJECT_RECT,
+                .rect = {.min = {100.0f * i, 0.0f}, .max = {100.0f * i + 10.0f, 10.0f}},
+        });
+    }
+    assert_int_equal(100, neopad_scene_count(scene));
+
+    // Covers rects 2, 3 and 4.
+    neopad_scene_id_t found[100];
+    rect_t area = {.min = {205.0f, 5.0f}, .max = {405.0f, 50.0f}};
+    assert_int_equal(3, neopad_scene_query(scene, area, found, 100));
+
+    // Removed objects are not found.
+    neopad_scene_remove(scene, ids[3]);
+    assert_null(neopad_scene_get(scene, ids[3]));
+    assert_int_equal(2, neopad_scene_query(scene, area, found, 100));
+
+    // Moved objects are found where they are now.
+    neopad_scene_object_t object = *neopad_scene_get(scene, ids[99]);
+    object.rect = (rect_t) {.min = {300.0f, 0.0f}, .max = {310.0f, 10.0f}};
+    neopad_scene_set(scene, ids[99], object);
+    assert_int_equal(3, neopad_scene_query(scene, area, found, 100));
+
+    neopad_scene_destroy(scene);
+}
+
+static void test_scene_stacking(void **state) {
+    neopad_scene_t scene = neopad_scene_create();
+    const neopad_scene_object_t square = {
+            .kind = NEOPAD_SCENE_OBJECT_RECT,
+            .rect = {.min = {0.0f, 0.0f}, .max = {10.0f, 10.0f}},
+    };
+
+    // Three overlapping objects; the first removed, and a fourth added, taking its id.
+    neopad_scene_id_t a = neopad_scene_add(scene, square);
+    neopad_scene_id_t b = neopad_scene_add(scene, square);
+    neopad_scene_id_t c = neopad_scene_add(scene, square);
+    neopad_scene_remove(scene, a);
+    neopad_scene_id_t d = neopad_scene_add(scene, square);
+    assert_int_equal(d, a);
+
+    // The newest is still drawn over the others, whatever its id.
+    neopad_scene_id_t found[3];
+    rect_t area = {.min = {0.0f, 0.0f}, .max = {10.0f, 10.0f}};
+    assert_int_equal(3, neopad_scene_query(scene, area, found, 3));
+    assert_int_equal(found[0], b);
+    assert_int_equal(found[1], c);
+    assert_int_equal(found[2], d);
+
+    // Moving an object does not change where it stacks.
+    neopad_scene_set(scene, b, square);
+    assert_int_equal(3, neopad_scene_query(scene, area, found, 3));
+    assert_int_equal(found[0], b);
+
+    // Querying into a vector sorts only what the query appended.
+    vec_uint32_t out = vec_uint32_t_init();
+    vec_uint32_t_push_back(&out, 99);
+    vec_uint32_t_push_back(&out, 7);
+    assert_int_equal(3, neopad_scene_query_into(scene, &area, &out));
+    assert_int_equal(out.size, 5);
+    assert_int_equal(out.vector[0], 99);
+    assert_int_equal(out.vector[1], 7);
+    assert_int_equal(out.vector[2], b);
+    assert_int_equal(out.vector[3], c);
+    assert_int_equal(out.vector[4], d);
+    vec_uint32_t_free(&out);
+
+    neopad_scene_destroy(scene);
+}
+
+static void test_scene_line_caps(void **state) {
+    // A line along a diagonal, 10 wide, and the origin off to one side.
+    const neopad_scene_object_t line = {
+            .kind = NEOPAD_SCENE_OBJECT_LINE,
+            .line = {.start = {10.0f, 10.0f}, .end = {70.0f, 90.0f}},
+            .width = 10.0f,
+    };
+    const neopad_dvec2_t origin = {10.0, 10.0};
+    const float axis[2] = {0.6f, 0.8f};
+
+    // Tessellated: how far the geometry reaches along the line, from its start.
+    const neopad_stroke_style_t style = neopad_scene_line_style(&line);
+    const neopad_stroke_size_t capacity = neopad_stroke_measure(2, &style);
+    neopad_renderer_vertex_t *vertices = malloc(capacity.vertex_count * sizeof(neopad_renderer_vertex_t));
+    uint32_t *indices = malloc(capacity.index_count * sizeof(uint32_t));
+    const neopad_vec2_t points[2] = {{0.0f, 0.0f}, {60.0f, 80.0f}};
+    const neopad_stroke_size_t size = neopad_stroke_tessellate(points, 2, &style, 0, vertices, indices);
+    float min = INFINITY, max = -INFINITY;
+    for (uint32_t i = 0; i < size.vertex_count; i++) {
+        const float along = vertices[i].xyzw[0] * axis[0] + vertices[i].xyzw[1] * axis[1];
+        min = fminf(min, along);
+        max = fmaxf(max, along);
+    }
+    free(vertices);
+    free(indices);
+
+    // Instanced: the shape's box, and its capsule within it.
+    neopad_renderer_shape_instance_t instance;
+    neopad_scene_shape_instance(&line, origin, &instance);
+    const float center = instance.center[0] * axis[0] + instance.center[1] * axis[1];
+    assert_true(fabsf(instance.axis[0] - axis[0]) < 1e-5f && fabsf(instance.axis[1] - axis[1]) < 1e-5f);
+    assert_true(fabsf(instance.radius - 5.0f) < 1e-5f);
+
+    // Both have round caps: they reach half the width past each end, and no further.
+    assert_true(fabsf(min - -5.0f) < 0.01f);
+    assert_true(fabsf(max - 105.0f) < 0.01f);
+    assert_true(fabsf(center - instance.half_size[0] - min) < 0.01f);
+    assert_true(fabsf(center + instance.half_size[0] - max) < 0.01f);
+}
+
+static void test_stroke_bounds(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {.width = 640, .height = 480, .content_scale = 1.0f, .headless = true};
+    assert_true(neopad_renderer_init(renderer, init));
+
+    // A sharp mitered corner, and square caps: both reach well past half the width from the points.
+    const neopad_stroke_style_t style = {
+            .width = 10.0f, .color = 0xff000000, .join = NEOPAD_STROKE_JOIN_MITER,
+            .cap = NEOPAD_STROKE_CAP_SQUARE, .miter_limit = 10.0f,
+    };
+    const neopad_vec2_t points[3] = {{20.0f, 20.0f}, {120.0f, 40.0f}, {20.0f, 60.0f}};
+    neopad_renderer_set_stroke_style(renderer, style);
+    neopad_renderer_begin_points_d(renderer, (neopad_dvec2_t) {points[0].x, points[0].y});
+    for (uint32_t i = 1; i < 3; i++) {
+        neopad_renderer_pen_add_point_d(renderer, (neopad_dvec2_t) {points[i].x, points[i].y});
+    }
+    neopad_renderer_end_points(renderer);
+
+    neopad_renderer_module_vector_t vector =
+            neopad_renderer_registry_get(&renderer->modules, renderer->builtin.vector).vector;
+    assert_int_equal(vector->strokes.size, 1);
+    const rect_t bounds = vector->strokes.vector[0].bounds;
+
+    // The stroke's origin is (0, 0): its geometry is in pad-world coordinates.
+    const neopad_stroke_size_t capacity = neopad_stroke_measure(3, &style);
+    neopad_renderer_vertex_t *vertices = malloc(capacity.vertex_count * sizeof(neopad_renderer_vertex_t));
+    uint32_t *indices = malloc(capacity.index_count * sizeof(uint32_t));
+    const neopad_stroke_size_t size = neopad_stroke_tessellate(points, 3, &style, 0, vertices, indices);
+    float max_x = -INFINITY;
+    for (uint32_t i = 0; i < size.vertex_count; i++) {
+        const float x = vertices[i].xyzw[0];
+        const float y = vertices[i].xyzw[1];
+        max_x = fmaxf(max_x, x);
+        assert_true(x >= bounds.min[0] && x <= bounds.max[0] && y >= bounds.min[1] && y <= bounds.max[1]);
+    }
+    free(vertices);
+    free(indices);
+
+    // The miter does reach past half the width (or the test shows nothing).
+    assert_true(max_x > points[1].x + style.width);
+
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+static void test_headless_frames(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {
+            .width = 640,
+            .height = 480,
+            .content_scale = 1.0f,
+            .headless = true,
+            .background = {.color = 0x222222FF, .grid_enabled = true, .grid_major = 100, .grid_minor = 25},
+    };
+    assert_true(neopad_renderer_init(renderer, init));
+    neopad_renderer_set_profiling(renderer, true);
+
+    neopad_scene_t scene = neopad_scene_create();
+    neopad_scene_add(scene, (neopad_scene_object_t) {
+            .kind = NEOPAD_SCENE_OBJECT_ELLIPSE,
+            .ellipse = {.center = {0.0f, 0.0f}, .radii = {50.0f, 25.0f}},
+            .color = 0xFFFFFFFF,
+    });
+
+    // Draw a stroke over a few frames, the whole pipeline running without a window.
+    for (int i = 0; i < 10; i++) {
+        neopad_renderer_begin_frame(renderer);
+        neopad_renderer_draw_background(renderer);
+        neopad_renderer_draw_scene(renderer, scene);
+        if (i == 0) {
+            neopad_renderer_begin_points_d(renderer, (neopad_dvec2_t) {0.0, 0.0});
+        } else {
+            neopad_renderer_pen_add_point_d(renderer, (neopad_dvec2_t) {10.0 * i, 5.0 * i});
+        }
+        neopad_renderer_end_frame(renderer);
+    }
+    neopad_renderer_end_points(renderer);
+
+    neopad_renderer_begin_frame(renderer);
+    neopad_renderer_end_frame(renderer);
+
+    // Every frame was profiled: the last drew nothing but the finished stroke.
+    assert_int_equal(neopad_renderer_get_profile_frame_count(renderer), 11);
+    const neopad_profile_frame_t *frame = neopad_renderer_get_profile_frame(renderer, 1);
+    assert_non_null(frame);
+    assert_int_equal(frame->index, 9);
+    for (uint32_t i = 0; i < frame->module_count; i++) {
+        if (strcmp(frame->modules[i].name, "scene") == 0) {
+            assert_int_equal(frame->modules[i].counters.visible, 1);
+        }
+    }
+    assert_true(frame->totals.draw_calls >= 3);
+    assert_null(neopad_renderer_get_profile_frame(renderer, 11));
+
+    neopad_scene_destroy(scene);
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+static void test_threaded_frames(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {
+            .width = 640,
+            .height = 480,
+            .content_scale = 1.0f,
+            .headless = true,
+            .threaded = true,
+    };
+    assert_true(neopad_renderer_init(renderer, init));
+    neopad_renderer_set_profiling(renderer, true);
+
+    neopad_scene_t scene = neopad_scene_create();
+    neopad_scene_id_t id = neopad_scene_add(scene, (neopad_scene_object_t) {
+            .kind = NEOPAD_SCENE_OBJECT_RECT,
+            .rect = {.min = {-10.0f, -10.0f}, .max = {10.0f, 10.0f}},
+    });
+
+    // The scene is snapshotted as it is drawn, so it may change before the frame is played back.
+    for (int i = 0; i < 5; i++) {
+        neopad_renderer_begin_frame(renderer);
+        neopad_renderer_draw_background(renderer);
+        neopad_renderer_draw_scene(renderer, scene);
+        neopad_renderer_end_frame(renderer);
+    }
+    neopad_scene_remove(scene, id);
+    neopad_scene_destroy(scene);
+
+    // Profiles can be read while the API thread is still recording them (up to two frames behind).
+    assert_true(neopad_renderer_get_profile_frame_count(renderer) >= 3);
+    assert_non_null(neopad_renderer_get_profile_frame(renderer, 0));
+
+    neopad_renderer_shutdown(renderer);
+    assert_int_equal(neopad_renderer_get_profile_frame_count(renderer), 5);
+    const neopad_profile_frame_t *frame = neopad_renderer_get_profile_frame(renderer, 0);
+    for (uint32_t i = 0; i < frame->module_count; i++) {
+        if (strcmp(frame->modules[i].name, "scene") == 0) {
+            assert_int_equal(frame->modules[i].counters.visible, 1);
+        }
+    }
+    neopad_renderer_destroy(renderer);
+}
+
+static void test_idle_frames(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {
+            .width = 640,
+            .height = 480,
+            .content_scale = 1.0f,
+            .headless = true,
+    };
+    assert_true(neopad_renderer_init(renderer, init));
+    neopad_scene_t scene = neopad_scene_create();
+
+    // The first frame is needed; once drawn, nothing changes until something is done.
+    assert_true(neopad_renderer_needs_frame(renderer));
+    neopad_renderer_begin_frame(renderer);
+    neopad_renderer_draw_scene(renderer, scene);
+    neopad_renderer_end_frame(renderer);
+    assert_false(neopad_renderer_needs_frame(renderer));
+
+    // Strokes in view need a frame, and only their area is dirty.
+    neopad_renderer_begin_points_d(renderer, (neopad_dvec2_t) {0.0, 0.0});
+    neopad_renderer_pen_add_point_d(renderer, (neopad_dvec2_t) {10.0, 10.0});
+    assert_true(neopad_renderer_needs_frame(renderer));
+    rect_t dirty;
+    neopad_renderer_get_dirty_rect(renderer, &dirty);
+    assert_true(dirty.min[0] < 0.0f && dirty.max[0] > 10.0f && dirty.max[0] < 50.0f);
+
+    neopad_renderer_begin_frame(renderer);
+    neopad_renderer_draw_scene(renderer, scene);
+    neopad_renderer_end_frame(renderer);
+    assert_false(neopad_renderer_needs_frame(renderer));
+
+    // Areas out of view do not; edits to the scene drawn, and camera moves, do.
+    neopad_renderer_invalidate_rect(renderer, (rect_t) {.min = {1e6f, 1e6f}, .max = {1e6f + 1.0f, 1e6f + 1.0f}});
+    assert_false(neopad_renderer_needs_frame(renderer));
+    neopad_scene_add(scene, (neopad_scene_object_t) {.kind = NEOPAD_SCENE_OBJECT_RECT});
+    assert_true(neopad_renderer_needs_frame(renderer));
+
+    neopad_renderer_begin_frame(renderer);
+    neopad_renderer_draw_scene(renderer, scene);
+    neopad_renderer_end_frame(renderer);
+    neopad_renderer_set_camera_d(renderer, (neopad_dvec2_t) {100.0, 0.0});
+    assert_true(neopad_renderer_needs_frame(renderer));
+
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+    neopad_scene_destroy(scene);
+}
+
+static void test_partial_redraw(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {
+            .width = 640,
+            .height = 480,
+            .content_scale = 1.0f,
+            .headless = true,
+            .partial_redraw = true,
+    };
+    assert_true(neopad_renderer_init(renderer, init));
+
+    // The first frame is drawn (and the back buffer cleared) whole.
+    draw_frame(renderer);
+    assert_true(renderer->graph.clear_flags & BGFX_CLEAR_COLOR);
+    assert_int_equal(renderer->graph.clear_rect.width, 0);
+
+    // After that, only what changed is cleared: what is outside it is kept.
+    neopad_renderer_invalidate_rect(renderer, (rect_t) {.min = {-10.0f, -10.0f}, .max = {10.0f, 10.0f}});
+    draw_frame(renderer);
+    const neopad_ivec4_t clear = renderer->graph.clear_rect;
+    assert_true(renderer->graph.clear_flags & BGFX_CLEAR_COLOR);
+    assert_int_equal(clear.x, renderer->scissor.x);
+    assert_int_equal(clear.y, renderer->scissor.y);
+    assert_int_equal(clear.width, renderer->scissor.width);
+    assert_int_equal(clear.height, renderer->scissor.height);
+    assert_true(clear.x > 0 && clear.x + clear.width < 640);
+    assert_true(clear.y > 0 && clear.y + clear.height < 480);
+
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+static void test_fly_to(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {
+            .width = 640,
+            .height = 480,
+            .content_scale = 1.0f,
+            .headless = true,
+    };
+    assert_true(neopad_renderer_init(renderer, init));
+
+    // A flight shorter than a frame lands exactly on its target, and comes to rest there.
+    neopad_renderer_fly_to(renderer, (neopad_dvec2_t) {500.0, -200.0}, 2.0f, 0.001f);
+    assert_true(neopad_renderer_needs_frame(renderer));
+    neopad_renderer_begin_frame(renderer);
+    neopad_renderer_end_frame(renderer);
+
+    neopad_dvec2_t camera;
+    neopad_renderer_get_camera_d(renderer, &camera);
+    assert_true(camera.x == 500.0 && camera.y == -200.0);
+    assert_true(neopad_renderer_arrest_zoom(renderer) == 2.0f);
+
+    neopad_renderer_begin_frame(renderer);
+    neopad_renderer_end_frame(renderer);
+    assert_false(neopad_renderer_needs_frame(renderer));
+
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+static void test_flight_tiny_pan(void **state) {
+    // Pans this small next to the widths (such as a camera read back as floats) still fly, finitely.
+    const double pans[] = {5e-6, 1e-5, 1e-3};
+    for (size_t i = 0; i < sizeof(pans) / sizeof(pans[0]); i++) {
+        neopad_flight_t flight;
+        neopad_flight_begin(&flight, (neopad_dvec2_t) {0.0, 0.0}, 1000.0, (neopad_dvec2_t) {pans[i], 0.0}, 2000.0, 1.0);
+        assert_true(isfinite(flight.r0));
+        assert_true(flight.length > 0.0);
+
+        neopad_dvec2_t center;
+        double width;
+        uint32_t steps = 0;
+        while (neopad_flight_update(&flight, 1.0 / 60.0, &center, &width)) {
+            assert_true(isfinite(center.x) && isfinite(center.y) && isfinite(width));
+            assert_true(center.x >= -1e-9 && center.x <= pans[i] + 1e-9);
+            assert_true(width >= 1000.0 - 1e-6 && width <= 2000.0 + 1e-6);
+            steps++;
+        }
+        assert_true(steps > 1);
+        assert_true(center.x == pans[i] && width == 2000.0);
+    }
+}
+
+static const neopad_profile_module_t *find_module(const neopad_profile_frame_t *frame, const char *name) {
+    for (uint32_t i = 0; i < frame->module_count; i++) {
+        if (strcmp(frame->modules[i].name, name) == 0) {
+            return &frame->modules[i];
+        }
+    }
+    return NULL;
+}
+
+static void test_tile_cache(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {
+            .width = 640,
+            .height = 480,
+            .content_scale = 1.0f,
+            .headless = true,
+            .tile_cache = true,
+    };
+    assert_true(neopad_renderer_init(renderer, init));
+    neopad_renderer_set_profiling(renderer, true);
+
+    neopad_renderer_begin_points_d(renderer, (neopad_dvec2_t) {0.0, 0.0});
+    neopad_renderer_pen_add_point_d(renderer, (neopad_dvec2_t) {90.0, 45.0});
+    neopad_renderer_end_points(renderer);
+
+    for (int i = 0; i < 3; i++) {
+        neopad_renderer_begin_frame(renderer);
+        neopad_renderer_end_frame(renderer);
+    }
+
+    // The stroke's tiles are drawn in the first frame, and only composited after that.
+    const neopad_profile_module_t *first = find_module(neopad_renderer_get_profile_frame(renderer, 2), "vector");
+    const neopad_profile_module_t *second = find_module(neopad_renderer_get_profile_frame(renderer, 1), "vector");
+    const neopad_profile_module_t *third = find_module(neopad_renderer_get_profile_frame(renderer, 0), "vector");
+    assert_non_null(first);
+    assert_true(second->counters.draw_calls > 0);
+    assert_true(first->counters.draw_calls > second->counters.draw_calls);
+    assert_int_equal(second->counters.draw_calls, third->counters.draw_calls);
+
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+/// The tile cache's tile at level 0, x, y, if it has one.
+static const neopad_tile_t *find_tile(const neopad_tile_cache_t *tiles, int64_t x, int64_t y) {
+    for (uint32_t i = 0; i < tiles->capacity; i++) {
+        const neopad_tile_t *tile = &tiles->tiles[i];
+        if (tile->is_valid && tile->level == 0 && tile->x == x && tile->y == y) {
+            return tile;
+        }
+    }
+    return NULL;
+}
+
+/// Draw a mitered stroke with a sharp corner at `corner`, from and back to 90 to its left.
+static void draw_miter(neopad_renderer_t renderer, neopad_dvec2_t corner) {
+    neopad_renderer_set_stroke_style(renderer, (neopad_stroke_style_t) {
+            .width = 10.0f, .color = 0xff000000, .join = NEOPAD_STROKE_JOIN_MITER,
+            .cap = NEOPAD_STROKE_CAP_BUTT, .miter_limit = 10.0f,
+    });
+    neopad_renderer_begin_points_d(renderer, (neopad_dvec2_t) {corner.x - 90.0, corner.y - 20.0});
+    neopad_renderer_pen_add_point_d(renderer, corner);
+    neopad_renderer_pen_add_point_d(renderer, (neopad_dvec2_t) {corner.x - 90.0, corner.y + 20.0});
+    neopad_renderer_end_points(renderer);
+}
+
+static void test_tile_cache_miters(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {
+            .width = 640,
+            .height = 480,
+            .content_scale = 1.0f,
+            .headless = true,
+            .tile_cache = true,
+    };
+    assert_true(neopad_renderer_init(renderer, init));
+    const neopad_tile_cache_t *tiles =
+            &neopad_renderer_registry_get(&renderer->modules, renderer->builtin.vector).vector->tiles;
+
+    // Tiles are 256 across at zoom 1. Something in the tile at (1, 0), drawn.
+    neopad_renderer_begin_points_d(renderer, (neopad_dvec2_t) {300.0, 100.0});
+    neopad_renderer_pen_add_point_d(renderer, (neopad_dvec2_t) {310.0, 110.0});
+    neopad_renderer_end_points(renderer);
+    draw_frame(renderer);
+    assert_non_null(find_tile(tiles, 1, 0));
+    assert_false(find_tile(tiles, 1, 0)->is_dirty);
+    assert_null(find_tile(tiles, 1, -1));
+
+    // Corners within 5 of x = 256 (half the width short of it): only their miters cross it.
+    // One into a tile already drawn, which is drawn again...
+    draw_miter(renderer, (neopad_dvec2_t) {240.0, 40.0});
+    assert_true(find_tile(tiles, 1, 0)->is_dirty);
+
+    // ...and one into a tile with nothing else in it, which is drawn at all.
+    draw_miter(renderer, (neopad_dvec2_t) {240.0, -40.0});
+    draw_frame(renderer);
+    assert_false(find_tile(tiles, 1, 0)->is_dirty);
+    assert_non_null(find_tile(tiles, 1, -1));
+
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+static void test_tile_pool(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {
+            .width = 3840,
+            .height = 2160,
+            .content_scale = 1.0f,
+            .headless = true,
+            .tile_cache = true,
+    };
+    assert_true(neopad_renderer_init(renderer, init));
+    draw_frame(renderer);
+
+    // At 4K, tiles as small as 256/√2 pixels take 23 by 13 to cover the view.
+    neopad_renderer_module_vector_t vector = neopad_renderer_registry_get(
+            &renderer->modules, renderer->builtin.vector).vector;
+    assert_true(vector->tiles.capacity >= 23 * 13);
+
+    // And more, when the window grows.
+    uint32_t capacity = vector->tiles.capacity;
+    neopad_renderer_resize(renderer, 7680, 4320);
+    draw_frame(renderer);
+    assert_true(vector->tiles.capacity > capacity);
+
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+static void test_shared_renderers(void **state) {
+    neopad_renderer_init_t init = {
+            .width = 640,
+            .height = 480,
+            .content_scale = 1.0f,
+            .headless = true,
+    };
+    neopad_renderer_t first = neopad_renderer_create();
+    assert_true(neopad_renderer_init(first, init));
+
+    init.share = first;
+    neopad_renderer_t second = neopad_renderer_create();
+    assert_true(neopad_renderer_init(second, init));
+
+    neopad_renderer_begin_frame(second);
+    neopad_renderer_end_frame(second);
+    neopad_renderer_begin_frame(first);
+    neopad_renderer_end_frame(first);
+    assert_false(neopad_renderer_needs_frame(first));
+
+    // A stroke finished in one window shows in the other.
+    neopad_renderer_begin_points_d(second, (neopad_dvec2_t) {0.0, 0.0});
+    neopad_renderer_pen_add_point_d(second, (neopad_dvec2_t) {90.0, 45.0});
+    neopad_renderer_end_points(second);
+    assert_true(neopad_renderer_needs_frame(first));
+    rect_t dirty;
+    neopad_renderer_get_dirty_rect(first, &dirty);
+    assert_true(dirty.min[0] <= 0.0f && dirty.max[0] >= 90.0f);
+
+    neopad_renderer_shutdown(second);
+    neopad_renderer_destroy(second);
+    neopad_renderer_shutdown(first);
+    neopad_renderer_destroy(first);
+}
+
+static void test_shared_hand_off(void **state) {
+    neopad_renderer_init_t init = {
+            .width = 640,
+            .height = 480,
+            .content_scale = 1.0f,
+            .headless = true,
+    };
+    neopad_renderer_t first = neopad_renderer_create();
+    assert_true(neopad_renderer_init(first, init));
+
+    init.share = first;
+    neopad_renderer_t second = neopad_renderer_create();
+    assert_true(neopad_renderer_init(second, init));
+    neopad_renderer_t third = neopad_renderer_create();
+    assert_true(neopad_renderer_init(third, init));
+
+    neopad_renderer_begin_points_d(second, (neopad_dvec2_t) {0.0, 0.0});
+    neopad_renderer_pen_add_point_d(second, (neopad_dvec2_t) {90.0, 45.0});
+    neopad_renderer_end_points(second);
+
+    // The renderer shared with goes first: another keeps the stroke, and submits.
+    neopad_renderer_shutdown(first);
+    neopad_renderer_destroy(first);
+    assert_true(neopad_renderer_group_primary(second) == second);
+    assert_true(neopad_renderer_group_primary(third) == second);
+
+    neopad_renderer_module_vector_t vector =
+            neopad_renderer_registry_get(&second->modules, second->builtin.vector).vector;
+    assert_true(vector->store == vector);
+    assert_int_equal(vector->strokes.size, 1);
+    assert_true(neopad_renderer_registry_get(&third->modules, third->builtin.vector).vector->store == vector);
+
+    // Strokes finished from then on go to the same storage.
+    neopad_renderer_begin_points_d(third, (neopad_dvec2_t) {10.0, 10.0});
+    neopad_renderer_pen_add_point_d(third, (neopad_dvec2_t) {20.0, 30.0});
+    neopad_renderer_end_points(third);
+    assert_int_equal(vector->strokes.size, 2);
+    assert_true(neopad_renderer_needs_frame(second));
+
+    draw_frame(third);
+    draw_frame(second);
+    assert_false(neopad_renderer_needs_frame(second));
+
+    neopad_renderer_shutdown(second);
+    neopad_renderer_destroy(second);
+    neopad_renderer_shutdown(third);
+    neopad_renderer_destroy(third);
+}
+
+#pragma mark - Module Registry
+
+/// A module that counts its calls, and (optionally) registers or unregisters modules from its hooks.
+typedef struct probe_module_s {
+    struct neopad_renderer_module_base_s base;
+    int begin_frames;
+    int end_frames;
+    bool is_destroyed;
+
+    /// Registered on the first begin_frame, and unregistered (along with this) on the second.
+    struct probe_module_s *child;
+    neopad_renderer_module_id_t id;
+    neopad_renderer_module_id_t child_id;
+} probe_module_t;
+
+static void probe_on_begin_frame(neopad_renderer_module_t module, neopad_renderer_t renderer) {
+    probe_module_t *probe = (probe_module_t *) module.base;
+    probe->begin_frames++;
+    if (!probe->child) {
+        return;
+    }
+    if (probe->begin_frames == 1) {
+        probe->child_id = neopad_renderer_register_module(renderer, &probe->child->base);
+    } else if (probe->begin_frames == 2) {
+        neopad_renderer_unregister_module(renderer, probe->child_id);
+        neopad_renderer_unregister_module(renderer, probe->id);
+    }
+}
+
+static void probe_on_end_frame(neopad_renderer_module_t module, neopad_renderer_t renderer) {
+    ((probe_module_t *) module.base)->end_frames++;
+}
+
+static void probe_destroy(neopad_renderer_module_t module) {
+    ((probe_module_t *) module.base)->is_destroyed = true;
+}
+
+static probe_module_t make_probe(const char *name, int32_t order) {
+    return (probe_module_t) {
+            .base = {
+                    .name = name,
+                    .order = order,
+                    .on_begin_frame = probe_on_begin_frame,
+                    .on_end_frame = probe_on_end_frame,
+                    .destroy = probe_destroy,
+            },
+            .id = NEOPAD_RENDERER_MODULE_NONE,
+            .child_id = NEOPAD_RENDERER_MODULE_NONE,
+    };
+}
+
+static void test_registry_between_frames(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {.width = 640, .height = 480, .content_scale = 1.0f, .headless = true};
+    assert_true(neopad_renderer_init(renderer, init));
+
+    probe_module_t probe = make_probe("probe", NEOPAD_RENDERER_ORDER_OVERLAY);
+    neopad_renderer_module_id_t id = neopad_renderer_register_module(renderer, &probe.base);
+    assert_int_not_equal(id, NEOPAD_RENDERER_MODULE_NONE);
+    assert_int_equal(neopad_renderer_find_module(renderer, "probe"), id);
+
+    draw_frame(renderer);
+    assert_int_equal(probe.begin_frames, 1);
+    assert_int_equal(probe.end_frames, 1);
+
+    neopad_renderer_unregister_module(renderer, id);
+    assert_true(probe.is_destroyed);
+    assert_int_equal(neopad_renderer_find_module(renderer, "probe"), NEOPAD_RENDERER_MODULE_NONE);
+
+    draw_frame(renderer);
+    assert_int_equal(probe.begin_frames, 1);
+    assert_int_equal(probe.end_frames, 1);
+
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+static void test_registry_from_hooks(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {.width = 640, .height = 480, .content_scale = 1.0f, .headless = true};
+    assert_true(neopad_renderer_init(renderer, init));
+
+    // The child goes after its parent, so it would be next in the phase the parent changes.
+    probe_module_t child = make_probe("child", NEOPAD_RENDERER_ORDER_OVERLAY + 1);
+    probe_module_t parent = make_probe("parent", NEOPAD_RENDERER_ORDER_OVERLAY);
+    parent.child = &child;
+    parent.id = neopad_renderer_register_module(renderer, &parent.base);
+
+    // Registered during begin_frame: called from the next phase on.
+    draw_frame(renderer);
+    assert_int_not_equal(parent.child_id, NEOPAD_RENDERER_MODULE_NONE);
+    assert_int_equal(child.begin_frames, 0);
+    assert_int_equal(child.end_frames, 1);
+
+    // Unregistered during begin_frame (the parent by itself): neither is called again, and both
+    // are destroyed once the phase is over.
+    draw_frame(renderer);
+    assert_int_equal(parent.begin_frames, 2);
+    assert_int_equal(child.begin_frames, 0);
+    assert_int_equal(parent.end_frames, 1);
+    assert_int_equal(child.end_frames, 1);
+    assert_true(parent.is_destroyed);
+    assert_true(child.is_destroyed);
+    assert_int_equal(neopad_renderer_find_module(renderer, "parent"), NEOPAD_RENDERER_MODULE_NONE);
+
+    // Their slots can be taken again.
+    probe_module_t probe = make_probe("probe", NEOPAD_RENDERER_ORDER_OVERLAY);
+    assert_int_not_equal(neopad_renderer_register_module(renderer, &probe.base), NEOPAD_RENDERER_MODULE_NONE);
+    draw_frame(renderer);
+    assert_int_equal(probe.begin_frames, 1);
+
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+#pragma mark - Render Graph
+
+static bgfx_view_id_t view_of(neopad_renderer_t renderer, neopad_renderer_pass_id_t id) {
+    assert_int_not_equal(id, NEOPAD_RENDERER_PASS_NONE);
+    return renderer->graph.passes[id].view_id;
+}
+
+static void test_graph_order(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {.width = 640, .height = 480, .content_scale = 1.0f, .headless = true};
+    assert_true(neopad_renderer_init(renderer, init));
+
+    neopad_renderer_pass_desc_t desc = {
+            .name = "first",
+            .order = NEOPAD_RENDERER_ORDER_OVERLAY,
+            .output = BGFX_INVALID_HANDLE,
+            .transform = NEOPAD_RENDERER_PASS_TRANSFORM_CUSTOM,
+    };
+    neopad_renderer_pass_id_t first = neopad_renderer_declare_pass(renderer, &desc);
+    desc.name = "second";
+    neopad_renderer_pass_id_t second = neopad_renderer_declare_pass(renderer, &desc);
+    assert_true(view_of(renderer, renderer->content_pass) < view_of(renderer, first));
+    assert_true(view_of(renderer, first) < view_of(renderer, second));
+
+    // A pass declared later goes later among those at its order, even in a slot freed before.
+    neopad_renderer_release_pass(renderer, first);
+    desc.name = "third";
+    neopad_renderer_pass_id_t third = neopad_renderer_declare_pass(renderer, &desc);
+    assert_int_equal(third, first);
+    assert_true(view_of(renderer, second) < view_of(renderer, third));
+
+    // Passes come after what they read from, whatever their order.
+    bgfx_frame_buffer_handle_t offscreen = {.idx = 7};
+    neopad_renderer_pass_id_t reader = neopad_renderer_declare_pass(renderer, &(neopad_renderer_pass_desc_t) {
+            .name = "reader",
+            .order = NEOPAD_RENDERER_ORDER_OFFSCREEN,
+            .output = BGFX_INVALID_HANDLE,
+            .inputs = {offscreen},
+            .input_count = 1,
+    });
+    neopad_renderer_pass_id_t writer = neopad_renderer_declare_pass(renderer, &(neopad_renderer_pass_desc_t) {
+            .name = "writer",
+            .order = NEOPAD_RENDERER_ORDER_OVERLAY,
+            .output = offscreen,
+            .width = 64,
+            .height = 64,
+    });
+    assert_true(view_of(renderer, writer) < view_of(renderer, reader));
+
+    neopad_renderer_release_pass(renderer, writer);
+    neopad_renderer_release_pass(renderer, reader);
+    neopad_renderer_release_pass(renderer, second);
+    neopad_renderer_release_pass(renderer, third);
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+static void test_graph_merge(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {.width = 640, .height = 480, .content_scale = 1.0f, .headless = true};
+    assert_true(neopad_renderer_init(renderer, init));
+
+    // Declared the same way as the content pass: the same pass, until every declaration is released.
+    neopad_renderer_pass_desc_t content = neopad_renderer_content_pass_desc();
+    uint32_t references = renderer->graph.passes[renderer->content_pass].references;
+    assert_int_equal(neopad_renderer_declare_pass(renderer, &content), renderer->content_pass);
+    assert_int_equal(renderer->graph.passes[renderer->content_pass].references, references + 1);
+    neopad_renderer_release_pass(renderer, renderer->content_pass);
+    assert_int_equal(renderer->graph.passes[renderer->content_pass].references, references);
+
+    // Not when anything differs, or when it reads from something.
+    content.order++;
+    neopad_renderer_pass_id_t later = neopad_renderer_declare_pass(renderer, &content);
+    assert_int_not_equal(later, renderer->content_pass);
+    content.order--;
+    content.inputs[0] = (bgfx_frame_buffer_handle_t) {.idx = 7};
+    content.input_count = 1;
+    neopad_renderer_pass_id_t reader = neopad_renderer_declare_pass(renderer, &content);
+    assert_int_not_equal(reader, renderer->content_pass);
+
+    neopad_renderer_release_pass(renderer, reader);
+    neopad_renderer_release_pass(renderer, later);
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+static void test_graph_cycle(void **state) {
+    neopad_renderer_t renderer = neopad_renderer_create();
+    neopad_renderer_init_t init = {.width = 640, .height = 480, .content_scale = 1.0f, .headless = true};
+    assert_true(neopad_renderer_init(renderer, init));
+    uint32_t count = renderer->graph.count;
+
+    // Each reads from what the other draws into.
+    bgfx_frame_buffer_handle_t a = {.idx = 7};
+    bgfx_frame_buffer_handle_t b = {.idx = 8};
+    neopad_renderer_pass_id_t first = neopad_renderer_declare_pass(renderer, &(neopad_renderer_pass_desc_t) {
+            .name = "a", .output = a, .width = 64, .height = 64, .inputs = {b}, .input_count = 1,
+    });
+    assert_int_not_equal(first, NEOPAD_RENDERER_PASS_NONE);
+    neopad_renderer_pass_id_t second = neopad_renderer_declare_pass(renderer, &(neopad_renderer_pass_desc_t) {
+            .name = "b", .output = b, .width = 64, .height = 64, .inputs = {a}, .input_count = 1,
+    });
+    assert_int_equal(second, NEOPAD_RENDERER_PASS_NONE);
+    assert_int_equal(renderer->graph.count, count + 1);
+
+    // A failed declaration can be used (and is not drawn).
+    assert_int_equal(neopad_renderer_use_pass(renderer, second), NEOPAD_RENDERER_VIEW_NONE);
+    neopad_renderer_set_pass_output(renderer, second, a, 64, 64);
+    neopad_renderer_release_pass(renderer, second);
+
+    neopad_renderer_release_pass(renderer, first);
+    assert_int_equal(renderer->graph.count, count);
+    draw_frame(renderer);
+
+    neopad_renderer_shutdown(renderer);
+    neopad_renderer_destroy(renderer);
+}
+
+#pragma mark - Jobs
+
+/// Workers for the job tests: a few, whatever the machine.
+#define TEST_JOBS_WORKERS 3
+
+static void count_job(void *data) {
+    atomic_fetch_add((atomic_uint *) data, 1);
+}
+
+/// A node of a binary tree of jobs, each forking and joining its two children.
+typedef struct tree_job_s {
+    neopad_jobs_t jobs;
+    uint32_t depth;
+    atomic_uint *leaves;
+} tree_job_t;
+
+static void tree_job(void *data) {
+    const tree_job_t *job = data;
+    if (job->depth == 0) {
+        atomic_fetch_add(job->leaves, 1);
+        return;
+    }
+
+    tree_job_t children[2] = {
+            {.jobs = job->jobs, .depth = job->depth - 1, .leaves = job->leaves},
+            {.jobs = job->jobs, .depth = job->depth - 1, .leaves = job->leaves},
+    };
+    neopad_job_counter_t counter = NEOPAD_JOB_COUNTER_INIT;
+    neopad_jobs_fork(job->jobs, tree_job, &children[0], &counter);
+    neopad_jobs_fork(job->jobs, tree_job, &children[1], &counter);
+    neopad_jobs_join(job->jobs, &counter);
+}
+
+/// Counts, per item, how often a parallel for ran it.
+typedef struct range_counts_s {
+    atomic_uint *counts;
+    size_t count;
+    size_t grain;
+    atomic_bool is_bad;
+} range_counts_t;
+
+static void count_range(void *context, size_t begin, size_t end) {
+    range_counts_t *counts = context;
+    if (begin >= end || end > counts->count || end - begin > counts->grain) {
+        atomic_store(&counts->is_bad, true);
+        return;
+    }
+    for (size_t i = begin; i < end; i++) {
+        atomic_fetch_add(&counts->counts[i], 1);
+    }
+}
+
+static void test_jobs_lifecycle(void **state) {
+    // One worker per core (less this thread), however many that is.
+    neopad_jobs_t jobs = neopad_jobs_create(0);
+    assert_non_null(jobs);
+    assert_true(neopad_jobs_thread_count(jobs) >= 1);
+    neopad_jobs_destroy(jobs);
+
+    jobs = neopad_jobs_create(TEST_JOBS_WORKERS);
+    assert_non_null(jobs);
+    assert_int_equal(neopad_jobs_thread_count(jobs), TEST_JOBS_WORKERS + 1);
+    neopad_jobs_destroy(jobs);
+
+    jobs = neopad_jobs_create(NEOPAD_JOBS_MAX_WORKERS + 1);
+    assert_non_null(jobs);
+    assert_int_equal(neopad_jobs_thread_count(jobs), NEOPAD_JOBS_MAX_WORKERS + 1);
+
+    // Destroyed having run something, too.
+    atomic_uint ran = 0;
+    neopad_job_counter_t counter = NEOPAD_JOB_COUNTER_INIT;
+    neopad_jobs_fork(jobs, count_job, &ran, &counter);
+    neopad_jobs_join(jobs, &counter);
+    assert_int_equal(atomic_load(&ran), 1);
+    neopad_jobs_destroy(jobs);
+
+    // No system at all: jobs are run there and then.
+    assert_int_equal(neopad_jobs_thread_count(NULL), 1);
+    neopad_jobs_fork(NULL, count_job, &ran, &counter);
+    assert_int_equal(atomic_load(&ran), 2);
+    neopad_jobs_join(NULL, &counter);
+    neopad_jobs_destroy(NULL);
+}
+
+static void test_jobs_recursive(void **state) {
+    neopad_jobs_t jobs = neopad_jobs_create(TEST_JOBS_WORKERS);
+    assert_non_null(jobs);
+
+    for (uint32_t depth = 0; depth <= 12; depth += 4) {
+        atomic_uint leaves = 0;
+        tree_job_t root = {.jobs = jobs, .depth = depth, .leaves = &leaves};
+        neopad_job_counter_t counter = NEOPAD_JOB_COUNTER_INIT;
+        neopad_jobs_fork(jobs, tree_job, &root, &counter);
+        neopad_jobs_join(jobs, &counter);
+        assert_int_equal(atomic_load(&leaves), 1u << depth);
+    }
+
+    neopad_jobs_destroy(jobs);
+}
+
+static void test_jobs_past_capacity(void **state) {
+    neopad_jobs_t jobs = neopad_jobs_create(TEST_JOBS_WORKERS);
+    assert_non_null(jobs);
+
+    // More than the deque holds: those that do not fit are run as they are forked.
+    const size_t count = 3 * NEOPAD_JOBS_DEQUE_CAPACITY + 1;
+    atomic_uint *counts = calloc(count, sizeof(atomic_uint));
+    assert_non_null(counts);
+    neopad_job_counter_t counter = NEOPAD_JOB_COUNTER_INIT;
+    for (size_t i = 0; i < count; i++) {
+        neopad_jobs_fork(jobs, count_job, &counts[i], &counter);
+    }
+    neopad_jobs_join(jobs, &counter);
+    assert_int_equal(atomic_load(&counter.pending), 0);
+    for (size_t i = 0; i < count; i++) {
+        assert_int_equal(atomic_load(&counts[i]), 1);
+    }
+
+    free(counts);
+    neopad_jobs_destroy(jobs);
+}
+
+static void test_jobs_parallel_for(void **state) {
+    neopad_jobs_t systems[] = {NULL, neopad_jobs_create(TEST_JOBS_WORKERS)};
+    assert_non_null(systems[1]);
+
+    // Around the grain (one range, or two), and well past it.
+    const size_t grain = 16;
+    const size_t counts[] = {0, 1, grain - 1, grain, grain + 1, 2 * grain - 1, 2 * grain, 2 * grain + 1, 1000};
+    atomic_uint items[1000];
+
+    for (size_t s = 0; s < sizeof(systems) / sizeof(systems[0]); s++) {
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            for (size_t i = 0; i < counts[c]; i++) {
+                atomic_init(&items[i], 0);
+            }
+            range_counts_t context = {.counts = items, .count = counts[c], .grain = grain};
+            atomic_init(&context.is_bad, false);
+
+            neopad_jobs_parallel_for(systems[s], counts[c], grain, count_range, &context);
+            assert_false(atomic_load(&context.is_bad));
+            for (size_t i = 0; i < counts[c]; i++) {
+                assert_int_equal(atomic_load(&items[i]), 1);
+            }
+        }
+    }
+
+    neopad_jobs_destroy(systems[1]);
+}
+
+#pragma mark - Containers
+
+static uint32_t next_random(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static int compare_int32(const void *a, const void *b) {
+    const int32_t x = *(const int32_t *) a;
+    const int32_t y = *(const int32_t *) b;
+    return (x > y) - (x < y);
+}
+
+static int compare_int32_descending(const void *a, const void *b) {
+    return compare_int32(b, a);
+}
+
+static int descending(int32_t *a, int32_t *b) {
+    return *a > *b;
+}
+
+typedef enum sort_input_e {
+    SORT_RANDOM,
+    SORT_SORTED,
+    SORT_REVERSED,
+    SORT_DUPLICATES,
+    SORT_EXTREMES,
+    SORT_INPUT_COUNT,
+} sort_input_t;
+
+/// Fill a vector with `count` values of a kind, and a copy of them sorted by qsort.
+static int32_t *fill_sort_input(vec_int32_t *vec, size_t count, sort_input_t input,
+                                int (*reference)(const void *, const void *)) {
+    uint32_t state = 0x2545F491u + (uint32_t) count;
+    vec_int32_t_clear(vec);
+    for (size_t i = 0; i < count; i++) {
+        int32_t value;
+        switch (input) {
+            case SORT_RANDOM:
+                value = (int32_t) next_random(&state);
+                break;
+            case SORT_SORTED:
+                value = (int32_t) i - (int32_t) (count / 2);
+                break;
+            case SORT_REVERSED:
+                value = (int32_t) (count / 2) - (int32_t) i;
+                break;
+            case SORT_DUPLICATES:
+                value = (int32_t) (next_random(&state) % 4) - 2;
+                break;
+            default: {
+                const int32_t extremes[] = {INT32_MIN, -1, 0, 1, INT32_MAX, INT32_MIN + 1, INT32_MAX - 1, -256, 256};
+                value = extremes[next_random(&state) % 9];
+                break;
+            }
+        }
+        vec_int32_t_push_back(vec, value);
+    }
+
+    int32_t *expected = malloc((count > 0 ? count : 1) * sizeof(int32_t));
+    if (count > 0) {
+        memcpy(expected, vec->vector, count * sizeof(int32_t));
+        qsort(expected, count, sizeof(int32_t), reference);
+    }
+    return expected;
+}
+
+static void assert_sorted_as(const vec_int32_t *vec, const int32_t *expected, size_t count) {
+    assert_int_equal(vec->size, count);
+    if (count > 0) {
+        assert_memory_equal(vec->vector, expected, count * sizeof(int32_t));
+    }
+}
+
+static void test_vector_sort(void **state) {
+    // Around the insertion sort cutoff and the radix sort's minimum, and well past both.
+    const size_t counts[] = {0, 1, 2, 15, 16, 17, 63, 64, 65, 1000, 20000};
+    vec_int32_t vec = vec_int32_t_init();
+    int (*const default_compare)(int32_t *, int32_t *) = vec.compare;
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        for (sort_input_t input = 0; input < SORT_INPUT_COUNT; input++) {
+            // The default compare (radix sort, from 64 on, with negatives ordered before positives).
+            int32_t *expected = fill_sort_input(&vec, counts[c], input, compare_int32);
+            vec_int32_t_sort(&vec);
+            assert_sorted_as(&vec, expected, counts[c]);
+            free(expected);
+
+            // A compare of our own (introsort).
+            expected = fill_sort_input(&vec, counts[c], input, compare_int32_descending);
+            vec.compare = descending;
+            vec_int32_t_sort(&vec);
+            vec.compare = default_compare;
+            assert_sorted_as(&vec, expected, counts[c]);
+            free(expected);
+        }
+    }
+    vec_int32_t_free(&vec);
+
+    // Unsigned, with the top bit set: not flipped.
+    vec_uint32_t unsigned_vec = vec_uint32_t_init();
+    uint32_t random = 1;
+    for (int i = 0; i < 1000; i++) {
+        vec_uint32_t_push_back(&unsigned_vec, next_random(&random) | (i % 2 ? 0x80000000u : 0));
+    }
+    vec_uint32_t_sort(&unsigned_vec);
+    for (size_t i = 1; i < unsigned_vec.size; i++) {
+        assert_true(unsigned_vec.vector[i - 1] <= unsigned_vec.vector[i]);
+    }
+    vec_uint32_t_free(&unsigned_vec);
+}
+
+#ifdef CTL_PARALLEL_SORT
+static void test_vector_parallel_sort(void **state) {
+    // Past the parallel minimum, in runs that do not pair off evenly (nor split the count evenly).
+    const size_t count = CTL_PARALLEL_SORT_MIN * 3 + 7;
+    const unsigned threads[] = {1, 2, 3, 5, 7};
+    vec_int32_t vec = vec_int32_t_init();
+    int (*const default_compare)(int32_t *, int32_t *) = vec.compare;
+
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        for (sort_input_t input = 0; input < SORT_INPUT_COUNT; input++) {
+            int32_t *expected = fill_sort_input(&vec, count, input, compare_int32);
+            vec_int32_t_parallel_sort(&vec, threads[t]);
+            assert_sorted_as(&vec, expected, count);
+            free(expected);
+
+            expected = fill_sort_input(&vec, count, input, compare_int32_descending);
+            vec.compare = descending;
+            vec_int32_t_parallel_sort(&vec, threads[t]);
+            assert_sorted_as(&vec, expected, count);
+            free(expected);
+            vec.compare = default_compare;
+        }
+    }
+    vec_int32_t_free(&vec);
+}
+#endif
+
+static void test_flat_set_empty(void **state) {
+    ufset_uint32_t set = ufset_uint32_t_init(NULL, NULL);
+    assert_true(ufset_uint32_t_empty(&set));
+    assert_int_equal(ufset_uint32_t_capacity(&set), 0);
+    assert_null(ufset_uint32_t_find(&set, 42));
+    assert_false(ufset_uint32_t_contains(&set, 0));
+    assert_int_equal(ufset_uint32_t_count(&set, 0), 0);
+    assert_false(ufset_uint32_t_erase(&set, 42));
+
+    int visited = 0;
+    ufset_foreach(uint32_t, &set, value) {
+        visited++;
+    }
+    assert_int_equal(visited, 0);
+
+    // Clearing or freeing a table that never allocated is fine, and it can be used after.
+    ufset_uint32_t_clear(&set);
+    ufset_uint32_t_free(&set);
+    ufset_uint32_t_free(&set);
+    assert_int_equal(*ufset_uint32_t_insert(&set, 7), 7);
+    assert_true(ufset_uint32_t_contains(&set, 7));
+    ufset_uint32_t_free(&set);
+    assert_true(ufset_uint32_t_empty(&set));
+    assert_false(ufset_uint32_t_contains(&set, 7));
+}
+
+static void test_flat_set_rehash(void **state) {
+    // Dense ids, as the identity hash sees them, and their multiples (which share low bits).
+    const uint32_t count = 5000;
+    ufset_uint32_t set = ufset_uint32_t_init(NULL, NULL);
+    size_t capacity = 0, growths = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        int found = -1;
+        assert_int_equal(*ufset_uint32_t_insert_found(&set, i * 64, &found), i * 64);
+        assert_int_equal(found, 0);
+        if (ufset_uint32_t_capacity(&set) != capacity) {
+            capacity = ufset_uint32_t_capacity(&set);
+            growths++;
+        }
+    }
+    assert_true(growths > 5);
+    assert_int_equal(set.size, count);
+
+    // Everything inserted is still there after every rehash, and nothing else is.
+    for (uint32_t i = 0; i < count; i++) {
+        assert_true(ufset_uint32_t_contains(&set, i * 64));
+        assert_false(ufset_uint32_t_contains(&set, i * 64 + 1));
+    }
+
+    // Inserting again finds what is there.
+    int found = 0;
+    ufset_uint32_t_insert_found(&set, 64, &found);
+    assert_int_equal(found, 1);
+    assert_int_equal(set.size, count);
+
+    // Erase every other value: the rest are still found (past the tombstones).
+    for (uint32_t i = 0; i < count; i += 2) {
+        assert_true(ufset_uint32_t_erase(&set, i * 64));
+    }
+    assert_false(ufset_uint32_t_erase(&set, 0));
+    assert_int_equal(set.size, count / 2);
+    for (uint32_t i = 0; i < count; i++) {
+        assert_int_equal(ufset_uint32_t_contains(&set, i * 64), i % 2);
+    }
+
+    size_t visited = 0;
+    ufset_foreach(uint32_t, &set, value) {
+        assert_int_equal(*value / 64 % 2, 1);
+        visited++;
+    }
+    assert_int_equal(visited, count / 2);
+
+    // Reserving room up front means no rehash while inserting.
+    ufset_uint32_t reserved = ufset_uint32_t_init(NULL, NULL);
+    ufset_uint32_t_reserve(&reserved, count);
+    capacity = ufset_uint32_t_capacity(&reserved);
+    for (uint32_t i = 0; i < count; i++) {
+        ufset_uint32_t_insert(&reserved, i);
+    }
+    assert_int_equal(ufset_uint32_t_capacity(&reserved), capacity);
+
+    ufset_uint32_t_free(&reserved);
+    ufset_uint32_t_free(&set);
+}
+
+static void test_flat_set_churn(void **state) {
+    // A steady hundred values, each erased and replaced by a new one, many times over.
+    const uint32_t live = 100;
+    ufset_uint32_t set = ufset_uint32_t_init(NULL, NULL);
+    for (uint32_t i = 0; i < live; i++) {
+        ufset_uint32_t_insert(&set, i);
+    }
+    const size_t capacity = ufset_uint32_t_capacity(&set);
+
+    for (uint32_t i = live; i < 100000; i++) {
+        assert_true(ufset_uint32_t_erase(&set, i - live));
+        ufset_uint32_t_insert(&set, i);
+        assert_int_equal(set.size, live);
+    }
+
+    // Tombstones were reused, or cleaned up in place: the table grew at most once (to keep values
+    // under half full), not with every value ever inserted.
+    assert_true(ufset_uint32_t_capacity(&set) <= capacity * 2);
+    for (uint32_t i = 0; i < 100000; i++) {
+        assert_int_equal(ufset_uint32_t_contains(&set, i), i >= 100000 - live);
+    }
+
+    ufset_uint32_t_free(&set);
+}
+
+static void test_flat_map(void **state) {
+    ufmap_named_t map = ufmap_named_t_init(named_hash, named_equal);
+    for (uint32_t id = 0; id < 1000; id++) {
+        ufmap_named_t_insert(&map, (named_t) {id, name_of(id)});
+    }
+
+    // Inserting a key that is there keeps the value there (and frees the one given).
+    named_t *kept = ufmap_named_t_insert(&map, (named_t) {3, name_of(33)});
+    assert_string_equal(kept->name, "#3");
+
+    // Assigning replaces the value (freeing the old one), without adding an entry.
+    named_t *assigned = ufmap_named_t_insert_or_assign(&map, (named_t) {3, name_of(33)});
+    assert_int_equal(assigned->id, 3);
+    assert_string_equal(assigned->name, "#33");
+    assert_int_equal(map.size, 1000);
+
+    // Or adds one, for a new key.
+    assigned = ufmap_named_t_insert_or_assign(&map, (named_t) {1000, name_of(1000)});
+    assert_string_equal(assigned->name, "#1000");
+    assert_int_equal(map.size, 1001);
+
+    // Find and erase by key alone.
+    assert_string_equal(ufmap_named_t_find(&map, (named_t) {.id = 3})->name, "#33");
+    assert_null(ufmap_named_t_find(&map, (named_t) {.id = 1001}));
+    assert_true(ufmap_named_t_erase(&map, (named_t) {.id = 3}));
+    assert_false(ufmap_named_t_contains(&map, (named_t) {.id = 3}));
+    assert_int_equal(map.size, 1000);
+
+    // Freeing frees every value left.
+    ufmap_named_t_free(&map);
+}
+
+static void test_arena(void **state) {
+    ctl_arena arena;
+    ctl_arena_init(&arena, 1024);
+
+    // Allocations are aligned for anything, and do not overlap.
+    char *a = ctl_arena_alloc(&arena, 10);
+    char *b = ctl_arena_alloc(&arena, 10);
+    assert_int_equal((uintptr_t) a % CTL_ALLOCATOR_ALIGN, 0);
+    assert_int_equal((uintptr_t) b % CTL_ALLOCATOR_ALIGN, 0);
+    assert_true(b >= a + 10);
+
+    // The last allocation grows in place; an earlier one moves, keeping what it held.
+    assert_true(ctl_arena_realloc(&arena, b, 10, 500) == b);
+    assert_int_equal(arena.allocated, CTL_ALLOCATOR_ROUND(10) + CTL_ALLOCATOR_ROUND(500));
+    memset(a, 'a', 10);
+    char *moved = ctl_arena_realloc(&arena, a, 10, 100);
+    assert_true(moved != a);
+    assert_memory_equal(moved, "aaaaaaaaaa", 10);
+
+    // Giving back the last allocation makes room for the next; giving back an earlier one does nothing.
+    ctl_arena_release(&arena, moved);
+    assert_true(ctl_arena_alloc(&arena, 100) == moved);
+    const size_t allocated = arena.allocated;
+    ctl_arena_release(&arena, b);
+    assert_int_equal(arena.allocated, allocated);
+
+    // Larger than a chunk: a chunk of its own.
+    char *big = ctl_arena_alloc(&arena, 4096);
+    memset(big, 0, 4096);
+
+    // Reset takes everything back, keeping the chunks: the same allocations land in the same places.
+    const size_t sizes[] = {300, 700, 5000, 10, 1000, 200};
+    void *first[6], *again[6];
+    size_t chunks = 0, chunks_again = 0;
+    ctl_arena_reset(&arena);
+    assert_int_equal(arena.allocated, 0);
+    for (int i = 0; i < 6; i++) {
+        first[i] = ctl_arena_alloc(&arena, sizes[i]);
+    }
+    assert_true(first[0] == a);
+    for (ctl_arena_chunk *chunk = arena.first; chunk; chunk = chunk->next) {
+        chunks++;
+    }
+    ctl_arena_reset(&arena);
+    for (int i = 0; i < 6; i++) {
+        again[i] = ctl_arena_alloc(&arena, sizes[i]);
+    }
+    for (ctl_arena_chunk *chunk = arena.first; chunk; chunk = chunk->next) {
+        chunks_again++;
+    }
+    assert_memory_equal(first, again, sizeof(first));
+    assert_int_equal(chunks, chunks_again);
+
+    // A lone vector grows in place, without copying.
+    ctl_arena_reset(&arena);
+    vec_int32_t vec = vec_int32_t_init();
+    vec_int32_t_set_allocator(&vec, ctl_arena_allocator(&arena));
+    vec_int32_t_push_back(&vec, 0);
+    const int32_t *vector = vec.vector;
+    for (int32_t i = 1; i < 200; i++) {
+        vec_int32_t_push_back(&vec, i);
+    }
+    assert_true(vec.vector == vector);
+    for (int32_t i = 0; i < 200; i++) {
+        assert_int_equal(vec.vector[i], i);
+    }
+    vec_int32_t_free(&vec);
+
+    ctl_arena_free(&arena);
+}
+
+static void test_pool(void **state) {
+    ctl_arena fallback;
+    ctl_arena_init(&fallback, 0);
+    ctl_pool pool;
+    ctl_pool_init(&pool, 24);
+    pool.fallback = ctl_arena_allocator(&fallback);
+
+    // Blocks are aligned, and those freed are handed out again (the last freed first).
+    void *a = ctl_pool_alloc(&pool, 24);
+    void *b = ctl_pool_alloc(&pool, 24);
+    char *c = ctl_pool_alloc(&pool, 24);
+    assert_int_equal((uintptr_t) b % CTL_ALLOCATOR_ALIGN, 0);
+    assert_true(a != b && b != (void *) c);
+    ctl_pool_release(&pool, a, 24);
+    ctl_pool_release(&pool, b, 24);
+    assert_true(ctl_pool_alloc(&pool, 24) == b);
+    assert_true(ctl_pool_alloc(&pool, 8) == a);
+    void *d = ctl_pool_alloc(&pool, 24);
+    assert_true(d != a && d != b && d != (void *) c);
+
+    // Anything larger than a block goes to the fallback.
+    const size_t blocks = pool.arena.allocated;
+    void *big = ctl_pool_alloc(&pool, 1000);
+    assert_non_null(big);
+    assert_int_equal(pool.arena.allocated, blocks);
+    assert_int_equal(fallback.allocated, CTL_ALLOCATOR_ROUND(1000));
+
+    // Growing a block past the block size moves it there too, freeing the block.
+    memset(c, 'c', 24);
+    char *grown = ctl_pool_realloc(&pool, c, 24, 200);
+    assert_memory_equal(grown, "cccccccccccccccccccccccc", 24);
+    assert_int_equal(fallback.allocated, CTL_ALLOCATOR_ROUND(1000) + CTL_ALLOCATOR_ROUND(200));
+    assert_true(ctl_pool_alloc(&pool, 24) == c);
+    ctl_pool_release(&pool, grown, 200);
+    assert_int_equal(fallback.allocated, CTL_ALLOCATOR_ROUND(1000));
+
+    // Reset takes back every block (and forgets the free list): the first is handed out again.
+    ctl_pool_release(&pool, d, 24);
+    ctl_pool_reset(&pool);
+    assert_true(ctl_pool_alloc(&pool, 24) == a);
+    assert_true(ctl_pool_alloc(&pool, 24) == b);
+
+    ctl_pool_free(&pool);
+    ctl_arena_free(&fallback);
+}
+
+static int named_compare(named_t *a, named_t *b) {
+    return (a->id > b->id) - (a->id < b->id);
+}
+
+static void test_map_insert_or_assign(void **state) {
+    // Nodes from a pool, so that a node freed while still in the tree would be handed out again.
+    ctl_pool pool;
+    ctl_pool_init(&pool, sizeof(map_named_t_node));
+    map_named_t map = map_named_t_init(named_compare);
+    map_named_t_set_allocator(&map, ctl_pool_allocator(&pool));
+    for (uint32_t id = 0; id < 100; id++) {
+        map_named_t_insert(&map, (named_t) {id, name_of(id)});
+    }
+
+    // Assigning to a key that is there keeps its node in the tree, with the new value (the old one freed).
+    for (uint32_t id = 0; id < 100; id += 3) {
+        map_named_t_it it = map_named_t_insert_or_assign(&map, (named_t) {id, name_of(id + 1000)});
+        assert_int_equal(it.ref->id, id);
+        void *next = ctl_pool_alloc(&pool, sizeof(map_named_t_node));
+        assert_true(next != (void *) it.node);
+        ctl_pool_release(&pool, next, sizeof(map_named_t_node));
+    }
+    assert_int_equal(map.size, 100);
+
+    // The tree is intact: every key in order, with its value.
+    uint32_t id = 0;
+    char name[16];
+    for (map_named_t_node *node = map_named_t_first(&map); node; node = map_named_t_node_next(node), id++) {
+        assert_int_equal(node->value.id, id);
+        snprintf(name, sizeof(name), "#%u", id % 3 ? id : id + 1000);
+        assert_string_equal(node->value.name, name);
+    }
+    assert_int_equal(id, 100);
+
+    // And comes apart again.
+    for (id = 0; id < 100; id++) {
+        map_named_t_erase(&map, (named_t) {.id = id});
+    }
+    assert_int_equal(map.size, 0);
+    assert_null(map.root);
+
+    map_named_t_free(&map);
+    ctl_pool_free(&pool);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
-            cmocka_unit_test(test_dummy)
+            cmocka_unit_test(test_dummy),
+            cmocka_unit_test(test_scene_query),
+            cmocka_unit_test(test_scene_stacking),
+            cmocka_unit_test(test_scene_line_caps),
+            cmocka_unit_test(test_stroke_bounds),
+            cmocka_unit_test(test_headless_frames),
+            cmocka_unit_test(test_threaded_frames),
+            cmocka_unit_test(test_tile_cache),
+            cmocka_unit_test(test_tile_cache_miters),
+            cmocka_unit_test(test_idle_frames),
+            cmocka_unit_test(test_partial_redraw),
+            cmocka_unit_test(test_fly_to),
+            cmocka_unit_test(test_flight_tiny_pan),
+            cmocka_unit_test(test_tile_pool),
+            cmocka_unit_test(test_shared_renderers),
+            cmocka_unit_test(test_shared_hand_off),
+            cmocka_unit_test(test_registry_between_frames),
+            cmocka_unit_test(test_registry_from_hooks),
+            cmocka_unit_test(test_graph_order),
+            cmocka_unit_test(test_graph_merge),
+            cmocka_unit_test(test_graph_cycle),
+            cmocka_unit_test(test_jobs_lifecycle),
+            cmocka_unit_test(test_jobs_recursive),
+            cmocka_unit_test(test_jobs_past_capacity),
+            cmocka_unit_test(test_jobs_parallel_for),
+            cmocka_unit_test(test_vector_sort),
+#ifdef CTL_PARALLEL_SORT
+            cmocka_unit_test(test_vector_parallel_sort),
+#endif
+            cmocka_unit_test(test_flat_set_empty),
+            cmocka_unit_test(test_flat_set_rehash),
+            cmocka_unit_test(test_flat_set_churn),
+            cmocka_unit_test(test_flat_map),
+            cmocka_unit_test(test_arena),
+            cmocka_unit_test(test_pool),
+            cmocka_unit_test(test_map_insert_or_assign),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);